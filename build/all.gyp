@@ -23,6 +23,7 @@
         '../build/temp_gyp/googleurl.gyp:*',
         '../build/temp_gyp/protobuf_java.gyp:*',
         '../pagespeed/apps/apps.gyp:*',
+        '../pagespeed/capi/capi.gyp:*',
         '../pagespeed/core/core.gyp:*',
         '../pagespeed/css/css.gyp:*',
         '../pagespeed/filters/filters.gyp:*',
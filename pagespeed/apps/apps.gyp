@@ -58,6 +58,7 @@
       'dependencies': [
         '<(DEPTH)/base/base.gyp:base',
         '<(DEPTH)/third_party/gflags/gflags.gyp:gflags',
+        '<(pagespeed_root)/pagespeed/core/core.gyp:pagespeed_allocation_counter',
         '<(pagespeed_root)/pagespeed/core/init.gyp:pagespeed_init',
         '<(pagespeed_root)/pagespeed/dom/dom.gyp:pagespeed_json_dom',
         '<(pagespeed_root)/pagespeed/formatters/formatters.gyp:pagespeed_formatters',
@@ -95,17 +96,19 @@
       'suppress_wildcard': 1,
       'type': 'none',
       'dependencies': [
-        'pagespeed_bin',
         '<(pagespeed_root)/build/temp_gyp/protobuf_java.gyp:protobuf_java_jar',
+        '<(pagespeed_root)/pagespeed/capi/capi.gyp:pagespeed_jni',
         '<(pagespeed_root)/pagespeed/proto/proto_gen.gyp:pagespeed_proto_java_jar',
       ],
       'actions': [
         {
           'action_name': 'javac',
           'inputs': [
+            'java/com/googlecode/page_speed/NativePagespeed.java',
             'java/com/googlecode/page_speed/Pagespeed.java',
           ],
           'outputs': [
+            '<(DEPTH)/out/java/classes/pagespeed/com/googlecode/page_speed/NativePagespeed.class',
             '<(DEPTH)/out/java/classes/pagespeed/com/googlecode/page_speed/Pagespeed.class',
           ],
 	  # Assumes javac is in the path.
@@ -113,6 +116,7 @@
             'javac',
             '-d', '<(DEPTH)/out/java/classes/pagespeed',
             '-classpath', '<(DEPTH)/out/java/protobuf.jar:<(DEPTH)/out/java/pagespeed_proto.jar',
+            'java/com/googlecode/page_speed/NativePagespeed.java',
             'java/com/googlecode/page_speed/Pagespeed.java',
           ],
         },
@@ -0,0 +1,143 @@
+// Copyright 2013 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+package com.googlecode.page_speed;
+
+import java.io.IOException;
+import java.nio.ByteBuffer;
+
+/**
+ * Runs Page Speed in-process, through the pagespeed_jni library, rather
+ * than as a pagespeed_bin subprocess.
+ *
+ * Each instance holds a native engine whose rules are instantiated and
+ * initialized once, and reused for every page it analyzes. An instance must
+ * only be used by one thread at a time; {@link #forCurrentThread} keeps one
+ * warm instance per thread and strategy.
+ */
+public final class NativePagespeed {
+
+  /** The strategies of pagespeed_bin's --strategy flag. */
+  public enum Strategy {
+    // The values of pagespeed_strategy in pagespeed_capi.h.
+    DESKTOP(0),
+    MOBILE(1);
+
+    private final int nativeValue;
+
+    private Strategy(int nativeValue) {
+      this.nativeValue = nativeValue;
+    }
+  }
+
+  // The input formats of nativeAnalyze. Must match InputFormat in
+  // pagespeed_jni.cc.
+  private static final int HAR_INPUT = 0;
+  private static final int PROTO_INPUT = 1;
+
+  static {
+    System.loadLibrary("pagespeed_jni");
+    if (!nativeInitialize()) {
+      throw new UnsatisfiedLinkError("Failed to initialize Page Speed.");
+    }
+  }
+
+  private static final ThreadLocal<NativePagespeed[]> threadInstances =
+      new ThreadLocal<NativePagespeed[]>() {
+        @Override
+        protected NativePagespeed[] initialValue() {
+          return new NativePagespeed[Strategy.values().length];
+        }
+      };
+
+  // The native pagespeed_engine, or 0 once closed.
+  private long engine;
+
+  /**
+   * Returns the instance for the given strategy that belongs to the
+   * calling thread, creating it on first use.
+   */
+  public static NativePagespeed forCurrentThread(Strategy strategy) {
+    NativePagespeed[] instances = threadInstances.get();
+    NativePagespeed instance = instances[strategy.ordinal()];
+    if (instance == null) {
+      instance = new NativePagespeed(strategy);
+      instances[strategy.ordinal()] = instance;
+    }
+    return instance;
+  }
+
+  public NativePagespeed(Strategy strategy) {
+    engine = nativeCreateEngine(strategy.nativeValue);
+  }
+
+  /**
+   * Analyzes the remaining bytes of har, an HTTP Archive, and returns a
+   * serialized FormattedResults protocol buffer. A direct buffer (such as
+   * a MappedByteBuffer) is read in place; other buffers are copied into a
+   * direct buffer first. locale may be null for English.
+   */
+  public byte[] analyzeHar(ByteBuffer har, String locale)
+      throws IOException {
+    return analyze(HAR_INPUT, har, locale);
+  }
+
+  /**
+   * Like analyzeHar, but for a serialized ProtoInput protocol buffer.
+   */
+  public byte[] analyzeProtoInput(ByteBuffer protoInput, String locale)
+      throws IOException {
+    return analyze(PROTO_INPUT, protoInput, locale);
+  }
+
+  /** Frees the native engine. The instance may not be used afterwards. */
+  public void close() {
+    if (engine != 0) {
+      nativeDestroyEngine(engine);
+      engine = 0;
+    }
+  }
+
+  @Override
+  protected void finalize() throws Throwable {
+    try {
+      close();
+    } finally {
+      super.finalize();
+    }
+  }
+
+  private byte[] analyze(int inputFormat, ByteBuffer input, String locale)
+      throws IOException {
+    if (engine == 0) {
+      throw new IllegalStateException("NativePagespeed has been closed.");
+    }
+    if (!input.isDirect()) {
+      ByteBuffer direct = ByteBuffer.allocateDirect(input.remaining());
+      direct.put(input.duplicate());
+      direct.flip();
+      input = direct;
+    }
+    return nativeAnalyze(engine, inputFormat, input, input.position(),
+                         input.remaining(), locale);
+  }
+
+  private static native boolean nativeInitialize();
+  private static native long nativeCreateEngine(int strategy);
+  private static native void nativeDestroyEngine(long engine);
+  private static native byte[] nativeAnalyze(long engine, int inputFormat,
+                                             ByteBuffer input, int offset,
+                                             int length, String locale)
+      throws IOException;
+}
@@ -12,26 +12,26 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
-// Command line utility that invokes pagespeed_bin and processes the
-// protocol buffer results.
+// Command line utility that runs Page Speed in-process on a HAR file and
+// processes the protocol buffer results.
 
 package com.googlecode.page_speed;
 
 import com.googlecode.page_speed.PagespeedProtoFormatter;
 
-import java.io.InputStream;
+import java.io.FileInputStream;
 import java.io.IOException;
+import java.nio.MappedByteBuffer;
+import java.nio.channels.FileChannel;
 import java.util.regex.Matcher;
 import java.util.regex.Pattern;
-import java.util.ArrayList;
-import java.util.List;
 
 public class Pagespeed {
 
   private static Pattern formatArgumentPattern = Pattern.compile("\\$\\d+");
 
   public static void ShowUsageAndExit() {
-    System.err.println("Pagespeed <path_to_pagespeed_bin> <path_to_har_file>");
+    System.err.println("Pagespeed <path_to_har_file> [desktop|mobile]");
     System.exit(1);
   }
 
@@ -149,65 +149,46 @@ public class Pagespeed {
   }
 
   public static void main(String[] args) {
-    if (args.length != 2) {
+    if (args.length < 1 || args.length > 2) {
       ShowUsageAndExit();
     }
-    final String pathToPagespeedBin = args[0];
-    final String pathToHarFile = args[1];
-
-    // Construct the command to invoke pagespeed.
-    List<String> command = new ArrayList<String>();
-    command.add(pathToPagespeedBin);
-    command.add("--output_format");
-    command.add("formatted_proto");
-    command.add("--input_format");
-    command.add("har");
-    command.add("--input_file");
-    // Note: alternatively, can specify a final argument of "-", and
-    // then send the input to pagespeed over p.getOutputStream().
-    command.add(pathToHarFile);
-
-    // Invoke the pagespeed binary.
-    Runtime r = Runtime.getRuntime();
-    Process p = null;
-    try {
-      p = r.exec(command.toArray(new String[0]));
-    } catch (IOException e) {
-      System.err.println(e);
-      System.exit(1);
+    final String pathToHarFile = args[0];
+    NativePagespeed.Strategy strategy = NativePagespeed.Strategy.DESKTOP;
+    if (args.length == 2) {
+      if (args[1].equals("mobile")) {
+        strategy = NativePagespeed.Strategy.MOBILE;
+      } else if (!args[1].equals("desktop")) {
+        ShowUsageAndExit();
+      }
     }
 
-    // Read the results from the pagespeed binary.
-    InputStream is = p.getInputStream();
-    PagespeedProtoFormatter.FormattedResults results = null;
+    // Map the HAR file into memory, so that the native code reads it in
+    // place.
+    MappedByteBuffer har = null;
     try {
-      results = PagespeedProtoFormatter.FormattedResults.parseFrom(is);
+      FileInputStream harStream = new FileInputStream(pathToHarFile);
+      try {
+        FileChannel channel = harStream.getChannel();
+        har = channel.map(FileChannel.MapMode.READ_ONLY, 0, channel.size());
+      } finally {
+        harStream.close();
+      }
     } catch (IOException e) {
-      System.err.println("Failed to parse protocol buffer.");
+      System.err.println("Failed to read " + pathToHarFile + ": " + e);
       System.exit(1);
     }
 
-    // Make sure the process exited successfully.
-    int pagespeedBinReturnValue = -1;
+    // Run Page Speed on the HAR, with this thread's engine. A long-running
+    // process would reuse the engine for every HAR it analyzes on this
+    // thread.
+    PagespeedProtoFormatter.FormattedResults results = null;
     try {
-      pagespeedBinReturnValue = p.waitFor();
-    } catch (InterruptedException e) {
-      System.err.println(pathToPagespeedBin + " was interrupted.");
-      System.exit(1);
-    }
-    if (pagespeedBinReturnValue != 0) {
-      System.err.println(pathToPagespeedBin
-                         + " exited with non-zero status. Standard error:");
-      InputStream es = p.getErrorStream();
-      byte[] buffer = new byte[1024];
-      int len;
-      try {
-        while ((len = es.read(buffer)) != -1) {
-          System.err.write(buffer, 0, len);
-        }
-      } catch (IOException e) {
-        System.err.println("Failed to read standard error stream.");
-      }
+      byte[] serializedResults =
+          NativePagespeed.forCurrentThread(strategy).analyzeHar(har, null);
+      results = PagespeedProtoFormatter.FormattedResults.parseFrom(
+          serializedResults);
+    } catch (IOException e) {
+      System.err.println("Failed to analyze " + pathToHarFile + ": " + e);
       System.exit(1);
     }
 
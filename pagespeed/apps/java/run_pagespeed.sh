@@ -1,3 +1,6 @@
 #!/bin/bash
 
-java -cp out/java/protobuf.jar:out/java/pagespeed_proto.jar:out/java/classes/pagespeed com.googlecode.page_speed.Pagespeed $@
+# Directory containing libpagespeed_jni.so; override for non-Release builds.
+PAGESPEED_LIB_DIR=${PAGESPEED_LIB_DIR:-out/Release/lib.target}
+
+java -Djava.library.path=$PAGESPEED_LIB_DIR -cp out/java/protobuf.jar:out/java/pagespeed_proto.jar:out/java/classes/pagespeed com.googlecode.page_speed.Pagespeed $@
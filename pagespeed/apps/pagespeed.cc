@@ -28,6 +28,8 @@
 #include "base/values.h"
 #include "google/protobuf/io/zero_copy_stream_impl_lite.h"
 #include "google/protobuf/stubs/common.h"
+#include "pagespeed/core/allocation_counter.h"
+#include "pagespeed/core/blob_store.h"
 #include "pagespeed/core/dom.h"
 #include "pagespeed/core/engine.h"
 #include "pagespeed/core/input_capabilities.h"
@@ -35,6 +37,7 @@
 #include "pagespeed/core/pagespeed_input.h"
 #include "pagespeed/core/pagespeed_input_util.h"
 #include "pagespeed/core/pagespeed_version.h"
+#include "pagespeed/core/profile_timer.h"
 #include "pagespeed/core/resource.h"
 #include "pagespeed/core/rule.h"
 #include "pagespeed/core/string_util.h"
@@ -59,7 +62,8 @@
 #include "third_party/gflags/src/google/gflags.h"
 
 DEFINE_string(input_format, "har",
-              "Format of input_file. One of 'har' or 'proto'.");
+              "Format of input_file. One of 'har', 'proto', or "
+              "'proto_stream'.");
 DEFINE_string(output_format, "text",
               "Format of the output. "
               "One of 'proto', 'text', 'unformatted_json', "
@@ -80,6 +84,13 @@ DEFINE_string(log_file, "",
               "Logs will be printed only to console if not specified.");
 DEFINE_bool(also_log_to_stderr, false,
             "Output logs to error console along with the log file. ");
+DEFINE_string(optimized_content_dir, "",
+              "Directory in which to store the optimized version of each "
+              "resource, in a file named after its MD5, instead of in the "
+              "results. Optional; the directory must exist.");
+DEFINE_bool(profile, false,
+            "Record the time and memory spent in each input phase and rule, "
+            "include it in the results, and print a summary to stderr.");
 
 // gflags defines its own version flag, which doesn't actually provide
 // any way to show the version of the program. We disable processing
@@ -119,6 +130,53 @@ bool ReadFileToString(const std::string &file_name, std::string *dest) {
   return true;
 }
 
+// Adapts a std::istream for use as a protobuf ZeroCopyInputStream, through
+// CopyingInputStreamAdaptor.
+class IstreamCopyingInputStream
+    : public ::google::protobuf::io::CopyingInputStream {
+ public:
+  explicit IstreamCopyingInputStream(std::istream* in) : in_(in) {}
+
+  virtual int Read(void* buffer, int size) {
+    in_->read(static_cast<char*>(buffer), size);
+    if (in_->bad()) {
+      return -1;
+    }
+    return in_->gcount();
+  }
+
+ private:
+  std::istream* in_;
+
+  DISALLOW_COPY_AND_ASSIGN(IstreamCopyingInputStream);
+};
+
+// Reads a PagespeedInput in the streaming form of ProtoInput from
+// in_filename, or from stdin if in_filename is '-', without holding the
+// whole file in memory.  Returns NULL on error.
+pagespeed::PagespeedInput* ParseProtoInputStream(
+    const std::string& in_filename) {
+  std::ifstream file_stream;
+  std::istream* in = &std::cin;
+  if (in_filename != "-") {
+    file_stream.open(
+        in_filename.c_str(), std::ifstream::in | std::ifstream::binary);
+    if (file_stream.fail()) {
+      return NULL;
+    }
+    in = &file_stream;
+  }
+  IstreamCopyingInputStream copying_stream(in);
+  ::google::protobuf::io::CopyingInputStreamAdaptor input_stream(
+      &copying_stream);
+  scoped_ptr<pagespeed::PagespeedInput> input(new pagespeed::PagespeedInput);
+  if (!pagespeed::proto::PopulatePagespeedInputFromStream(&input_stream,
+                                                          input.get())) {
+    return NULL;
+  }
+  return input.release();
+}
+
 pagespeed::PagespeedInput* ParseProtoInput(const std::string& file_contents) {
   pagespeed::ProtoInput input_proto;
   ::google::protobuf::io::ArrayInputStream input_stream(
@@ -134,6 +192,22 @@ pagespeed::PagespeedInput* ParseProtoInput(const std::string& file_contents) {
   return input;
 }
 
+// Returns the stream to write output to: stdout if out_filename is '-', or
+// else out_file, opened on out_filename.  Returns NULL if out_filename cannot
+// be opened.
+std::ostream* OpenOutputStream(const std::string& out_filename,
+                               std::ofstream* out_file) {
+  if (out_filename == "-") {
+    return &std::cout;
+  }
+  out_file->open(out_filename.c_str(), std::ios::out | std::ios::binary);
+  if (!*out_file) {
+    fprintf(stderr, "Could not write output to %s.\n", out_filename.c_str());
+    return NULL;
+  }
+  return out_file;
+}
+
 void PrintUsage() {
   ::google::ShowUsageWithFlagsRestrict(::google::GetArgv0(), __FILE__);
 }
@@ -159,12 +233,38 @@ void PrintVersion() {
 #endif
 }
 
+void PrintProfileEntries(
+    const char* phase,
+    const google::protobuf::RepeatedPtrField<pagespeed::ProfileEntry>&
+        entries) {
+  for (int i = 0, len = entries.size(); i < len; ++i) {
+    const pagespeed::ProfileEntry& entry = entries.Get(i);
+    fprintf(stderr, "%-26s %-40s %10.3f %10.3f %12.0f\n",
+            phase, entry.name().c_str(), entry.wall_time_ms(),
+            entry.has_cpu_time_ms() ? entry.cpu_time_ms() : -1.0,
+            static_cast<double>(entry.bytes_allocated()));
+  }
+}
+
+void PrintProfile(const pagespeed::Profile& profile) {
+  fprintf(stderr, "%-26s %-40s %10s %10s %12s\n",
+          "phase", "name", "wall_ms", "cpu_ms", "bytes");
+  PrintProfileEntries("input", profile.input_phases());
+  PrintProfileEntries("compute_results", profile.compute_results());
+  PrintProfileEntries("compute_score_and_impact",
+                      profile.compute_score_and_impact());
+  PrintProfileEntries("format_results", profile.format_results());
+}
+
+// profile may be NULL.  If not, it is filled in with the time spent in each
+// phase of the run.
 bool RunPagespeed(const std::string& out_format,
                   const std::string& in_format,
                   const std::string& in_filename,
                   const std::string& dom_filename,
                   const std::string& instrumentation_filename,
-                  const std::string& out_filename) {
+                  const std::string& out_filename,
+                  pagespeed::Profile* profile) {
   OutputFormat output_format;
   if (out_format == "proto") {
     output_format = PROTO_OUTPUT;
@@ -200,7 +300,9 @@ bool RunPagespeed(const std::string& out_format,
   }
 
   std::string file_contents;
-  if (in_filename == "-") {
+  if (in_format == "proto_stream") {
+    // Read incrementally by ParseProtoInputStream, below.
+  } else if (in_filename == "-") {
     // Special case: if user specifies input file as '-', read the
     // input from stdin.
     file_contents.assign(std::istreambuf_iterator<char>(std::cin),
@@ -211,17 +313,16 @@ bool RunPagespeed(const std::string& out_format,
     return false;
   }
 
-  scoped_ptr<pagespeed::l10n::Localizer> localizer;
+  pagespeed::l10n::BasicLocalizer basic_localizer;
+  const pagespeed::l10n::Localizer* localizer = &basic_localizer;
   if (!FLAGS_locale.empty()) {
-    localizer.reset(pagespeed::l10n::GettextLocalizer::Create(FLAGS_locale));
-    if (!localizer.get()) {
+    localizer = pagespeed::l10n::GettextLocalizer::GetShared(FLAGS_locale);
+    if (localizer == NULL) {
       fprintf(stderr, "Invalid locale %s.\n", FLAGS_locale.c_str());
       PrintLocales();
       PrintUsage();
       return false;
     }
-  } else {
-    localizer.reset(new pagespeed::l10n::BasicLocalizer());
   }
 
   // TODO(lsong): Add support for byte order mark.
@@ -231,11 +332,17 @@ bool RunPagespeed(const std::string& out_format,
     LOG(INFO) << "Byte order mark ignored.";
   }
 
+  pagespeed::ProfileTimer input_timer(profile, pagespeed::ProfileTimer::INPUT);
   scoped_ptr<pagespeed::PagespeedInput> input;
   if (in_format == "har") {
     input.reset(pagespeed::ParseHttpArchive(file_contents));
+    input_timer.Record("ParseHttpArchive");
   } else if (in_format == "proto") {
     input.reset(ParseProtoInput(file_contents));
+    input_timer.Record("ParseProtoInput");
+  } else if (in_format == "proto_stream") {
+    input.reset(ParseProtoInputStream(in_filename));
+    input_timer.Record("ParseProtoInputStream");
   } else {
     fprintf(stderr, "Invalid input format %s.\n", in_format.c_str());
     PrintUsage();
@@ -257,22 +364,26 @@ bool RunPagespeed(const std::string& out_format,
   std::vector<const pagespeed::InstrumentationData*> instrumentation_data;
   {
     if (!instrumentation_filename.empty()) {
-      std::string instrumentation_file_contents;
-      if (!ReadFileToString(instrumentation_filename,
-                            &instrumentation_file_contents)) {
+      // Timelines of long sessions can be very large, so import them as
+      // they are read rather than reading the whole file first.
+      std::ifstream instrumentation_stream(
+          instrumentation_filename.c_str(),
+          std::ifstream::in | std::ifstream::binary);
+      if (instrumentation_stream.fail()) {
         fprintf(stderr, "Could not read input from %s.\n",
                 instrumentation_filename.c_str());
         PrintUsage();
         return false;
       }
 
-      if (!pagespeed::timeline::CreateTimelineProtoFromJsonString(
-              instrumentation_file_contents, &instrumentation_data)) {
+      if (!pagespeed::timeline::CreateTimelineProtoFromJsonStream(
+              &instrumentation_stream, &instrumentation_data)) {
         fprintf(stderr, "Failed to parse instrumentation data from %s.\n",
                 instrumentation_filename.c_str());
         PrintUsage();
         return false;
       }
+      input_timer.Record("CreateTimelineProtoFromJsonStream");
     }
   }
 
@@ -313,6 +424,7 @@ bool RunPagespeed(const std::string& out_format,
         PrintUsage();
         return false;
       }
+      input_timer.Record("CreateDocument");
     }
   }
 
@@ -327,6 +439,7 @@ bool RunPagespeed(const std::string& out_format,
   }
 
   input->Freeze();
+  input_timer.Record("Freeze");
 
   std::vector<pagespeed::Rule*> rules;
 
@@ -358,6 +471,17 @@ bool RunPagespeed(const std::string& out_format,
   // Ownership of rules is transferred to the Engine instance.
   pagespeed::Engine engine(&rules);
   engine.Init();
+  engine.set_profile(profile);
+
+  scoped_ptr<pagespeed::DirectoryBlobStore> blob_store;
+  scoped_ptr<pagespeed::ContentAddressedSink> optimized_content_sink;
+  if (!FLAGS_optimized_content_dir.empty()) {
+    blob_store.reset(
+        new pagespeed::DirectoryBlobStore(FLAGS_optimized_content_dir));
+    optimized_content_sink.reset(
+        new pagespeed::ContentAddressedSink(blob_store.get()));
+    engine.set_optimized_content_sink(optimized_content_sink.get());
+  }
 
   pagespeed::Results results;
   engine.ComputeResults(*input, &results);
@@ -369,13 +493,16 @@ bool RunPagespeed(const std::string& out_format,
     ::google::protobuf::io::StringOutputStream out_stream(&out);
     results.SerializeToZeroCopyStream(&out_stream);
   } else if (output_format == JSON_OUTPUT) {
-      pagespeed::proto::ResultsToJsonConverter::Convert(
-          results, &out);
+    // Stream the JSON straight to the output instead of buffering it.
+    std::ofstream out_file;
+    std::ostream* out_stream = OpenOutputStream(out_filename, &out_file);
+    return out_stream != NULL &&
+        pagespeed::proto::ResultsToJsonConverter::Convert(results, out_stream);
   } else {
     // Format the results.
     pagespeed::FormattedResults formatted_results;
     formatted_results.set_locale(localizer->GetLocale());
-    pagespeed::formatters::ProtoFormatter formatter(localizer.get(),
+    pagespeed::formatters::ProtoFormatter formatter(localizer,
                                                     &formatted_results);
     engine.FormatResults(results, &formatter);
 
@@ -384,35 +511,34 @@ bool RunPagespeed(const std::string& out_format,
       pagespeed::proto::FormattedResultsToTextConverter::Convert(
           formatted_results, &out);
     } else if (output_format == FORMATTED_JSON_OUTPUT) {
-      pagespeed::proto::FormattedResultsToJsonConverter::Convert(
-          formatted_results, &out);
+      std::ofstream out_file;
+      std::ostream* out_stream = OpenOutputStream(out_filename, &out_file);
+      return out_stream != NULL &&
+          pagespeed::proto::FormattedResultsToJsonConverter::Convert(
+              formatted_results, out_stream);
     } else if (output_format == FORMATTED_PROTO_OUTPUT) {
       ::google::protobuf::io::StringOutputStream out_stream(&out);
       formatted_results.SerializeToZeroCopyStream(&out_stream);
     } else if (output_format == PDF_OUTPUT) {
-      // We only over write PDF output to a file (enforced in main()).
-      DCHECK(out_filename != "-");
-      return GeneratePdfReportToFile(formatted_results, out_filename);
+      if (out_filename == "-") {
+        // Stream the PDF to stdout rather than through a temporary file.
+        fflush(stdout);
+        return pagespeed::GeneratePdfReportToFileDescriptor(
+            formatted_results, fileno(stdout));
+      }
+      return pagespeed::GeneratePdfReportToFile(formatted_results,
+                                                out_filename);
     } else {
       LOG(DFATAL) << "unexpected output_format value: " << output_format;
     }
   }
 
-  if (out_filename == "-") {
-    // Special case: if user specifies output file as '-', write the output to
-    // stdout.
-    std::cout << out;
-  } else {
-    std::ofstream out_stream(out_filename.c_str(),
-                             std::ios::out | std::ios::binary);
-    if (!out_stream) {
-      fprintf(stderr, "Could not write output to %s.\n", out_filename.c_str());
-      return false;
-    }
-    out_stream << out;
-    out_stream.close();
+  std::ofstream out_file;
+  std::ostream* out_stream = OpenOutputStream(out_filename, &out_file);
+  if (out_stream == NULL) {
+    return false;
   }
-
+  *out_stream << out;
   return true;
 }
 
@@ -469,12 +595,6 @@ int main(int argc, char** argv) {
     return 1;
   }
 
-  if (FLAGS_output_format == "pdf" && FLAGS_output_file == "-") {
-    fprintf(stderr, "Must specify --output_file for --output_format=pdf.\n");
-    PrintUsage();
-    return 1;
-  }
-
   logging::LoggingDestination log_destination =
       FLAGS_log_file.empty() ?
       logging::LOG_ONLY_TO_SYSTEM_DEBUG_LOG : logging::LOG_ONLY_TO_FILE;
@@ -504,14 +624,25 @@ int main(int argc, char** argv) {
       logging::APPEND_TO_OLD_LOG_FILE,
       logging::DISABLE_DCHECK_FOR_NON_OFFICIAL_RELEASE_BUILDS);
 
-  if (RunPagespeed(FLAGS_output_format,
-                   FLAGS_input_format,
-                   FLAGS_input_file,
-                   FLAGS_dom_input_file,
-                   FLAGS_instrumentation_input_file,
-                   FLAGS_output_file)) {
-    return EXIT_SUCCESS;
-  } else {
-    return EXIT_FAILURE;
+  scoped_ptr<pagespeed::Profile> profile;
+  if (FLAGS_profile) {
+    profile.reset(new pagespeed::Profile());
+    pagespeed::EnableAllocationCounting();
+    pagespeed::ProfileTimer::SetAllocatedBytesFunction(
+        pagespeed::GetAllocatedBytes);
+  }
+
+  const bool success = RunPagespeed(FLAGS_output_format,
+                                    FLAGS_input_format,
+                                    FLAGS_input_file,
+                                    FLAGS_dom_input_file,
+                                    FLAGS_instrumentation_input_file,
+                                    FLAGS_output_file,
+                                    profile.get());
+  if (profile != NULL) {
+    // The results only hold the phases up to ComputeResults; this also
+    // includes FormatResults.
+    PrintProfile(*profile);
   }
+  return success ? EXIT_SUCCESS : EXIT_FAILURE;
 }
@@ -0,0 +1,119 @@
+# Copyright 2013 Google Inc. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+{
+  'variables': {
+    'pagespeed_root': '../..',
+    'chromium_code': 1,
+    # Directory of the JDK whose JNI headers pagespeed_jni is built against.
+    'java_home%': '/usr/lib/jvm/default-java',
+    # The libraries that the C API is implemented with.
+    'pagespeed_capi_dependencies': [
+      '<(DEPTH)/base/base.gyp:base',
+      '<(pagespeed_root)/pagespeed/core/init.gyp:pagespeed_init',
+      '<(pagespeed_root)/pagespeed/dom/dom.gyp:pagespeed_json_dom',
+      '<(pagespeed_root)/pagespeed/formatters/formatters.gyp:pagespeed_formatters',
+      '<(pagespeed_root)/pagespeed/har/har.gyp:pagespeed_har',
+      '<(pagespeed_root)/pagespeed/image_compression/image_compression.gyp:pagespeed_image_attributes_factory',
+      '<(pagespeed_root)/pagespeed/pagespeed.gyp:pagespeed_library',
+      '<(pagespeed_root)/pagespeed/pdf/pdf.gyp:pagespeed_pdf',
+      '<(pagespeed_root)/pagespeed/po/po_gen.gyp:pagespeed_all_po',
+      '<(pagespeed_root)/pagespeed/proto/proto_gen.gyp:pagespeed_input_pb',
+      '<(pagespeed_root)/pagespeed/proto/proto_gen.gyp:pagespeed_output_pb',
+      '<(pagespeed_root)/pagespeed/proto/proto_gen.gyp:pagespeed_proto_formatted_results_converter',
+      '<(pagespeed_root)/pagespeed/proto/proto_gen.gyp:pagespeed_proto_results_converter',
+      '<(pagespeed_root)/pagespeed/proto/proto.gyp:pagespeed_proto',
+      '<(pagespeed_root)/pagespeed/timeline/timeline.gyp:pagespeed_timeline',
+      '<(DEPTH)/<(protobuf_gyp_path):protobuf_lite',
+    ],
+  },
+  'targets': [
+    {
+      # A shared library that exposes the C API in pagespeed_capi.h, for
+      # running Page Speed in-process from other languages and runtimes.
+      'target_name': 'pagespeed_capi',
+      'type': 'shared_library',
+      'dependencies': [
+        '<@(pagespeed_capi_dependencies)',
+      ],
+      'sources': [
+        'pagespeed_capi.cc',
+      ],
+      'include_dirs': [
+        '<(pagespeed_root)',
+      ],
+      'defines': [
+        'PAGESPEED_CAPI_IMPLEMENTATION',
+      ],
+      'direct_dependent_settings': {
+        'include_dirs': [
+          '<(pagespeed_root)',
+        ],
+      },
+    },
+    {
+      # The JNI binding used by com.googlecode.page_speed.NativePagespeed.
+      # The C API is linked in, so that the JVM only has one library to
+      # load.
+      'target_name': 'pagespeed_jni',
+      # Requires a JDK, so it is only built when asked for.
+      'suppress_wildcard': 1,
+      'type': 'shared_library',
+      'dependencies': [
+        '<@(pagespeed_capi_dependencies)',
+      ],
+      'sources': [
+        'pagespeed_capi.cc',
+        'pagespeed_jni.cc',
+      ],
+      'include_dirs': [
+        '<(pagespeed_root)',
+        '<(java_home)/include',
+      ],
+      'defines': [
+        'PAGESPEED_CAPI_IMPLEMENTATION',
+      ],
+      'conditions': [
+        ['OS=="linux"', {
+          'include_dirs': [
+            '<(java_home)/include/linux',
+          ],
+        }],
+        ['OS=="mac"', {
+          'include_dirs': [
+            '<(java_home)/include/darwin',
+          ],
+        }],
+        ['OS=="win"', {
+          'include_dirs': [
+            '<(java_home)/include/win32',
+          ],
+        }],
+      ],
+    },
+    {
+      # Exercises the library only through its exported C API.
+      'target_name': 'pagespeed_capi_test',
+      'type': 'executable',
+      'dependencies': [
+        'pagespeed_capi',
+        '<(DEPTH)/testing/gtest.gyp:gtest',
+        '<(DEPTH)/testing/gtest.gyp:gtest_main',
+      ],
+      'sources': [
+        'pagespeed_capi_test.cc',
+      ],
+    },
+  ],
+}
@@ -0,0 +1,607 @@
+// Copyright 2013 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pagespeed/capi/pagespeed_capi.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "base/at_exit.h"
+#include "base/basictypes.h"
+#include "base/json/json_reader.h"
+#include "base/logging.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/stl_util.h"
+#include "base/values.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
+#include "google/protobuf/stubs/common.h"
+#include "pagespeed/core/dom.h"
+#include "pagespeed/core/engine.h"
+#include "pagespeed/core/input_capabilities.h"
+#include "pagespeed/core/pagespeed_init.h"
+#include "pagespeed/core/pagespeed_input.h"
+#include "pagespeed/core/pagespeed_input_util.h"
+#include "pagespeed/core/pagespeed_version.h"
+#include "pagespeed/core/resource.h"
+#include "pagespeed/core/rule.h"
+#include "pagespeed/dom/json_dom.h"
+#include "pagespeed/formatters/proto_formatter.h"
+#include "pagespeed/har/http_archive.h"
+#include "pagespeed/image_compression/image_attributes_factory.h"
+#include "pagespeed/l10n/gettext_localizer.h"
+#include "pagespeed/l10n/localizer.h"
+#include "pagespeed/pdf/generate_pdf_report.h"
+#include "pagespeed/proto/formatted_results_to_json_converter.h"
+#include "pagespeed/proto/formatted_results_to_text_converter.h"
+#include "pagespeed/proto/pagespeed_input.pb.h"
+#include "pagespeed/proto/pagespeed_output.pb.h"
+#include "pagespeed/proto/pagespeed_proto_formatter.pb.h"
+#include "pagespeed/proto/proto_resource_utils.h"
+#include "pagespeed/proto/results_to_json_converter.h"
+#include "pagespeed/proto/timeline.pb.h"
+#include "pagespeed/rules/rule_provider.h"
+#include "pagespeed/timeline/json_importer.h"
+
+// An initialized Engine, and what is needed to choose which of its rules
+// can run on a given input.
+struct pagespeed_engine {
+  explicit pagespeed_engine(pagespeed_strategy strategy_in)
+      : strategy(strategy_in) {}
+
+  const pagespeed_strategy strategy;
+  scoped_ptr<pagespeed::Engine> engine;
+  // The capabilities each rule of engine requires of the input, by rule
+  // name.
+  std::map<std::string, pagespeed::InputCapabilities> rule_requirements;
+  // Created on the first request for PDF output.
+  scoped_ptr<pagespeed::PdfReportGenerator> pdf_generator;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(pagespeed_engine);
+};
+
+// The state of one analysis.  Until pagespeed_analysis_compute, the DOM and
+// timeline are held here rather than in input, so that
+// pagespeed_analysis_set_har can replace input without losing them.
+struct pagespeed_analysis {
+  explicit pagespeed_analysis(pagespeed_engine* engine_in)
+      : engine(engine_in),
+        input(new pagespeed::PagespeedInput()),
+        has_output(false),
+        output_format(PAGESPEED_OUTPUT_PROTO) {}
+
+  ~pagespeed_analysis() {
+    STLDeleteElements(&instrumentation_data);
+  }
+
+  pagespeed_engine* const engine;
+  // Set if engine was created for this analysis alone.
+  scoped_ptr<pagespeed_engine> owned_engine;
+  scoped_ptr<pagespeed::PagespeedInput> input;
+  scoped_ptr<pagespeed::DomDocument> document;
+  std::vector<const pagespeed::InstrumentationData*> instrumentation_data;
+
+  // Set by pagespeed_analysis_compute.
+  scoped_ptr<pagespeed::Results> results;
+
+  // The most recent output of pagespeed_analysis_format.
+  bool has_output;
+  pagespeed_output_format output_format;
+  std::string output_locale;
+  std::string output;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(pagespeed_analysis);
+};
+
+namespace {
+
+// Set by pagespeed_initialize, and released by pagespeed_shutdown.
+bool g_initialized = false;
+unsigned int g_init_flags = 0;
+// Some of our code uses Singleton<>s, which require an AtExitManager to
+// schedule their destruction.  Unless the embedder has its own, the library
+// keeps one (see PAGESPEED_INIT_AT_EXIT_MANAGER).
+base::AtExitManager* g_at_exit_manager = NULL;
+std::string* g_version = NULL;
+
+// Input may only be changed before the analysis is computed.
+bool CanChangeInput(const pagespeed_analysis* analysis) {
+  return analysis->results == NULL;
+}
+
+// Accepts the rules whose capability requirements the input satisfies, as
+// RemoveIncompatibleRules would, so that one Engine can run on inputs with
+// different capabilities.
+class CompatibleRuleFilter : public pagespeed::ResultFilter {
+ public:
+  CompatibleRuleFilter(const pagespeed_engine& engine,
+                       const pagespeed::InputCapabilities& capabilities)
+      : engine_(engine), capabilities_(capabilities) {}
+
+  virtual bool IsResultAccepted(const pagespeed::Result&) const {
+    return true;
+  }
+
+  virtual bool IsRuleResultsAccepted(const pagespeed::RuleResults&) const {
+    return true;
+  }
+
+  virtual bool IsRuleAccepted(const std::string& rule_name) const {
+    std::map<std::string, pagespeed::InputCapabilities>::const_iterator it =
+        engine_.rule_requirements.find(rule_name);
+    return it != engine_.rule_requirements.end() &&
+        capabilities_.satisfies(it->second);
+  }
+
+ private:
+  const pagespeed_engine& engine_;
+  const pagespeed::InputCapabilities capabilities_;
+
+  DISALLOW_COPY_AND_ASSIGN(CompatibleRuleFilter);
+};
+
+// Formats the results of the analysis into analysis->output.
+pagespeed_status FormatOutput(pagespeed_analysis* analysis,
+                              pagespeed_output_format format,
+                              const std::string& locale) {
+  const pagespeed::Results& results = *analysis->results;
+  std::string* out = &analysis->output;
+  out->clear();
+  if (format == PAGESPEED_OUTPUT_PROTO) {
+    ::google::protobuf::io::StringOutputStream out_stream(out);
+    return results.SerializeToZeroCopyStream(&out_stream) ?
+        PAGESPEED_OK : PAGESPEED_ERROR_INTERNAL;
+  }
+  if (format == PAGESPEED_OUTPUT_UNFORMATTED_JSON) {
+    return pagespeed::proto::ResultsToJsonConverter::Convert(results, out) ?
+        PAGESPEED_OK : PAGESPEED_ERROR_INTERNAL;
+  }
+
+  pagespeed::l10n::BasicLocalizer basic_localizer;
+  const pagespeed::l10n::Localizer* localizer = &basic_localizer;
+  if (!locale.empty()) {
+    localizer = pagespeed::l10n::GettextLocalizer::GetShared(locale);
+    if (localizer == NULL) {
+      LOG(INFO) << "Invalid locale " << locale;
+      return PAGESPEED_ERROR_INVALID_ARGUMENT;
+    }
+  }
+
+  pagespeed::FormattedResults formatted_results;
+  formatted_results.set_locale(localizer->GetLocale());
+  pagespeed::formatters::ProtoFormatter formatter(localizer,
+                                                  &formatted_results);
+  if (!analysis->engine->engine->FormatResults(results, &formatter)) {
+    return PAGESPEED_ERROR_INTERNAL;
+  }
+
+  bool success = false;
+  switch (format) {
+    case PAGESPEED_OUTPUT_TEXT:
+      success = pagespeed::proto::FormattedResultsToTextConverter::Convert(
+          formatted_results, out);
+      break;
+    case PAGESPEED_OUTPUT_FORMATTED_JSON:
+      success = pagespeed::proto::FormattedResultsToJsonConverter::Convert(
+          formatted_results, out);
+      break;
+    case PAGESPEED_OUTPUT_FORMATTED_PROTO: {
+      ::google::protobuf::io::StringOutputStream out_stream(out);
+      success = formatted_results.SerializeToZeroCopyStream(&out_stream);
+      break;
+    }
+    case PAGESPEED_OUTPUT_PDF: {
+      pagespeed_engine* engine = analysis->engine;
+      if (engine->pdf_generator == NULL) {
+        engine->pdf_generator.reset(new pagespeed::PdfReportGenerator());
+      }
+      success = engine->pdf_generator->GenerateToString(formatted_results,
+                                                        out);
+      break;
+    }
+    default:
+      LOG(DFATAL) << "unexpected output format " << format;
+      break;
+  }
+  return success ? PAGESPEED_OK : PAGESPEED_ERROR_INTERNAL;
+}
+
+}  // namespace
+
+pagespeed_status pagespeed_initialize(unsigned int flags) {
+  if (g_initialized) {
+    return PAGESPEED_OK;
+  }
+  // pagespeed::Init() may already create singletons, so the AtExitManager
+  // must exist first.
+  if ((flags & PAGESPEED_INIT_AT_EXIT_MANAGER) != 0) {
+    g_at_exit_manager = new base::AtExitManager();
+  }
+  if (!pagespeed::Init()) {
+    LOG(ERROR) << "Failed to initialize PageSpeed.";
+    delete g_at_exit_manager;
+    g_at_exit_manager = NULL;
+    return PAGESPEED_ERROR_INTERNAL;
+  }
+  g_init_flags = flags;
+
+  pagespeed::Version version;
+  pagespeed::GetPageSpeedVersion(&version);
+  char version_string[64];
+  snprintf(version_string, sizeof(version_string), "%d.%d%s",
+           version.major(), version.minor(), version.extra().c_str());
+  g_version = new std::string(version_string);
+
+  g_initialized = true;
+  return PAGESPEED_OK;
+}
+
+void pagespeed_shutdown(void) {
+  if (!g_initialized) {
+    return;
+  }
+  delete g_version;
+  g_version = NULL;
+  pagespeed::ShutDown();
+  delete g_at_exit_manager;
+  g_at_exit_manager = NULL;
+  if ((g_init_flags & PAGESPEED_INIT_SHUTDOWN_PROTOBUF) != 0) {
+    ::google::protobuf::ShutdownProtobufLibrary();
+  }
+  g_init_flags = 0;
+  g_initialized = false;
+}
+
+const char* pagespeed_version(void) {
+  DCHECK(g_initialized);
+  return g_version != NULL ? g_version->c_str() : "";
+}
+
+pagespeed_status pagespeed_engine_create(
+    pagespeed_strategy strategy,
+    const char* const* rule_names,
+    size_t num_rule_names,
+    pagespeed_engine** engine_out) {
+  DCHECK(g_initialized);
+  if (engine_out == NULL ||
+      (num_rule_names > 0 && rule_names == NULL) ||
+      (strategy != PAGESPEED_STRATEGY_DESKTOP &&
+       strategy != PAGESPEED_STRATEGY_MOBILE)) {
+    return PAGESPEED_ERROR_INVALID_ARGUMENT;
+  }
+  *engine_out = NULL;
+
+  std::vector<pagespeed::Rule*> rules;
+  // Frees the rules if they are not transferred to the Engine.
+  STLElementDeleter<std::vector<pagespeed::Rule*> > rule_deleter(&rules);
+
+  const bool save_optimized_content = true;
+  if (num_rule_names == 0) {
+    pagespeed::rule_provider::AppendPageSpeedRules(save_optimized_content,
+                                                   &rules);
+    if (strategy == PAGESPEED_STRATEGY_MOBILE) {
+      pagespeed::rule_provider::AppendRuleSet(
+          save_optimized_content,
+          pagespeed::rule_provider::MOBILE_BROWSER_RULES,
+          &rules);
+    }
+  } else {
+    std::vector<std::string> names;
+    for (size_t i = 0; i < num_rule_names; ++i) {
+      if (rule_names[i] == NULL) {
+        return PAGESPEED_ERROR_INVALID_ARGUMENT;
+      }
+      names.push_back(rule_names[i]);
+    }
+    std::vector<std::string> nonexistent_rule_names;
+    if (!pagespeed::rule_provider::AppendRulesWithNames(
+            save_optimized_content, names, &rules,
+            &nonexistent_rule_names)) {
+      LOG(INFO) << "Unknown rule " << nonexistent_rule_names[0];
+      return PAGESPEED_ERROR_INVALID_ARGUMENT;
+    }
+  }
+
+  scoped_ptr<pagespeed_engine> engine(new pagespeed_engine(strategy));
+  for (std::vector<pagespeed::Rule*>::const_iterator it = rules.begin(),
+           end = rules.end();
+       it != end;
+       ++it) {
+    engine->rule_requirements[(*it)->name()] =
+        (*it)->capability_requirements();
+  }
+  // Ownership of the rules is transferred to the Engine instance.
+  engine->engine.reset(new pagespeed::Engine(&rules));
+  engine->engine->Init();
+
+  *engine_out = engine.release();
+  return PAGESPEED_OK;
+}
+
+void pagespeed_engine_destroy(pagespeed_engine* engine) {
+  delete engine;
+}
+
+pagespeed_status pagespeed_analysis_create(
+    pagespeed_strategy strategy,
+    const char* const* rule_names,
+    size_t num_rule_names,
+    pagespeed_analysis** analysis_out) {
+  if (analysis_out == NULL) {
+    return PAGESPEED_ERROR_INVALID_ARGUMENT;
+  }
+  *analysis_out = NULL;
+
+  pagespeed_engine* engine = NULL;
+  const pagespeed_status status = pagespeed_engine_create(
+      strategy, rule_names, num_rule_names, &engine);
+  if (status != PAGESPEED_OK) {
+    return status;
+  }
+  pagespeed_analysis* analysis = new pagespeed_analysis(engine);
+  analysis->owned_engine.reset(engine);
+  *analysis_out = analysis;
+  return PAGESPEED_OK;
+}
+
+pagespeed_status pagespeed_analysis_create_with_engine(
+    pagespeed_engine* engine, pagespeed_analysis** analysis_out) {
+  if (engine == NULL || analysis_out == NULL) {
+    return PAGESPEED_ERROR_INVALID_ARGUMENT;
+  }
+  *analysis_out = new pagespeed_analysis(engine);
+  return PAGESPEED_OK;
+}
+
+void pagespeed_analysis_destroy(pagespeed_analysis* analysis) {
+  delete analysis;
+}
+
+pagespeed_status pagespeed_analysis_add_resource(
+    pagespeed_analysis* analysis,
+    const char* url,
+    const char* method,
+    int status_code,
+    const char* const* header_names,
+    const char* const* header_values,
+    size_t num_headers,
+    const char* body,
+    size_t body_size) {
+  if (analysis == NULL || url == NULL || method == NULL ||
+      (num_headers > 0 && (header_names == NULL || header_values == NULL)) ||
+      (body_size > 0 && body == NULL)) {
+    return PAGESPEED_ERROR_INVALID_ARGUMENT;
+  }
+  if (!CanChangeInput(analysis)) {
+    return PAGESPEED_ERROR_INVALID_STATE;
+  }
+
+  scoped_ptr<pagespeed::Resource> resource(new pagespeed::Resource());
+  resource->SetRequestUrl(url);
+  resource->SetRequestMethod(method);
+  resource->SetResponseStatusCode(status_code);
+  for (size_t i = 0; i < num_headers; ++i) {
+    if (header_names[i] == NULL || header_values[i] == NULL) {
+      return PAGESPEED_ERROR_INVALID_ARGUMENT;
+    }
+    resource->AddResponseHeader(header_names[i], header_values[i]);
+  }
+  if (body_size > 0) {
+    resource->SetResponseBody(std::string(body, body_size));
+  }
+
+  // AddResource takes ownership even if it rejects the resource.
+  if (!analysis->input->AddResource(resource.release())) {
+    return PAGESPEED_ERROR_INVALID_ARGUMENT;
+  }
+  return PAGESPEED_OK;
+}
+
+pagespeed_status pagespeed_analysis_set_har(
+    pagespeed_analysis* analysis, const char* har, size_t har_size) {
+  if (analysis == NULL || (har_size > 0 && har == NULL)) {
+    return PAGESPEED_ERROR_INVALID_ARGUMENT;
+  }
+  if (!CanChangeInput(analysis) || analysis->input->num_resources() > 0) {
+    return PAGESPEED_ERROR_INVALID_STATE;
+  }
+
+  pagespeed::PagespeedInput* input =
+      pagespeed::ParseHttpArchive(std::string(har, har_size));
+  if (input == NULL) {
+    return PAGESPEED_ERROR_PARSE;
+  }
+  analysis->input.reset(input);
+  return PAGESPEED_OK;
+}
+
+pagespeed_status pagespeed_analysis_set_proto_input(
+    pagespeed_analysis* analysis, const char* data, size_t size) {
+  if (analysis == NULL || (size > 0 && data == NULL)) {
+    return PAGESPEED_ERROR_INVALID_ARGUMENT;
+  }
+  if (!CanChangeInput(analysis) || analysis->input->num_resources() > 0) {
+    return PAGESPEED_ERROR_INVALID_STATE;
+  }
+
+  pagespeed::ProtoInput input_proto;
+  ::google::protobuf::io::ArrayInputStream input_stream(
+      data, static_cast<int>(size));
+  if (!input_proto.ParseFromZeroCopyStream(&input_stream)) {
+    return PAGESPEED_ERROR_PARSE;
+  }
+  pagespeed::proto::PopulatePagespeedInput(input_proto,
+                                           analysis->input.get());
+  if (!input_proto.identifier().empty()) {
+    analysis->input->SetPrimaryResourceUrl(input_proto.identifier());
+  }
+  return PAGESPEED_OK;
+}
+
+pagespeed_status pagespeed_analysis_set_primary_resource_url(
+    pagespeed_analysis* analysis, const char* url) {
+  if (analysis == NULL || url == NULL) {
+    return PAGESPEED_ERROR_INVALID_ARGUMENT;
+  }
+  if (!CanChangeInput(analysis)) {
+    return PAGESPEED_ERROR_INVALID_STATE;
+  }
+  return analysis->input->SetPrimaryResourceUrl(url) ?
+      PAGESPEED_OK : PAGESPEED_ERROR_INVALID_ARGUMENT;
+}
+
+pagespeed_status pagespeed_analysis_set_dom(
+    pagespeed_analysis* analysis, const char* json, size_t json_size) {
+  if (analysis == NULL || (json_size > 0 && json == NULL)) {
+    return PAGESPEED_ERROR_INVALID_ARGUMENT;
+  }
+  if (!CanChangeInput(analysis)) {
+    return PAGESPEED_ERROR_INVALID_STATE;
+  }
+
+  std::string error_msg_out;
+  scoped_ptr<base::Value> document_json(
+      base::JSONReader::ReadAndReturnError(
+          std::string(json, json_size),
+          true,  // allow_trailing_comma
+          NULL,  // error_code_out (ReadAndReturnError permits NULL here)
+          &error_msg_out));
+  if (document_json == NULL ||
+      !document_json->IsType(base::Value::TYPE_DICTIONARY)) {
+    LOG(INFO) << "Could not parse DOM: " << error_msg_out;
+    return PAGESPEED_ERROR_PARSE;
+  }
+  // CreateDocument takes ownership of the JSON.
+  pagespeed::DomDocument* document = pagespeed::dom::CreateDocument(
+      static_cast<const base::DictionaryValue*>(document_json.release()));
+  if (document == NULL) {
+    return PAGESPEED_ERROR_PARSE;
+  }
+  analysis->document.reset(document);
+  return PAGESPEED_OK;
+}
+
+pagespeed_status pagespeed_analysis_set_timeline(
+    pagespeed_analysis* analysis, const char* json, size_t json_size) {
+  if (analysis == NULL || (json_size > 0 && json == NULL)) {
+    return PAGESPEED_ERROR_INVALID_ARGUMENT;
+  }
+  if (!CanChangeInput(analysis)) {
+    return PAGESPEED_ERROR_INVALID_STATE;
+  }
+
+  // Import one record at a time, so that the value tree of the whole
+  // timeline is never built.
+  std::vector<const pagespeed::InstrumentationData*> instrumentation_data;
+  pagespeed::timeline::JsonTimelineImporter importer(&instrumentation_data);
+  importer.Append(json, json_size);
+  if (!importer.Finish()) {
+    STLDeleteElements(&instrumentation_data);
+    return PAGESPEED_ERROR_PARSE;
+  }
+  STLDeleteElements(&analysis->instrumentation_data);
+  analysis->instrumentation_data.swap(instrumentation_data);
+  return PAGESPEED_OK;
+}
+
+pagespeed_status pagespeed_analysis_compute(pagespeed_analysis* analysis) {
+  if (analysis == NULL) {
+    return PAGESPEED_ERROR_INVALID_ARGUMENT;
+  }
+  if (!CanChangeInput(analysis)) {
+    return PAGESPEED_ERROR_INVALID_STATE;
+  }
+
+  pagespeed::PagespeedInput* input = analysis->input.get();
+  if (input->primary_resource_url().empty() && input->num_resources() > 0) {
+    // If no primary resource URL was specified, assume the first
+    // resource is the primary resource.
+    input->SetPrimaryResourceUrl(input->GetResource(0).GetRequestUrl());
+  }
+  input->AcquireImageAttributesFactory(
+      new pagespeed::image_compression::ImageAttributesFactory());
+  if (!analysis->instrumentation_data.empty()) {
+    input->AcquireInstrumentationData(&analysis->instrumentation_data);
+  }
+  if (analysis->document != NULL) {
+    input->AcquireDomDocument(analysis->document.release());
+  }
+  if (analysis->engine->strategy == PAGESPEED_STRATEGY_MOBILE) {
+    pagespeed::ClientCharacteristics cc;
+    pagespeed::pagespeed_input_util::PopulateMobileClientCharacteristics(&cc);
+    input->SetClientCharacteristics(cc);
+  }
+  input->Freeze();
+
+  const CompatibleRuleFilter filter(*analysis->engine,
+                                    input->EstimateCapabilities());
+  analysis->results.reset(new pagespeed::Results());
+  return analysis->engine->engine->ComputeResults(
+      *input, filter, analysis->results.get()) ?
+      PAGESPEED_OK : PAGESPEED_ERROR_RULE_FAILURE;
+}
+
+pagespeed_status pagespeed_analysis_format(
+    pagespeed_analysis* analysis,
+    pagespeed_output_format format,
+    const char* locale,
+    char* buffer,
+    size_t buffer_size,
+    size_t* output_size) {
+  if (analysis == NULL || output_size == NULL ||
+      (buffer_size > 0 && buffer == NULL)) {
+    return PAGESPEED_ERROR_INVALID_ARGUMENT;
+  }
+  if (analysis->results == NULL) {
+    return PAGESPEED_ERROR_INVALID_STATE;
+  }
+
+  const std::string locale_string(locale != NULL ? locale : "");
+  if (!analysis->has_output || analysis->output_format != format ||
+      analysis->output_locale != locale_string) {
+    analysis->has_output = false;
+    const pagespeed_status status =
+        FormatOutput(analysis, format, locale_string);
+    if (status != PAGESPEED_OK) {
+      analysis->output.clear();
+      return status;
+    }
+    analysis->has_output = true;
+    analysis->output_format = format;
+    analysis->output_locale = locale_string;
+  }
+
+  const std::string& output = analysis->output;
+  *output_size = output.size();
+  if (buffer_size < output.size()) {
+    return PAGESPEED_ERROR_BUFFER_TOO_SMALL;
+  }
+  if (!output.empty()) {
+    memcpy(buffer, output.data(), output.size());
+  }
+  return PAGESPEED_OK;
+}
+
+int pagespeed_analysis_get_score(const pagespeed_analysis* analysis) {
+  if (analysis == NULL || analysis->results == NULL ||
+      !analysis->results->has_score()) {
+    return -1;
+  }
+  return analysis->results->score();
+}
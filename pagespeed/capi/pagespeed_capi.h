@@ -0,0 +1,256 @@
+/*
+ * Copyright 2013 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PAGESPEED_CAPI_PAGESPEED_CAPI_H_
+#define PAGESPEED_CAPI_PAGESPEED_CAPI_H_
+
+/*
+ * A stable C interface to Page Speed, for embedding the analysis in another
+ * process instead of running pagespeed_bin.  The input (resources, DOM and
+ * timeline) is passed in from memory, and the results are formatted into a
+ * buffer supplied by the caller, so no files or subprocesses are involved.
+ *
+ * Typical use:
+ *
+ *   pagespeed_initialize(PAGESPEED_INIT_AT_EXIT_MANAGER);
+ *   pagespeed_analysis* analysis = NULL;
+ *   pagespeed_analysis_create(PAGESPEED_STRATEGY_DESKTOP, NULL, 0, &analysis);
+ *   pagespeed_analysis_set_har(analysis, har, har_size);
+ *   pagespeed_analysis_compute(analysis);
+ *   size_t size = 0;
+ *   pagespeed_analysis_format(analysis, PAGESPEED_OUTPUT_FORMATTED_JSON,
+ *                             NULL, NULL, 0, &size);
+ *   char* buffer = malloc(size);
+ *   pagespeed_analysis_format(analysis, PAGESPEED_OUTPUT_FORMATTED_JSON,
+ *                             NULL, buffer, size, &size);
+ *   pagespeed_analysis_destroy(analysis);
+ *
+ * Instantiating and initializing the rules has a cost of its own, so a
+ * caller that analyzes many pages can create a pagespeed_engine once and
+ * create each analysis with pagespeed_analysis_create_with_engine.
+ *
+ * Thread safety: pagespeed_initialize and pagespeed_shutdown modify process
+ * state, and must not run concurrently with any other function in this
+ * file.  Between them, any number of engines and analyses may be created
+ * and used at once from different threads, as long as each analysis, and
+ * each engine together with the analyses created with it, is used by only
+ * one thread at a time.  Neither has thread affinity, so either may be
+ * handed from one thread to another; a typical server keeps one engine per
+ * thread.
+ *
+ * Strings passed in are copied, so the caller may free them as soon as the
+ * call returns.  Unless stated otherwise, strings are NUL-terminated UTF-8,
+ * and buffers are arbitrary bytes.
+ */
+
+#include <stddef.h>
+
+#if defined(_WIN32)
+#if defined(PAGESPEED_CAPI_IMPLEMENTATION)
+#define PAGESPEED_CAPI_EXPORT __declspec(dllexport)
+#else
+#define PAGESPEED_CAPI_EXPORT __declspec(dllimport)
+#endif
+#else
+#define PAGESPEED_CAPI_EXPORT __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* An opaque handle to a set of initialized rules, which may be used for
+ * any number of analyses. */
+typedef struct pagespeed_engine pagespeed_engine;
+
+/* An opaque handle to the input and results of one analysis. */
+typedef struct pagespeed_analysis pagespeed_analysis;
+
+typedef enum {
+  PAGESPEED_OK = 0,
+  /* An argument was NULL, or otherwise invalid. */
+  PAGESPEED_ERROR_INVALID_ARGUMENT = 1,
+  /* The call is not allowed at this point in the analysis, e.g. adding a
+   * resource after pagespeed_analysis_compute. */
+  PAGESPEED_ERROR_INVALID_STATE = 2,
+  /* A HAR, DOM or timeline could not be parsed. */
+  PAGESPEED_ERROR_PARSE = 3,
+  /* The output buffer was too small; see pagespeed_analysis_format. */
+  PAGESPEED_ERROR_BUFFER_TOO_SMALL = 4,
+  /* The analysis ran, but some rules failed.  The results of the other
+   * rules are still available. */
+  PAGESPEED_ERROR_RULE_FAILURE = 5,
+  PAGESPEED_ERROR_INTERNAL = 6
+} pagespeed_status;
+
+typedef enum {
+  PAGESPEED_STRATEGY_DESKTOP = 0,
+  PAGESPEED_STRATEGY_MOBILE = 1
+} pagespeed_strategy;
+
+/* The output formats, as named by pagespeed_bin's --output_format. */
+typedef enum {
+  /* A serialized pagespeed.Results protocol buffer. */
+  PAGESPEED_OUTPUT_PROTO = 0,
+  /* pagespeed.Results as JSON. */
+  PAGESPEED_OUTPUT_UNFORMATTED_JSON = 1,
+  /* Localized, human-readable text. */
+  PAGESPEED_OUTPUT_TEXT = 2,
+  /* pagespeed.FormattedResults as JSON. */
+  PAGESPEED_OUTPUT_FORMATTED_JSON = 3,
+  /* A serialized pagespeed.FormattedResults protocol buffer. */
+  PAGESPEED_OUTPUT_FORMATTED_PROTO = 4,
+  /* A PDF report.  Analyses that share an engine also share its PDF
+   * generator. */
+  PAGESPEED_OUTPUT_PDF = 5
+} pagespeed_output_format;
+
+/* Flags for pagespeed_initialize, which may be combined with |.  Both
+ * change process-wide state, so neither is set by default. */
+enum {
+  /* Install the base::AtExitManager that Page Speed's singletons require,
+   * and run it in pagespeed_shutdown.  Pass this unless the embedder
+   * already has an AtExitManager of its own, e.g. because it embeds
+   * Chromium's base library. */
+  PAGESPEED_INIT_AT_EXIT_MANAGER = 1 << 0,
+  /* Shut down the protocol buffer library in pagespeed_shutdown.  Pass this
+   * only if the embedder does not use protocol buffers itself. */
+  PAGESPEED_INIT_SHUTDOWN_PROTOBUF = 1 << 1
+};
+
+/* Initializes the library.  Must be called before any other function in
+ * this file.  flags is a combination of the PAGESPEED_INIT_ flags above.
+ * Calls after the first successful one have no effect.  Returns
+ * PAGESPEED_ERROR_INTERNAL if this CPU cannot run Page Speed. */
+PAGESPEED_CAPI_EXPORT pagespeed_status pagespeed_initialize(
+    unsigned int flags);
+
+/* Releases the memory held by the library.  Optional; no function in this
+ * file may be called afterwards. */
+PAGESPEED_CAPI_EXPORT void pagespeed_shutdown(void);
+
+/* Returns the Page Speed version, e.g. "1.12".  The string is owned by the
+ * library. */
+PAGESPEED_CAPI_EXPORT const char* pagespeed_version(void);
+
+/* Creates an engine that runs the given rules, named as in
+ * pagespeed.Results (e.g. "MinifyCss").  If num_rule_names is zero, the
+ * rules of the Page Speed score for the strategy are run.  Rules that
+ * cannot run on an input (e.g. rules that need a DOM when none is given)
+ * are skipped for that input.  On success, *engine_out must be freed with
+ * pagespeed_engine_destroy, after the analyses created with it. */
+PAGESPEED_CAPI_EXPORT pagespeed_status pagespeed_engine_create(
+    pagespeed_strategy strategy,
+    const char* const* rule_names,
+    size_t num_rule_names,
+    pagespeed_engine** engine_out);
+
+/* Frees the engine.  engine may be NULL. */
+PAGESPEED_CAPI_EXPORT void pagespeed_engine_destroy(pagespeed_engine* engine);
+
+/* Creates an analysis with an engine of its own, as made by
+ * pagespeed_engine_create.  On success, *analysis_out must be freed with
+ * pagespeed_analysis_destroy. */
+PAGESPEED_CAPI_EXPORT pagespeed_status pagespeed_analysis_create(
+    pagespeed_strategy strategy,
+    const char* const* rule_names,
+    size_t num_rule_names,
+    pagespeed_analysis** analysis_out);
+
+/* Creates an analysis that is computed with the given engine, and uses its
+ * strategy.  On success, *analysis_out must be freed with
+ * pagespeed_analysis_destroy. */
+PAGESPEED_CAPI_EXPORT pagespeed_status pagespeed_analysis_create_with_engine(
+    pagespeed_engine* engine, pagespeed_analysis** analysis_out);
+
+/* Frees the analysis.  analysis may be NULL. */
+PAGESPEED_CAPI_EXPORT void pagespeed_analysis_destroy(
+    pagespeed_analysis* analysis);
+
+/* Adds a resource fetched by the page.  header_names and header_values hold
+ * num_headers response headers.  body may be NULL if body_size is zero.  The
+ * first resource added is the primary resource, unless
+ * pagespeed_analysis_set_primary_resource_url says otherwise.  Returns
+ * PAGESPEED_ERROR_INVALID_ARGUMENT if the resource was rejected, e.g. for
+ * a duplicate URL. */
+PAGESPEED_CAPI_EXPORT pagespeed_status pagespeed_analysis_add_resource(
+    pagespeed_analysis* analysis,
+    const char* url,
+    const char* method,
+    int status_code,
+    const char* const* header_names,
+    const char* const* header_values,
+    size_t num_headers,
+    const char* body,
+    size_t body_size);
+
+/* Adds the resources of an HTTP Archive.  Must be called before any
+ * resource is added. */
+PAGESPEED_CAPI_EXPORT pagespeed_status pagespeed_analysis_set_har(
+    pagespeed_analysis* analysis, const char* har, size_t har_size);
+
+/* Adds the resources of a serialized pagespeed.ProtoInput.  Must be called
+ * before any resource is added.  The identifier of the ProtoInput, if any,
+ * is the URL of the primary resource. */
+PAGESPEED_CAPI_EXPORT pagespeed_status pagespeed_analysis_set_proto_input(
+    pagespeed_analysis* analysis, const char* data, size_t size);
+
+/* Sets the URL of the page's primary (main document) resource, which must
+ * have been added already. */
+PAGESPEED_CAPI_EXPORT pagespeed_status
+pagespeed_analysis_set_primary_resource_url(
+    pagespeed_analysis* analysis, const char* url);
+
+/* Sets the DOM of the page, in the JSON form read by pagespeed_bin's
+ * --dom_input_file. */
+PAGESPEED_CAPI_EXPORT pagespeed_status pagespeed_analysis_set_dom(
+    pagespeed_analysis* analysis, const char* json, size_t json_size);
+
+/* Sets the timeline of the page load, in the JSON form read by
+ * pagespeed_bin's --instrumentation_input_file. */
+PAGESPEED_CAPI_EXPORT pagespeed_status pagespeed_analysis_set_timeline(
+    pagespeed_analysis* analysis, const char* json, size_t json_size);
+
+/* Runs the rules on the input.  May be called only once per analysis;
+ * afterwards, the input can no longer be changed. */
+PAGESPEED_CAPI_EXPORT pagespeed_status pagespeed_analysis_compute(
+    pagespeed_analysis* analysis);
+
+/* Writes the results of pagespeed_analysis_compute to buffer, in the given
+ * format.  locale is used by the formatted outputs, and may be NULL for
+ * English.  *output_size is set to the size of the output, which is not
+ * NUL-terminated.  If buffer_size is smaller than that, nothing is written
+ * and PAGESPEED_ERROR_BUFFER_TOO_SMALL is returned; buffer may be NULL to
+ * query the size.  The most recent output is kept, so asking again for the
+ * same format and locale does not format the results again. */
+PAGESPEED_CAPI_EXPORT pagespeed_status pagespeed_analysis_format(
+    pagespeed_analysis* analysis,
+    pagespeed_output_format format,
+    const char* locale,
+    char* buffer,
+    size_t buffer_size,
+    size_t* output_size);
+
+/* Returns the score (0-100) of the results of pagespeed_analysis_compute,
+ * or -1 if there are no results or no score could be computed. */
+PAGESPEED_CAPI_EXPORT int pagespeed_analysis_get_score(
+    const pagespeed_analysis* analysis);
+
+#ifdef __cplusplus
+}  /* extern "C" */
+#endif
+
+#endif  /* PAGESPEED_CAPI_PAGESPEED_CAPI_H_ */
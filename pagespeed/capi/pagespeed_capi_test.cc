@@ -0,0 +1,273 @@
+// Copyright 2013 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string.h>
+
+#include <string>
+
+#include "pagespeed/capi/pagespeed_capi.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace {
+
+const char* kRootUrl = "http://www.example.com/";
+const char* kCssUrl = "http://www.example.com/style.css";
+
+const char* kHtmlHeaderNames[] = { "Content-Type" };
+const char* kHtmlHeaderValues[] = { "text/html" };
+const char* kCssHeaderNames[] = { "Content-Type" };
+const char* kCssHeaderValues[] = { "text/css" };
+
+const char* kHtmlBody =
+    "<html><head><link rel=\"stylesheet\" href=\"style.css\"></head>"
+    "<body>Hello</body></html>";
+
+class PagespeedCapiTest : public ::testing::Test {
+ protected:
+  static void SetUpTestCase() {
+    ASSERT_EQ(PAGESPEED_OK,
+              pagespeed_initialize(PAGESPEED_INIT_AT_EXIT_MANAGER));
+  }
+
+  PagespeedCapiTest() : analysis_(NULL) {}
+
+  virtual void TearDown() {
+    pagespeed_analysis_destroy(analysis_);
+  }
+
+  void Create(const char* const* rule_names, size_t num_rule_names) {
+    ASSERT_EQ(PAGESPEED_OK,
+              pagespeed_analysis_create(PAGESPEED_STRATEGY_DESKTOP,
+                                        rule_names, num_rule_names,
+                                        &analysis_));
+    ASSERT_TRUE(analysis_ != NULL);
+  }
+
+  // Adds an HTML page and an uncompressed stylesheet large enough for
+  // EnableGzipCompression to flag.
+  void AddResources() {
+    ASSERT_EQ(PAGESPEED_OK,
+              pagespeed_analysis_add_resource(
+                  analysis_, kRootUrl, "GET", 200,
+                  kHtmlHeaderNames, kHtmlHeaderValues, 1,
+                  kHtmlBody, strlen(kHtmlBody)));
+    const std::string css(4096, ' ');
+    ASSERT_EQ(PAGESPEED_OK,
+              pagespeed_analysis_add_resource(
+                  analysis_, kCssUrl, "GET", 200,
+                  kCssHeaderNames, kCssHeaderValues, 1,
+                  css.data(), css.size()));
+  }
+
+  // Formats the results of analysis_, checking the size query on the way.
+  std::string Format(pagespeed_output_format format) {
+    size_t size = 0;
+    EXPECT_EQ(PAGESPEED_ERROR_BUFFER_TOO_SMALL,
+              pagespeed_analysis_format(analysis_, format, NULL,
+                                        NULL, 0, &size));
+    EXPECT_LT(0U, size);
+    std::string out(size, '\0');
+    size_t written = 0;
+    EXPECT_EQ(PAGESPEED_OK,
+              pagespeed_analysis_format(analysis_, format, NULL,
+                                        &out[0], out.size(), &written));
+    EXPECT_EQ(size, written);
+    return out;
+  }
+
+  pagespeed_analysis* analysis_;
+};
+
+TEST_F(PagespeedCapiTest, Version) {
+  EXPECT_LT(0U, strlen(pagespeed_version()));
+}
+
+TEST_F(PagespeedCapiTest, CreateRejectsUnknownRule) {
+  const char* rule_names[] = { "MinifyHTML", "NoSuchRule" };
+  pagespeed_analysis* analysis = NULL;
+  EXPECT_EQ(PAGESPEED_ERROR_INVALID_ARGUMENT,
+            pagespeed_analysis_create(PAGESPEED_STRATEGY_DESKTOP,
+                                      rule_names, 2, &analysis));
+  EXPECT_TRUE(analysis == NULL);
+}
+
+TEST_F(PagespeedCapiTest, ComputeAndFormat) {
+  const char* rule_names[] = { "EnableGzipCompression" };
+  Create(rule_names, 1);
+  AddResources();
+  ASSERT_EQ(PAGESPEED_OK, pagespeed_analysis_compute(analysis_));
+
+  const std::string json = Format(PAGESPEED_OUTPUT_UNFORMATTED_JSON);
+  EXPECT_NE(std::string::npos, json.find("EnableGzipCompression"));
+  EXPECT_NE(std::string::npos, json.find(kCssUrl));
+  const std::string text = Format(PAGESPEED_OUTPUT_TEXT);
+  EXPECT_NE(std::string::npos, text.find(kCssUrl));
+  EXPECT_FALSE(Format(PAGESPEED_OUTPUT_PROTO).empty());
+
+  const int score = pagespeed_analysis_get_score(analysis_);
+  EXPECT_LE(0, score);
+  EXPECT_GT(100, score);
+}
+
+TEST_F(PagespeedCapiTest, EngineIsReused) {
+  const char* rule_names[] = { "EnableGzipCompression" };
+  pagespeed_engine* engine = NULL;
+  ASSERT_EQ(PAGESPEED_OK,
+            pagespeed_engine_create(PAGESPEED_STRATEGY_DESKTOP,
+                                    rule_names, 1, &engine));
+  for (int i = 0; i < 2; ++i) {
+    ASSERT_EQ(PAGESPEED_OK,
+              pagespeed_analysis_create_with_engine(engine, &analysis_));
+    AddResources();
+    ASSERT_EQ(PAGESPEED_OK, pagespeed_analysis_compute(analysis_));
+    const std::string json = Format(PAGESPEED_OUTPUT_UNFORMATTED_JSON);
+    EXPECT_NE(std::string::npos, json.find(kCssUrl));
+    // The second report reuses the engine's PDF generator.
+    const std::string pdf = Format(PAGESPEED_OUTPUT_PDF);
+    EXPECT_EQ(0U, pdf.find("%PDF-"));
+    pagespeed_analysis_destroy(analysis_);
+    analysis_ = NULL;
+  }
+  pagespeed_engine_destroy(engine);
+}
+
+TEST_F(PagespeedCapiTest, SetProtoInput) {
+  // A ProtoInput with identifier "http://a.com/" and one resource, a GET of
+  // that URL with status code 200.
+  const char kProtoInput[] =
+      "\x0a\x0d" "http://a.com/"
+      "\x12\x17"
+      "\x0a\x0d" "http://a.com/"
+      "\x12\x03" "GET"
+      "\x38\xc8\x01";
+  Create(NULL, 0);
+  EXPECT_EQ(PAGESPEED_ERROR_PARSE,
+            pagespeed_analysis_set_proto_input(analysis_, "\xff", 1));
+  ASSERT_EQ(PAGESPEED_OK,
+            pagespeed_analysis_set_proto_input(analysis_, kProtoInput,
+                                               sizeof(kProtoInput) - 1));
+  // The resource of the ProtoInput is now in the input, so it cannot be
+  // replaced.
+  EXPECT_EQ(PAGESPEED_ERROR_INVALID_STATE,
+            pagespeed_analysis_set_proto_input(analysis_, kProtoInput,
+                                               sizeof(kProtoInput) - 1));
+  EXPECT_EQ(PAGESPEED_ERROR_INVALID_ARGUMENT,
+            pagespeed_analysis_add_resource(analysis_, "http://a.com/", "GET",
+                                            200, NULL, NULL, 0, NULL, 0));
+  EXPECT_EQ(PAGESPEED_OK, pagespeed_analysis_compute(analysis_));
+}
+
+TEST_F(PagespeedCapiTest, DefaultRules) {
+  Create(NULL, 0);
+  AddResources();
+  ASSERT_EQ(PAGESPEED_OK, pagespeed_analysis_compute(analysis_));
+  const std::string json = Format(PAGESPEED_OUTPUT_FORMATTED_JSON);
+  EXPECT_NE(std::string::npos, json.find("EnableGzipCompression"));
+}
+
+TEST_F(PagespeedCapiTest, UnknownLocale) {
+  Create(NULL, 0);
+  AddResources();
+  ASSERT_EQ(PAGESPEED_OK, pagespeed_analysis_compute(analysis_));
+  size_t size = 0;
+  EXPECT_EQ(PAGESPEED_ERROR_INVALID_ARGUMENT,
+            pagespeed_analysis_format(analysis_, PAGESPEED_OUTPUT_TEXT,
+                                      "xx_no_such_locale", NULL, 0, &size));
+}
+
+TEST_F(PagespeedCapiTest, InputIsFixedAfterCompute) {
+  Create(NULL, 0);
+  size_t size = 0;
+  EXPECT_EQ(PAGESPEED_ERROR_INVALID_STATE,
+            pagespeed_analysis_format(analysis_, PAGESPEED_OUTPUT_PROTO, NULL,
+                                      NULL, 0, &size));
+  AddResources();
+  ASSERT_EQ(PAGESPEED_OK, pagespeed_analysis_compute(analysis_));
+  EXPECT_EQ(PAGESPEED_ERROR_INVALID_STATE,
+            pagespeed_analysis_add_resource(analysis_, "http://b.com/", "GET",
+                                            200, NULL, NULL, 0, NULL, 0));
+  EXPECT_EQ(PAGESPEED_ERROR_INVALID_STATE,
+            pagespeed_analysis_compute(analysis_));
+}
+
+TEST_F(PagespeedCapiTest, DuplicateResource) {
+  Create(NULL, 0);
+  AddResources();
+  EXPECT_EQ(PAGESPEED_ERROR_INVALID_ARGUMENT,
+            pagespeed_analysis_add_resource(analysis_, kRootUrl, "GET", 200,
+                                            NULL, NULL, 0, NULL, 0));
+}
+
+TEST_F(PagespeedCapiTest, SetHar) {
+  const char* har =
+      "{\"log\":{\"entries\":[{"
+      "\"pageref\":\"page_0\","
+      "\"startedDateTime\":\"2009-05-26T23:51:17.000Z\","
+      "\"time\":100,"
+      "\"request\":{\"method\":\"GET\",\"url\":\"http://www.example.com/\","
+      "\"httpVersion\":\"HTTP/1.1\",\"cookies\":[],\"headers\":[],"
+      "\"headersSize\":-1,\"bodySize\":0},"
+      "\"response\":{\"status\":200,\"statusText\":\"OK\","
+      "\"httpVersion\":\"HTTP/1.1\",\"cookies\":[],"
+      "\"headers\":[{\"name\":\"Content-Type\",\"value\":\"text/html\"}],"
+      "\"content\":{\"size\":5,\"mimeType\":\"text/html\",\"text\":\"hello\"},"
+      "\"redirectURL\":\"\",\"headersSize\":-1,\"bodySize\":5},"
+      "\"cache\":{},\"timings\":{\"send\":0,\"wait\":0,\"receive\":0}"
+      "}]}}";
+  Create(NULL, 0);
+  EXPECT_EQ(PAGESPEED_ERROR_PARSE,
+            pagespeed_analysis_set_har(analysis_, "{", 1));
+  ASSERT_EQ(PAGESPEED_OK,
+            pagespeed_analysis_set_har(analysis_, har, strlen(har)));
+  // The resources of the HAR are now in the input, so it cannot be
+  // replaced.
+  EXPECT_EQ(PAGESPEED_ERROR_INVALID_STATE,
+            pagespeed_analysis_set_har(analysis_, har, strlen(har)));
+  EXPECT_EQ(PAGESPEED_OK,
+            pagespeed_analysis_set_primary_resource_url(analysis_, kRootUrl));
+  EXPECT_EQ(PAGESPEED_ERROR_INVALID_ARGUMENT,
+            pagespeed_analysis_set_primary_resource_url(analysis_, kCssUrl));
+  EXPECT_EQ(PAGESPEED_OK, pagespeed_analysis_compute(analysis_));
+}
+
+TEST_F(PagespeedCapiTest, InvalidDomAndTimeline) {
+  Create(NULL, 0);
+  const char* not_json = "not json";
+  EXPECT_EQ(PAGESPEED_ERROR_PARSE,
+            pagespeed_analysis_set_dom(analysis_, not_json,
+                                       strlen(not_json)));
+  EXPECT_EQ(PAGESPEED_ERROR_PARSE,
+            pagespeed_analysis_set_timeline(analysis_, not_json,
+                                            strlen(not_json)));
+  const char* empty_timeline = "[]";
+  EXPECT_EQ(PAGESPEED_OK,
+            pagespeed_analysis_set_timeline(analysis_, empty_timeline,
+                                            strlen(empty_timeline)));
+}
+
+TEST_F(PagespeedCapiTest, NullArguments) {
+  EXPECT_EQ(PAGESPEED_ERROR_INVALID_ARGUMENT,
+            pagespeed_analysis_create(PAGESPEED_STRATEGY_MOBILE, NULL, 0,
+                                      NULL));
+  EXPECT_EQ(PAGESPEED_ERROR_INVALID_ARGUMENT,
+            pagespeed_analysis_compute(NULL));
+  EXPECT_EQ(-1, pagespeed_analysis_get_score(NULL));
+  Create(NULL, 0);
+  EXPECT_EQ(PAGESPEED_ERROR_INVALID_ARGUMENT,
+            pagespeed_analysis_add_resource(analysis_, NULL, "GET", 200,
+                                            NULL, NULL, 0, NULL, 0));
+  EXPECT_EQ(-1, pagespeed_analysis_get_score(analysis_));
+}
+
+}  // namespace
@@ -0,0 +1,184 @@
+// Copyright 2013 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// JNI binding of the C API for com.googlecode.page_speed.NativePagespeed.
+
+#include <jni.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <string>
+
+#include "base/basictypes.h"
+#include "pagespeed/capi/pagespeed_capi.h"
+
+namespace {
+
+// The input formats of nativeAnalyze.  Must match the constants in
+// NativePagespeed.java.
+enum InputFormat {
+  HAR_INPUT = 0,
+  PROTO_INPUT = 1
+};
+
+void ThrowException(JNIEnv* env, const char* class_name,
+                    const char* message) {
+  jclass exception_class = env->FindClass(class_name);
+  if (exception_class != NULL) {
+    env->ThrowNew(exception_class, message);
+  }
+}
+
+pagespeed_engine* ToEngine(jlong handle) {
+  return reinterpret_cast<pagespeed_engine*>(static_cast<intptr_t>(handle));
+}
+
+// Destroys an analysis when it goes out of scope.
+class ScopedAnalysis {
+ public:
+  ScopedAnalysis() : analysis_(NULL) {}
+  ~ScopedAnalysis() { pagespeed_analysis_destroy(analysis_); }
+
+  pagespeed_analysis* get() const { return analysis_; }
+  pagespeed_analysis** receive() { return &analysis_; }
+
+ private:
+  pagespeed_analysis* analysis_;
+
+  DISALLOW_COPY_AND_ASSIGN(ScopedAnalysis);
+};
+
+}  // namespace
+
+extern "C" {
+
+JNIEXPORT jboolean JNICALL
+Java_com_googlecode_page_1speed_NativePagespeed_nativeInitialize(
+    JNIEnv* env, jclass clazz) {
+  // The JVM has no AtExitManager, and may use protocol buffers in other
+  // native libraries.
+  const pagespeed_status status =
+      pagespeed_initialize(PAGESPEED_INIT_AT_EXIT_MANAGER);
+  return status == PAGESPEED_OK ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_googlecode_page_1speed_NativePagespeed_nativeCreateEngine(
+    JNIEnv* env, jclass clazz, jint strategy) {
+  pagespeed_engine* engine = NULL;
+  if (pagespeed_engine_create(static_cast<pagespeed_strategy>(strategy),
+                              NULL, 0, &engine) != PAGESPEED_OK) {
+    ThrowException(env, "java/lang/IllegalArgumentException",
+                   "Failed to create a Page Speed engine.");
+    return 0;
+  }
+  return static_cast<jlong>(reinterpret_cast<intptr_t>(engine));
+}
+
+JNIEXPORT void JNICALL
+Java_com_googlecode_page_1speed_NativePagespeed_nativeDestroyEngine(
+    JNIEnv* env, jclass clazz, jlong engine) {
+  pagespeed_engine_destroy(ToEngine(engine));
+}
+
+// Analyzes the length bytes of the direct ByteBuffer input starting at
+// offset, and returns the serialized FormattedResults.  The input is read
+// in place rather than copied into the Java heap and back.
+JNIEXPORT jbyteArray JNICALL
+Java_com_googlecode_page_1speed_NativePagespeed_nativeAnalyze(
+    JNIEnv* env, jclass clazz, jlong engine, jint input_format,
+    jobject input, jint offset, jint length, jstring locale) {
+  const char* data = static_cast<const char*>(
+      env->GetDirectBufferAddress(input));
+  const jlong capacity = env->GetDirectBufferCapacity(input);
+  if (data == NULL || offset < 0 || length < 0 ||
+      static_cast<jlong>(offset) + length > capacity) {
+    ThrowException(env, "java/lang/IllegalArgumentException",
+                   "Input must be a range of a direct ByteBuffer.");
+    return NULL;
+  }
+
+  ScopedAnalysis analysis;
+  if (pagespeed_analysis_create_with_engine(ToEngine(engine),
+                                            analysis.receive()) !=
+      PAGESPEED_OK) {
+    ThrowException(env, "java/lang/IllegalStateException",
+                   "The Page Speed engine has been closed.");
+    return NULL;
+  }
+
+  pagespeed_status status = PAGESPEED_ERROR_INVALID_ARGUMENT;
+  if (input_format == HAR_INPUT) {
+    status = pagespeed_analysis_set_har(analysis.get(), data + offset, length);
+  } else if (input_format == PROTO_INPUT) {
+    status = pagespeed_analysis_set_proto_input(analysis.get(),
+                                                data + offset, length);
+  }
+  if (status != PAGESPEED_OK) {
+    ThrowException(env, "java/io/IOException", "Failed to parse input.");
+    return NULL;
+  }
+
+  // As with pagespeed_bin, the results of the rules that succeeded are
+  // returned even if others failed.
+  status = pagespeed_analysis_compute(analysis.get());
+  if (status != PAGESPEED_OK && status != PAGESPEED_ERROR_RULE_FAILURE) {
+    ThrowException(env, "java/io/IOException", "Failed to compute results.");
+    return NULL;
+  }
+
+  std::string locale_string;
+  if (locale != NULL) {
+    const char* locale_chars = env->GetStringUTFChars(locale, NULL);
+    if (locale_chars == NULL) {
+      return NULL;  // OutOfMemoryError has been thrown.
+    }
+    locale_string = locale_chars;
+    env->ReleaseStringUTFChars(locale, locale_chars);
+  }
+
+  // Format once to learn the size of the output; the second call copies
+  // the cached output straight into the Java array.
+  size_t size = 0;
+  status = pagespeed_analysis_format(analysis.get(),
+                                     PAGESPEED_OUTPUT_FORMATTED_PROTO,
+                                     locale_string.c_str(), NULL, 0, &size);
+  if (status != PAGESPEED_OK && status != PAGESPEED_ERROR_BUFFER_TOO_SMALL) {
+    ThrowException(env, "java/io/IOException", "Failed to format results.");
+    return NULL;
+  }
+  jbyteArray output = env->NewByteArray(static_cast<jsize>(size));
+  if (output == NULL) {
+    return NULL;  // OutOfMemoryError has been thrown.
+  }
+  if (size > 0) {
+    void* buffer = env->GetPrimitiveArrayCritical(output, NULL);
+    if (buffer == NULL) {
+      return NULL;  // OutOfMemoryError has been thrown.
+    }
+    status = pagespeed_analysis_format(analysis.get(),
+                                       PAGESPEED_OUTPUT_FORMATTED_PROTO,
+                                       locale_string.c_str(),
+                                       static_cast<char*>(buffer), size,
+                                       &size);
+    env->ReleasePrimitiveArrayCritical(output, buffer, 0);
+    if (status != PAGESPEED_OK) {
+      ThrowException(env, "java/io/IOException", "Failed to format results.");
+      return NULL;
+    }
+  }
+  return output;
+}
+
+}  // extern "C"
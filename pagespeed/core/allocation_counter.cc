@@ -0,0 +1,78 @@
+// Copyright 2013 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pagespeed/core/allocation_counter.h"
+
+#include <stdlib.h>
+
+#include <new>
+
+#include "base/atomicops.h"
+
+namespace {
+
+bool g_counting_enabled = false;
+volatile base::subtle::AtomicWord g_allocation_count = 0;
+volatile base::subtle::AtomicWord g_allocated_bytes = 0;
+
+void* CountedAlloc(size_t size) {
+  if (g_counting_enabled) {
+    base::subtle::NoBarrier_AtomicIncrement(&g_allocation_count, 1);
+    base::subtle::NoBarrier_AtomicIncrement(
+        &g_allocated_bytes, static_cast<base::subtle::AtomicWord>(size));
+  }
+  void* ptr = malloc(size == 0 ? 1 : size);
+  if (ptr == NULL) {
+    // Page Speed is built without exceptions, so there is no bad_alloc to
+    // throw.
+    abort();
+  }
+  return ptr;
+}
+
+}  // namespace
+
+void* operator new(size_t size) {
+  return CountedAlloc(size);
+}
+
+void* operator new[](size_t size) {
+  return CountedAlloc(size);
+}
+
+void operator delete(void* ptr) {
+  free(ptr);
+}
+
+void operator delete[](void* ptr) {
+  free(ptr);
+}
+
+namespace pagespeed {
+
+void EnableAllocationCounting() {
+  g_counting_enabled = true;
+}
+
+size_t GetAllocationCount() {
+  return static_cast<size_t>(
+      base::subtle::NoBarrier_Load(&g_allocation_count));
+}
+
+size_t GetAllocatedBytes() {
+  return static_cast<size_t>(
+      base::subtle::NoBarrier_Load(&g_allocated_bytes));
+}
+
+}  // namespace pagespeed
@@ -0,0 +1,42 @@
+// Copyright 2013 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PAGESPEED_CORE_ALLOCATION_COUNTER_H_
+#define PAGESPEED_CORE_ALLOCATION_COUNTER_H_
+
+#include <stddef.h>
+
+#include "base/basictypes.h"
+
+// Linking the pagespeed_allocation_counter library replaces the global
+// operator new and delete with versions that can count allocations.  Only
+// link it into executables (benchmarks, command line tools), never into
+// libraries that are embedded elsewhere.
+
+namespace pagespeed {
+
+// Starts counting.  Until this is called, the replaced operator new costs a
+// single untaken branch.  Not thread-safe; call before starting threads.
+void EnableAllocationCounting();
+
+// The number of allocations, and the total number of bytes requested, since
+// counting was enabled.  The counters are word-sized and wrap around, so
+// only the difference between two readings, computed as a size_t, is
+// meaningful.
+size_t GetAllocationCount();
+size_t GetAllocatedBytes();
+
+}  // namespace pagespeed
+
+#endif  // PAGESPEED_CORE_ALLOCATION_COUNTER_H_
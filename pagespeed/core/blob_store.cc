@@ -0,0 +1,273 @@
+// Copyright 2013 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pagespeed/core/blob_store.h"
+
+#include "base/logging.h"
+#include "base/md5.h"
+#include "build/build_config.h"
+#include "pagespeed/core/string_util.h"
+#include "pagespeed/proto/pagespeed_output.pb.h"
+
+#if defined(OS_WIN)
+#include <io.h>
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+
+// Reads size bytes from the current position of file into *content.
+bool ReadBytes(FILE* file, size_t size, std::string* content) {
+  content->resize(size);
+  return size == 0 || fread(&(*content)[0], 1, size, file) == size;
+}
+
+bool WriteBytes(FILE* file, const std::string& content) {
+  return content.empty() ||
+      fwrite(content.data(), 1, content.size(), file) == content.size();
+}
+
+// Seeks to the end of file and returns its size, or -1 on error.
+long GetSize(FILE* file) {
+  return fseek(file, 0, SEEK_END) == 0 ? ftell(file) : -1;
+}
+
+bool TruncateFile(FILE* file, long size) {
+#if defined(OS_WIN)
+  return _chsize(_fileno(file), size) == 0;
+#else
+  return ftruncate(fileno(file), size) == 0;
+#endif
+}
+
+int GetProcessId() {
+#if defined(OS_WIN)
+  return _getpid();
+#else
+  return getpid();
+#endif
+}
+
+}  // namespace
+
+namespace pagespeed {
+
+BlobStore::BlobStore() {}
+
+BlobStore::~BlobStore() {}
+
+// static
+std::string BlobStore::ComputeBlobHash(const std::string& content) {
+  return base::MD5String(content);
+}
+
+DirectoryBlobStore::DirectoryBlobStore(const std::string& directory)
+    : directory_(directory) {}
+
+DirectoryBlobStore::~DirectoryBlobStore() {}
+
+bool DirectoryBlobStore::Put(const std::string& hash,
+                             const std::string& content) {
+  const std::string path = GetPath(hash);
+  FILE* existing = fopen(path.c_str(), "rb");
+  if (existing != NULL) {
+    const long size = GetSize(existing);
+    fclose(existing);
+    // A file of another size is left over from an interrupted write, or was
+    // damaged since; replace it.
+    if (size == static_cast<long>(content.size())) {
+      return true;
+    }
+  }
+
+  // Write to a temporary file first, and only move it to its final name
+  // once complete, so that the store never holds a partial blob.
+  const std::string temp_path =
+      path + ".tmp" + string_util::IntToString(GetProcessId());
+  FILE* file = fopen(temp_path.c_str(), "wb");
+  if (file == NULL) {
+    LOG(ERROR) << "Unable to create " << temp_path;
+    return false;
+  }
+  const bool written = WriteBytes(file, content);
+  if (fclose(file) != 0 || !written) {
+    LOG(ERROR) << "Unable to write " << temp_path;
+    remove(temp_path.c_str());
+    return false;
+  }
+#if defined(OS_WIN)
+  // rename() does not replace an existing file on Windows.
+  remove(path.c_str());
+#endif
+  if (rename(temp_path.c_str(), path.c_str()) != 0) {
+    LOG(ERROR) << "Unable to rename " << temp_path << " to " << path;
+    remove(temp_path.c_str());
+    return false;
+  }
+  return true;
+}
+
+bool DirectoryBlobStore::Get(const std::string& hash,
+                             std::string* content) const {
+  const std::string path = GetPath(hash);
+  FILE* file = fopen(path.c_str(), "rb");
+  if (file == NULL) {
+    return false;
+  }
+  const long size = GetSize(file);
+  const bool success = size >= 0 && fseek(file, 0, SEEK_SET) == 0 &&
+      ReadBytes(file, static_cast<size_t>(size), content);
+  fclose(file);
+  if (!success) {
+    LOG(ERROR) << "Unable to read " << path;
+  }
+  return success;
+}
+
+std::string DirectoryBlobStore::GetPath(const std::string& hash) const {
+  return directory_ + "/" + hash;
+}
+
+PackFileBlobStore::PackFileBlobStore(const std::string& path)
+    : path_(path), file_(NULL) {}
+
+PackFileBlobStore::~PackFileBlobStore() {
+  if (file_ != NULL) {
+    fclose(file_);
+  }
+}
+
+bool PackFileBlobStore::Init() {
+  if (file_ != NULL) {
+    LOG(DFATAL) << "Init() called twice.";
+    return false;
+  }
+  // Writes to a file opened for appending always go to its end, whatever
+  // the position last read from.
+  file_ = fopen(path_.c_str(), "a+b");
+  if (file_ == NULL) {
+    LOG(ERROR) << "Unable to open " << path_;
+    return false;
+  }
+  return ReadIndex();
+}
+
+bool PackFileBlobStore::ReadIndex() {
+  const long end = GetSize(file_);
+  if (end < 0 || fseek(file_, 0, SEEK_SET) != 0) {
+    return false;
+  }
+  long offset = 0;
+  while (offset < end) {
+    char hash[33];
+    unsigned long size = 0;
+    if (fscanf(file_, "%32s %lu", hash, &size) != 2 || fgetc(file_) != '\n') {
+      break;
+    }
+    const long content_offset = ftell(file_);
+    if (content_offset < 0 ||
+        size > static_cast<unsigned long>(end - content_offset)) {
+      break;
+    }
+    index_[hash] = Extent(content_offset, size);
+    offset = content_offset + static_cast<long>(size);
+    if (fseek(file_, offset, SEEK_SET) != 0) {
+      return false;
+    }
+  }
+  if (offset < end) {
+    // The tail was left by an interrupted Put(). Drop it, so that new blobs
+    // are appended right after the complete ones.
+    LOG(WARNING) << "Discarding damaged blob in " << path_ << " at " << offset;
+    if (!TruncateFile(file_, offset)) {
+      LOG(ERROR) << "Unable to truncate " << path_;
+      return false;
+    }
+  }
+  return true;
+}
+
+bool PackFileBlobStore::Put(const std::string& hash,
+                            const std::string& content) {
+  DCHECK(file_ != NULL);
+  if (index_.count(hash) > 0) {
+    return true;
+  }
+  const long end = GetSize(file_);
+  if (end < 0) {
+    LOG(ERROR) << "Unable to write to " << path_;
+    return false;
+  }
+  long offset = -1;
+  if (fprintf(file_, "%s %lu\n", hash.c_str(),
+              static_cast<unsigned long>(content.size())) < 0 ||
+      (offset = ftell(file_)) < 0 ||
+      !WriteBytes(file_, content) || fflush(file_) != 0) {
+    LOG(ERROR) << "Unable to write to " << path_;
+    // Drop the partial blob, so that it does not hide the ones appended
+    // after it when the pack file is read again.
+    fflush(file_);
+    clearerr(file_);
+    if (!TruncateFile(file_, end)) {
+      LOG(ERROR) << "Unable to truncate " << path_;
+    }
+    return false;
+  }
+  index_[hash] = Extent(offset, content.size());
+  return true;
+}
+
+bool PackFileBlobStore::Get(const std::string& hash,
+                            std::string* content) const {
+  DCHECK(file_ != NULL);
+  HashToExtentMap::const_iterator iter = index_.find(hash);
+  if (iter == index_.end()) {
+    return false;
+  }
+  const Extent& extent = iter->second;
+  if (fseek(file_, extent.first, SEEK_SET) != 0 ||
+      !ReadBytes(file_, extent.second, content)) {
+    LOG(ERROR) << "Unable to read from " << path_;
+    return false;
+  }
+  return true;
+}
+
+ContentAddressedSink::ContentAddressedSink(BlobStore* store)
+    : store_(store) {
+  DCHECK(store_);
+}
+
+ContentAddressedSink::~ContentAddressedSink() {}
+
+bool ContentAddressedSink::Write(const std::string& rule_name,
+                                 Result* result) {
+  const std::string& content = result->optimized_content();
+  const std::string hash = BlobStore::ComputeBlobHash(content);
+  if (written_hashes_.count(hash) == 0) {
+    if (!store_->Put(hash, content)) {
+      LOG(ERROR) << "Unable to store optimized content of "
+                 << rule_name << ".";
+      return false;
+    }
+    written_hashes_.insert(hash);
+  }
+  result->set_optimized_content_hash(hash);
+  result->set_optimized_content_size(static_cast<int>(content.size()));
+  return true;
+}
+
+}  // namespace pagespeed
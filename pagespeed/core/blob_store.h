@@ -0,0 +1,129 @@
+// Copyright 2013 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PAGESPEED_CORE_BLOB_STORE_H_
+#define PAGESPEED_CORE_BLOB_STORE_H_
+
+#include <stdio.h>
+
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+
+#include "base/basictypes.h"
+#include "pagespeed/core/optimized_content_sink.h"
+
+namespace pagespeed {
+
+// A content-addressed store of blobs, such as the optimized versions of
+// resources. Each blob is identified by the hex MD5 of its content (see
+// ComputeBlobHash). Implement this interface to hand the blobs to some
+// other storage.
+class BlobStore {
+ public:
+  BlobStore();
+  virtual ~BlobStore();
+
+  // Stores content under hash, which must be ComputeBlobHash(content).
+  // Storing a blob that is already present succeeds without effect.
+  // @return true on success.
+  virtual bool Put(const std::string& hash, const std::string& content) = 0;
+
+  // Fetches the blob with the given hash into *content.
+  // @return true on success, false if there is no such blob or on error.
+  virtual bool Get(const std::string& hash, std::string* content) const = 0;
+
+  static std::string ComputeBlobHash(const std::string& content);
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(BlobStore);
+};
+
+// Stores each blob in a file named after its hash, in an existing
+// directory. Each file is written under a temporary name and then renamed,
+// so an interrupted Put() never leaves a partial blob under its hash.
+class DirectoryBlobStore : public BlobStore {
+ public:
+  explicit DirectoryBlobStore(const std::string& directory);
+  virtual ~DirectoryBlobStore();
+
+  virtual bool Put(const std::string& hash, const std::string& content);
+  virtual bool Get(const std::string& hash, std::string* content) const;
+
+ private:
+  std::string GetPath(const std::string& hash) const;
+
+  const std::string directory_;
+
+  DISALLOW_COPY_AND_ASSIGN(DirectoryBlobStore);
+};
+
+// Appends the blobs to a single pack file, so that many small blobs do not
+// each need a file. Each blob is preceded by a line with its hash and
+// size; the index is kept in memory, and rebuilt by Init() from an
+// existing pack file. A blob that could not be completely written is
+// truncated away, by Put() on failure or else by the next Init().
+class PackFileBlobStore : public BlobStore {
+ public:
+  explicit PackFileBlobStore(const std::string& path);
+  virtual ~PackFileBlobStore();
+
+  // Opens the pack file, creating it if necessary. Must be called once
+  // before any other method.
+  // @return true on success.
+  bool Init();
+
+  virtual bool Put(const std::string& hash, const std::string& content);
+  virtual bool Get(const std::string& hash, std::string* content) const;
+
+ private:
+  // The offset and size of a blob in the pack file.
+  typedef std::pair<long, size_t> Extent;
+  typedef std::map<std::string, Extent> HashToExtentMap;
+
+  // Adds the blobs already in the pack file to the index, and truncates
+  // any damaged tail after the last complete blob.
+  bool ReadIndex();
+
+  const std::string path_;
+  FILE* file_;
+  HashToExtentMap index_;
+
+  DISALLOW_COPY_AND_ASSIGN(PackFileBlobStore);
+};
+
+// Writes optimized content to a BlobStore, leaving only its hash and size
+// in the Result (see Engine::set_optimized_content_sink). Consumers fetch
+// the content from the store on demand.
+class ContentAddressedSink : public OptimizedContentSink {
+ public:
+  // Ownership of store is not transferred.
+  explicit ContentAddressedSink(BlobStore* store);
+  virtual ~ContentAddressedSink();
+
+  virtual bool Write(const std::string& rule_name, Result* result);
+
+ private:
+  BlobStore* const store_;
+  // The hashes of the blobs already put, so that content shared by several
+  // results is only put once.
+  std::set<std::string> written_hashes_;
+
+  DISALLOW_COPY_AND_ASSIGN(ContentAddressedSink);
+};
+
+}  // namespace pagespeed
+
+#endif  // PAGESPEED_CORE_BLOB_STORE_H_
@@ -0,0 +1,268 @@
+// Copyright 2013 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <map>
+#include <string>
+
+#include "build/build_config.h"
+#include "pagespeed/core/blob_store.h"
+#include "pagespeed/core/string_util.h"
+#include "pagespeed/proto/pagespeed_output.pb.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+#if defined(OS_WIN)
+#include <direct.h>
+#include <process.h>
+#else
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using pagespeed::BlobStore;
+using pagespeed::ContentAddressedSink;
+using pagespeed::DirectoryBlobStore;
+using pagespeed::PackFileBlobStore;
+using pagespeed::Result;
+
+namespace {
+
+const char kEmptyHash[] = "d41d8cd98f00b204e9800998ecf8427e";
+
+// Returns a path in the temporary directory that is unique to the test
+// and the process, so that concurrent test runs do not collide.
+std::string GetTempPath(const char* test_name) {
+  const char* dir = getenv("TMPDIR");
+#if defined(OS_WIN)
+  const int pid = _getpid();
+#else
+  const int pid = getpid();
+#endif
+  return std::string(dir != NULL ? dir : "/tmp") + "/blob_store_test." +
+      test_name + "." + pagespeed::string_util::IntToString(pid);
+}
+
+bool MakeDirectory(const std::string& path) {
+#if defined(OS_WIN)
+  return _mkdir(path.c_str()) == 0;
+#else
+  return mkdir(path.c_str(), 0700) == 0;
+#endif
+}
+
+bool RemoveDirectory(const std::string& path) {
+#if defined(OS_WIN)
+  return _rmdir(path.c_str()) == 0;
+#else
+  return rmdir(path.c_str()) == 0;
+#endif
+}
+
+void WriteFile(const std::string& path, const std::string& content) {
+  FILE* file = fopen(path.c_str(), "wb");
+  ASSERT_TRUE(file != NULL);
+  ASSERT_EQ(content.size(), fwrite(content.data(), 1, content.size(), file));
+  ASSERT_EQ(0, fclose(file));
+}
+
+// Keeps the blobs in memory, and counts the calls to Put().
+class MemoryBlobStore : public BlobStore {
+ public:
+  MemoryBlobStore() : num_puts_(0), success_(true) {}
+
+  virtual bool Put(const std::string& hash, const std::string& content) {
+    ++num_puts_;
+    if (success_) {
+      blobs_[hash] = content;
+    }
+    return success_;
+  }
+
+  virtual bool Get(const std::string& hash, std::string* content) const {
+    std::map<std::string, std::string>::const_iterator iter =
+        blobs_.find(hash);
+    if (iter == blobs_.end()) {
+      return false;
+    }
+    *content = iter->second;
+    return true;
+  }
+
+  int num_puts() const { return num_puts_; }
+  void set_success(bool success) { success_ = success; }
+
+ private:
+  std::map<std::string, std::string> blobs_;
+  int num_puts_;
+  bool success_;
+
+  DISALLOW_COPY_AND_ASSIGN(MemoryBlobStore);
+};
+
+TEST(BlobStoreTest, ComputeBlobHash) {
+  EXPECT_EQ(kEmptyHash, BlobStore::ComputeBlobHash(""));
+  EXPECT_NE(BlobStore::ComputeBlobHash("a"), BlobStore::ComputeBlobHash("b"));
+}
+
+TEST(ContentAddressedSinkTest, Write) {
+  MemoryBlobStore store;
+  ContentAddressedSink sink(&store);
+
+  Result result1;
+  result1.set_optimized_content("body{}");
+  ASSERT_TRUE(sink.Write("MinifyCss", &result1));
+  const std::string hash = BlobStore::ComputeBlobHash("body{}");
+  EXPECT_EQ(hash, result1.optimized_content_hash());
+  EXPECT_EQ(6, result1.optimized_content_size());
+
+  // The same content is only stored once.
+  Result result2;
+  result2.set_optimized_content("body{}");
+  ASSERT_TRUE(sink.Write("MinifyCss", &result2));
+  EXPECT_EQ(hash, result2.optimized_content_hash());
+  EXPECT_EQ(1, store.num_puts());
+
+  std::string content;
+  ASSERT_TRUE(store.Get(hash, &content));
+  EXPECT_EQ("body{}", content);
+}
+
+TEST(ContentAddressedSinkTest, StoreFailure) {
+  MemoryBlobStore store;
+  store.set_success(false);
+  ContentAddressedSink sink(&store);
+
+  Result result;
+  result.set_optimized_content("body{}");
+  ASSERT_FALSE(sink.Write("MinifyCss", &result));
+  EXPECT_FALSE(result.has_optimized_content_hash());
+
+  // A later attempt tries the store again.
+  store.set_success(true);
+  ASSERT_TRUE(sink.Write("MinifyCss", &result));
+  EXPECT_EQ(2, store.num_puts());
+}
+
+TEST(DirectoryBlobStoreTest, PutAndGet) {
+  const std::string dir = GetTempPath("PutAndGet");
+  ASSERT_TRUE(MakeDirectory(dir));
+  DirectoryBlobStore store(dir);
+  const std::string content("binary\0content\n", 15);
+  const std::string hash = BlobStore::ComputeBlobHash(content);
+  ASSERT_TRUE(store.Put(hash, content));
+  ASSERT_TRUE(store.Put(hash, content));
+
+  std::string fetched;
+  ASSERT_TRUE(store.Get(hash, &fetched));
+  EXPECT_EQ(content, fetched);
+  EXPECT_FALSE(store.Get(kEmptyHash, &fetched));
+
+  EXPECT_EQ(0, remove((dir + "/" + hash).c_str()));
+  EXPECT_TRUE(RemoveDirectory(dir));
+}
+
+TEST(DirectoryBlobStoreTest, ReplacesPartialBlob) {
+  const std::string dir = GetTempPath("ReplacesPartialBlob");
+  ASSERT_TRUE(MakeDirectory(dir));
+  DirectoryBlobStore store(dir);
+  const std::string content("a { color: red }");
+  const std::string hash = BlobStore::ComputeBlobHash(content);
+  // A file left by an interrupted write is not taken for the blob.
+  WriteFile(dir + "/" + hash, "a { co");
+  ASSERT_TRUE(store.Put(hash, content));
+
+  std::string fetched;
+  ASSERT_TRUE(store.Get(hash, &fetched));
+  EXPECT_EQ(content, fetched);
+
+  EXPECT_EQ(0, remove((dir + "/" + hash).c_str()));
+  // No temporary file is left behind, or the directory could not be removed.
+  EXPECT_TRUE(RemoveDirectory(dir));
+}
+
+TEST(PackFileBlobStoreTest, PutAndGet) {
+  const std::string path = GetTempPath("PackPutAndGet");
+
+  const std::string content1("binary\0content\n", 15);
+  const std::string hash1 = BlobStore::ComputeBlobHash(content1);
+  const std::string content2("a { color: red }");
+  const std::string hash2 = BlobStore::ComputeBlobHash(content2);
+  {
+    PackFileBlobStore store(path);
+    ASSERT_TRUE(store.Init());
+    ASSERT_TRUE(store.Put(hash1, content1));
+    ASSERT_TRUE(store.Put(hash2, content2));
+    ASSERT_TRUE(store.Put(hash1, content1));
+
+    std::string fetched;
+    ASSERT_TRUE(store.Get(hash2, &fetched));
+    EXPECT_EQ(content2, fetched);
+    ASSERT_TRUE(store.Get(hash1, &fetched));
+    EXPECT_EQ(content1, fetched);
+    EXPECT_FALSE(store.Get(kEmptyHash, &fetched));
+  }
+
+  // A new store finds the blobs already in the pack file, and appends to it.
+  {
+    PackFileBlobStore store(path);
+    ASSERT_TRUE(store.Init());
+    ASSERT_TRUE(store.Put(kEmptyHash, ""));
+
+    std::string fetched;
+    ASSERT_TRUE(store.Get(hash1, &fetched));
+    EXPECT_EQ(content1, fetched);
+    ASSERT_TRUE(store.Get(hash2, &fetched));
+    EXPECT_EQ(content2, fetched);
+    ASSERT_TRUE(store.Get(kEmptyHash, &fetched));
+    EXPECT_EQ("", fetched);
+  }
+
+  EXPECT_EQ(0, remove(path.c_str()));
+}
+
+TEST(PackFileBlobStoreTest, TruncatedPackFile) {
+  const std::string path = GetTempPath("TruncatedPackFile");
+  const std::string content("a { color: red }");
+  const std::string hash = BlobStore::ComputeBlobHash(content);
+  // A complete blob, followed by one cut short by an interrupted write.
+  WriteFile(path, hash + " 16\na { color: red }" +
+            kEmptyHash + " 10\nshort");
+
+  {
+    PackFileBlobStore store(path);
+    ASSERT_TRUE(store.Init());
+    std::string fetched;
+    ASSERT_TRUE(store.Get(hash, &fetched));
+    EXPECT_EQ(content, fetched);
+    EXPECT_FALSE(store.Get(kEmptyHash, &fetched));
+    ASSERT_TRUE(store.Put(kEmptyHash, ""));
+  }
+
+  // The damaged tail was dropped, so the blob appended after it is found.
+  {
+    PackFileBlobStore store(path);
+    ASSERT_TRUE(store.Init());
+    std::string fetched;
+    ASSERT_TRUE(store.Get(hash, &fetched));
+    EXPECT_EQ(content, fetched);
+    ASSERT_TRUE(store.Get(kEmptyHash, &fetched));
+    EXPECT_EQ("", fetched);
+  }
+
+  EXPECT_EQ(0, remove(path.c_str()));
+}
+
+}  // namespace
@@ -0,0 +1,46 @@
+// Copyright 2013 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pagespeed/core/cancellation.h"
+
+namespace pagespeed {
+
+CancellationToken::CancellationToken()
+    : parent_(NULL), cancelled_(0) {
+}
+
+CancellationToken::CancellationToken(const CancellationToken* parent)
+    : parent_(parent), cancelled_(0) {
+}
+
+CancellationToken::~CancellationToken() {
+}
+
+void CancellationToken::Cancel() {
+  base::subtle::Release_Store(&cancelled_, 1);
+}
+
+bool CancellationToken::IsCancelled() const {
+  if (base::subtle::Acquire_Load(&cancelled_) != 0) {
+    return true;
+  }
+  if ((!deadline_.is_null() && base::TimeTicks::Now() >= deadline_) ||
+      (parent_ != NULL && parent_->IsCancelled())) {
+    base::subtle::Release_Store(&cancelled_, 1);
+    return true;
+  }
+  return false;
+}
+
+}  // namespace pagespeed
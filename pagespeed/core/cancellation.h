@@ -0,0 +1,104 @@
+// Copyright 2013 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PAGESPEED_CORE_CANCELLATION_H_
+#define PAGESPEED_CORE_CANCELLATION_H_
+
+#include "base/atomicops.h"
+#include "base/basictypes.h"
+#include "base/time.h"
+
+namespace pagespeed {
+
+/**
+ * Lets long-running work (rules, minifiers, image optimizers, visitors) be
+ * stopped cooperatively: the work polls IsCancelled() and gives up, reporting
+ * failure, once it returns true.  A token is cancelled explicitly by
+ * Cancel(), implicitly once its deadline passes, or whenever its parent
+ * token is cancelled.
+ *
+ * Code that accepts a token accepts NULL to mean "never cancelled".
+ */
+class CancellationToken {
+ public:
+  CancellationToken();
+
+  // The token is also cancelled whenever parent is.  parent may be NULL.
+  // Ownership is not transferred; parent must outlive this token.
+  explicit CancellationToken(const CancellationToken* parent);
+
+  ~CancellationToken();
+
+  // Cancels the token.  May be called from any thread.
+  void Cancel();
+
+  // Cancels the token once deadline has passed.  A null TimeTicks (the
+  // default) means no deadline.  Not thread-safe: set the deadline before
+  // sharing the token with other threads.
+  void set_deadline(const base::TimeTicks& deadline) { deadline_ = deadline; }
+  const base::TimeTicks& deadline() const { return deadline_; }
+
+  // Returns true once the token, or one of its ancestors, has been cancelled
+  // or has passed its deadline.  This reads the clock for every token in the
+  // chain that has a deadline, so loops with cheap iterations should poll
+  // through a CancellationPoller instead.
+  bool IsCancelled() const;
+
+ private:
+  const CancellationToken* const parent_;
+  base::TimeTicks deadline_;
+  // Latched once the token is found to be cancelled, so that a passed
+  // deadline only has to be detected once.
+  mutable volatile base::subtle::Atomic32 cancelled_;
+
+  DISALLOW_COPY_AND_ASSIGN(CancellationToken);
+};
+
+// Returns true if token is non-NULL and has been cancelled.
+inline bool IsCancelled(const CancellationToken* token) {
+  return token != NULL && token->IsCancelled();
+}
+
+/**
+ * Polls a CancellationToken only once every kPollInterval calls, for loops
+ * whose iterations are too cheap to read the clock each time.
+ */
+class CancellationPoller {
+ public:
+  // token may be NULL.  Ownership is not transferred.
+  explicit CancellationPoller(const CancellationToken* token)
+      : token_(token), calls_until_poll_(kPollInterval), cancelled_(false) {}
+
+  bool IsCancelled() {
+    if (token_ == NULL || cancelled_ || --calls_until_poll_ > 0) {
+      return cancelled_;
+    }
+    calls_until_poll_ = kPollInterval;
+    cancelled_ = token_->IsCancelled();
+    return cancelled_;
+  }
+
+ private:
+  static const int kPollInterval = 1024;
+
+  const CancellationToken* const token_;
+  int calls_until_poll_;
+  bool cancelled_;
+
+  DISALLOW_COPY_AND_ASSIGN(CancellationPoller);
+};
+
+}  // namespace pagespeed
+
+#endif  // PAGESPEED_CORE_CANCELLATION_H_
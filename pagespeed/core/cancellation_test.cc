@@ -0,0 +1,81 @@
+// Copyright 2013 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pagespeed/core/cancellation.h"
+
+#include "base/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace {
+
+using pagespeed::CancellationPoller;
+using pagespeed::CancellationToken;
+
+TEST(CancellationTokenTest, Cancel) {
+  CancellationToken token;
+  EXPECT_FALSE(token.IsCancelled());
+  token.Cancel();
+  EXPECT_TRUE(token.IsCancelled());
+}
+
+TEST(CancellationTokenTest, NullToken) {
+  EXPECT_FALSE(pagespeed::IsCancelled(NULL));
+  CancellationPoller poller(NULL);
+  for (int i = 0; i < 10000; ++i) {
+    ASSERT_FALSE(poller.IsCancelled());
+  }
+}
+
+TEST(CancellationTokenTest, Deadline) {
+  CancellationToken future;
+  future.set_deadline(base::TimeTicks::Now() +
+                      base::TimeDelta::FromSeconds(3600));
+  EXPECT_FALSE(future.IsCancelled());
+
+  CancellationToken past;
+  past.set_deadline(base::TimeTicks::Now());
+  EXPECT_TRUE(past.IsCancelled());
+}
+
+TEST(CancellationTokenTest, Parent) {
+  CancellationToken parent;
+  CancellationToken child(&parent);
+  EXPECT_FALSE(child.IsCancelled());
+  parent.Cancel();
+  EXPECT_TRUE(child.IsCancelled());
+  EXPECT_TRUE(pagespeed::IsCancelled(&child));
+
+  // Cancelling a child does not cancel its parent.
+  CancellationToken parent2;
+  CancellationToken child2(&parent2);
+  child2.Cancel();
+  EXPECT_TRUE(child2.IsCancelled());
+  EXPECT_FALSE(parent2.IsCancelled());
+}
+
+TEST(CancellationPollerTest, PollsPeriodically) {
+  CancellationToken token;
+  CancellationPoller poller(&token);
+  EXPECT_FALSE(poller.IsCancelled());
+  token.Cancel();
+  // The poller notices within a bounded number of calls, and then stays
+  // cancelled.
+  int calls = 0;
+  while (!poller.IsCancelled()) {
+    ASSERT_LT(++calls, 100000);
+  }
+  EXPECT_TRUE(poller.IsCancelled());
+}
+
+}  // namespace
@@ -29,6 +29,7 @@
       # that tracks this issue.
       'hard_dependency': 1,
       'dependencies': [
+        'pagespeed_cancellation',
         '<(DEPTH)/base/base.gyp:base',
         '<(DEPTH)/build/temp_gyp/googleurl.gyp:googleurl',
         '<(pagespeed_root)/pagespeed/proto/proto_gen.gyp:pagespeed_output_pb',
@@ -39,6 +40,7 @@
         '<(DEPTH)/third_party/zlib/zlib.gyp:zlib',
       ],
       'sources': [
+        'blob_store.cc',
         'browsing_context.cc',
         'directive_enumerator.cc',
         'dom.cc',
@@ -47,20 +49,28 @@
         'formatter.cc',
         'image_attributes.cc',
         'input_capabilities.cc',
+        'input_fingerprint.cc',
         'instrumentation_data.cc',
+        'optimized_content_sink.cc',
         'pagespeed_input.cc',
         'pagespeed_input_util.cc',
         'pagespeed_version.cc',
+        'parallel_for.cc',
+        'profile_timer.cc',
         'resource.cc',
         'resource_cache_computer.cc',
         'resource_collection.cc',
+        'resource_coordinate_finder.cc',
         'resource_evaluation.cc',
         'resource_fetch.cc',
         'resource_filter.cc',
+        'resource_url_index.cc',
         'resource_util.cc',
+        'response_body_releaser.cc',
         'result_provider.cc',
         'rule.cc',
         'rule_input.cc',
+        'site_analyzer.cc',
         'string_util.cc',
         'uri_util.cc',
       ],
@@ -73,6 +83,7 @@
         ],
       },
       'export_dependent_settings': [
+        'pagespeed_cancellation',
         '<(DEPTH)/base/base.gyp:base',
         '<(DEPTH)/build/temp_gyp/googleurl.gyp:googleurl',
         '<(DEPTH)/<(instaweb_src_root)/instaweb_core.gyp:instaweb_htmlparse_core',
@@ -80,5 +91,45 @@
         '<(pagespeed_root)/pagespeed/proto/proto_gen.gyp:pagespeed_resource_pb',
       ]
     },
+    {
+      # Kept separate from pagespeed_core so that the minifiers and image
+      # optimizers, which only depend on base, can poll for cancellation.
+      'target_name': 'pagespeed_cancellation',
+      'type': '<(library)',
+      'dependencies': [
+        '<(DEPTH)/base/base.gyp:base',
+      ],
+      'sources': [
+        'cancellation.cc',
+      ],
+      'include_dirs': [
+        '<(pagespeed_root)',
+      ],
+      'direct_dependent_settings': {
+        'include_dirs': [
+          '<(pagespeed_root)',
+        ],
+      },
+    },
+    {
+      # Replaces the global operator new, so only link this into
+      # executables.  See allocation_counter.h.
+      'target_name': 'pagespeed_allocation_counter',
+      'type': '<(library)',
+      'dependencies': [
+        '<(DEPTH)/base/base.gyp:base',
+      ],
+      'sources': [
+        'allocation_counter.cc',
+      ],
+      'include_dirs': [
+        '<(pagespeed_root)',
+      ],
+      'direct_dependent_settings': {
+        'include_dirs': [
+          '<(pagespeed_root)',
+        ],
+      },
+    },
   ],
 }
@@ -0,0 +1,61 @@
+// Copyright 2013 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+
+#include "pagespeed/core/resource_util.h"
+#include "pagespeed/core/string_util.h"
+#include "pagespeed/testing/benchmark.h"
+
+namespace {
+
+// Keeps benchmark results live so the loops are not optimized away.
+volatile uint64 g_sink = 0;
+
+// About 100KB of moderately compressible text.
+std::string MakeText() {
+  std::string text;
+  for (int i = 0; i < 2000; ++i) {
+    text += pagespeed::string_util::StringPrintf(
+        "<li class=\"entry-%d\"><a href=\"/page/%d\">Entry %d</a></li>\n",
+        i % 17, i * 31, i);
+  }
+  return text;
+}
+
+PAGESPEED_BENCHMARK(BM_GetGzippedSize) {
+  const std::string text = MakeText();
+  int size = 0;
+  state->SetBytesPerIteration(text.size());
+  state->ResetTiming();
+  for (int i = 0; i < state->iterations(); ++i) {
+    if (!pagespeed::resource_util::GetGzippedSize(text, &size)) {
+      state->SetError("GetGzippedSize failed");
+      return;
+    }
+  }
+}
+
+PAGESPEED_BENCHMARK(BM_Hash64) {
+  const std::string text = MakeText();
+  uint64 hash = 0;
+  state->SetBytesPerIteration(text.size());
+  state->ResetTiming();
+  for (int i = 0; i < state->iterations(); ++i) {
+    hash += pagespeed::string_util::Hash64(text);
+  }
+  g_sink = hash;
+}
+
+}  // namespace
@@ -18,6 +18,8 @@
 
 #include "base/logging.h"
 #include "base/memory/scoped_ptr.h"
+#include "base/stl_util.h"  // for STLDeleteContainerPointers
+#include "pagespeed/core/cancellation.h"
 #include "pagespeed/core/string_util.h"
 #include "pagespeed/core/uri_util.h"
 
@@ -29,6 +31,34 @@ namespace pagespeed {
 
 namespace {
 
+// Find the URL of the external resource referenced by the given node, if
+// any, resolved against the base URL of the given document.
+bool GetExternalResourceUrl(const DomElement& node,
+                            const DomDocument& document,
+                            std::string* out_url) {
+  bool found_uri = false;
+  std::string relative_uri;
+  const std::string tag_name(node.GetTagName());
+  if (tag_name == "IMG" ||
+      tag_name == "SCRIPT" ||
+      tag_name == "IFRAME" ||
+      tag_name == "EMBED") {
+    found_uri = node.GetAttributeByName("src", &relative_uri);
+  } else if (tag_name == "LINK") {
+    std::string rel;
+    if (node.GetAttributeByName("rel", &rel) &&
+        pagespeed::string_util::LowerCaseEqualsASCII(rel, "stylesheet")) {
+      found_uri = node.GetAttributeByName("href", &relative_uri);
+    }
+  }
+  if (!found_uri || relative_uri.empty()) {
+    return false;
+  }
+  *out_url =
+      pagespeed::uri_util::ResolveUri(relative_uri, document.GetBaseUrl());
+  return uri_util::IsExternalResourceUrl(*out_url);
+}
+
 class ExternalResourceVisitorAdaptor : public DomElementVisitor {
  public:
   ExternalResourceVisitorAdaptor(
@@ -49,26 +79,9 @@ ExternalResourceVisitorAdaptor::ExternalResourceVisitorAdaptor(
 }
 
 void ExternalResourceVisitorAdaptor::Visit(const DomElement& node) {
-  bool found_uri = false;
-  std::string relative_uri;
-  if (node.GetTagName() == "IMG" ||
-      node.GetTagName() == "SCRIPT" ||
-      node.GetTagName() == "IFRAME" ||
-      node.GetTagName() == "EMBED") {
-    found_uri = node.GetAttributeByName("src", &relative_uri);
-  } else if (node.GetTagName() == "LINK") {
-    std::string rel;
-    if (node.GetAttributeByName("rel", &rel) &&
-        pagespeed::string_util::LowerCaseEqualsASCII(rel, "stylesheet")) {
-      found_uri = node.GetAttributeByName("href", &relative_uri);
-    }
-  }
-  if (found_uri && !relative_uri.empty()) {
-    std::string resolved_uri =
-        pagespeed::uri_util::ResolveUri(relative_uri, document_->GetBaseUrl());
-    if (uri_util::IsExternalResourceUrl(resolved_uri)) {
-      inner_->VisitUrl(node, resolved_uri);
-    }
+  std::string resolved_uri;
+  if (GetExternalResourceUrl(node, *document_, &resolved_uri)) {
+    inner_->VisitUrl(node, resolved_uri);
   }
 
   if (node.GetTagName() == "IFRAME") {
@@ -79,6 +92,129 @@ void ExternalResourceVisitorAdaptor::Visit(const DomElement& node) {
   }
 }
 
+// Adapts an ExternalResourceDomElementVisitor so that it can take part in
+// a DomTraversal.
+class ExternalResourceTraversalAdaptor : public DomTraversalVisitor {
+ public:
+  // If owns_inner is true, the adaptor takes ownership of inner.
+  ExternalResourceTraversalAdaptor(ExternalResourceDomElementVisitor* inner,
+                                   const DomDocument* document,
+                                   bool owns_inner);
+  virtual ~ExternalResourceTraversalAdaptor();
+
+  virtual void Visit(const DomElement& node);
+  virtual DomTraversalVisitor* VisitContentDocument(
+      const DomElement& element, const DomDocument& document);
+
+ private:
+  ExternalResourceDomElementVisitor* inner_;
+  const DomDocument* document_;
+  const bool owns_inner_;
+
+  DISALLOW_COPY_AND_ASSIGN(ExternalResourceTraversalAdaptor);
+};
+
+ExternalResourceTraversalAdaptor::ExternalResourceTraversalAdaptor(
+    ExternalResourceDomElementVisitor* inner,
+    const DomDocument* document,
+    bool owns_inner)
+    : inner_(inner), document_(document), owns_inner_(owns_inner) {
+}
+
+ExternalResourceTraversalAdaptor::~ExternalResourceTraversalAdaptor() {
+  if (owns_inner_) {
+    delete inner_;
+  }
+}
+
+void ExternalResourceTraversalAdaptor::Visit(const DomElement& node) {
+  std::string resolved_uri;
+  if (GetExternalResourceUrl(node, *document_, &resolved_uri)) {
+    inner_->VisitUrl(node, resolved_uri);
+  }
+}
+
+DomTraversalVisitor* ExternalResourceTraversalAdaptor::VisitContentDocument(
+    const DomElement& element, const DomDocument& document) {
+  ExternalResourceDomElementVisitor* child_visitor =
+      inner_->VisitContentDocument(element, document);
+  if (child_visitor == NULL) {
+    return NULL;
+  }
+  return new ExternalResourceTraversalAdaptor(child_visitor, &document, true);
+}
+
+void TraverseDocument(const DomDocument& document,
+                      const std::vector<DomTraversalVisitor*>& visitors,
+                      CancellationPoller* poller);
+
+// Dispatches each element of a document to a set of DomTraversalVisitors,
+// and descends into content documents on their behalf.
+class MultiplexingVisitor : public DomElementVisitor {
+ public:
+  MultiplexingVisitor(const std::vector<DomTraversalVisitor*>* visitors,
+                      CancellationPoller* poller)
+      : visitors_(visitors), poller_(poller) {}
+
+  virtual void Visit(const DomElement& node);
+
+ private:
+  const std::vector<DomTraversalVisitor*>* visitors_;
+  // Shared by the visitors of all nested documents.
+  CancellationPoller* poller_;
+
+  DISALLOW_COPY_AND_ASSIGN(MultiplexingVisitor);
+};
+
+void MultiplexingVisitor::Visit(const DomElement& node) {
+  // DomDocument::Traverse cannot be interrupted, but skipping the visitors
+  // makes the rest of a cancelled traversal cheap.
+  if (poller_->IsCancelled()) {
+    return;
+  }
+  for (std::vector<DomTraversalVisitor*>::const_iterator
+           it = visitors_->begin(), end = visitors_->end(); it != end; ++it) {
+    (*it)->Visit(node);
+  }
+
+  if (node.GetTagName() != "IFRAME") {
+    return;
+  }
+
+  // Build the content document only once, and share it among all of the
+  // visitors that are interested in it.
+  scoped_ptr<DomDocument> child_doc(node.GetContentDocument());
+  if (child_doc == NULL) {
+    return;
+  }
+
+  std::vector<DomTraversalVisitor*> child_visitors;
+  for (std::vector<DomTraversalVisitor*>::const_iterator
+           it = visitors_->begin(), end = visitors_->end(); it != end; ++it) {
+    DomTraversalVisitor* child_visitor =
+        (*it)->VisitContentDocument(node, *child_doc);
+    if (child_visitor != NULL) {
+      child_visitors.push_back(child_visitor);
+    }
+  }
+  TraverseDocument(*child_doc, child_visitors, poller_);
+  STLDeleteContainerPointers(child_visitors.begin(), child_visitors.end());
+}
+
+void TraverseDocument(const DomDocument& document,
+                      const std::vector<DomTraversalVisitor*>& visitors,
+                      CancellationPoller* poller) {
+  if (visitors.empty()) {
+    return;
+  }
+  MultiplexingVisitor visitor(&visitors, poller);
+  document.Traverse(&visitor);
+  for (std::vector<DomTraversalVisitor*>::const_iterator
+           it = visitors.begin(), end = visitors.end(); it != end; ++it) {
+    (*it)->Finish();
+  }
+}
+
 }  // namespace
 
 DomDocument::DomDocument() {}
@@ -160,6 +296,54 @@ DomElementVisitor::~DomElementVisitor() {}
 ExternalResourceDomElementVisitor::ExternalResourceDomElementVisitor() {}
 ExternalResourceDomElementVisitor::~ExternalResourceDomElementVisitor() {}
 
+ExternalResourceDomElementVisitor*
+ExternalResourceDomElementVisitor::VisitContentDocument(
+    const DomElement& element, const DomDocument& document) {
+  VisitDocument(element, document);
+  return NULL;
+}
+
+DomTraversalVisitor::DomTraversalVisitor() {}
+
+DomTraversalVisitor::~DomTraversalVisitor() {}
+
+DomTraversalVisitor* DomTraversalVisitor::VisitContentDocument(
+    const DomElement& element, const DomDocument& document) {
+  return NULL;
+}
+
+void DomTraversalVisitor::Finish() {}
+
+DomTraversal::DomTraversal() : cancellation_token_(NULL) {}
+
+DomTraversal::~DomTraversal() {}
+
+void DomTraversal::AddVisitor(DomTraversalVisitor* visitor) {
+  visitors_.push_back(visitor);
+}
+
+void DomTraversal::AddExternalResourceVisitor(
+    ExternalResourceDomElementVisitor* visitor) {
+  external_resource_visitors_.push_back(visitor);
+}
+
+void DomTraversal::Traverse(const DomDocument& document) {
+  std::vector<DomTraversalVisitor*> adaptors;
+  for (std::vector<ExternalResourceDomElementVisitor*>::const_iterator
+           it = external_resource_visitors_.begin(),
+           end = external_resource_visitors_.end(); it != end; ++it) {
+    adaptors.push_back(
+        new ExternalResourceTraversalAdaptor(*it, &document, false));
+  }
+
+  std::vector<DomTraversalVisitor*> all_visitors(visitors_);
+  all_visitors.insert(all_visitors.end(), adaptors.begin(), adaptors.end());
+  CancellationPoller poller(cancellation_token_);
+  TraverseDocument(document, all_visitors, &poller);
+
+  STLDeleteContainerPointers(adaptors.begin(), adaptors.end());
+}
+
 DomElementVisitor* MakeDomElementVisitorForDocument(
     const DomDocument* document,
     ExternalResourceDomElementVisitor* visitor) {
@@ -21,11 +21,13 @@
 
 #include <algorithm>
 #include <string>
+#include <vector>
 
 #include "base/basictypes.h"
 
 namespace pagespeed {
 
+class CancellationToken;
 class DomDocument;
 class DomElement;
 class DomElementVisitor;
@@ -248,10 +250,87 @@ class ExternalResourceDomElementVisitor {
   virtual void VisitDocument(const DomElement& element,
                              const DomDocument& document) {}
 
+  // Called by DomTraversal in place of VisitDocument() above. Implementers
+  // that want the child document to be visited as part of the same
+  // traversal should return a visitor for it. Ownership of the returned
+  // visitor is transferred to the caller. The default implementation
+  // invokes VisitDocument() and returns NULL.
+  virtual ExternalResourceDomElementVisitor* VisitContentDocument(
+      const DomElement& element, const DomDocument& document);
+
  private:
   DISALLOW_COPY_AND_ASSIGN(ExternalResourceDomElementVisitor);
 };
 
+// A DomElementVisitor that can take part in a DomTraversal. In addition
+// to visiting the elements of a document, it is asked for a visitor for
+// each nested content document, and notified once its document has been
+// fully visited.
+class DomTraversalVisitor : public DomElementVisitor {
+ public:
+  DomTraversalVisitor();
+  virtual ~DomTraversalVisitor();
+
+  // Called immediately after Visit() for an element that hosts a
+  // content document (e.g. an iframe). Return a visitor for the
+  // elements of the child document, or NULL to skip it. Ownership of
+  // the returned visitor is transferred to the caller. The default
+  // implementation returns NULL.
+  virtual DomTraversalVisitor* VisitContentDocument(
+      const DomElement& element, const DomDocument& document);
+
+  // Called once all elements of this visitor's document, including
+  // those of any nested content documents, have been visited.
+  virtual void Finish();
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(DomTraversalVisitor);
+};
+
+// Walks a document and all of its nested content documents exactly once,
+// dispatching every element to each of the registered visitors. This
+// allows several DOM consumers to share a single traversal, which can be
+// expensive for DOMs that are backed by a browser.
+class DomTraversal {
+ public:
+  DomTraversal();
+  ~DomTraversal();
+
+  // Register a visitor for the root document. Ownership of the
+  // visitor is NOT transferred to the DomTraversal.
+  void AddVisitor(DomTraversalVisitor* visitor);
+
+  // Register a visitor for the external resources referenced from the
+  // root document. Ownership of the visitor is NOT transferred to the
+  // DomTraversal.
+  void AddExternalResourceVisitor(ExternalResourceDomElementVisitor* visitor);
+
+  bool empty() const {
+    return visitors_.empty() && external_resource_visitors_.empty();
+  }
+
+  // Once token is cancelled, elements are no longer dispatched to the
+  // visitors and content documents are no longer built, so the traversal
+  // winds down quickly; Finish() is still invoked on each visitor.  token
+  // may be NULL (the default).  Ownership is not transferred.
+  void set_cancellation_token(const CancellationToken* token) {
+    cancellation_token_ = token;
+  }
+
+  // Visit the elements of the given document and its content documents
+  // in pre-order. The elements of a content document are visited
+  // immediately after the element that hosts it. Finish() is invoked on
+  // each registered visitor once the traversal is complete.
+  void Traverse(const DomDocument& document);
+
+ private:
+  std::vector<DomTraversalVisitor*> visitors_;
+  std::vector<ExternalResourceDomElementVisitor*> external_resource_visitors_;
+  const CancellationToken* cancellation_token_;
+
+  DISALLOW_COPY_AND_ASSIGN(DomTraversal);
+};
+
 // Instantiates a DomElementVisitor that wraps the given
 // ExternalResourceDomElementVisitor. Ownership of the
 // ExternalResourceDomElementVisitor is NOT transferred to this
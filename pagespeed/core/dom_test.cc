@@ -12,11 +12,175 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <string>
+#include <vector>
+
 #include "pagespeed/core/dom.h"
+#include "pagespeed/testing/fake_dom.h"
 #include "pagespeed/testing/pagespeed_test.h"
 
 namespace {
 
+using pagespeed_testing::FakeDomDocument;
+using pagespeed_testing::FakeDomElement;
+
+// A DomDocument that counts the number of times it was traversed.
+class CountingDocument : public pagespeed::DomDocument {
+ public:
+  explicit CountingDocument(const pagespeed::DomDocument* document)
+      : document_(document), num_traversals_(0) {}
+
+  virtual std::string GetDocumentUrl() const {
+    return document_->GetDocumentUrl();
+  }
+  virtual std::string GetBaseUrl() const { return document_->GetBaseUrl(); }
+  virtual bool IsResponsive() const { return document_->IsResponsive(); }
+  virtual void Traverse(pagespeed::DomElementVisitor* visitor) const {
+    ++num_traversals_;
+    document_->Traverse(visitor);
+  }
+
+  int num_traversals() const { return num_traversals_; }
+
+ private:
+  const pagespeed::DomDocument* document_;
+  mutable int num_traversals_;
+};
+
+// Records the visited tags, and the documents that were finished, into
+// logs shared with the visitors of any child documents.
+class RecordingVisitor : public pagespeed::DomTraversalVisitor {
+ public:
+  RecordingVisitor(const std::string& document_url,
+                   std::vector<std::string>* tags,
+                   std::vector<std::string>* finished)
+      : document_url_(document_url), tags_(tags), finished_(finished) {}
+
+  virtual void Visit(const pagespeed::DomElement& node) {
+    tags_->push_back(node.GetTagName());
+  }
+
+  virtual pagespeed::DomTraversalVisitor* VisitContentDocument(
+      const pagespeed::DomElement& node,
+      const pagespeed::DomDocument& document) {
+    return new RecordingVisitor(document.GetDocumentUrl(), tags_, finished_);
+  }
+
+  virtual void Finish() {
+    finished_->push_back(document_url_);
+  }
+
+ private:
+  const std::string document_url_;
+  std::vector<std::string>* tags_;
+  std::vector<std::string>* finished_;
+};
+
+class UrlRecordingVisitor : public pagespeed::ExternalResourceDomElementVisitor {
+ public:
+  explicit UrlRecordingVisitor(std::vector<std::string>* urls)
+      : urls_(urls) {}
+
+  virtual void VisitUrl(const pagespeed::DomElement& node,
+                        const std::string& url) {
+    urls_->push_back(url);
+  }
+
+  virtual pagespeed::ExternalResourceDomElementVisitor* VisitContentDocument(
+      const pagespeed::DomElement& node,
+      const pagespeed::DomDocument& document) {
+    return new UrlRecordingVisitor(urls_);
+  }
+
+ private:
+  std::vector<std::string>* urls_;
+};
+
+const char* kRootUrl = "http://www.example.com/";
+const char* kChildUrl = "http://www.example.com/child.html";
+
+TEST(DomTraversalTest, SingleTraversalForAllVisitors) {
+  scoped_ptr<FakeDomDocument> document(FakeDomDocument::NewRoot(kRootUrl));
+  FakeDomElement* root = FakeDomElement::NewRoot(document.get(), "html");
+  FakeDomElement* body = FakeDomElement::New(root, "body");
+  FakeDomElement::NewImg(body, "http://www.example.com/a.png");
+  FakeDomElement* iframe = FakeDomElement::NewIframe(body);
+  FakeDomElement::New(body, "p");
+  FakeDomDocument* child = FakeDomDocument::New(iframe, kChildUrl);
+  FakeDomElement* child_root = FakeDomElement::NewRoot(child, "html");
+  FakeDomElement::NewScript(child_root, "http://www.example.com/b.js");
+
+  std::vector<std::string> tags1, tags2, finished1, finished2, urls;
+  RecordingVisitor visitor1(kRootUrl, &tags1, &finished1);
+  RecordingVisitor visitor2(kRootUrl, &tags2, &finished2);
+  UrlRecordingVisitor url_visitor(&urls);
+
+  CountingDocument counting_document(document.get());
+  pagespeed::DomTraversal traversal;
+  ASSERT_TRUE(traversal.empty());
+  traversal.AddVisitor(&visitor1);
+  traversal.AddVisitor(&visitor2);
+  traversal.AddExternalResourceVisitor(&url_visitor);
+  ASSERT_FALSE(traversal.empty());
+  traversal.Traverse(counting_document);
+
+  ASSERT_EQ(1, counting_document.num_traversals());
+
+  // The elements of the child document are visited immediately after
+  // the iframe that hosts it.
+  ASSERT_EQ(7U, tags1.size());
+  ASSERT_EQ("HTML", tags1[0]);
+  ASSERT_EQ("BODY", tags1[1]);
+  ASSERT_EQ("IMG", tags1[2]);
+  ASSERT_EQ("IFRAME", tags1[3]);
+  ASSERT_EQ("HTML", tags1[4]);
+  ASSERT_EQ("SCRIPT", tags1[5]);
+  ASSERT_EQ("P", tags1[6]);
+  ASSERT_TRUE(tags1 == tags2);
+
+  // The child document is finished before its parent.
+  ASSERT_EQ(2U, finished1.size());
+  ASSERT_EQ(kChildUrl, finished1[0]);
+  ASSERT_EQ(kRootUrl, finished1[1]);
+  ASSERT_TRUE(finished1 == finished2);
+
+  ASSERT_EQ(2U, urls.size());
+  ASSERT_EQ("http://www.example.com/a.png", urls[0]);
+  ASSERT_EQ("http://www.example.com/b.js", urls[1]);
+}
+
+TEST(DomTraversalTest, SkipContentDocument) {
+  scoped_ptr<FakeDomDocument> document(FakeDomDocument::NewRoot(kRootUrl));
+  FakeDomElement* root = FakeDomElement::NewRoot(document.get(), "html");
+  FakeDomElement* iframe = FakeDomElement::NewIframe(root);
+  FakeDomDocument* child = FakeDomDocument::New(iframe, kChildUrl);
+  FakeDomElement* child_root = FakeDomElement::NewRoot(child, "html");
+  FakeDomElement::NewImg(child_root, "http://www.example.com/a.png");
+
+  // The default ExternalResourceDomElementVisitor does not descend into
+  // content documents.
+  class RootOnlyVisitor : public pagespeed::ExternalResourceDomElementVisitor {
+   public:
+    RootOnlyVisitor() : num_urls(0), num_documents(0) {}
+    virtual void VisitUrl(const pagespeed::DomElement& node,
+                          const std::string& url) {
+      ++num_urls;
+    }
+    virtual void VisitDocument(const pagespeed::DomElement& element,
+                               const pagespeed::DomDocument& document) {
+      ++num_documents;
+    }
+    int num_urls;
+    int num_documents;
+  } visitor;
+
+  pagespeed::DomTraversal traversal;
+  traversal.AddExternalResourceVisitor(&visitor);
+  traversal.Traverse(*document);
+  ASSERT_EQ(0, visitor.num_urls);
+  ASSERT_EQ(1, visitor.num_documents);
+}
+
 TEST(DomRectTest, Empty) {
   {
     pagespeed::DomRect r(0, 0, 0, 0);
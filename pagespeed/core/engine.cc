@@ -21,11 +21,17 @@
 
 #include "base/logging.h"
 #include "base/stl_util.h"  // for STLDeleteContainerPointers
+#include "pagespeed/core/cancellation.h"
+#include "pagespeed/core/dom.h"
 #include "pagespeed/core/formatter.h"
+#include "pagespeed/core/input_capabilities.h"
+#include "pagespeed/core/optimized_content_sink.h"
 #include "pagespeed/core/pagespeed_input.h"
 #include "pagespeed/core/pagespeed_version.h"
+#include "pagespeed/core/profile_timer.h"
 #include "pagespeed/core/resource.h"
 #include "pagespeed/core/resource_util.h"
+#include "pagespeed/core/response_body_releaser.h"
 #include "pagespeed/core/result_provider.h"
 #include "pagespeed/core/rule.h"
 #include "pagespeed/core/rule_input.h"
@@ -57,10 +63,90 @@ void FormatRuleResults(const RuleResults& rule_results,
   rule->FormatResults(sorted_results, rule_formatter);
 }
 
+// Returns the results of rule in previous_results if the rule can be
+// re-evaluated incrementally from them, or NULL.
+const RuleResults* FindReusableRuleResults(const Rule& rule,
+                                           const Results* previous_results) {
+  if (previous_results == NULL || !rule.SupportsIncrementalResults()) {
+    return NULL;
+  }
+  const std::string rule_name = rule.name();
+  for (int idx = 0; idx < previous_results->error_rules_size(); ++idx) {
+    if (previous_results->error_rules(idx) == rule_name) {
+      // The previous results of the rule may be incomplete.
+      return NULL;
+    }
+  }
+  for (int idx = 0; idx < previous_results->rule_results_size(); ++idx) {
+    const RuleResults& rule_results = previous_results->rule_results(idx);
+    if (rule_results.rule_name() == rule_name) {
+      return &rule_results;
+    }
+  }
+  return NULL;
+}
+
+// Gives token a deadline budget from now, unless budget is zero.
+void SetDeadline(const base::TimeDelta& budget, CancellationToken* token) {
+  if (budget > base::TimeDelta()) {
+    token->set_deadline(base::TimeTicks::Now() + budget);
+  }
+}
+
+// Hands the optimized content of the results of rule_results, starting at
+// first_result, to sink, and clears it from them.  Returns false if the sink
+// failed, in which case the content the sink did not take is kept in the
+// results.
+bool StreamOptimizedContent(OptimizedContentSink* sink,
+                            RuleResults* rule_results,
+                            int first_result) {
+  bool success = true;
+  for (int idx = first_result; idx < rule_results->results_size(); ++idx) {
+    Result* result = rule_results->mutable_results(idx);
+    if (!result->has_optimized_content()) {
+      continue;
+    }
+    if (!sink->Write(rule_results->rule_name(), result)) {
+      success = false;
+      continue;
+    }
+    result->clear_optimized_content();
+  }
+  return success;
+}
+
+// Runs rule on its own, with a budget of rule_time_budget within
+// analysis_token.  Returns true iff the rule completed without errors.
+bool RunRule(Rule* rule,
+             const Results* previous_results,
+             const base::TimeDelta& rule_time_budget,
+             const CancellationToken* analysis_token,
+             RuleInput* rule_input,
+             ResultProvider* provider) {
+  CancellationToken rule_token(analysis_token);
+  SetDeadline(rule_time_budget, &rule_token);
+  rule_input->set_cancellation_token(&rule_token);
+  rule_input->set_previous_rule_results(
+      FindReusableRuleResults(*rule, previous_results));
+  bool rule_success = rule->AppendResults(*rule_input, provider);
+  rule_input->set_previous_rule_results(NULL);
+  rule_input->set_cancellation_token(NULL);
+  if (rule_token.IsCancelled()) {
+    // Whatever the rule returned, its results may be incomplete.
+    rule_success = false;
+  }
+  return rule_success;
+}
+
 }  // namespace
 
 Engine::Engine(std::vector<Rule*>* rules)
-    : rules_(*rules), init_has_been_called_(false) {
+    : rules_(*rules),
+      init_has_been_called_(false),
+      profile_(NULL),
+      cancellation_token_(NULL),
+      optimized_content_sink_(NULL),
+      response_body_releaser_(NULL) {
   // Now that we've transferred the rule ownership to our local
   // vector, clear the passed in vector.
   rules->clear();
@@ -93,6 +179,65 @@ void Engine::PopulateNameToRuleMap() {
 
 bool Engine::ComputeResults(const PagespeedInput& pagespeed_input,
                             Results* results) const {
+  AlwaysAcceptResultFilter filter;
+  return ComputeResults(pagespeed_input, filter, results);
+}
+
+bool Engine::ComputeResults(const PagespeedInput& pagespeed_input,
+                            const ResultFilter& filter,
+                            Results* results) const {
+  return ComputeResultsInternal(pagespeed_input, filter, NULL, NULL, results);
+}
+
+bool Engine::ComputeResultsIncrementally(
+    const PagespeedInput& pagespeed_input,
+    const Results& previous_results,
+    const InputFingerprint& previous_fingerprint,
+    const InputFingerprint& fingerprint,
+    Results* results) const {
+  AlwaysAcceptResultFilter filter;
+
+  // Results from another version of the rules can not be reused.
+  Version version;
+  GetPageSpeedVersion(&version);
+  if (version.SerializeAsString() !=
+      previous_results.version().SerializeAsString()) {
+    return ComputeResultsInternal(pagespeed_input, filter, NULL, NULL,
+                                  results);
+  }
+
+  std::map<std::string, std::string> previous_digests;
+  for (int idx = 0; idx < previous_fingerprint.resources_size(); ++idx) {
+    const ResourceFingerprint& resource = previous_fingerprint.resources(idx);
+    previous_digests[resource.url()] = resource.digest();
+  }
+  std::set<std::string> unchanged_resource_urls;
+  for (int idx = 0; idx < fingerprint.resources_size(); ++idx) {
+    const ResourceFingerprint& resource = fingerprint.resources(idx);
+    std::map<std::string, std::string>::const_iterator iter =
+        previous_digests.find(resource.url());
+    if (iter != previous_digests.end() && iter->second == resource.digest()) {
+      unchanged_resource_urls.insert(resource.url());
+    }
+  }
+
+  return ComputeResultsInternal(pagespeed_input, filter, &previous_results,
+                                &unchanged_resource_urls, results);
+}
+
+bool Engine::RuleSupportsIncrementalResults(
+    const std::string& rule_name) const {
+  NameToRuleMap::const_iterator iter = name_to_rule_map_.find(rule_name);
+  return iter != name_to_rule_map_.end() &&
+      iter->second->SupportsIncrementalResults();
+}
+
+bool Engine::ComputeResultsInternal(
+    const PagespeedInput& pagespeed_input,
+    const ResultFilter& filter,
+    const Results* previous_results,
+    const std::set<std::string>* unchanged_resource_urls,
+    Results* results) const {
   CHECK(init_has_been_called_);
 
   if (!pagespeed_input.is_frozen()) {
@@ -105,31 +250,190 @@ bool Engine::ComputeResults(const PagespeedInput& pagespeed_input,
 
   RuleInput rule_input(pagespeed_input);
   rule_input.Init();
-  int num_results_so_far = 0;
-
-  bool success = true;
+  rule_input.set_unchanged_resource_urls(unchanged_resource_urls);
+
+  CancellationToken analysis_token(cancellation_token_);
+  SetDeadline(analysis_time_budget_, &analysis_token);
+
+  // Rules that only need a walk over the DOM share a single traversal of
+  // the DOM, so the (possibly expensive) DOM is only traversed once no
+  // matter how many such rules are registered.  When profiling, every rule
+  // runs on its own instead, so that its time can be measured.
+  const DomDocument* document =
+      profile_ == NULL ? pagespeed_input.dom_document() : NULL;
+  DomTraversal dom_traversal;
+  // Likewise, when streaming optimized content or releasing response
+  // bodies, the rules that consume response bodies and analyze each
+  // resource separately share a single pass over the resources.
+  const bool use_resource_pass =
+      (optimized_content_sink_ != NULL || response_body_releaser_ != NULL) &&
+      profile_ == NULL && previous_results == NULL;
+  ResponseBodyReleaser* const releaser =
+      use_resource_pass ? response_body_releaser_ : NULL;
+  const InputCapabilities response_body(InputCapabilities::RESPONSE_BODY);
+  std::vector<Rule*> rules;
+  std::vector<RuleResults*> rule_results_list;
+  std::vector<ResultProvider*> providers;
+  std::vector<DomTraversalVisitor*> dom_visitors;
+  std::vector<size_t> resource_pass_rules;
+  std::vector<bool> in_resource_pass;
+  // The other rules that consume response bodies, which must run before
+  // the pass when bodies are released during it.
+  std::vector<bool> runs_before_resource_pass;
   for (std::vector<Rule*>::const_iterator iter = rules_.begin(),
            end = rules_.end();
        iter != end;
        ++iter) {
     Rule* rule = *iter;
+    if (!filter.IsRuleAccepted(rule->name())) {
+      continue;
+    }
+    rules.push_back(rule);
     RuleResults* rule_results = results->add_rule_results();
     rule_results->set_rule_name(rule->name());
+    rule_results_list.push_back(rule_results);
+
+    // Result ids are assigned once all rules have run; see below.
+    ResultProvider* provider = new ResultProvider(*rule, rule_results, 0);
+    providers.push_back(provider);
+
+    DomTraversalVisitor* visitor = NULL;
+    if (document != NULL) {
+      visitor = rule->NewDomVisitor(rule_input, provider);
+      if (visitor != NULL) {
+        dom_traversal.AddVisitor(visitor);
+      }
+    }
+    dom_visitors.push_back(visitor);
+
+    const bool in_pass = visitor == NULL && use_resource_pass &&
+        rule->AnalyzesResourcesSeparately() &&
+        rule->capability_requirements().satisfies(response_body);
+    if (in_pass) {
+      resource_pass_rules.push_back(rules.size() - 1);
+    }
+    in_resource_pass.push_back(in_pass);
+    runs_before_resource_pass.push_back(
+        releaser != NULL && visitor == NULL && !in_pass &&
+        rule->capability_requirements().satisfies(response_body));
+  }
+
+  bool dom_traversal_cancelled = false;
+  if (!dom_traversal.empty()) {
+    CancellationToken traversal_token(&analysis_token);
+    SetDeadline(rule_time_budget_, &traversal_token);
+    dom_traversal.set_cancellation_token(&traversal_token);
+    dom_traversal.Traverse(*document);
+    dom_traversal_cancelled = traversal_token.IsCancelled();
+  }
+
+  // When releasing response bodies, every other rule that consumes them
+  // runs first, so that the resource pass is left as the only consumer.
+  std::vector<bool> rule_errors(rules.size(), false);
+  for (size_t i = 0; i < rules.size(); ++i) {
+    if (runs_before_resource_pass[i]) {
+      rule_errors[i] = analysis_token.IsCancelled() ||
+          !RunRule(rules[i], previous_results, rule_time_budget_,
+                   &analysis_token, &rule_input, providers[i]);
+    }
+  }
 
-    ResultProvider provider(*rule, rule_results, num_results_so_far);
-    const bool rule_success = rule->AppendResults(rule_input, &provider);
-    num_results_so_far += provider.num_new_results();
+  bool resource_pass_cancelled = false;
+  if (!resource_pass_rules.empty() || releaser != NULL) {
+    CancellationToken pass_token(&analysis_token);
+    SetDeadline(rule_time_budget_, &pass_token);
+    rule_input.set_cancellation_token(&pass_token);
+    for (int idx = 0, num = pagespeed_input.num_resources();
+         idx < num && !pass_token.IsCancelled();
+         ++idx) {
+      const Resource& resource = pagespeed_input.GetResource(idx);
+      // The rules in the pass that have yet to consume this body.
+      size_t pending_consumers = resource_pass_rules.size();
+      for (std::vector<size_t>::const_iterator it =
+               resource_pass_rules.begin(), end = resource_pass_rules.end();
+           it != end;
+           ++it) {
+        const size_t i = *it;
+        RuleResults* rule_results = rule_results_list[i];
+        const int first_result = rule_results->results_size();
+        if (!rules[i]->AppendResultsForResource(rule_input, resource,
+                                                providers[i])) {
+          rule_errors[i] = true;
+        }
+        --pending_consumers;
+        if (optimized_content_sink_ != NULL &&
+            !StreamOptimizedContent(optimized_content_sink_, rule_results,
+                                    first_result)) {
+          rule_errors[i] = true;
+        }
+      }
+      if (releaser != NULL && pending_consumers == 0 &&
+          !resource.GetResponseBody().empty()) {
+        releaser->Release(resource);
+      }
+    }
+    rule_input.set_cancellation_token(NULL);
+    resource_pass_cancelled = pass_token.IsCancelled();
+  }
+
+  bool success = true;
+  ProfileTimer timer(profile_, ProfileTimer::COMPUTE_RESULTS);
+  for (size_t i = 0; i < rules.size(); ++i) {
+    Rule* rule = rules[i];
+    bool rule_success = true;
+    if (dom_visitors[i] != NULL) {
+      // The results for this rule were generated during the DOM traversal.
+      rule_success = !dom_traversal_cancelled;
+    } else if (in_resource_pass[i]) {
+      // The results for this rule were generated during the resource pass.
+      rule_success = !resource_pass_cancelled && !rule_errors[i];
+    } else if (runs_before_resource_pass[i]) {
+      // The results for this rule were generated before the resource pass.
+      rule_success = !rule_errors[i];
+    } else if (analysis_token.IsCancelled()) {
+      rule_success = false;
+    } else {
+      rule_success = RunRule(rule, previous_results, rule_time_budget_,
+                             &analysis_token, &rule_input, providers[i]);
+    }
+    if (optimized_content_sink_ != NULL && !in_resource_pass[i] &&
+        !StreamOptimizedContent(optimized_content_sink_,
+                                rule_results_list[i], 0)) {
+      rule_success = false;
+    }
     if (!rule_success) {
       // Record that the rule encountered an error.
       results->add_error_rules(rule->name());
       success = false;
     }
+    if (timer.enabled()) {
+      timer.Record(rule->name())->set_num_results(
+          providers[i]->num_new_results());
+    }
+  }
+  STLDeleteContainerPointers(dom_visitors.begin(), dom_visitors.end());
+  STLDeleteContainerPointers(providers.begin(), providers.end());
+
+  // Assign result ids in rule order, exactly as if each rule had run to
+  // completion before the next one started.
+  int num_results_so_far = 0;
+  for (int rule_idx = 0; rule_idx < results->rule_results_size();
+       ++rule_idx) {
+    RuleResults* rule_results = results->mutable_rule_results(rule_idx);
+    for (int result_idx = 0; result_idx < rule_results->results_size();
+         ++result_idx) {
+      rule_results->mutable_results(result_idx)->set_id(num_results_so_far++);
+    }
   }
 
   if (!ComputeScoreAndImpact(results)) {
     success = false;
   }
 
+  if (profile_ != NULL) {
+    results->mutable_profile()->CopyFrom(*profile_);
+  }
+
   if (!results->IsInitialized()) {
     LOG(DFATAL) << "Failed to fully initialize results object.";
     return false;
@@ -149,6 +453,7 @@ bool Engine::FormatResults(const Results& results,
   }
 
   bool success = true;
+  ProfileTimer timer(profile_, ProfileTimer::FORMAT_RESULTS);
   for (int idx = 0, end = results.rule_results_size(); idx < end; ++idx) {
     const RuleResults& rule_results = results.rule_results(idx);
     if (!filter.IsRuleResultsAccepted(rule_results)) {
@@ -169,6 +474,9 @@ bool Engine::FormatResults(const Results& results,
     Rule* rule = rule_iter->second;
     FormatRuleResults(rule_results, results.input_info(), rule, filter,
                       formatter);
+    if (timer.enabled()) {
+      timer.Record(rule_name)->set_num_results(rule_results.results_size());
+    }
   }
 
   if (results.has_score()) {
@@ -185,7 +493,7 @@ bool Engine::ComputeAndFormatResults(const PagespeedInput& input,
   CHECK(init_has_been_called_);
 
   Results results;
-  bool success = ComputeResults(input, &results);
+  bool success = ComputeResults(input, filter, &results);
   success = FormatResults(results, filter, formatter) && success;
   return success;
 }
@@ -196,6 +504,7 @@ bool Engine::ComputeScoreAndImpact(Results* results) const {
   double total_impact = 0.0;
 
   bool success = true;
+  ProfileTimer timer(profile_, ProfileTimer::COMPUTE_SCORE_AND_IMPACT);
   for (int i = 0; i < results->rule_results_size(); ++i) {
     RuleResults* rule_results = results->mutable_rule_results(i);
     rule_results->clear_rule_impact();
@@ -227,6 +536,9 @@ bool Engine::ComputeScoreAndImpact(Results* results) const {
     if (!rule->IsExperimental()) {
       total_impact += impact;
     }
+    if (timer.enabled()) {
+      timer.Record(rule_name)->set_num_results(rule_results->results_size());
+    }
   }
 
   // Compute the overall score based on the impacts of the rules.
@@ -307,6 +619,10 @@ void Engine::FilterResults(const Results& results,
 ResultFilter::ResultFilter() {}
 ResultFilter::~ResultFilter() {}
 
+bool ResultFilter::IsRuleAccepted(const std::string&) const {
+  return true;
+}
+
 AlwaysAcceptResultFilter::AlwaysAcceptResultFilter() {}
 AlwaysAcceptResultFilter::~AlwaysAcceptResultFilter() {}
 
@@ -328,4 +644,9 @@ bool AndResultFilter::IsRuleResultsAccepted(const RuleResults& results) const {
       filter2_->IsRuleResultsAccepted(results);
 }
 
+bool AndResultFilter::IsRuleAccepted(const std::string& rule_name) const {
+  return filter1_->IsRuleAccepted(rule_name) &&
+      filter2_->IsRuleAccepted(rule_name);
+}
+
 }  // namespace pagespeed
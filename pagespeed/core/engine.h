@@ -21,17 +21,24 @@
 #define PAGESPEED_CORE_ENGINE_H_
 
 #include <map>
+#include <set>
 #include <string>
 #include <vector>
 
 #include "base/basictypes.h"
 #include "base/memory/scoped_ptr.h"
+#include "base/time.h"
 
 namespace pagespeed {
 
+class CancellationToken;
 class Formatter;
+class InputFingerprint;
 class InputInformation;
+class OptimizedContentSink;
 class PagespeedInput;
+class Profile;
+class ResponseBodyReleaser;
 class ResultText;
 class Results;
 class Result;
@@ -55,6 +62,14 @@ class ResultFilter {
   // IsResultAccepted(Result) to determine if they should be retained.
   virtual bool IsRuleResultsAccepted(const RuleResults& results) const = 0;
 
+  // Whether the results of the rule with the given name are wanted at
+  // all. Engine::ComputeAndFormatResults and the filtering overload of
+  // Engine::ComputeResults do not run rules for which this returns
+  // false, so a filter must only return false for rules whose
+  // RuleResults it would never accept. The default implementation
+  // returns true.
+  virtual bool IsRuleAccepted(const std::string& rule_name) const;
+
  private:
   DISALLOW_COPY_AND_ASSIGN(ResultFilter);
 };
@@ -82,6 +97,7 @@ class AndResultFilter : public ResultFilter {
 
   virtual bool IsResultAccepted(const Result& result) const;
   virtual bool IsRuleResultsAccepted(const RuleResults& results) const;
+  virtual bool IsRuleAccepted(const std::string& rule_name) const;
 
  private:
   scoped_ptr<ResultFilter> filter1_;
@@ -101,11 +117,103 @@ class Engine {
   // instantiating the engine.
   void Init();
 
+  // Enables profiling.  While profile is non-NULL, ComputeResults,
+  // ComputeScoreAndImpact and FormatResults append one ProfileEntry per
+  // rule to it, and ComputeResults copies it (including any input phases
+  // the caller recorded) into Results.profile.  So that each rule's time
+  // can be told apart, rules that normally share one DOM traversal each
+  // walk the DOM separately while profiling.  Ownership is not
+  // transferred; NULL (the default) disables profiling.  A profiling engine
+  // must not be used from several threads at once.
+  void set_profile(Profile* profile) { profile_ = profile; }
+
+  // Limits the wall time of each rule in ComputeResults.  A rule that
+  // overruns is asked to stop (see RuleInput::cancellation_token()) and is
+  // recorded in Results.error_rules, along with whatever results it added
+  // before stopping.  The rules that share a DOM traversal share one budget
+  // for it.  A zero TimeDelta (the default) means no limit.
+  void set_rule_time_budget(const base::TimeDelta& budget) {
+    rule_time_budget_ = budget;
+  }
+
+  // Limits the wall time of each call to ComputeResults.  Once the budget
+  // is spent, the rule in progress is asked to stop, and the rules that have
+  // not yet run are skipped; all of them are recorded in
+  // Results.error_rules.  A zero TimeDelta (the default) means no limit.
+  void set_analysis_time_budget(const base::TimeDelta& budget) {
+    analysis_time_budget_ = budget;
+  }
+
+  // Lets the caller stop ComputeResults, e.g. from another thread, by
+  // cancelling token; rules are then treated as if the analysis budget had
+  // been spent.  Ownership is not transferred; NULL (the default) disables
+  // external cancellation.
+  void set_cancellation_token(const CancellationToken* token) {
+    cancellation_token_ = token;
+  }
+
+  // Streams optimized content out of the results.  While sink is non-NULL,
+  // ComputeResults hands the optimized_content of each result to it as soon
+  // as the rule produces it, and clears it from the result unless the sink
+  // fails, so that the results do not hold the optimized version of every
+  // resource.  The rules that consume response bodies and analyze resources
+  // separately (see Rule::AnalyzesResourcesSeparately) then analyze the
+  // resources one at a time, all rules on one resource before the next, so
+  // that at most one optimized resource is held at any time; they share one
+  // rule time budget for it.  This is not done when profiling or computing
+  // incrementally.  Ownership is not transferred; NULL (the default) keeps
+  // the optimized content in the results.
+  void set_optimized_content_sink(OptimizedContentSink* sink) {
+    optimized_content_sink_ = sink;
+  }
+
+  // Releases response bodies during the analysis.  While releaser is
+  // non-NULL, ComputeResults first runs the rules that consume response
+  // bodies (per their InputCapabilities) but do not analyze resources
+  // separately, then the others in the resource pass described above,
+  // and hands each resource to releaser as soon as the last of them is
+  // done with its body.  Rules that do not declare RESPONSE_BODY must not
+  // read bodies.  Results are assigned ids in rule order as usual.  This
+  // is not done when profiling or computing incrementally.  Ownership is
+  // not transferred; NULL (the default) keeps every body for the whole
+  // analysis.
+  void set_response_body_releaser(ResponseBodyReleaser* releaser) {
+    response_body_releaser_ = releaser;
+  }
+
   // Compute and add results to the result set by querying rule
   // objects about results they produce.
   // @return true iff the computation was completed without errors.
   bool ComputeResults(const PagespeedInput& input, Results* results) const;
 
+  // Like ComputeResults above, but only runs the rules accepted by
+  // filter.IsRuleAccepted(). The rules that are not run get no
+  // RuleResults, so they do not count towards the score, and any DOM
+  // traversal needed only by them is skipped. filter is not otherwise
+  // applied to the results.
+  // @return true iff the computation was completed without errors.
+  bool ComputeResults(const PagespeedInput& input,
+                      const ResultFilter& filter,
+                      Results* results) const;
+
+  // Like ComputeResults above, but reuses the work of a previous analysis
+  // of a similar input.  previous_results must have been computed by an
+  // Engine with the same rules, from an input whose fingerprint (see
+  // input_fingerprint::ComputeInputFingerprint) is previous_fingerprint;
+  // fingerprint must be the fingerprint of input.  Rules that support
+  // incremental results (see Rule::SupportsIncrementalResults) copy their
+  // previous results for the resources whose digest did not change, and
+  // only analyze the others.  All other rules, rules that had errors in the
+  // previous analysis, and all rules if the previous analysis was made by a
+  // different version of Page Speed, are evaluated in full.  Impacts and
+  // the score are always recomputed.
+  // @return true iff the computation was completed without errors.
+  bool ComputeResultsIncrementally(const PagespeedInput& input,
+                                   const Results& previous_results,
+                                   const InputFingerprint& previous_fingerprint,
+                                   const InputFingerprint& fingerprint,
+                                   Results* results) const;
+
   // Generate a formatted representation of the results, such as
   // human-readable markup that will be displayed to a user.
   // @return true iff the formatting was completed without errors.
@@ -115,7 +223,8 @@ class Engine {
 
   // Compute the results and generate their formatted
   // representation. This is a convenience method that invokes both
-  // ComputeResults and FormatResults.
+  // ComputeResults and FormatResults. Only the rules accepted by
+  // filter.IsRuleAccepted() are run.
   // @return true iff the computation was completed without errors. if
   // false is returned, the formatter will only be invoked for those
   // results that did not generate errors.
@@ -135,6 +244,10 @@ class Engine {
     return ComputeAndFormatResults(input, filter, formatter);
   }
 
+  // Returns true if this engine has a rule with the given name, and that
+  // rule supports incremental results (see Rule::SupportsIncrementalResults).
+  bool RuleSupportsIncrementalResults(const std::string& rule_name) const;
+
   // Filters the results with the given filter into a second results proto,
   // and recomputing the impact for the filtered results.
   void FilterResults(const Results& results,
@@ -148,6 +261,16 @@ class Engine {
   // @return true iff the computation was completed without errors.
   bool ComputeScoreAndImpact(Results* results) const;
 
+  // Implements ComputeResults and ComputeResultsIncrementally.  If
+  // previous_results is non-NULL, the results of the resources in
+  // unchanged_resource_urls are reused where possible.
+  bool ComputeResultsInternal(
+      const PagespeedInput& input,
+      const ResultFilter& filter,
+      const Results* previous_results,
+      const std::set<std::string>* unchanged_resource_urls,
+      Results* results) const;
+
   void PopulateNameToRuleMap();
 
   typedef std::map<std::string, Rule*> NameToRuleMap;
@@ -155,6 +278,12 @@ class Engine {
   std::vector<Rule*> rules_;
   NameToRuleMap name_to_rule_map_;
   bool init_has_been_called_;
+  Profile* profile_;
+  base::TimeDelta rule_time_budget_;
+  base::TimeDelta analysis_time_budget_;
+  const CancellationToken* cancellation_token_;
+  OptimizedContentSink* optimized_content_sink_;
+  ResponseBodyReleaser* response_body_releaser_;
 
   DISALLOW_COPY_AND_ASSIGN(Engine);
 };
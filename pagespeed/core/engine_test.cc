@@ -15,11 +15,20 @@
 #include <string>
 #include <vector>
 
+#include "base/memory/scoped_ptr.h"
+#include "base/time.h"
+#include "pagespeed/core/cancellation.h"
+#include "pagespeed/core/dom.h"
 #include "pagespeed/core/engine.h"
+#include "pagespeed/core/input_fingerprint.h"
+#include "pagespeed/core/optimized_content_sink.h"
 #include "pagespeed/core/pagespeed_input.h"
+#include "pagespeed/core/resource.h"
+#include "pagespeed/core/response_body_releaser.h"
 #include "pagespeed/core/result_provider.h"
 #include "pagespeed/core/rule.h"
 #include "pagespeed/core/rule_input.h"
+#include "pagespeed/core/string_util.h"
 #include "pagespeed/formatters/proto_formatter.h"
 #include "pagespeed/l10n/l10n.h"
 #include "pagespeed/l10n/localizer.h"
@@ -28,14 +37,24 @@
 #include "pagespeed/testing/pagespeed_test.h"
 
 using pagespeed::AlwaysAcceptResultFilter;
+using pagespeed::CancellationToken;
+using pagespeed::DomDocument;
+using pagespeed::DomElement;
+using pagespeed::DomTraversalVisitor;
 using pagespeed::Engine;
 using pagespeed::FormatArgument;
 using pagespeed::Formatter;
+using pagespeed::InputFingerprint;
+using pagespeed::InputCapabilities;
 using pagespeed::InputInformation;
+using pagespeed::OptimizedContentSink;
 using pagespeed::UserFacingString;
 using pagespeed::FormattedResults;
 using pagespeed::FormattedRuleResults;
 using pagespeed::PagespeedInput;
+using pagespeed::Profile;
+using pagespeed::Resource;
+using pagespeed::ResponseBodyReleaser;
 using pagespeed::Result;
 using pagespeed::ResultProvider;
 using pagespeed::Results;
@@ -44,7 +63,10 @@ using pagespeed::RuleFormatter;
 using pagespeed::RuleInput;
 using pagespeed::RuleResults;
 using pagespeed::formatters::ProtoFormatter;
+using pagespeed::input_fingerprint::ComputeInputFingerprint;
 using pagespeed::l10n::NullLocalizer;
+using pagespeed_testing::FakeDomDocument;
+using pagespeed_testing::FakeDomElement;
 
 namespace {
 
@@ -123,6 +145,170 @@ class TestExperimentalRule : public TestRule {
   DISALLOW_COPY_AND_ASSIGN(TestExperimentalRule);
 };
 
+// A rule that adds one result and then runs until it is cancelled.
+class SlowRule : public TestRule {
+ public:
+  explicit SlowRule(const char* name) : TestRule(name) {}
+
+  virtual bool AppendResults(const RuleInput& input,
+                             ResultProvider* provider) {
+    provider->NewResult();
+    // Give up eventually, so that a broken budget fails the test rather
+    // than hanging it.
+    const base::TimeTicks give_up =
+        base::TimeTicks::Now() + base::TimeDelta::FromSeconds(10);
+    while (!input.IsCancelled()) {
+      if (base::TimeTicks::Now() >= give_up) {
+        ADD_FAILURE() << "Rule was never cancelled.";
+        break;
+      }
+    }
+    return true;
+  }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(SlowRule);
+};
+
+// Visitor for TestDomRule that adds a result for every IMG element.
+class ImgResultVisitor : public DomTraversalVisitor {
+ public:
+  explicit ImgResultVisitor(ResultProvider* provider)
+      : provider_(provider), num_images_(0) {}
+
+  virtual void Visit(const DomElement& node) {
+    if (node.GetTagName() == "IMG") {
+      ++num_images_;
+    }
+  }
+
+  virtual DomTraversalVisitor* VisitContentDocument(
+      const DomElement& node, const DomDocument& document) {
+    return new ImgResultVisitor(provider_);
+  }
+
+  virtual void Finish() {
+    for (int i = 0; i < num_images_; ++i) {
+      provider_->NewResult();
+    }
+  }
+
+ private:
+  ResultProvider* provider_;
+  int num_images_;
+
+  DISALLOW_COPY_AND_ASSIGN(ImgResultVisitor);
+};
+
+class TestDomRule : public TestRule {
+ public:
+  explicit TestDomRule(const char* name) : TestRule(name) {}
+
+  virtual bool AppendResults(const RuleInput& input,
+                             ResultProvider* provider) {
+    ++num_append_results_calls;
+    return AppendResultsFromDomVisitor(input, provider);
+  }
+
+  virtual DomTraversalVisitor* NewDomVisitor(const RuleInput& input,
+                                             ResultProvider* provider) {
+    return new ImgResultVisitor(provider);
+  }
+
+  static int num_append_results_calls;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(TestDomRule);
+};
+
+int TestDomRule::num_append_results_calls = 0;
+
+// A rule that must never be run.
+class NeverRunRule : public TestRule {
+ public:
+  explicit NeverRunRule(const char* name) : TestRule(name) {}
+
+  virtual bool AppendResults(const RuleInput& input,
+                             ResultProvider* provider) {
+    ADD_FAILURE() << "Rule " << name() << " was run.";
+    return false;
+  }
+
+  virtual DomTraversalVisitor* NewDomVisitor(const RuleInput& input,
+                                             ResultProvider* provider) {
+    ADD_FAILURE() << "Rule " << name() << " was run.";
+    return NULL;
+  }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(NeverRunRule);
+};
+
+// A rule that adds a result for every resource with a non-empty body, and
+// records which resources it analyzed.
+class PerResourceRule : public TestRule {
+ public:
+  PerResourceRule(const char* name, bool incremental)
+      : TestRule(name), incremental_(incremental) {}
+
+  virtual bool AppendResults(const RuleInput& input,
+                             ResultProvider* provider) {
+    const PagespeedInput& pagespeed_input = input.pagespeed_input();
+    for (int idx = 0, num = pagespeed_input.num_resources(); idx < num;
+         ++idx) {
+      const Resource& resource = pagespeed_input.GetResource(idx);
+      if (incremental_ && input.ReusePreviousResults(resource, provider)) {
+        continue;
+      }
+      analyzed_urls_.push_back(resource.GetRequestUrl());
+      if (!resource.GetResponseBody().empty()) {
+        Result* result = provider->NewResult();
+        result->add_resource_urls(resource.GetRequestUrl());
+        result->set_original_response_bytes(
+            resource.GetResponseBody().size());
+      }
+    }
+    return true;
+  }
+
+  virtual bool SupportsIncrementalResults() const { return incremental_; }
+
+  std::vector<std::string>* analyzed_urls() { return &analyzed_urls_; }
+
+ private:
+  const bool incremental_;
+  std::vector<std::string> analyzed_urls_;
+
+  DISALLOW_COPY_AND_ASSIGN(PerResourceRule);
+};
+
+void AddResource(const char* url, const char* body, PagespeedInput* input) {
+  Resource* resource = new Resource;
+  resource->SetRequestUrl(url);
+  resource->SetRequestMethod("GET");
+  resource->SetResponseStatusCode(200);
+  resource->SetResponseBody(body);
+  ASSERT_TRUE(input->AddResource(resource));
+}
+
+// Accepts the rules whose names do not start with "skip".
+class SkipRuleFilter : public pagespeed::ResultFilter {
+ public:
+  SkipRuleFilter() {}
+  virtual ~SkipRuleFilter() {}
+
+  virtual bool IsResultAccepted(const Result&) const { return true; }
+  virtual bool IsRuleResultsAccepted(const RuleResults& results) const {
+    return IsRuleAccepted(results.rule_name());
+  }
+  virtual bool IsRuleAccepted(const std::string& rule_name) const {
+    return rule_name.compare(0, 4, "skip") != 0;
+  }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(SkipRuleFilter);
+};
+
 TEST(EngineTest, ComputeResults) {
   PagespeedInput input;
   input.Freeze();
@@ -172,6 +358,52 @@ TEST(EngineTest, ComputeResultsError) {
   EXPECT_EQ(result.rule_name(), kRuleName);
 }
 
+TEST(EngineTest, RuleTimeBudget) {
+  PagespeedInput input;
+  input.Freeze();
+
+  std::vector<Rule*> rules;
+  rules.push_back(new SlowRule("slow"));
+  rules.push_back(new TestRule("fast"));
+
+  Engine engine(&rules);
+  engine.Init();
+  engine.set_rule_time_budget(base::TimeDelta::FromMilliseconds(1));
+  Results results;
+  ASSERT_FALSE(engine.ComputeResults(input, &results));
+  ASSERT_EQ(1, results.error_rules_size());
+  EXPECT_EQ("slow", results.error_rules(0));
+  ASSERT_EQ(2, results.rule_results_size());
+  // The results added before the budget ran out are kept.
+  EXPECT_EQ(1, results.rule_results(0).results_size());
+  // The budget is per rule, so the next rule still runs.
+  EXPECT_EQ(1, results.rule_results(1).results_size());
+}
+
+TEST(EngineTest, CancelledAnalysisSkipsRules) {
+  PagespeedInput input;
+  input.Freeze();
+
+  std::vector<Rule*> rules;
+  rules.push_back(new TestRule("rule1"));
+  rules.push_back(new TestRule("rule2"));
+
+  CancellationToken token;
+  token.Cancel();
+  Engine engine(&rules);
+  engine.Init();
+  engine.set_cancellation_token(&token);
+  Results results;
+  ASSERT_FALSE(engine.ComputeResults(input, &results));
+  ASSERT_EQ(2, results.error_rules_size());
+  EXPECT_EQ("rule1", results.error_rules(0));
+  EXPECT_EQ("rule2", results.error_rules(1));
+  ASSERT_EQ(2, results.rule_results_size());
+  EXPECT_EQ(0, results.rule_results(0).results_size());
+  EXPECT_EQ(0, results.rule_results(1).results_size());
+  ASSERT_TRUE(results.has_score());
+}
+
 TEST(EngineTest, ComputeImpacts) {
   PagespeedInput input;
   input.Freeze();
@@ -198,6 +430,65 @@ TEST(EngineTest, ComputeImpacts) {
   ASSERT_EQ(100, results.rule_results(3).rule_impact());
 }
 
+TEST(EngineTest, Profile) {
+  FakeDomDocument* document = FakeDomDocument::NewRoot("http://a.com/");
+  FakeDomElement* root = FakeDomElement::NewRoot(document, "html");
+  FakeDomElement::NewImg(root, "http://a.com/a.png");
+
+  PagespeedInput input;
+  input.AcquireDomDocument(document);
+  input.Freeze();
+
+  std::vector<Rule*> rules;
+  rules.push_back(new TestDomRule("rule1"));
+  rules.push_back(new TestRule("rule2"));
+
+  TestDomRule::num_append_results_calls = 0;
+  Engine engine(&rules);
+  engine.Init();
+  Profile profile;
+  profile.add_input_phases()->set_name("input");
+  engine.set_profile(&profile);
+  Results results;
+  ASSERT_TRUE(engine.ComputeResults(input, &results));
+
+  // While profiling, DOM rules run on their own so they can be timed.
+  EXPECT_EQ(1, TestDomRule::num_append_results_calls);
+  ASSERT_EQ(2, results.rule_results_size());
+  EXPECT_EQ(1, results.rule_results(0).results_size());
+  EXPECT_EQ(1, results.rule_results(1).results_size());
+
+  ASSERT_TRUE(results.has_profile());
+  const Profile& recorded = results.profile();
+  ASSERT_EQ(1, recorded.input_phases_size());
+  EXPECT_EQ("input", recorded.input_phases(0).name());
+  ASSERT_EQ(2, recorded.compute_results_size());
+  EXPECT_EQ("rule1", recorded.compute_results(0).name());
+  EXPECT_EQ(1, recorded.compute_results(0).num_results());
+  EXPECT_EQ("rule2", recorded.compute_results(1).name());
+  EXPECT_LE(0.0, recorded.compute_results(1).wall_time_ms());
+  ASSERT_EQ(2, recorded.compute_score_and_impact_size());
+  EXPECT_EQ("rule2", recorded.compute_score_and_impact(1).name());
+  EXPECT_EQ(0, recorded.format_results_size());
+  // No allocation counter is installed in this binary.
+  EXPECT_FALSE(recorded.compute_results(0).has_bytes_allocated());
+
+  FormattedResults formatted_results;
+  NullLocalizer localizer;
+  ProtoFormatter formatter(&localizer, &formatted_results);
+  ASSERT_TRUE(engine.FormatResults(results, &formatter));
+  ASSERT_EQ(2, profile.format_results_size());
+  EXPECT_EQ("rule1", profile.format_results(0).name());
+  EXPECT_EQ(1, profile.format_results(0).num_results());
+
+  // Without a profile, nothing is recorded.
+  engine.set_profile(NULL);
+  Results unprofiled_results;
+  ASSERT_TRUE(engine.ComputeResults(input, &unprofiled_results));
+  EXPECT_FALSE(unprofiled_results.has_profile());
+  EXPECT_EQ(2, profile.compute_results_size());
+}
+
 TEST(EngineTest, FormatResults) {
   PagespeedInput input;
   input.Freeze();
@@ -422,6 +713,427 @@ TEST(EngineTest, ResultIdAssignment) {
   EXPECT_EQ(2, results.rule_results(2).results(0).id());
 }
 
+TEST(EngineTest, FusedDomTraversal) {
+  FakeDomDocument* document = FakeDomDocument::NewRoot("http://a.com/");
+  FakeDomElement* root = FakeDomElement::NewRoot(document, "html");
+  FakeDomElement::NewImg(root, "http://a.com/a.png");
+  FakeDomElement* iframe = FakeDomElement::NewIframe(root);
+  FakeDomDocument* child = FakeDomDocument::New(iframe, "http://a.com/b");
+  FakeDomElement* child_root = FakeDomElement::NewRoot(child, "html");
+  FakeDomElement::NewImg(child_root, "http://a.com/b.png");
+
+  PagespeedInput input;
+  input.AcquireDomDocument(document);
+  input.Freeze();
+
+  std::vector<Rule*> rules;
+  rules.push_back(new TestDomRule("rule1"));
+  rules.push_back(new TestRule("rule2"));
+  rules.push_back(new TestDomRule("rule3"));
+
+  TestDomRule::num_append_results_calls = 0;
+  Engine engine(&rules);
+  engine.Init();
+  Results results;
+  ASSERT_TRUE(engine.ComputeResults(input, &results));
+
+  // The DOM rules are evaluated by the Engine's DOM traversal rather than
+  // by AppendResults().
+  ASSERT_EQ(0, TestDomRule::num_append_results_calls);
+
+  ASSERT_EQ(3, results.rule_results_size());
+  ASSERT_EQ(2, results.rule_results(0).results_size());
+  ASSERT_EQ(1, results.rule_results(1).results_size());
+  ASSERT_EQ(2, results.rule_results(2).results_size());
+
+  // Ids are assigned in rule order.
+  EXPECT_EQ(0, results.rule_results(0).results(0).id());
+  EXPECT_EQ(1, results.rule_results(0).results(1).id());
+  EXPECT_EQ(2, results.rule_results(1).results(0).id());
+  EXPECT_EQ(3, results.rule_results(2).results(0).id());
+  EXPECT_EQ(4, results.rule_results(2).results(1).id());
+}
+
+TEST(EngineTest, ComputeResultsSkipsRejectedRules) {
+  FakeDomDocument* document = FakeDomDocument::NewRoot("http://a.com/");
+  FakeDomElement* root = FakeDomElement::NewRoot(document, "html");
+  FakeDomElement::NewImg(root, "http://a.com/a.png");
+
+  PagespeedInput input;
+  input.AcquireDomDocument(document);
+  input.Freeze();
+
+  std::vector<Rule*> rules;
+  rules.push_back(new NeverRunRule("skip1"));
+  rules.push_back(new TestRule("rule2"));
+  rules.push_back(new NeverRunRule("skip3"));
+  rules.push_back(new TestDomRule("rule4"));
+
+  Engine engine(&rules);
+  engine.Init();
+  SkipRuleFilter filter;
+  Results results;
+  ASSERT_TRUE(engine.ComputeResults(input, filter, &results));
+
+  ASSERT_EQ(2, results.rule_results_size());
+  ASSERT_EQ("rule2", results.rule_results(0).rule_name());
+  ASSERT_EQ(1, results.rule_results(0).results_size());
+  ASSERT_EQ("rule4", results.rule_results(1).rule_name());
+  ASSERT_EQ(1, results.rule_results(1).results_size());
+  EXPECT_EQ(0, results.rule_results(0).results(0).id());
+  EXPECT_EQ(1, results.rule_results(1).results(0).id());
+  ASSERT_EQ(0, results.error_rules_size());
+}
+
+TEST(EngineTest, ComputeAndFormatResultsSkipsRejectedRules) {
+  PagespeedInput input;
+  input.Freeze();
+
+  std::vector<Rule*> rules;
+  rules.push_back(new TestRule("rule1"));
+  rules.push_back(new NeverRunRule("skip2"));
+
+  Engine engine(&rules);
+  engine.Init();
+  FormattedResults formatted_results;
+  NullLocalizer localizer;
+  ProtoFormatter formatter(&localizer, &formatted_results);
+  SkipRuleFilter filter;
+  ASSERT_TRUE(engine.ComputeAndFormatResults(input, filter, &formatter));
+
+  ASSERT_EQ(1, formatted_results.rule_results_size());
+  EXPECT_EQ("rule1", formatted_results.rule_results(0).rule_name());
+}
+
+class IncrementalEngineTest : public ::testing::Test {
+ protected:
+  virtual void SetUp() {
+    incremental_rule_ = new PerResourceRule("incremental", true);
+    full_rule_ = new PerResourceRule("full", false);
+    std::vector<Rule*> rules;
+    rules.push_back(incremental_rule_);
+    rules.push_back(full_rule_);
+    engine_.reset(new Engine(&rules));
+    engine_->Init();
+
+    AddResource("http://a.com/a", "a", &previous_input_);
+    AddResource("http://a.com/b", "b", &previous_input_);
+    AddResource("http://a.com/d", "", &previous_input_);
+    previous_input_.Freeze();
+    ComputeInputFingerprint(previous_input_, &previous_fingerprint_);
+    ASSERT_TRUE(engine_->ComputeResults(previous_input_, &previous_results_));
+
+    // b changes, c is new, and a and d are unchanged.
+    AddResource("http://a.com/a", "a", &input_);
+    AddResource("http://a.com/b", "bb", &input_);
+    AddResource("http://a.com/c", "c", &input_);
+    AddResource("http://a.com/d", "", &input_);
+    input_.Freeze();
+    ComputeInputFingerprint(input_, &fingerprint_);
+
+    incremental_rule_->analyzed_urls()->clear();
+    full_rule_->analyzed_urls()->clear();
+  }
+
+  // Owned by engine_.
+  PerResourceRule* incremental_rule_;
+  PerResourceRule* full_rule_;
+  scoped_ptr<Engine> engine_;
+  PagespeedInput previous_input_;
+  InputFingerprint previous_fingerprint_;
+  Results previous_results_;
+  PagespeedInput input_;
+  InputFingerprint fingerprint_;
+};
+
+TEST_F(IncrementalEngineTest, ReusesUnchangedResources) {
+  Results results;
+  ASSERT_TRUE(engine_->ComputeResultsIncrementally(
+      input_, previous_results_, previous_fingerprint_, fingerprint_,
+      &results));
+
+  ASSERT_EQ(2U, incremental_rule_->analyzed_urls()->size());
+  EXPECT_EQ("http://a.com/b", incremental_rule_->analyzed_urls()->at(0));
+  EXPECT_EQ("http://a.com/c", incremental_rule_->analyzed_urls()->at(1));
+  EXPECT_EQ(4U, full_rule_->analyzed_urls()->size());
+
+  // The results are the same as those of a full analysis.
+  Results expected;
+  ASSERT_TRUE(engine_->ComputeResults(input_, &expected));
+  EXPECT_EQ(expected.SerializeAsString(), results.SerializeAsString());
+  ASSERT_EQ(3, results.rule_results(0).results_size());
+  EXPECT_EQ(2, results.rule_results(0).results(1).original_response_bytes());
+}
+
+TEST_F(IncrementalEngineTest, PreviousErrorForcesFullEvaluation) {
+  previous_results_.add_error_rules("incremental");
+  Results results;
+  ASSERT_TRUE(engine_->ComputeResultsIncrementally(
+      input_, previous_results_, previous_fingerprint_, fingerprint_,
+      &results));
+  EXPECT_EQ(4U, incremental_rule_->analyzed_urls()->size());
+}
+
+TEST_F(IncrementalEngineTest, VersionChangeForcesFullEvaluation) {
+  previous_results_.mutable_version()->set_major(
+      previous_results_.version().major() + 1);
+  Results results;
+  ASSERT_TRUE(engine_->ComputeResultsIncrementally(
+      input_, previous_results_, previous_fingerprint_, fingerprint_,
+      &results));
+  EXPECT_EQ(4U, incremental_rule_->analyzed_urls()->size());
+}
+
+// A rule that analyzes each resource separately, suggesting an upper-cased
+// copy of every body. It logs each resource it analyzes to a log shared
+// with LoggingSink below.
+class UpperCaseRule : public Rule {
+ public:
+  UpperCaseRule(const char* name, uint32 capabilities,
+                std::vector<std::string>* log)
+      : Rule(InputCapabilities(capabilities)), name_(name), log_(log) {}
+
+  virtual const char* name() const { return name_; }
+
+  virtual UserFacingString header() const {
+    return not_localized(kHeader);
+  }
+
+  virtual bool AppendResults(const RuleInput& input,
+                             ResultProvider* provider) {
+    return AppendResultsForEachResource(input, provider);
+  }
+
+  virtual bool AnalyzesResourcesSeparately() const { return true; }
+
+  virtual bool AppendResultsForResource(const RuleInput& input,
+                                        const Resource& resource,
+                                        ResultProvider* provider) {
+    log_->push_back(std::string(name_) + " " + resource.GetRequestUrl());
+    std::string content = resource.GetResponseBody();
+    pagespeed::string_util::StringToUpperASCII(&content);
+    Result* result = provider->NewResult();
+    result->add_resource_urls(resource.GetRequestUrl());
+    result->set_optimized_content(content);
+    result->set_optimized_content_mime_type("text/plain");
+    return true;
+  }
+
+  virtual void FormatResults(const pagespeed::ResultVector& results,
+                             RuleFormatter* formatter) {}
+
+ private:
+  const char* name_;
+  std::vector<std::string>* log_;
+
+  DISALLOW_COPY_AND_ASSIGN(UpperCaseRule);
+};
+
+// Logs the optimized content it is given, and fails if so configured.
+class LoggingSink : public OptimizedContentSink {
+ public:
+  explicit LoggingSink(std::vector<std::string>* log)
+      : log_(log), success_(true) {}
+
+  virtual bool Write(const std::string& rule_name, Result* result) {
+    log_->push_back("sink " + rule_name + " " + result->optimized_content());
+    return success_;
+  }
+
+  void set_success(bool success) { success_ = success; }
+
+ private:
+  std::vector<std::string>* log_;
+  bool success_;
+
+  DISALLOW_COPY_AND_ASSIGN(LoggingSink);
+};
+
+class OptimizedContentSinkTest : public ::testing::Test {
+ protected:
+  virtual void SetUp() {
+    std::vector<Rule*> rules;
+    rules.push_back(
+        new UpperCaseRule("a", InputCapabilities::RESPONSE_BODY, &log_));
+    rules.push_back(
+        new UpperCaseRule("b", InputCapabilities::RESPONSE_BODY, &log_));
+    // Does not consume response bodies, so is run on its own.
+    rules.push_back(new UpperCaseRule("c", InputCapabilities::NONE, &log_));
+    engine_.reset(new Engine(&rules));
+    engine_->Init();
+
+    AddResource("http://a.com/1", "one", &input_);
+    AddResource("http://a.com/2", "two", &input_);
+    input_.Freeze();
+  }
+
+  std::vector<std::string> log_;
+  scoped_ptr<Engine> engine_;
+  PagespeedInput input_;
+};
+
+TEST_F(OptimizedContentSinkTest, NoSink) {
+  Results results;
+  ASSERT_TRUE(engine_->ComputeResults(input_, &results));
+  ASSERT_EQ(6U, log_.size());
+  EXPECT_EQ("a http://a.com/1", log_[0]);
+  EXPECT_EQ("a http://a.com/2", log_[1]);
+  EXPECT_EQ("b http://a.com/1", log_[2]);
+  EXPECT_EQ("b http://a.com/2", log_[3]);
+  ASSERT_EQ(3, results.rule_results_size());
+  EXPECT_EQ("ONE", results.rule_results(0).results(0).optimized_content());
+}
+
+TEST_F(OptimizedContentSinkTest, StreamsOneResourceAtATime) {
+  Results expected;
+  ASSERT_TRUE(engine_->ComputeResults(input_, &expected));
+  log_.clear();
+
+  LoggingSink sink(&log_);
+  engine_->set_optimized_content_sink(&sink);
+  Results results;
+  ASSERT_TRUE(engine_->ComputeResults(input_, &results));
+
+  // a and b analyze each resource in turn, and the sink gets the content
+  // right away.
+  ASSERT_EQ(12U, log_.size());
+  EXPECT_EQ("a http://a.com/1", log_[0]);
+  EXPECT_EQ("sink a ONE", log_[1]);
+  EXPECT_EQ("b http://a.com/1", log_[2]);
+  EXPECT_EQ("sink b ONE", log_[3]);
+  EXPECT_EQ("a http://a.com/2", log_[4]);
+  EXPECT_EQ("sink a TWO", log_[5]);
+  EXPECT_EQ("b http://a.com/2", log_[6]);
+  EXPECT_EQ("sink b TWO", log_[7]);
+  EXPECT_EQ("c http://a.com/1", log_[8]);
+  EXPECT_EQ("c http://a.com/2", log_[9]);
+  EXPECT_EQ("sink c ONE", log_[10]);
+  EXPECT_EQ("sink c TWO", log_[11]);
+
+  // The results are otherwise the same.
+  for (int rule_idx = 0; rule_idx < expected.rule_results_size();
+       ++rule_idx) {
+    RuleResults* rule_results = expected.mutable_rule_results(rule_idx);
+    for (int idx = 0; idx < rule_results->results_size(); ++idx) {
+      rule_results->mutable_results(idx)->clear_optimized_content();
+    }
+  }
+  EXPECT_EQ(expected.SerializeAsString(), results.SerializeAsString());
+}
+
+TEST_F(OptimizedContentSinkTest, SinkFailure) {
+  LoggingSink sink(&log_);
+  sink.set_success(false);
+  engine_->set_optimized_content_sink(&sink);
+  Results results;
+  ASSERT_FALSE(engine_->ComputeResults(input_, &results));
+  ASSERT_EQ(3, results.error_rules_size());
+  EXPECT_EQ("a", results.error_rules(0));
+  EXPECT_EQ("b", results.error_rules(1));
+  EXPECT_EQ("c", results.error_rules(2));
+  // The content the sink failed to take is kept in the results.
+  EXPECT_EQ("ONE", results.rule_results(0).results(0).optimized_content());
+}
+
+// A rule that consumes response bodies all at once, logging the size of
+// each body it reads.
+class BodySizeRule : public Rule {
+ public:
+  explicit BodySizeRule(std::vector<std::string>* log)
+      : Rule(InputCapabilities(InputCapabilities::RESPONSE_BODY)),
+        log_(log) {}
+
+  virtual const char* name() const { return "d"; }
+
+  virtual UserFacingString header() const {
+    return not_localized(kHeader);
+  }
+
+  virtual bool AppendResults(const RuleInput& input,
+                             ResultProvider* provider) {
+    const PagespeedInput& pagespeed_input = input.pagespeed_input();
+    for (int idx = 0; idx < pagespeed_input.num_resources(); ++idx) {
+      const Resource& resource = pagespeed_input.GetResource(idx);
+      log_->push_back(pagespeed::string_util::StringPrintf(
+          "d %s %d", resource.GetRequestUrl().c_str(),
+          static_cast<int>(resource.GetResponseBody().size())));
+    }
+    return true;
+  }
+
+  virtual void FormatResults(const pagespeed::ResultVector& results,
+                             RuleFormatter* formatter) {}
+
+ private:
+  std::vector<std::string>* log_;
+
+  DISALLOW_COPY_AND_ASSIGN(BodySizeRule);
+};
+
+// Logs each resource it is given, and releases its body.
+class LoggingReleaser : public ResponseBodyReleaser {
+ public:
+  LoggingReleaser(PagespeedInput* input, std::vector<std::string>* log)
+      : input_(input), log_(log) {}
+
+  virtual void Release(const Resource& resource) {
+    log_->push_back("release " + resource.GetRequestUrl());
+    input_->ReleaseResponseBody(resource);
+  }
+
+ private:
+  PagespeedInput* input_;
+  std::vector<std::string>* log_;
+
+  DISALLOW_COPY_AND_ASSIGN(LoggingReleaser);
+};
+
+TEST(EngineTest, ReleasesBodiesAfterLastConsumer) {
+  std::vector<std::string> log;
+  std::vector<Rule*> rules;
+  rules.push_back(
+      new UpperCaseRule("a", InputCapabilities::RESPONSE_BODY, &log));
+  rules.push_back(new BodySizeRule(&log));
+  rules.push_back(
+      new UpperCaseRule("b", InputCapabilities::RESPONSE_BODY, &log));
+  Engine engine(&rules);
+  engine.Init();
+
+  PagespeedInput input;
+  AddResource("http://a.com/1", "one", &input);
+  AddResource("http://a.com/2", "three", &input);
+  input.Freeze();
+
+  LoggingReleaser releaser(&input, &log);
+  engine.set_response_body_releaser(&releaser);
+  Results results;
+  ASSERT_TRUE(engine.ComputeResults(input, &results));
+
+  // d reads every body before the resource pass, and each body is released
+  // as soon as both a and b have analyzed it.
+  ASSERT_EQ(8U, log.size());
+  EXPECT_EQ("d http://a.com/1 3", log[0]);
+  EXPECT_EQ("d http://a.com/2 5", log[1]);
+  EXPECT_EQ("a http://a.com/1", log[2]);
+  EXPECT_EQ("b http://a.com/1", log[3]);
+  EXPECT_EQ("release http://a.com/1", log[4]);
+  EXPECT_EQ("a http://a.com/2", log[5]);
+  EXPECT_EQ("b http://a.com/2", log[6]);
+  EXPECT_EQ("release http://a.com/2", log[7]);
+  EXPECT_TRUE(input.GetResource(0).GetResponseBody().empty());
+  EXPECT_TRUE(input.GetResource(1).GetResponseBody().empty());
+
+  // The results are kept in rule order, with the content the bodies had.
+  ASSERT_EQ(3, results.rule_results_size());
+  EXPECT_EQ("a", results.rule_results(0).rule_name());
+  EXPECT_EQ("d", results.rule_results(1).rule_name());
+  EXPECT_EQ("b", results.rule_results(2).rule_name());
+  EXPECT_EQ("THREE",
+            results.rule_results(2).results(1).optimized_content());
+  EXPECT_EQ(0, results.rule_results(0).results(0).id());
+  EXPECT_EQ(2, results.rule_results(2).results(0).id());
+}
+
 TEST(EngineTest, ComputeScoreOneExperimentalRule) {
   PagespeedInput input;
   input.Freeze();
@@ -0,0 +1,88 @@
+// Copyright 2013 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pagespeed/core/input_fingerprint.h"
+
+#include "base/logging.h"
+#include "base/md5.h"
+#include "base/string_number_conversions.h"
+#include "pagespeed/core/pagespeed_input.h"
+#include "pagespeed/core/resource.h"
+#include "pagespeed/proto/pagespeed_output.pb.h"
+
+namespace {
+
+// Adds value to the digest, prefixed with its length so that the
+// boundaries between consecutive fields are unambiguous.
+void UpdateField(const std::string& value, base::MD5Context* context) {
+  base::MD5Update(context, base::IntToString(value.size()) + ":");
+  base::MD5Update(context, value);
+}
+
+void UpdateHeaders(const pagespeed::Resource::HeaderMap& headers,
+                   base::MD5Context* context) {
+  UpdateField(base::IntToString(headers.size()), context);
+  for (pagespeed::Resource::HeaderMap::const_iterator it = headers.begin(),
+           end = headers.end();
+       it != end;
+       ++it) {
+    UpdateField(it->first, context);
+    UpdateField(it->second, context);
+  }
+}
+
+}  // namespace
+
+namespace pagespeed {
+
+namespace input_fingerprint {
+
+std::string ComputeResourceDigest(const Resource& resource) {
+  base::MD5Context context;
+  base::MD5Init(&context);
+  UpdateField(resource.GetRequestUrl(), &context);
+  UpdateField(resource.GetRequestMethod(), &context);
+  UpdateHeaders(*resource.GetRequestHeaders(), &context);
+  UpdateField(resource.GetRequestBody(), &context);
+  UpdateField(resource.GetCookies(), &context);
+  UpdateField(base::IntToString(resource.GetResponseStatusCode()), &context);
+  UpdateField(resource.GetResponseProtocolString(), &context);
+  UpdateHeaders(*resource.GetResponseHeaders(), &context);
+  UpdateField(resource.GetResponseBody(), &context);
+  UpdateField(resource.IsResponseBodyModified() ? "1" : "0", &context);
+  UpdateField(base::IntToString(resource.GetResourceType()), &context);
+
+  base::MD5Digest digest;
+  base::MD5Final(&digest, &context);
+  return base::MD5DigestToBase16(digest);
+}
+
+void ComputeInputFingerprint(const PagespeedInput& input,
+                             InputFingerprint* fingerprint) {
+  if (!input.is_frozen()) {
+    LOG(DFATAL) << "Attempting to fingerprint non-frozen input.";
+    return;
+  }
+  fingerprint->Clear();
+  for (int idx = 0, num = input.num_resources(); idx < num; ++idx) {
+    const Resource& resource = input.GetResource(idx);
+    ResourceFingerprint* resource_fingerprint = fingerprint->add_resources();
+    resource_fingerprint->set_url(resource.GetRequestUrl());
+    resource_fingerprint->set_digest(ComputeResourceDigest(resource));
+  }
+}
+
+}  // namespace input_fingerprint
+
+}  // namespace pagespeed
@@ -0,0 +1,42 @@
+// Copyright 2013 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PAGESPEED_CORE_INPUT_FINGERPRINT_H_
+#define PAGESPEED_CORE_INPUT_FINGERPRINT_H_
+
+#include <string>
+
+namespace pagespeed {
+
+class InputFingerprint;
+class PagespeedInput;
+class Resource;
+
+namespace input_fingerprint {
+
+// Compute the hex MD5 digest of everything rules may look at in the given
+// resource (but not its timing). Two resources with the same digest are
+// indistinguishable to rules that only look at one resource at a time.
+std::string ComputeResourceDigest(const Resource& resource);
+
+// Populate fingerprint with the digest of each resource of the given input,
+// in input order. The input must be frozen.
+void ComputeInputFingerprint(const PagespeedInput& input,
+                             InputFingerprint* fingerprint);
+
+}  // namespace input_fingerprint
+
+}  // namespace pagespeed
+
+#endif  // PAGESPEED_CORE_INPUT_FINGERPRINT_H_
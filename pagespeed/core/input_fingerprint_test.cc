@@ -0,0 +1,79 @@
+// Copyright 2013 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+
+#include "pagespeed/core/input_fingerprint.h"
+#include "pagespeed/core/resource.h"
+#include "pagespeed/proto/pagespeed_output.pb.h"
+#include "pagespeed/testing/pagespeed_test.h"
+
+using pagespeed::InputFingerprint;
+using pagespeed::Resource;
+using pagespeed::input_fingerprint::ComputeInputFingerprint;
+using pagespeed::input_fingerprint::ComputeResourceDigest;
+
+namespace {
+
+class InputFingerprintTest : public ::pagespeed_testing::PagespeedTest {};
+
+TEST_F(InputFingerprintTest, ResourceDigest) {
+  Resource* resource = NewScriptResource(kUrl1, NULL, NULL);
+  resource->SetResponseBody("var a = 1;");
+  const std::string digest = ComputeResourceDigest(*resource);
+  EXPECT_EQ(32U, digest.size());
+  EXPECT_EQ(digest, ComputeResourceDigest(*resource));
+
+  resource->SetResponseBody("var a = 2;");
+  const std::string body_digest = ComputeResourceDigest(*resource);
+  EXPECT_NE(digest, body_digest);
+
+  resource->AddResponseHeader("Cache-Control", "max-age=3600");
+  const std::string header_digest = ComputeResourceDigest(*resource);
+  EXPECT_NE(body_digest, header_digest);
+
+  resource->SetResponseBodyModified(true);
+  EXPECT_NE(header_digest, ComputeResourceDigest(*resource));
+}
+
+TEST(InputFingerprintFieldsTest, FieldBoundaries) {
+  // Moving bytes from one field to the next must change the digest.
+  Resource r1;
+  r1.SetRequestUrl("http://www.example.com/");
+  r1.AddResponseHeader("X-Test", "ab");
+  r1.SetResponseBody("c");
+  Resource r2;
+  r2.SetRequestUrl("http://www.example.com/");
+  r2.AddResponseHeader("X-Test", "a");
+  r2.SetResponseBody("bc");
+  EXPECT_NE(ComputeResourceDigest(r1), ComputeResourceDigest(r2));
+}
+
+TEST_F(InputFingerprintTest, InputFingerprint) {
+  NewScriptResource(kUrl1, NULL, NULL)->SetResponseBody("var a = 1;");
+  NewCssResource(kUrl2, NULL, NULL)->SetResponseBody("a { color: red }");
+  Freeze();
+
+  InputFingerprint fingerprint;
+  ComputeInputFingerprint(*pagespeed_input(), &fingerprint);
+  ASSERT_EQ(2, fingerprint.resources_size());
+  for (int idx = 0; idx < 2; ++idx) {
+    const Resource& resource = pagespeed_input()->GetResource(idx);
+    EXPECT_EQ(resource.GetRequestUrl(), fingerprint.resources(idx).url());
+    EXPECT_EQ(ComputeResourceDigest(resource),
+              fingerprint.resources(idx).digest());
+  }
+}
+
+}  // namespace
@@ -13,6 +13,8 @@
 // limitations under the License.
 
 #include "pagespeed/core/instrumentation_data.h"
+
+#include "pagespeed/core/cancellation.h"
 #include "pagespeed/proto/timeline.pb.h"
 
 namespace pagespeed {
@@ -24,30 +26,47 @@ InstrumentationDataVisitor::~InstrumentationDataVisitor() {}
 void InstrumentationDataVisitor::Traverse(
     InstrumentationDataVisitor* visitor,
     const InstrumentationDataStack& data) {
+  Traverse(visitor, data, NULL);
+}
+
+// static
+void InstrumentationDataVisitor::Traverse(
+    InstrumentationDataVisitor* visitor,
+    const InstrumentationDataStack& data,
+    const CancellationToken* cancel) {
+  CancellationPoller poller(cancel);
+  InstrumentationDataStack stack;
   for (InstrumentationDataStack::const_iterator
            it = data.begin(), end = data.end(); it != end; ++it) {
-    Traverse(visitor, **it);
+    stack.push_back(*it);
+    TraverseImpl(visitor, &stack, &poller);
+    stack.pop_back();
   }
 }
 
 // static
 void InstrumentationDataVisitor::Traverse(InstrumentationDataVisitor* visitor,
                                           const InstrumentationData& data) {
+  CancellationPoller poller(NULL);
   InstrumentationDataStack stack;
   stack.push_back(&data);
-  TraverseImpl(visitor, &stack);
+  TraverseImpl(visitor, &stack, &poller);
   stack.pop_back();
 }
 
 // static
 void InstrumentationDataVisitor::TraverseImpl(
     InstrumentationDataVisitor* visitor,
-    InstrumentationDataStack* stack) {
+    InstrumentationDataStack* stack,
+    CancellationPoller* poller) {
+  if (poller->IsCancelled()) {
+    return;
+  }
   const InstrumentationData& data = *stack->back();
   if (visitor->Visit(*stack)) {
     for (int i = 0; i < data.children_size(); ++i) {
       stack->push_back(&data.children(i));
-      TraverseImpl(visitor, stack);
+      TraverseImpl(visitor, stack, poller);
       stack->pop_back();
     }
   }
@@ -21,6 +21,8 @@
 
 namespace pagespeed {
 
+class CancellationPoller;
+class CancellationToken;
 class InstrumentationData;
 
 typedef std::vector<const InstrumentationData*> InstrumentationDataVector;
@@ -38,6 +40,12 @@ class InstrumentationDataVisitor {
   static void Traverse(InstrumentationDataVisitor* visitor,
                        const InstrumentationData& data);
 
+  // As above, but stops visiting nodes once cancel is cancelled.  cancel
+  // may be NULL.
+  static void Traverse(InstrumentationDataVisitor* visitor,
+                       const InstrumentationDataStack& data,
+                       const CancellationToken* cancel);
+
   // Invoked for each node in the InstrumentationData instances,
   // visited in pre-order. The stack parameter contains the stack of
   // nodes being visited, with the rootmost node at index 0. Return 0
@@ -47,7 +55,8 @@ class InstrumentationDataVisitor {
 
  private:
   static void TraverseImpl(InstrumentationDataVisitor* visitor,
-                           InstrumentationDataStack* stack);
+                           InstrumentationDataStack* stack,
+                           CancellationPoller* poller);
 
   DISALLOW_COPY_AND_ASSIGN(InstrumentationDataVisitor);
 };
@@ -0,0 +1,48 @@
+// Copyright 2013 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PAGESPEED_CORE_OPTIMIZED_CONTENT_SINK_H_
+#define PAGESPEED_CORE_OPTIMIZED_CONTENT_SINK_H_
+
+#include <string>
+
+#include "base/basictypes.h"
+
+namespace pagespeed {
+
+class Result;
+
+// Receives the optimized content of results as soon as the rules produce
+// it, so that it does not accumulate in the Results (see
+// Engine::set_optimized_content_sink).
+class OptimizedContentSink {
+ public:
+  OptimizedContentSink();
+  virtual ~OptimizedContentSink();
+
+  // Called with each result that has optimized_content, right after the
+  // rule named rule_name produced it. The id of result is not final yet.
+  // The sink may record in result where it put the content; the Engine
+  // then clears result's optimized_content. Returns false on error, in
+  // which case the content is left in result and the rule is recorded in
+  // Results.error_rules.
+  virtual bool Write(const std::string& rule_name, Result* result) = 0;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(OptimizedContentSink);
+};
+
+}  // namespace pagespeed
+
+#endif  // PAGESPEED_CORE_OPTIMIZED_CONTENT_SINK_H_
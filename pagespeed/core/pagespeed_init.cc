@@ -17,6 +17,7 @@
 #include "googleurl/src/url_util.h"
 #include "net/instaweb/htmlparse/public/html_keywords.h"
 #include "pagespeed/core/cpu_compatibility.h"
+#include "pagespeed/l10n/gettext_localizer.h"
 #include "pagespeed/l10n/register_locale.h"
 #include "third_party/domain_registry_provider/src/domain_registry/domain_registry.h"
 
@@ -30,11 +31,13 @@ bool Init() {
   url_util::Initialize();
   net_instaweb::HtmlKeywords::Init();
   l10n::RegisterLocale::Freeze();
+  l10n::GettextLocalizer::InitSharedLocalizers();
   InitializeDomainRegistry();
   return true;
 }
 
 void ShutDown() {
+  l10n::GettextLocalizer::ShutDownSharedLocalizers();
   net_instaweb::HtmlKeywords::ShutDown();
   url_util::Shutdown();
 }
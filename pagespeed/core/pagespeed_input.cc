@@ -16,12 +16,14 @@
 
 #include <algorithm>
 #include <map>
+#include <vector>
 
 #include "base/logging.h"
 #include "base/stl_util.h"
 #include "pagespeed/core/browsing_context.h"
 #include "pagespeed/core/dom.h"
 #include "pagespeed/core/image_attributes.h"
+#include "pagespeed/core/parallel_for.h"
 #include "pagespeed/core/resource.h"
 #include "pagespeed/core/resource_util.h"
 #include "pagespeed/core/string_util.h"
@@ -43,6 +45,49 @@ struct ResourceRequestStartTimeLessThan {
   }
 };
 
+// Estimating sizes parses each resource's URL and headers, which takes a
+// few microseconds, so only use worker threads for large inputs.
+const int kParallelSizesMinResources = 1024;
+const int kMaxSizesThreads = 4;
+
+// The per-resource facts that PopulateInputInformation sums up.
+struct ResourceSizes {
+  ResourceSizes()
+      : request_bytes(0), response_bytes(0), type(OTHER),
+        is_likely_static(false) {}
+
+  int request_bytes;
+  int response_bytes;
+  ResourceType type;
+  bool is_likely_static;
+};
+
+// Computes the ResourceSizes of a range of resources into a preallocated
+// vector.  Each index is written by exactly one thread.
+class ComputeResourceSizesTask : public ParallelForTask {
+ public:
+  ComputeResourceSizesTask(const ResourceCollection& resources,
+                           std::vector<ResourceSizes>* sizes)
+      : resources_(resources), sizes_(sizes) {}
+
+  virtual void Run(int begin, int end) {
+    for (int idx = begin; idx < end; ++idx) {
+      const Resource& resource = resources_.GetResource(idx);
+      ResourceSizes* sizes = &(*sizes_)[idx];
+      sizes->request_bytes = resource_util::EstimateRequestBytes(resource);
+      sizes->response_bytes = resource_util::EstimateResponseBytes(resource);
+      sizes->type = resource.GetResourceType();
+      sizes->is_likely_static = resource_util::IsLikelyStaticResource(resource);
+    }
+  }
+
+ private:
+  const ResourceCollection& resources_;
+  std::vector<ResourceSizes>* sizes_;
+
+  DISALLOW_COPY_AND_ASSIGN(ComputeResourceSizesTask);
+};
+
 }  // namespace
 
 PagespeedInput::PagespeedInput()
@@ -203,15 +248,22 @@ bool PagespeedInput::Freeze(
 }
 
 void PagespeedInput::PopulateInputInformation() {
-  for (int idx = 0, num = num_resources(); idx < num; ++idx) {
-    const Resource& resource = GetResource(idx);
+  const int num = num_resources();
+  std::vector<ResourceSizes> sizes(num);
+  ComputeResourceSizesTask task(resources_, &sizes);
+  ParallelFor(&task, num,
+              num >= kParallelSizesMinResources ? kMaxSizesThreads : 1);
+
+  // Accumulate in resource order, exactly as a serial loop would.
+  for (int idx = 0; idx < num; ++idx) {
+    const ResourceSizes& resource_sizes = sizes[idx];
 
     // Update input information
-    int request_bytes = resource_util::EstimateRequestBytes(resource);
+    int request_bytes = resource_sizes.request_bytes;
     input_info_->set_total_request_bytes(
         input_info_->total_request_bytes() + request_bytes);
-    int response_bytes = resource_util::EstimateResponseBytes(resource);
-    switch (resource.GetResourceType()) {
+    int response_bytes = resource_sizes.response_bytes;
+    switch (resource_sizes.type) {
       case HTML:
         input_info_->set_html_response_bytes(
             input_info_->html_response_bytes() + response_bytes);
@@ -258,14 +310,14 @@ void PagespeedInput::PopulateInputInformation() {
             input_info_->binary_data_response_bytes() + response_bytes);
         break;
       default:
-        LOG(DFATAL) << "Unknown resource type " << resource.GetResourceType();
+        LOG(DFATAL) << "Unknown resource type " << resource_sizes.type;
         input_info_->set_other_response_bytes(
             input_info_->other_response_bytes() + response_bytes);
         break;
     }
-    input_info_->set_number_resources(num_resources());
+    input_info_->set_number_resources(num);
     input_info_->set_number_hosts(GetHostResourceMap()->size());
-    if (resource_util::IsLikelyStaticResource(resource)) {
+    if (resource_sizes.is_likely_static) {
       input_info_->set_number_static_resources(
           input_info_->number_static_resources() + 1);
     }
@@ -525,6 +577,10 @@ Resource* PagespeedInput::GetMutableResourceWithUrlOrNull(
   return resources_.GetMutableResourceWithUrlOrNull(url);
 }
 
+bool PagespeedInput::ReleaseResponseBody(const Resource& resource) {
+  return resources_.ReleaseResponseBody(resource);
+}
+
 InputCapabilities PagespeedInput::EstimateCapabilities() const {
   InputCapabilities capabilities;
   if (!is_frozen()) {
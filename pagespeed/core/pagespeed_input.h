@@ -148,6 +148,12 @@ class PagespeedInput {
   Resource* GetMutableResource(int idx);
   Resource* GetMutableResourceWithUrlOrNull(const std::string& url);
 
+  // Frees the response body of one of our resources, e.g. once an
+  // Engine no longer needs it (see ResponseBodyReleaser). Unlike other
+  // modifications, this is allowed once frozen. Returns false if the
+  // resource is not part of this PagespeedInput.
+  bool ReleaseResponseBody(const Resource& resource);
+
   ImageAttributes* NewImageAttributes(const Resource* resource) const;
 
   const TopLevelBrowsingContext* GetTopLevelBrowsingContext() const;
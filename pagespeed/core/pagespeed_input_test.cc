@@ -18,6 +18,9 @@
 #include "pagespeed/core/pagespeed_input.h"
 #include "pagespeed/core/resource.h"
 #include "pagespeed/core/resource_filter.h"
+#include "pagespeed/core/resource_util.h"
+#include "pagespeed/core/string_util.h"
+#include "pagespeed/proto/pagespeed_output.pb.h"
 #include "pagespeed/proto/timeline.pb.h"
 #include "pagespeed/testing/instrumentation_data_builder.h"
 #include "pagespeed/testing/pagespeed_test.h"
@@ -129,6 +132,71 @@ TEST(PagespeedInputTest, FreezeParticipant) {
   input.Freeze(&participant);
 }
 
+TEST(PagespeedInputTest, ReleaseResponseBody) {
+  PagespeedInput input;
+  Resource* resource = NewResource(kURL1, 200);
+  resource->SetResponseBody("body");
+  ASSERT_TRUE(input.AddResource(resource));
+  ASSERT_TRUE(input.Freeze());
+  const uint64 hash =
+      input.GetResourceCollection().GetResponseBodyHash(*resource);
+
+  // Releasing is allowed once frozen, and keeps what Freeze() derived
+  // from the body.
+  ASSERT_TRUE(input.ReleaseResponseBody(*resource));
+  EXPECT_TRUE(input.GetResource(0).GetResponseBody().empty());
+  EXPECT_EQ(hash, input.GetResourceCollection().GetResponseBodyHash(*resource));
+
+  Resource other;
+  other.SetRequestUrl(kURL1);
+#ifdef NDEBUG
+  EXPECT_FALSE(input.ReleaseResponseBody(other));
+#else
+  ASSERT_DEATH(input.ReleaseResponseBody(other),
+               "is not part of this ResourceCollection");
+#endif
+}
+
+TEST(PagespeedInputTest, InputInformationManyResources) {
+  // Enough resources to compute their sizes on multiple threads.
+  const int kNumResources = 2048;
+  PagespeedInput input;
+  for (int i = 0; i < kNumResources; ++i) {
+    Resource* resource = NewResource(
+        "http://www.example.com/" + pagespeed::string_util::IntToString(i),
+        200);
+    resource->SetRequestMethod("GET");
+    resource->AddResponseHeader("Content-Type",
+                                i % 2 == 0 ? "text/css" : "image/png");
+    resource->SetResponseBody(std::string(i % 100, 'x'));
+    ASSERT_TRUE(input.AddResource(resource));
+  }
+  ASSERT_TRUE(input.Freeze());
+
+  int total_request_bytes = 0;
+  int css_response_bytes = 0;
+  int image_response_bytes = 0;
+  for (int i = 0; i < kNumResources; ++i) {
+    const Resource& resource = input.GetResource(i);
+    total_request_bytes +=
+        pagespeed::resource_util::EstimateRequestBytes(resource);
+    const int response_bytes =
+        pagespeed::resource_util::EstimateResponseBytes(resource);
+    if (i % 2 == 0) {
+      css_response_bytes += response_bytes;
+    } else {
+      image_response_bytes += response_bytes;
+    }
+  }
+  const pagespeed::InputInformation& info = *input.input_information();
+  EXPECT_EQ(kNumResources, info.number_resources());
+  EXPECT_EQ(1, info.number_hosts());
+  EXPECT_EQ(kNumResources / 2, info.number_css_resources());
+  EXPECT_EQ(total_request_bytes, info.total_request_bytes());
+  EXPECT_EQ(css_response_bytes, info.css_response_bytes());
+  EXPECT_EQ(image_response_bytes, info.image_response_bytes());
+}
+
 class UpdateResourceTypesTest : public pagespeed_testing::PagespeedTest {
  protected:
   static const char* kRootUrl;
@@ -0,0 +1,92 @@
+// Copyright 2013 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pagespeed/core/parallel_for.h"
+
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/logging.h"
+#include "base/stl_util.h"
+#include "base/threading/platform_thread.h"
+
+namespace {
+
+class RangeDelegate : public base::PlatformThread::Delegate {
+ public:
+  RangeDelegate(pagespeed::ParallelForTask* task, int begin, int end)
+      : task_(task), begin_(begin), end_(end) {}
+
+  virtual void ThreadMain() {
+    task_->Run(begin_, end_);
+  }
+
+ private:
+  pagespeed::ParallelForTask* task_;
+  const int begin_;
+  const int end_;
+
+  DISALLOW_COPY_AND_ASSIGN(RangeDelegate);
+};
+
+// Returns the first index of the given range when [0, count) is split into
+// num_ranges nearly equal contiguous ranges.
+int RangeBegin(int count, int num_ranges, int range) {
+  return static_cast<int>(static_cast<int64>(count) * range / num_ranges);
+}
+
+}  // namespace
+
+namespace pagespeed {
+
+void ParallelFor(ParallelForTask* task, int count, int num_threads) {
+  DCHECK(task != NULL);
+  if (count <= 0) {
+    return;
+  }
+  const int num_ranges = num_threads < count ? num_threads : count;
+  if (num_ranges <= 1) {
+    task->Run(0, count);
+    return;
+  }
+
+  std::vector<RangeDelegate*> delegates;
+  std::vector<base::PlatformThreadHandle> handles;
+  // Range 0 is left for the calling thread.
+  for (int range = 1; range < num_ranges; ++range) {
+    RangeDelegate* delegate =
+        new RangeDelegate(task,
+                          RangeBegin(count, num_ranges, range),
+                          RangeBegin(count, num_ranges, range + 1));
+    delegates.push_back(delegate);
+    base::PlatformThreadHandle handle;
+    if (base::PlatformThread::Create(0, delegate, &handle)) {
+      handles.push_back(handle);
+    } else {
+      LOG(WARNING) << "Unable to start worker thread. Running inline.";
+      delegate->ThreadMain();
+    }
+  }
+  task->Run(0, RangeBegin(count, num_ranges, 1));
+
+  for (std::vector<base::PlatformThreadHandle>::const_iterator
+           it = handles.begin(), end = handles.end();
+       it != end;
+       ++it) {
+    base::PlatformThread::Join(*it);
+  }
+  STLDeleteElements(&delegates);
+}
+
+}  // namespace pagespeed
@@ -0,0 +1,44 @@
+// Copyright 2013 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PAGESPEED_CORE_PARALLEL_FOR_H_
+#define PAGESPEED_CORE_PARALLEL_FOR_H_
+
+namespace pagespeed {
+
+/**
+ * A unit of work over the index range [0, count) that can be split into
+ * disjoint subranges and run concurrently.
+ */
+class ParallelForTask {
+ public:
+  ParallelForTask() {}
+  virtual ~ParallelForTask() {}
+
+  // Processes indices [begin, end).  May be called concurrently from several
+  // threads, always with disjoint ranges, so implementations must only write
+  // state owned by the indices in their range.
+  virtual void Run(int begin, int end) = 0;
+};
+
+// Runs task over the indices [0, count), split into at most num_threads
+// contiguous ranges, one of which runs on the calling thread.  Returns once
+// every range has been processed.  If num_threads <= 1, or if a worker
+// thread cannot be started, the affected ranges run on the calling thread
+// instead, so the result never depends on whether threads were available.
+void ParallelFor(ParallelForTask* task, int count, int num_threads);
+
+}  // namespace pagespeed
+
+#endif  // PAGESPEED_CORE_PARALLEL_FOR_H_
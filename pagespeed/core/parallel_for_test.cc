@@ -0,0 +1,68 @@
+// Copyright 2013 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <vector>
+
+#include "pagespeed/core/parallel_for.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace {
+
+using pagespeed::ParallelFor;
+using pagespeed::ParallelForTask;
+
+// Counts how many times each index was visited.
+class CountingTask : public ParallelForTask {
+ public:
+  explicit CountingTask(int count) : visits_(count, 0) {}
+
+  virtual void Run(int begin, int end) {
+    for (int i = begin; i < end; ++i) {
+      ++visits_[i];
+    }
+  }
+
+  const std::vector<int>& visits() const { return visits_; }
+
+ private:
+  std::vector<int> visits_;
+};
+
+void ExpectEachIndexVisitedOnce(int count, int num_threads) {
+  CountingTask task(count);
+  ParallelFor(&task, count, num_threads);
+  for (int i = 0; i < count; ++i) {
+    EXPECT_EQ(1, task.visits()[i]) << "index " << i << " of " << count
+                                   << " with " << num_threads << " threads";
+  }
+}
+
+TEST(ParallelForTest, Empty) {
+  ExpectEachIndexVisitedOnce(0, 4);
+}
+
+TEST(ParallelForTest, SingleThread) {
+  ExpectEachIndexVisitedOnce(10, 1);
+  ExpectEachIndexVisitedOnce(10, 0);
+}
+
+TEST(ParallelForTest, MultipleThreads) {
+  ExpectEachIndexVisitedOnce(1, 4);
+  ExpectEachIndexVisitedOnce(3, 4);
+  ExpectEachIndexVisitedOnce(4, 4);
+  ExpectEachIndexVisitedOnce(1001, 4);
+  ExpectEachIndexVisitedOnce(1000, 7);
+}
+
+}  // namespace
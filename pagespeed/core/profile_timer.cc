@@ -0,0 +1,126 @@
+// Copyright 2013 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pagespeed/core/profile_timer.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#include "base/logging.h"
+#include "pagespeed/proto/pagespeed_output.pb.h"
+
+namespace {
+
+pagespeed::ProfileTimer::AllocatedBytesFunction g_allocated_bytes_function =
+    NULL;
+
+// Returns the CPU time used by the calling thread, in microseconds, or -1 if
+// it is not available.
+int64 GetThreadCpuTimeMicroseconds() {
+#if defined(_WIN32)
+  FILETIME creation_time, exit_time, kernel_time, user_time;
+  if (!GetThreadTimes(GetCurrentThread(), &creation_time, &exit_time,
+                      &kernel_time, &user_time)) {
+    return -1;
+  }
+  // FILETIMEs count 100ns intervals.
+  ULARGE_INTEGER kernel, user;
+  kernel.LowPart = kernel_time.dwLowDateTime;
+  kernel.HighPart = kernel_time.dwHighDateTime;
+  user.LowPart = user_time.dwLowDateTime;
+  user.HighPart = user_time.dwHighDateTime;
+  return static_cast<int64>((kernel.QuadPart + user.QuadPart) / 10);
+#elif defined(CLOCK_THREAD_CPUTIME_ID)
+  struct timespec ts;
+  if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0) {
+    return -1;
+  }
+  return static_cast<int64>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+#else
+  return -1;
+#endif
+}
+
+}  // namespace
+
+namespace pagespeed {
+
+ProfileTimer::ProfileTimer(Profile* profile, Phase phase)
+    : profile_(profile),
+      phase_(phase),
+      start_cpu_time_us_(-1),
+      start_allocated_bytes_(0) {
+  if (profile_ != NULL) {
+    Start();
+  }
+}
+
+ProfileEntry* ProfileTimer::Record(const std::string& name) {
+  if (profile_ == NULL) {
+    return NULL;
+  }
+  const base::TimeTicks end_time = base::TimeTicks::HighResNow();
+  const int64 end_cpu_time_us = GetThreadCpuTimeMicroseconds();
+  const size_t end_allocated_bytes =
+      g_allocated_bytes_function != NULL ? g_allocated_bytes_function() : 0;
+
+  ProfileEntry* entry = NULL;
+  switch (phase_) {
+    case INPUT:
+      entry = profile_->add_input_phases();
+      break;
+    case COMPUTE_RESULTS:
+      entry = profile_->add_compute_results();
+      break;
+    case COMPUTE_SCORE_AND_IMPACT:
+      entry = profile_->add_compute_score_and_impact();
+      break;
+    case FORMAT_RESULTS:
+      entry = profile_->add_format_results();
+      break;
+  }
+  DCHECK(entry != NULL);
+
+  entry->set_name(name);
+  entry->set_wall_time_ms((end_time - start_time_).InMillisecondsF());
+  if (start_cpu_time_us_ >= 0 && end_cpu_time_us >= 0) {
+    entry->set_cpu_time_ms((end_cpu_time_us - start_cpu_time_us_) / 1000.0);
+  }
+  if (g_allocated_bytes_function != NULL) {
+    entry->set_bytes_allocated(
+        static_cast<size_t>(end_allocated_bytes - start_allocated_bytes_));
+  }
+
+  Start();
+  return entry;
+}
+
+// static
+void ProfileTimer::SetAllocatedBytesFunction(
+    AllocatedBytesFunction function) {
+  g_allocated_bytes_function = function;
+}
+
+void ProfileTimer::Start() {
+  if (g_allocated_bytes_function != NULL) {
+    start_allocated_bytes_ = g_allocated_bytes_function();
+  }
+  start_cpu_time_us_ = GetThreadCpuTimeMicroseconds();
+  start_time_ = base::TimeTicks::HighResNow();
+}
+
+}  // namespace pagespeed
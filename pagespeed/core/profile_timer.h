@@ -0,0 +1,81 @@
+// Copyright 2013 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PAGESPEED_CORE_PROFILE_TIMER_H_
+#define PAGESPEED_CORE_PROFILE_TIMER_H_
+
+#include <stddef.h>
+
+#include <string>
+
+#include "base/basictypes.h"
+#include "base/time.h"
+
+namespace pagespeed {
+
+class Profile;
+class ProfileEntry;
+
+/**
+ * Measures the wall time, thread CPU time and bytes allocated by successive
+ * steps of an analysis, appending one ProfileEntry per step to one of the
+ * lists of a Profile.  A ProfileTimer for a NULL Profile reads no clocks and
+ * records nothing, so code can be instrumented unconditionally at no cost
+ * when profiling is off.
+ */
+class ProfileTimer {
+ public:
+  enum Phase {
+    INPUT,
+    COMPUTE_RESULTS,
+    COMPUTE_SCORE_AND_IMPACT,
+    FORMAT_RESULTS
+  };
+
+  // Returns the number of bytes allocated so far, e.g.
+  // pagespeed::GetAllocatedBytes from allocation_counter.h.
+  typedef size_t (*AllocatedBytesFunction)();
+
+  // Starts timing the first step.  profile may be NULL.
+  ProfileTimer(Profile* profile, Phase phase);
+
+  bool enabled() const { return profile_ != NULL; }
+
+  // Records the step that just finished, i.e. everything since the timer
+  // was constructed or Record was last called, as an entry named name, and
+  // starts timing the next step.  Returns the new entry, so that the caller
+  // can fill in num_results, or NULL if the timer is disabled.
+  ProfileEntry* Record(const std::string& name);
+
+  // Sets the function used to fill in bytes_allocated.  Without one,
+  // bytes_allocated is left unset.  Not thread-safe: call it at startup,
+  // before any ProfileTimer is created.
+  static void SetAllocatedBytesFunction(AllocatedBytesFunction function);
+
+ private:
+  void Start();
+
+  Profile* const profile_;
+  const Phase phase_;
+  base::TimeTicks start_time_;
+  // Negative if thread CPU time is not available.
+  int64 start_cpu_time_us_;
+  size_t start_allocated_bytes_;
+
+  DISALLOW_COPY_AND_ASSIGN(ProfileTimer);
+};
+
+}  // namespace pagespeed
+
+#endif  // PAGESPEED_CORE_PROFILE_TIMER_H_
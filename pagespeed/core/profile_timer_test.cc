@@ -0,0 +1,78 @@
+// Copyright 2013 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pagespeed/core/profile_timer.h"
+
+#include "pagespeed/proto/pagespeed_output.pb.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace {
+
+using pagespeed::Profile;
+using pagespeed::ProfileEntry;
+using pagespeed::ProfileTimer;
+
+size_t g_allocated_bytes = 0;
+
+size_t FakeAllocatedBytes() {
+  return g_allocated_bytes;
+}
+
+TEST(ProfileTimerTest, Disabled) {
+  ProfileTimer timer(NULL, ProfileTimer::COMPUTE_RESULTS);
+  EXPECT_FALSE(timer.enabled());
+  EXPECT_TRUE(timer.Record("rule") == NULL);
+}
+
+TEST(ProfileTimerTest, RecordsToPhase) {
+  Profile profile;
+  ProfileTimer input_timer(&profile, ProfileTimer::INPUT);
+  ProfileTimer format_timer(&profile, ProfileTimer::FORMAT_RESULTS);
+  EXPECT_TRUE(input_timer.enabled());
+
+  ProfileEntry* entry = input_timer.Record("parse");
+  ASSERT_TRUE(entry != NULL);
+  entry->set_num_results(2);
+  input_timer.Record("freeze");
+  format_timer.Record("rule");
+
+  ASSERT_EQ(2, profile.input_phases_size());
+  EXPECT_EQ("parse", profile.input_phases(0).name());
+  EXPECT_EQ(2, profile.input_phases(0).num_results());
+  EXPECT_EQ("freeze", profile.input_phases(1).name());
+  EXPECT_LE(0.0, profile.input_phases(1).wall_time_ms());
+  EXPECT_FALSE(profile.input_phases(0).has_bytes_allocated());
+  EXPECT_EQ(0, profile.compute_results_size());
+  EXPECT_EQ(0, profile.compute_score_and_impact_size());
+  ASSERT_EQ(1, profile.format_results_size());
+  EXPECT_EQ("rule", profile.format_results(0).name());
+}
+
+TEST(ProfileTimerTest, AllocatedBytes) {
+  ProfileTimer::SetAllocatedBytesFunction(FakeAllocatedBytes);
+  g_allocated_bytes = 100;
+  Profile profile;
+  ProfileTimer timer(&profile, ProfileTimer::COMPUTE_RESULTS);
+  g_allocated_bytes = 150;
+  timer.Record("first");
+  g_allocated_bytes = 170;
+  timer.Record("second");
+  ProfileTimer::SetAllocatedBytesFunction(NULL);
+
+  ASSERT_EQ(2, profile.compute_results_size());
+  EXPECT_EQ(50, profile.compute_results(0).bytes_allocated());
+  EXPECT_EQ(20, profile.compute_results(1).bytes_allocated());
+}
+
+}  // namespace
@@ -176,6 +176,10 @@ void Resource::SetResponseBody(const std::string& value) {
   response_body_ = value;
 }
 
+void Resource::SwapResponseBody(std::string* value) {
+  response_body_.swap(*value);
+}
+
 void Resource::SetCookies(const std::string& cookies) {
   cookies_ = cookies;
 }
@@ -44,6 +44,9 @@ class Resource {
   void AddResponseHeader(const std::string& name, const std::string& value);
   void RemoveResponseHeader(const std::string& name);
   void SetResponseBody(const std::string& value);
+  // Like SetResponseBody, but swaps the body with *value instead of
+  // copying it, which is cheaper for large bodies.
+  void SwapResponseBody(std::string* value);
   void SetResponseBodyModified(bool modified) {
     response_body_modified_ = modified;
   }
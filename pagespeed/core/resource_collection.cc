@@ -16,17 +16,61 @@
 
 #include <algorithm>
 
+#include "base/hash_tables.h"
 #include "base/logging.h"
 #include "base/stl_util.h"
+#include "pagespeed/core/parallel_for.h"
 #include "pagespeed/core/resource.h"
 #include "pagespeed/core/resource_filter.h"
 #include "pagespeed/core/resource_util.h"
+#include "pagespeed/core/string_util.h"
 #include "pagespeed/core/uri_util.h"
 
 namespace pagespeed {
 
 namespace {
 
+// Hashing runs at several GB/s per core, and parsing a URL takes about a
+// microsecond, so only bother with worker threads once there is enough body
+// data or there are enough URLs for thread startup to be noise.
+const size_t kParallelIndexMinTotalBodyBytes = 4 << 20;
+const int kParallelIndexMinResources = 1024;
+const int kMaxIndexThreads = 4;
+
+// Computes the per-resource data that the ResourceCollection indices are
+// built from, for a range of resources, into preallocated vectors.  Each
+// index is written by exactly one thread.
+class ComputeIndexDataTask : public pagespeed::ParallelForTask {
+ public:
+  ComputeIndexDataTask(const std::vector<pagespeed::Resource*>& resources,
+                       std::vector<uint64>* hashes,
+                       std::vector<std::string>* hosts,
+                       std::vector<std::string>* redirect_targets)
+      : resources_(resources),
+        hashes_(hashes),
+        hosts_(hosts),
+        redirect_targets_(redirect_targets) {}
+
+  virtual void Run(int begin, int end) {
+    for (int idx = begin; idx < end; ++idx) {
+      const pagespeed::Resource& resource = *resources_[idx];
+      (*hashes_)[idx] =
+          pagespeed::string_util::Hash64(resource.GetResponseBody());
+      (*hosts_)[idx] = resource.GetHost();
+      (*redirect_targets_)[idx] =
+          pagespeed::resource_util::GetRedirectedUrl(resource);
+    }
+  }
+
+ private:
+  const std::vector<pagespeed::Resource*>& resources_;
+  std::vector<uint64>* hashes_;
+  std::vector<std::string>* hosts_;
+  std::vector<std::string>* redirect_targets_;
+
+  DISALLOW_COPY_AND_ASSIGN(ComputeIndexDataTask);
+};
+
 // sorts resources by their request start times.
 struct ResourceRequestStartTimeLessThan {
   bool operator() (const Resource* lhs, const Resource* rhs) const {
@@ -63,7 +107,8 @@ class RedirectGraph {
  public:
   explicit RedirectGraph(const ResourceCollection* resource_collection)
       : resource_collection_(resource_collection) {}
-  void AddResource(const Resource& resource);
+  // destination is the URL resource redirects to, or the empty string.
+  void AddResource(const Resource& resource, const std::string& destination);
   void AppendRedirectChainResults(
       RedirectRegistry::RedirectChainVector* chains);
 
@@ -84,9 +129,8 @@ class RedirectGraph {
   const ResourceCollection* resource_collection_;
 };
 
-void RedirectGraph::AddResource(const Resource& resource) {
-  std::string destination =
-      resource_util::GetRedirectedUrl(resource);
+void RedirectGraph::AddResource(const Resource& resource,
+                                const std::string& destination) {
   if (!destination.empty()) {
     redirect_map_[resource.GetRequestUrl()].push_back(destination);
     destinations_.insert(destination);
@@ -187,7 +231,8 @@ bool ResourceCollection::IsValidResource(const Resource* resource) const {
     LOG(WARNING) << "Refusing Resource with empty URL.";
     return false;
   }
-  if (has_resource_with_url(url)) {
+  // Resource URLs are canonical, so no need to canonicalize here.
+  if (url_index_.Find(url) >= 0) {
     LOG(INFO) << "Ignoring duplicate AddResource for resource at \""
               << url << "\".";
     return false;
@@ -219,11 +264,8 @@ bool ResourceCollection::AddResource(Resource* resource) {
     delete resource;  // Resource is owned by ResourceCollection.
     return false;
   }
-  const std::string& url = resource->GetRequestUrl();
-
+  url_index_.Add(&resource->GetRequestUrl(), resources_.size());
   resources_.push_back(resource);
-  url_resource_map_[url] = resource;
-  host_resource_map_[resource->GetHost()].insert(resource);
   return true;
 }
 
@@ -242,21 +284,102 @@ bool ResourceCollection::Freeze() {
                      request_order_vector_.end(),
                      ResourceRequestStartTimeLessThan());
   }
+  BuildIndices();
   frozen_ = true;
   redirect_registry_.Init(*this);
   return true;
 }
 
+void ResourceCollection::BuildIndices() {
+  const int num = num_resources();
+  size_t total_body_bytes = 0;
+  for (int idx = 0; idx < num; ++idx) {
+    total_body_bytes += resources_[idx]->GetResponseBody().size();
+  }
+  response_body_hashes_.assign(num, 0);
+  redirect_targets_.assign(num, std::string());
+  std::vector<std::string> hosts(num);
+  ComputeIndexDataTask task(resources_, &response_body_hashes_, &hosts,
+                            &redirect_targets_);
+  const bool parallel = total_body_bytes >= kParallelIndexMinTotalBodyBytes ||
+      num >= kParallelIndexMinResources;
+  ParallelFor(&task, num, parallel ? kMaxIndexThreads : 1);
+
+  // Inserting into the indices is cheap next to computing their keys, and
+  // the indices are shared, so do it on this thread.  Number the hosts, and
+  // group the resources of each host.
+  base::hash_map<std::string, int> host_ids;
+  std::vector<ResourceVector> host_resources;
+  resource_host_ids_.assign(num, 0);
+  for (int idx = 0; idx < num; ++idx) {
+    std::pair<base::hash_map<std::string, int>::iterator, bool> inserted =
+        host_ids.insert(std::make_pair(hosts[idx], host_names_.size()));
+    if (inserted.second) {
+      host_names_.push_back(hosts[idx]);
+      host_resources.push_back(ResourceVector());
+    }
+    const int host_id = inserted.first->second;
+    resource_host_ids_[idx] = host_id;
+    host_resources[host_id].push_back(resources_[idx]);
+  }
+  // There are typically far fewer hosts than resources, so looking each
+  // host up in the effective-TLD data once here saves the rules from doing
+  // it for every resource.
+  host_domains_.resize(host_names_.size());
+  host_registries_.resize(host_names_.size());
+  for (size_t host_id = 0; host_id < host_names_.size(); ++host_id) {
+    host_domains_[host_id] =
+        uri_util::GetDomainAndRegistryForHost(host_names_[host_id]);
+    host_registries_[host_id] =
+        uri_util::GetRegistryForHost(host_names_[host_id]);
+  }
+  // Sorted input lets each ResourceSet be filled by appending.
+  for (size_t host_id = 0; host_id < host_names_.size(); ++host_id) {
+    ResourceVector* resources = &host_resources[host_id];
+    std::sort(resources->begin(), resources->end(), ResourceUrlLessThan());
+    ResourceSet* resource_set = &host_resource_map_[host_names_[host_id]];
+    for (ResourceVector::const_iterator it = resources->begin(),
+             end = resources->end();
+         it != end;
+         ++it) {
+      resource_set->insert(resource_set->end(), *it);
+    }
+  }
+
+  for (int idx = 0; idx < num; ++idx) {
+    const Resource* resource = resources_[idx];
+    if (!resource->GetResponseBody().empty()) {
+      body_hash_resource_map_[response_body_hashes_[idx]].push_back(resource);
+    }
+  }
+}
+
 int ResourceCollection::num_resources() const {
   return resources_.size();
 }
 
 bool ResourceCollection::has_resource_with_url(const std::string& url) const {
+  return FindResourceIndex(url) >= 0;
+}
+
+int ResourceCollection::FindResourceIndex(const std::string& url) const {
+  // Resource URLs are canonical, and canonicalization is idempotent, so a
+  // URL that matches one exactly is its own canonical form.  Only parse
+  // the URL if it does not.
+  const int idx = url_index_.Find(url);
+  if (idx >= 0) {
+    return idx;
+  }
   std::string url_canon;
-  if (!uri_util::GetUriWithoutFragment(url, &url_canon)) {
-    url_canon = url;
+  if (!uri_util::GetUriWithoutFragment(url, &url_canon) || url_canon == url) {
+    return -1;
   }
-  return url_resource_map_.find(url_canon) != url_resource_map_.end();
+  const int canon_idx = url_index_.Find(url_canon);
+  if (canon_idx >= 0) {
+    LOG(INFO) << "Resolved \"" << url << "\" to resource with URL "
+              << url_canon;
+  }
+  return canon_idx;
 }
 
 const Resource& ResourceCollection::GetResource(int idx) const {
@@ -269,6 +392,63 @@ const HostResourceMap* ResourceCollection::GetHostResourceMap() const {
   return &host_resource_map_;
 }
 
+int ResourceCollection::num_hosts() const {
+  DCHECK(is_frozen());
+  return host_names_.size();
+}
+
+const std::string& ResourceCollection::GetHostName(int host_id) const {
+  DCHECK(is_frozen());
+  DCHECK(host_id >= 0 && static_cast<size_t>(host_id) < host_names_.size());
+  return host_names_[host_id];
+}
+
+int ResourceCollection::GetHostId(int idx) const {
+  DCHECK(is_frozen());
+  DCHECK(idx >= 0 && static_cast<size_t>(idx) < resource_host_ids_.size());
+  return resource_host_ids_[idx];
+}
+
+int ResourceCollection::GetResourceHostId(const Resource& resource) const {
+  DCHECK(is_frozen());
+  const int idx = url_index_.Find(resource.GetRequestUrl());
+  if (idx < 0 || resources_[idx] != &resource) {
+    return -1;
+  }
+  return resource_host_ids_[idx];
+}
+
+const std::string& ResourceCollection::GetHostDomainAndRegistry(
+    int host_id) const {
+  DCHECK(is_frozen());
+  DCHECK(host_id >= 0 && static_cast<size_t>(host_id) < host_domains_.size());
+  return host_domains_[host_id];
+}
+
+const std::string& ResourceCollection::GetHostRegistry(int host_id) const {
+  DCHECK(is_frozen());
+  DCHECK(host_id >= 0 &&
+         static_cast<size_t>(host_id) < host_registries_.size());
+  return host_registries_[host_id];
+}
+
+uint64 ResourceCollection::GetResponseBodyHash(
+    const Resource& resource) const {
+  DCHECK(is_frozen());
+  const int idx = url_index_.Find(resource.GetRequestUrl());
+  if (idx < 0 || resources_[idx] != &resource) {
+    LOG(DFATAL) << "Resource " << resource.GetRequestUrl()
+                << " is not part of this ResourceCollection.";
+    return string_util::Hash64(resource.GetResponseBody());
+  }
+  return response_body_hashes_[idx];
+}
+
+const BodyHashResourceMap* ResourceCollection::GetBodyHashResourceMap() const {
+  DCHECK(is_frozen());
+  return &body_hash_resource_map_;
+}
+
 const ResourceVector*
 ResourceCollection::GetResourcesInRequestOrder() const {
   DCHECK(is_frozen());
@@ -288,20 +468,11 @@ const RedirectRegistry* ResourceCollection::GetRedirectRegistry() const {
 
 const Resource* ResourceCollection::GetResourceWithUrlOrNull(
     const std::string& url) const {
-  std::string url_canon;
-  if (!uri_util::GetUriWithoutFragment(url, &url_canon)) {
-    url_canon = url;
-  }
-  std::map<std::string, const Resource*>::const_iterator it =
-      url_resource_map_.find(url_canon);
-  if (it == url_resource_map_.end()) {
+  const int idx = FindResourceIndex(url);
+  if (idx < 0) {
     return NULL;
   }
-  if (url_canon != url) {
-    LOG(INFO) << "GetResourceWithUrlOrNull(\"" << url
-              << "\"): Returning resource with URL " << url_canon;
-  }
-  return it->second;
+  return resources_[idx];
 }
 
 Resource* ResourceCollection::GetMutableResource(int idx) {
@@ -321,6 +492,18 @@ Resource* ResourceCollection::GetMutableResourceWithUrlOrNull(
   return const_cast<Resource*>(GetResourceWithUrlOrNull(url));
 }
 
+bool ResourceCollection::ReleaseResponseBody(const Resource& resource) {
+  const int idx = FindResourceIndex(resource.GetRequestUrl());
+  if (idx < 0 || resources_[idx] != &resource) {
+    LOG(DFATAL) << "Resource " << resource.GetRequestUrl()
+                << " is not part of this ResourceCollection.";
+    return false;
+  }
+  std::string released;
+  resources_[idx]->SwapResponseBody(&released);
+  return true;
+}
+
 bool ResourceCollection::SetPrimaryResourceUrl(const std::string& url) {
   if (is_frozen()) {
     LOG(DFATAL) << "Can't set primary resource " << url
@@ -449,7 +632,8 @@ void RedirectRegistry::BuildRedirectChains(
   RedirectGraph redirect_graph(&resource_collection);
   for (int idx = 0, num = resource_collection.num_resources();
        idx < num; ++idx) {
-    redirect_graph.AddResource(resource_collection.GetResource(idx));
+    redirect_graph.AddResource(resource_collection.GetResource(idx),
+                               resource_collection.redirect_targets_[idx]);
   }
 
   redirect_chains_.clear();
@@ -22,6 +22,7 @@
 
 #include "base/basictypes.h"
 #include "base/memory/scoped_ptr.h"
+#include "pagespeed/core/resource_url_index.h"
 
 namespace pagespeed {
 
@@ -37,6 +38,9 @@ struct ResourceUrlLessThan {
 typedef std::set<const Resource*, ResourceUrlLessThan> ResourceSet;
 typedef std::map<std::string, ResourceSet> HostResourceMap;
 typedef std::vector<const Resource*> ResourceVector;
+// Map from response body hash to the resources with that hash, in the order
+// they were added to the ResourceCollection.
+typedef std::map<uint64, ResourceVector> BodyHashResourceMap;
 
 /**
  * Companion class to ResourceCollection that provides convenience
@@ -101,9 +105,32 @@ class ResourceCollection {
   Resource* GetMutableResource(int idx);
   Resource* GetMutableResourceWithUrlOrNull(const std::string& url);
 
+  // Frees the response body of the given resource of this collection.
+  // This is the only change allowed once frozen: everything Freeze()
+  // derives from the body (e.g. its hash) is kept, but any later reader
+  // of the body sees an empty string. Returns false if the resource is
+  // not part of this collection.
+  bool ReleaseResponseBody(const Resource& resource);
+
   // Get the map from hostname to all resources on that hostname.
   const HostResourceMap* GetHostResourceMap() const;
 
+  // Hosts are also numbered 0 .. num_hosts() - 1, in the order in which
+  // their first resource was added, so that per-host data can be kept in
+  // vectors.  These methods may only be called once frozen.
+  int num_hosts() const;
+  const std::string& GetHostName(int host_id) const;
+  // Get the id of the host of the resource at index idx.
+  int GetHostId(int idx) const;
+  // Get the id of the host of the given resource, or -1 if it is not in
+  // this collection.
+  int GetResourceHostId(const Resource& resource) const;
+  // Get the registered domain and the registry of the host (see
+  // uri_util::GetDomainAndRegistryForHost and GetRegistryForHost), as
+  // computed by Freeze().
+  const std::string& GetHostDomainAndRegistry(int host_id) const;
+  const std::string& GetHostRegistry(int host_id) const;
+
   // Get the set of all resources, sorted in request order. Will be
   // NULL if one or more resources does not have a request start
   // time.
@@ -111,27 +138,62 @@ class ResourceCollection {
 
   const RedirectRegistry* GetRedirectRegistry() const;
 
+  // Get the string_util::Hash64 of the resource's response body, as
+  // computed by Freeze().  Resources with equal bodies have equal hashes.
+  // Equal hashes almost certainly, but not necessarily, mean equal bodies,
+  // so compare the bodies themselves when exact equality matters.
+  uint64 GetResponseBodyHash(const Resource& resource) const;
+
+  // Get the map from response body hash to all resources with that hash.
+  // Resources with empty response bodies are not included.
+  const BodyHashResourceMap* GetBodyHashResourceMap() const;
+
   bool SetPrimaryResourceUrl(const std::string& url);
   const std::string& primary_resource_url() const;
   const Resource* GetPrimaryResourceOrNull() const;
   bool is_frozen() const;
 
  private:
+  // RedirectRegistry::Init reads redirect_targets_.
+  friend class RedirectRegistry;
+
   bool IsValidResource(const Resource* resource) const;
+  // Returns the index of the resource with the given URL, canonicalizing
+  // the URL if needed, or -1.
+  int FindResourceIndex(const std::string& url) const;
+  // Computes the per-resource data of the indices below, on several threads
+  // for large collections, then builds the indices.
+  void BuildIndices();
 
   std::vector<Resource*> resources_;
   std::string primary_resource_url_;
 
-  // Map from URL to Resource. The resources_ vector, above, owns the
-  // Resource instances in this map.
-  std::map<std::string, const Resource*> url_resource_map_;
+  // Map from the (canonical) URL of each resource to its index in
+  // resources_.  The keys are the resources' own URL strings.
+  ResourceUrlIndex url_index_;
 
-  // Map from hostname to Resources on that hostname. The resources_
-  // vector, above, owns the Resource instances in this map.
+  // Map from hostname to Resources on that hostname, built by Freeze(). The
+  // resources_ vector, above, owns the Resource instances in this map.
   HostResourceMap host_resource_map_;
 
+  // The host id of each resource, parallel to resources_, and the name of
+  // each host id, along with its registered domain and registry.  Built by
+  // Freeze().
+  std::vector<int> resource_host_ids_;
+  std::vector<std::string> host_names_;
+  std::vector<std::string> host_domains_;
+  std::vector<std::string> host_registries_;
+
   ResourceVector request_order_vector_;
 
+  // The absolute URL each resource redirects to, or the empty string,
+  // parallel to resources_.  Computed by Freeze().
+  std::vector<std::string> redirect_targets_;
+
+  // Response body hashes, parallel to resources_, and the index over them.
+  std::vector<uint64> response_body_hashes_;
+  BodyHashResourceMap body_hash_resource_map_;
+
   scoped_ptr<ResourceFilter> resource_filter_;
   RedirectRegistry redirect_registry_;
   bool frozen_;
@@ -15,10 +15,12 @@
 #include "pagespeed/core/resource.h"
 #include "pagespeed/core/resource_collection.h"
 #include "pagespeed/core/resource_filter.h"
+#include "pagespeed/core/string_util.h"
 #include "pagespeed/testing/pagespeed_test.h"
 
 namespace {
 
+using pagespeed::BodyHashResourceMap;
 using pagespeed::PagespeedInput;
 using pagespeed::RedirectRegistry;
 using pagespeed::Resource;
@@ -262,6 +264,165 @@ TEST(ResourceCollectionTest, FilterResources) {
   ASSERT_TRUE(coll.Freeze());
 }
 
+TEST(ResourceCollectionTest, BodyHashIndex) {
+  ResourceCollection coll;
+  Resource* r1 = New200Resource(kURL1);
+  r1->SetResponseBody("body");
+  Resource* r2 = New200Resource(kURL2);
+  r2->SetResponseBody("other body");
+  Resource* r3 = New200Resource(kURL3);
+  r3->SetResponseBody("body");
+  Resource* r4 = New200Resource(kURL4);
+  ASSERT_TRUE(coll.AddResource(r1));
+  ASSERT_TRUE(coll.AddResource(r2));
+  ASSERT_TRUE(coll.AddResource(r3));
+  ASSERT_TRUE(coll.AddResource(r4));
+  ASSERT_TRUE(coll.Freeze());
+
+  EXPECT_EQ(coll.GetResponseBodyHash(*r1), coll.GetResponseBodyHash(*r3));
+  EXPECT_NE(coll.GetResponseBodyHash(*r1), coll.GetResponseBodyHash(*r2));
+  EXPECT_EQ(pagespeed::string_util::Hash64(""),
+            coll.GetResponseBodyHash(*r4));
+
+  // The empty body is not indexed; the others are, in insertion order.
+  const BodyHashResourceMap& map = *coll.GetBodyHashResourceMap();
+  ASSERT_EQ(2U, map.size());
+  BodyHashResourceMap::const_iterator it =
+      map.find(coll.GetResponseBodyHash(*r1));
+  ASSERT_TRUE(it != map.end());
+  ASSERT_EQ(2U, it->second.size());
+  EXPECT_EQ(r1, it->second[0]);
+  EXPECT_EQ(r3, it->second[1]);
+  it = map.find(coll.GetResponseBodyHash(*r2));
+  ASSERT_TRUE(it != map.end());
+  ASSERT_EQ(1U, it->second.size());
+  EXPECT_EQ(r2, it->second[0]);
+}
+
+TEST(ResourceCollectionTest, BodyHashIndexLargeBodies) {
+  // Enough body data to hash on multiple threads.
+  const std::string big(1 << 20, 'x');
+  ResourceCollection coll;
+  for (int i = 0; i < 8; ++i) {
+    Resource* r = New200Resource(
+        std::string(kURL1) + pagespeed::string_util::IntToString(i));
+    r->SetResponseBody(big + static_cast<char>('0' + i % 2));
+    ASSERT_TRUE(coll.AddResource(r));
+  }
+  ASSERT_TRUE(coll.Freeze());
+
+  const BodyHashResourceMap& map = *coll.GetBodyHashResourceMap();
+  ASSERT_EQ(2U, map.size());
+  for (int i = 0; i < coll.num_resources(); ++i) {
+    const Resource& resource = coll.GetResource(i);
+    EXPECT_EQ(pagespeed::string_util::Hash64(resource.GetResponseBody()),
+              coll.GetResponseBodyHash(resource));
+  }
+  for (BodyHashResourceMap::const_iterator it = map.begin();
+       it != map.end(); ++it) {
+    EXPECT_EQ(4U, it->second.size());
+  }
+}
+
+TEST(ResourceCollectionTest, HostIds) {
+  ResourceCollection coll;
+  ASSERT_TRUE(coll.AddResource(New200Resource("http://b.com/2")));
+  ASSERT_TRUE(coll.AddResource(New200Resource("http://a.com/1")));
+  ASSERT_TRUE(coll.AddResource(New200Resource("http://b.com/1")));
+  ASSERT_TRUE(coll.Freeze());
+
+  // Hosts are numbered in order of their first resource.
+  ASSERT_EQ(2, coll.num_hosts());
+  EXPECT_EQ("b.com", coll.GetHostName(0));
+  EXPECT_EQ("a.com", coll.GetHostName(1));
+  EXPECT_EQ(0, coll.GetHostId(0));
+  EXPECT_EQ(1, coll.GetHostId(1));
+  EXPECT_EQ(0, coll.GetHostId(2));
+
+  // The resources of each host are still sorted by URL.
+  const pagespeed::HostResourceMap& host_map = *coll.GetHostResourceMap();
+  ASSERT_EQ(2U, host_map.size());
+  const pagespeed::ResourceSet& b_resources = host_map.find("b.com")->second;
+  ASSERT_EQ(2U, b_resources.size());
+  EXPECT_EQ("http://b.com/1", (*b_resources.begin())->GetRequestUrl());
+  EXPECT_EQ("http://b.com/2", (*b_resources.rbegin())->GetRequestUrl());
+}
+
+TEST(ResourceCollectionTest, HostDomainAndRegistry) {
+  ResourceCollection coll;
+  ASSERT_TRUE(coll.AddResource(New200Resource("http://www.a.co.uk/")));
+  ASSERT_TRUE(coll.AddResource(New200Resource("http://static.a.co.uk/")));
+  ASSERT_TRUE(coll.AddResource(New200Resource("http://10.0.0.1/")));
+  ASSERT_TRUE(coll.Freeze());
+
+  ASSERT_EQ(3, coll.num_hosts());
+  EXPECT_EQ("a.co.uk", coll.GetHostDomainAndRegistry(0));
+  EXPECT_EQ("co.uk", coll.GetHostRegistry(0));
+  EXPECT_EQ("a.co.uk", coll.GetHostDomainAndRegistry(1));
+  EXPECT_EQ("co.uk", coll.GetHostRegistry(1));
+  EXPECT_EQ("", coll.GetHostDomainAndRegistry(2));
+  EXPECT_EQ("", coll.GetHostRegistry(2));
+
+  for (int i = 0; i < coll.num_resources(); ++i) {
+    EXPECT_EQ(coll.GetHostId(i), coll.GetResourceHostId(coll.GetResource(i)));
+  }
+  Resource* other = New200Resource("http://www.a.co.uk/");
+  EXPECT_EQ(-1, coll.GetResourceHostId(*other));
+  delete other;
+}
+
+TEST(ResourceCollectionTest, ManyResources) {
+  // Enough resources to build the indices on multiple threads.  Every even
+  // resource redirects to the next one.
+  const int kNumResources = 4096;
+  const int kNumHosts = 8;
+  std::vector<std::string> urls;
+  for (int i = 0; i < kNumResources; ++i) {
+    urls.push_back("http://host" +
+                   pagespeed::string_util::IntToString(i % kNumHosts) +
+                   ".com/" + pagespeed::string_util::IntToString(i));
+  }
+  ResourceCollection coll;
+  for (int i = 0; i < kNumResources; ++i) {
+    Resource* r = NewResource(urls[i], i % 2 == 0 ? 302 : 200);
+    if (i % 2 == 0) {
+      r->AddResponseHeader("Location", urls[i + 1]);
+    }
+    ASSERT_TRUE(coll.AddResource(r));
+  }
+  ASSERT_TRUE(coll.Freeze());
+
+  const pagespeed::HostResourceMap& host_map = *coll.GetHostResourceMap();
+  ASSERT_EQ(static_cast<size_t>(kNumHosts), host_map.size());
+  for (pagespeed::HostResourceMap::const_iterator it = host_map.begin();
+       it != host_map.end(); ++it) {
+    EXPECT_EQ(static_cast<size_t>(kNumResources / kNumHosts),
+              it->second.size());
+  }
+
+  ASSERT_EQ(kNumHosts, coll.num_hosts());
+  for (int i = 0; i < kNumResources; ++i) {
+    const int host_id = coll.GetHostId(i);
+    EXPECT_EQ(i % kNumHosts, host_id);
+    EXPECT_EQ(coll.GetResource(i).GetHost(), coll.GetHostName(host_id));
+  }
+
+  const RedirectRegistry& registry = *coll.GetRedirectRegistry();
+  EXPECT_EQ(static_cast<size_t>(kNumResources / 2),
+            registry.GetRedirectChains().size());
+  for (int i = 0; i < kNumResources; ++i) {
+    const Resource* resource = coll.GetResourceWithUrlOrNull(urls[i]);
+    ASSERT_TRUE(resource != NULL);
+    EXPECT_EQ(urls[i], resource->GetRequestUrl());
+    const RedirectRegistry::RedirectChain* chain =
+        registry.GetRedirectChainOrNull(resource);
+    ASSERT_TRUE(chain != NULL);
+    ASSERT_EQ(2U, chain->size());
+    EXPECT_EQ(urls[i - i % 2], chain->at(0)->GetRequestUrl());
+    EXPECT_EQ(urls[i - i % 2 + 1], chain->at(1)->GetRequestUrl());
+  }
+}
+
 // Make sure SetPrimaryResourceUrl canonicalizes its coll.
 TEST(ResourceCollectionTest, GetResourceWithUrlOrNull) {
   ResourceCollection coll;
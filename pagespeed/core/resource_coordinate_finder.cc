@@ -12,7 +12,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
-#include "pagespeed/dom/resource_coordinate_finder.h"
+#include "pagespeed/core/resource_coordinate_finder.h"
 
 #include <algorithm>
 
@@ -76,10 +76,37 @@ void ResourceCoordinateFinder::VisitDocument(
   }
 }
 
+pagespeed::ExternalResourceDomElementVisitor*
+ResourceCoordinateFinder::VisitContentDocument(
+    const pagespeed::DomElement& node,
+    const pagespeed::DomDocument& document) {
+  int x, y;
+  if (node.GetX(&x) == pagespeed::DomElement::SUCCESS &&
+      node.GetY(&y) == pagespeed::DomElement::SUCCESS) {
+    return new ResourceCoordinateFinder(input_,
+                                        resource_to_rect_map_,
+                                        x_translate_ + x,
+                                        y_translate_ + y);
+  }
+  return NULL;
+}
+
 bool FindOnAndOffscreenImageResources(
     const PagespeedInput& input,
     std::vector<const pagespeed::Resource*>* out_onscreen_resources,
     std::vector<const pagespeed::Resource*>* out_offscreen_resources) {
+  ResourceRectMap resource_to_rect_map;
+  return FindOnAndOffscreenImageResources(input,
+                                          out_onscreen_resources,
+                                          out_offscreen_resources,
+                                          &resource_to_rect_map);
+}
+
+bool FindOnAndOffscreenImageResources(
+    const PagespeedInput& input,
+    std::vector<const pagespeed::Resource*>* out_onscreen_resources,
+    std::vector<const pagespeed::Resource*>* out_offscreen_resources,
+    ResourceRectMap* out_resource_to_rect_map) {
   const pagespeed::DomRect onscreen_rect(0,
                                          0,
                                          input.viewport_width(),
@@ -100,16 +127,22 @@ bool FindOnAndOffscreenImageResources(
     out_offscreen_resources->clear();
   }
 
-  std::map<const pagespeed::Resource*, std::vector<pagespeed::DomRect> >
-      resource_to_rect_map;
+  if (!out_resource_to_rect_map->empty()) {
+    LOG(DFATAL) << "out_resource_to_rect_map non-empty.";
+    out_resource_to_rect_map->clear();
+  }
+
+  if (input.dom_document() == NULL) {
+    return false;
+  }
+
+  ResourceRectMap& resource_to_rect_map = *out_resource_to_rect_map;
   ResourceCoordinateFinder image_finder(&input, &resource_to_rect_map);
-  scoped_ptr<pagespeed::DomElementVisitor> visitor(
-      pagespeed::MakeDomElementVisitorForDocument(
-          input.dom_document(), &image_finder));
-  input.dom_document()->Traverse(visitor.get());
+  pagespeed::DomTraversal traversal;
+  traversal.AddExternalResourceVisitor(&image_finder);
+  traversal.Traverse(*input.dom_document());
 
-  for (std::map<const pagespeed::Resource*,
-           std::vector<pagespeed::DomRect> >::const_iterator
+  for (ResourceRectMap::const_iterator
            it = resource_to_rect_map.begin(), end = resource_to_rect_map.end();
        it != end; ++it) {
     const pagespeed::Resource& resource = *it->first;
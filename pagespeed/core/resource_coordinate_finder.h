@@ -12,8 +12,8 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
-#ifndef PAGESPEED_DOM_RESOURCE_COORDINATE_FINDER_H_
-#define PAGESPEED_DOM_RESOURCE_COORDINATE_FINDER_H_
+#ifndef PAGESPEED_CORE_RESOURCE_COORDINATE_FINDER_H_
+#define PAGESPEED_CORE_RESOURCE_COORDINATE_FINDER_H_
 
 #include "pagespeed/core/dom.h"
 
@@ -27,6 +27,9 @@ class Resource;
 
 namespace dom {
 
+typedef std::map<const pagespeed::Resource*, std::vector<pagespeed::DomRect> >
+    ResourceRectMap;
+
 // DOM visitor that finds the coordinates of resources (e.g. images)
 // in the coordinate space of the top-level document.
 class ResourceCoordinateFinder
@@ -55,6 +58,9 @@ class ResourceCoordinateFinder
                         const std::string& url);
   virtual void VisitDocument(const pagespeed::DomElement& node,
                              const pagespeed::DomDocument& document);
+  virtual pagespeed::ExternalResourceDomElementVisitor* VisitContentDocument(
+      const pagespeed::DomElement& node,
+      const pagespeed::DomDocument& document);
 
  private:
   const pagespeed::PagespeedInput *const input_;
@@ -77,7 +83,18 @@ bool FindOnAndOffscreenImageResources(
     std::vector<const pagespeed::Resource*>* out_onscreen_resources,
     std::vector<const pagespeed::Resource*>* out_offscreen_resources);
 
+// As above, but also populates out_resource_to_rect_map with the rects, in
+// the coordinate space of the top-level document, at which each image is
+// displayed.  Rule implementations should use
+// RuleInput::GetOnAndOffscreenImageResources instead, which computes this
+// once per analysis.
+bool FindOnAndOffscreenImageResources(
+    const PagespeedInput& input,
+    std::vector<const pagespeed::Resource*>* out_onscreen_resources,
+    std::vector<const pagespeed::Resource*>* out_offscreen_resources,
+    ResourceRectMap* out_resource_to_rect_map);
+
 }  // namespace dom
 }  // namespace pagespeed
 
-#endif  // PAGESPEED_DOM_RESOURCE_COORDINATE_FINDER_H_
+#endif  // PAGESPEED_CORE_RESOURCE_COORDINATE_FINDER_H_
@@ -16,7 +16,7 @@
 #include <vector>
 
 #include "base/memory/scoped_ptr.h"
-#include "pagespeed/dom/resource_coordinate_finder.h"
+#include "pagespeed/core/resource_coordinate_finder.h"
 #include "pagespeed/testing/pagespeed_test.h"
 
 using pagespeed::dom::FindOnAndOffscreenImageResources;
@@ -40,6 +40,15 @@ TEST(ResourceTest, SetFields) {
   EXPECT_EQ(resource.GetResponseBody(), "response body");
 }
 
+TEST(ResourceTest, SwapResponseBody) {
+  Resource resource;
+  resource.SetResponseBody("old body");
+  std::string body("new body");
+  resource.SwapResponseBody(&body);
+  EXPECT_EQ("new body", resource.GetResponseBody());
+  EXPECT_EQ("old body", body);
+}
+
 TEST(ResourceTest, IsRequestStartTimeLessThanDeathTest) {
   Resource r1, r2;
 #ifndef NDEBUG
@@ -0,0 +1,94 @@
+// Copyright 2013 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pagespeed/core/resource_url_index.h"
+
+#include "base/logging.h"
+#include "pagespeed/core/string_util.h"
+
+namespace {
+
+// The number of slots of the first table; must be a power of two.
+const size_t kInitialSlots = 64;
+
+}  // namespace
+
+namespace pagespeed {
+
+ResourceUrlIndex::ResourceUrlIndex() : size_(0) {
+}
+
+ResourceUrlIndex::~ResourceUrlIndex() {
+}
+
+bool ResourceUrlIndex::Add(const std::string* url, int value) {
+  DCHECK_GE(value, 0);
+  // Keep at most half of the slots in use, so that probe sequences stay
+  // short.
+  if (2 * static_cast<size_t>(size_ + 1) > slots_.size()) {
+    Grow();
+  }
+  const uint64 hash = string_util::Hash64(*url);
+  Slot* slot = &slots_[FindSlot(*url, hash)];
+  if (slot->url != NULL) {
+    return false;
+  }
+  slot->hash = hash;
+  slot->url = url;
+  slot->value = value;
+  ++size_;
+  return true;
+}
+
+int ResourceUrlIndex::Find(const std::string& url) const {
+  if (size_ == 0) {
+    return -1;
+  }
+  const Slot& slot = slots_[FindSlot(url, string_util::Hash64(url))];
+  return slot.url != NULL ? slot.value : -1;
+}
+
+size_t ResourceUrlIndex::FindSlot(const std::string& url, uint64 hash) const {
+  const size_t mask = slots_.size() - 1;
+  for (size_t idx = static_cast<size_t>(hash) & mask; ;
+       idx = (idx + 1) & mask) {
+    const Slot& slot = slots_[idx];
+    if (slot.url == NULL || (slot.hash == hash && *slot.url == url)) {
+      return idx;
+    }
+  }
+}
+
+void ResourceUrlIndex::Grow() {
+  std::vector<Slot> old_slots;
+  old_slots.swap(slots_);
+  slots_.resize(old_slots.empty() ? kInitialSlots : 2 * old_slots.size());
+  const size_t mask = slots_.size() - 1;
+  for (std::vector<Slot>::const_iterator it = old_slots.begin(),
+           end = old_slots.end();
+       it != end;
+       ++it) {
+    if (it->url == NULL) {
+      continue;
+    }
+    // Keys are unique, so the first empty slot is the right one.
+    size_t idx = static_cast<size_t>(it->hash) & mask;
+    while (slots_[idx].url != NULL) {
+      idx = (idx + 1) & mask;
+    }
+    slots_[idx] = *it;
+  }
+}
+
+}  // namespace pagespeed
@@ -0,0 +1,71 @@
+// Copyright 2013 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PAGESPEED_CORE_RESOURCE_URL_INDEX_H_
+#define PAGESPEED_CORE_RESOURCE_URL_INDEX_H_
+
+#include <string>
+#include <vector>
+
+#include "base/basictypes.h"
+
+namespace pagespeed {
+
+/**
+ * Maps URL strings to non-negative integers, e.g. resource indices.  The
+ * table uses open addressing with linear probing, and keeps the hash of
+ * each key next to it, so that a lookup usually costs one hash of the
+ * query and one string compare.  Keys are not copied: each key must stay
+ * alive and unchanged while it is in the index.
+ */
+class ResourceUrlIndex {
+ public:
+  ResourceUrlIndex();
+  ~ResourceUrlIndex();
+
+  // Adds *url with the given value, which must be >= 0.  Returns false, and
+  // leaves the index unchanged, if an equal URL is already present.
+  bool Add(const std::string* url, int value);
+
+  // Returns the value of the given URL, or -1 if it is not present.  The
+  // comparison is exact; callers canonicalize URLs as needed.
+  int Find(const std::string& url) const;
+
+  int size() const { return size_; }
+
+ private:
+  struct Slot {
+    Slot() : hash(0), url(NULL), value(-1) {}
+    uint64 hash;
+    // NULL if the slot is empty.
+    const std::string* url;
+    int value;
+  };
+
+  // Returns the slot holding url, or the empty slot where it belongs.
+  size_t FindSlot(const std::string& url, uint64 hash) const;
+
+  // Doubles the number of slots, rehashing from the stored hashes.
+  void Grow();
+
+  // The number of slots is zero or a power of two.
+  std::vector<Slot> slots_;
+  int size_;
+
+  DISALLOW_COPY_AND_ASSIGN(ResourceUrlIndex);
+};
+
+}  // namespace pagespeed
+
+#endif  // PAGESPEED_CORE_RESOURCE_URL_INDEX_H_
@@ -0,0 +1,69 @@
+// Copyright 2013 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+#include <vector>
+
+#include "pagespeed/core/resource_url_index.h"
+#include "pagespeed/core/string_util.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+using pagespeed::ResourceUrlIndex;
+
+namespace {
+
+TEST(ResourceUrlIndexTest, Empty) {
+  ResourceUrlIndex index;
+  EXPECT_EQ(0, index.size());
+  EXPECT_EQ(-1, index.Find("http://www.example.com/"));
+}
+
+TEST(ResourceUrlIndexTest, AddAndFind) {
+  const std::string url1 = "http://www.example.com/";
+  const std::string url2 = "http://www.example.com/a.css";
+  const std::string url1_copy = url1;
+  ResourceUrlIndex index;
+  EXPECT_TRUE(index.Add(&url1, 0));
+  EXPECT_TRUE(index.Add(&url2, 1));
+  EXPECT_FALSE(index.Add(&url1_copy, 2));
+  EXPECT_EQ(2, index.size());
+
+  EXPECT_EQ(0, index.Find(url1));
+  EXPECT_EQ(1, index.Find(url2));
+  EXPECT_EQ(-1, index.Find("http://www.example.com"));
+  EXPECT_EQ(-1, index.Find("http://www.example.com/a.cs"));
+  EXPECT_EQ(-1, index.Find(""));
+}
+
+TEST(ResourceUrlIndexTest, Grow) {
+  // Enough URLs to grow the table several times.
+  const int kNumUrls = 10000;
+  std::vector<std::string> urls;
+  for (int i = 0; i < kNumUrls; ++i) {
+    urls.push_back("http://www.example.com/" +
+                   pagespeed::string_util::IntToString(i));
+  }
+  ResourceUrlIndex index;
+  for (int i = 0; i < kNumUrls; ++i) {
+    ASSERT_TRUE(index.Add(&urls[i], i));
+  }
+  EXPECT_EQ(kNumUrls, index.size());
+  for (int i = 0; i < kNumUrls; ++i) {
+    EXPECT_EQ(i, index.Find(urls[i]));
+  }
+  EXPECT_EQ(-1, index.Find("http://www.example.com/" +
+                           pagespeed::string_util::IntToString(kNumUrls)));
+}
+
+}  // namespace
@@ -0,0 +1,36 @@
+// Copyright 2013 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pagespeed/core/response_body_releaser.h"
+
+#include "pagespeed/core/pagespeed_input.h"
+
+namespace pagespeed {
+
+ResponseBodyReleaser::ResponseBodyReleaser() {}
+
+ResponseBodyReleaser::~ResponseBodyReleaser() {}
+
+DiscardingResponseBodyReleaser::DiscardingResponseBodyReleaser(
+    PagespeedInput* input)
+    : input_(input) {
+}
+
+DiscardingResponseBodyReleaser::~DiscardingResponseBodyReleaser() {}
+
+void DiscardingResponseBodyReleaser::Release(const Resource& resource) {
+  input_->ReleaseResponseBody(resource);
+}
+
+}  // namespace pagespeed
@@ -0,0 +1,60 @@
+// Copyright 2013 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PAGESPEED_CORE_RESPONSE_BODY_RELEASER_H_
+#define PAGESPEED_CORE_RESPONSE_BODY_RELEASER_H_
+
+#include "base/basictypes.h"
+
+namespace pagespeed {
+
+class PagespeedInput;
+class Resource;
+
+// Is told when the Engine is done with the response body of a resource,
+// so that the body can be freed (or spilled elsewhere) before the analysis
+// ends (see Engine::set_response_body_releaser).
+class ResponseBodyReleaser {
+ public:
+  ResponseBodyReleaser();
+  virtual ~ResponseBodyReleaser();
+
+  // Called once every rule that consumes response bodies (per its
+  // InputCapabilities) has finished with the body of resource. Rules that
+  // do not consume response bodies may still run afterwards.
+  virtual void Release(const Resource& resource) = 0;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(ResponseBodyReleaser);
+};
+
+// Frees each released body from the PagespeedInput that owns it. The
+// input can not be analyzed again afterwards.
+class DiscardingResponseBodyReleaser : public ResponseBodyReleaser {
+ public:
+  // Ownership of input is not transferred.
+  explicit DiscardingResponseBodyReleaser(PagespeedInput* input);
+  virtual ~DiscardingResponseBodyReleaser();
+
+  virtual void Release(const Resource& resource);
+
+ private:
+  PagespeedInput* const input_;
+
+  DISALLOW_COPY_AND_ASSIGN(DiscardingResponseBodyReleaser);
+};
+
+}  // namespace pagespeed
+
+#endif  // PAGESPEED_CORE_RESPONSE_BODY_RELEASER_H_
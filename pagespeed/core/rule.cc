@@ -17,7 +17,11 @@
 #include <algorithm>
 #include "base/basictypes.h"
 #include "base/logging.h"
+#include "base/memory/scoped_ptr.h"
+#include "pagespeed/core/dom.h"
+#include "pagespeed/core/pagespeed_input.h"
 #include "pagespeed/core/resource_util.h"
+#include "pagespeed/core/rule_input.h"
 #include "pagespeed/proto/pagespeed_output.pb.h"
 
 namespace pagespeed {
@@ -104,6 +108,61 @@ Rule::Rule(const InputCapabilities& capability_requirements)
 
 Rule::~Rule() {}
 
+DomTraversalVisitor* Rule::NewDomVisitor(const RuleInput& input,
+                                         ResultProvider* result_provider) {
+  return NULL;
+}
+
+bool Rule::AnalyzesResourcesSeparately() const {
+  return false;
+}
+
+bool Rule::AppendResultsForResource(const RuleInput& input,
+                                    const Resource& resource,
+                                    ResultProvider* result_provider) {
+  LOG(DFATAL) << name() << " does not analyze resources separately.";
+  return false;
+}
+
+bool Rule::AppendResultsFromDomVisitor(const RuleInput& input,
+                                       ResultProvider* result_provider) {
+  const DomDocument* document = input.pagespeed_input().dom_document();
+  if (document == NULL) {
+    return true;
+  }
+  scoped_ptr<DomTraversalVisitor> visitor(
+      NewDomVisitor(input, result_provider));
+  if (visitor == NULL) {
+    LOG(DFATAL) << name() << " did not provide a DOM visitor.";
+    return false;
+  }
+  DomTraversal traversal;
+  traversal.AddVisitor(visitor.get());
+  traversal.set_cancellation_token(input.cancellation_token());
+  traversal.Traverse(*document);
+  return !input.IsCancelled();
+}
+
+bool Rule::AppendResultsForEachResource(const RuleInput& input,
+                                        ResultProvider* result_provider) {
+  bool error = false;
+  const PagespeedInput& pagespeed_input = input.pagespeed_input();
+  for (int idx = 0, num = pagespeed_input.num_resources(); idx < num; ++idx) {
+    if (input.IsCancelled()) {
+      return false;
+    }
+    const Resource& resource = pagespeed_input.GetResource(idx);
+    if (SupportsIncrementalResults() &&
+        input.ReusePreviousResults(resource, result_provider)) {
+      continue;
+    }
+    if (!AppendResultsForResource(input, resource, result_provider)) {
+      error = true;
+    }
+  }
+  return !error;
+}
+
 double Rule::ComputeRuleImpact(const InputInformation& input_info,
                                const RuleResults& results) {
   double total_impact = 0.0;
@@ -162,4 +221,8 @@ bool Rule::IsExperimental() const {
   return false;
 }
 
+bool Rule::SupportsIncrementalResults() const {
+  return false;
+}
+
 }  // namespace pagespeed
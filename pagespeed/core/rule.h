@@ -24,6 +24,7 @@
 
 namespace pagespeed {
 
+class DomTraversalVisitor;
 class InputInformation;
 class Resource;
 class Result;
@@ -67,6 +68,34 @@ class Rule {
   virtual bool AppendResults(const RuleInput& input,
                              ResultProvider* result_provider) = 0;
 
+  // Rules whose AppendResults() consists of a single walk over the DOM can
+  // override this to return a visitor for the root document, and
+  // implement AppendResults() by calling AppendResultsFromDomVisitor(). The
+  // Engine then walks the DOM once on behalf of all such rules, and does
+  // not call their AppendResults(). Results should be added to the given
+  // provider no later than the visitor's Finish(). Ownership of the
+  // returned visitor is transferred to the caller. The default
+  // implementation returns NULL.
+  virtual DomTraversalVisitor* NewDomVisitor(const RuleInput& input,
+                                             ResultProvider* result_provider);
+
+  // Rules whose AppendResults() consists of analyzing each resource of the
+  // input on its own can override this to return true, implement
+  // AppendResultsForResource(), and implement AppendResults() by calling
+  // AppendResultsForEachResource(). When streaming optimized content (see
+  // Engine::set_optimized_content_sink), the Engine then analyzes the
+  // resources one at a time on behalf of all such rules that consume
+  // response bodies, and does not call their AppendResults(). Returns
+  // false by default.
+  virtual bool AnalyzesResourcesSeparately() const;
+
+  // Compute the results of a single resource, for rules whose
+  // AnalyzesResourcesSeparately() returns true.
+  // @return true iff the computation was completed without errors.
+  virtual bool AppendResultsForResource(const RuleInput& input,
+                                        const Resource& resource,
+                                        ResultProvider* result_provider);
+
   // Interpret the results structure and produce a formatted representation.
   //
   // @param results Results to interpret
@@ -99,7 +128,27 @@ class Rule {
   // deleted.
   virtual bool IsExperimental() const;
 
+  // Whether the Engine may re-evaluate this rule incrementally (see
+  // Engine::ComputeResultsIncrementally).  Rules that return true must name
+  // exactly one resource in each Result, compute each Result from nothing
+  // but that resource, and call RuleInput::ReusePreviousResults() before
+  // analyzing each resource.  Returns false by default.
+  virtual bool SupportsIncrementalResults() const;
+
  protected:
+  // Walk the DOM of the given input with the visitor returned by
+  // NewDomVisitor(), if there is a DOM.
+  // @return true iff the computation was completed without errors.
+  bool AppendResultsFromDomVisitor(const RuleInput& input,
+                                   ResultProvider* result_provider);
+
+  // Analyze each resource of the input with AppendResultsForResource(),
+  // skipping the resources whose previous results can be reused if the rule
+  // supports incremental results.
+  // @return true iff the computation was completed without errors.
+  bool AppendResultsForEachResource(const RuleInput& input,
+                                    ResultProvider* result_provider);
+
   // Compute the impact of a single rule suggestion.  The result should be a
   // nonnegative number, where zero means there is no room for improvement.
   // The relative scaling of this number should depend upon the
@@ -18,11 +18,18 @@
 #include "pagespeed/core/pagespeed_input.h"
 #include "pagespeed/core/resource.h"
 #include "pagespeed/core/resource_util.h"
+#include "pagespeed/core/result_provider.h"
+#include "pagespeed/proto/pagespeed_output.pb.h"
 
 namespace pagespeed {
 
 RuleInput::RuleInput(const PagespeedInput& pagespeed_input)
     : pagespeed_input_(&pagespeed_input),
+      cancellation_token_(NULL),
+      unchanged_resource_urls_(NULL),
+      previous_rule_results_(NULL),
+      images_classified_(false),
+      images_classified_successfully_(false),
       initialized_(false) {
   if (!pagespeed_input_->is_frozen()) {
     LOG(DFATAL) << "Passed non-frozen PagespeedInput to RuleInput.";
@@ -65,4 +72,80 @@ bool RuleInput::GetCompressedResponseBodySize(const Resource& resource,
   return true;
 }
 
+bool RuleInput::GetOnAndOffscreenImageResources(
+    const std::vector<const Resource*>** onscreen_resources,
+    const std::vector<const Resource*>** offscreen_resources,
+    const dom::ResourceRectMap** resource_to_rect_map) const {
+  if (!images_classified_) {
+    images_classified_ = true;
+    images_classified_successfully_ = dom::FindOnAndOffscreenImageResources(
+        *pagespeed_input_,
+        &onscreen_image_resources_,
+        &offscreen_image_resources_,
+        &image_resource_rects_);
+  }
+  if (!images_classified_successfully_) {
+    return false;
+  }
+  if (onscreen_resources != NULL) {
+    *onscreen_resources = &onscreen_image_resources_;
+  }
+  if (offscreen_resources != NULL) {
+    *offscreen_resources = &offscreen_image_resources_;
+  }
+  if (resource_to_rect_map != NULL) {
+    *resource_to_rect_map = &image_resource_rects_;
+  }
+  return true;
+}
+
+bool RuleInput::ReusePreviousResults(const Resource& resource,
+                                     ResultProvider* provider) const {
+  if (previous_rule_results_ == NULL || unchanged_resource_urls_ == NULL) {
+    return false;
+  }
+  const std::string& url = resource.GetRequestUrl();
+  if (unchanged_resource_urls_->count(url) == 0) {
+    return false;
+  }
+
+  // The resource had no results if it is missing from the map.
+  UrlToResultsMap::const_iterator iter = previous_results_by_url_.find(url);
+  if (iter != previous_results_by_url_.end()) {
+    const std::vector<const Result*>& results = iter->second;
+    for (std::vector<const Result*>::const_iterator it = results.begin(),
+             end = results.end();
+         it != end;
+         ++it) {
+      Result* result = provider->NewResult();
+      const int id = result->id();
+      result->CopyFrom(**it);
+      result->set_id(id);
+    }
+  }
+  return true;
+}
+
+void RuleInput::set_previous_rule_results(const RuleResults* rule_results) {
+  previous_rule_results_ = rule_results;
+  previous_results_by_url_.clear();
+  if (rule_results == NULL) {
+    return;
+  }
+  for (int idx = 0, num = rule_results->results_size(); idx < num; ++idx) {
+    const Result& result = rule_results->results(idx);
+    if (result.resource_urls_size() != 1) {
+      // Rules that support incremental results name exactly one resource
+      // in each result; anything else can not be attributed to a resource.
+      LOG(WARNING) << "Result of " << rule_results->rule_name()
+                   << " names " << result.resource_urls_size()
+                   << " resources.";
+      previous_rule_results_ = NULL;
+      previous_results_by_url_.clear();
+      return;
+    }
+    previous_results_by_url_[result.resource_urls(0)].push_back(&result);
+  }
+}
+
 }  // namespace pagespeed
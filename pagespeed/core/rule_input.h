@@ -16,14 +16,21 @@
 #define PAGESPEED_CORE_RULE_INPUT_H_
 
 #include <map>
+#include <set>
 #include <string>
+#include <vector>
 
 #include "base/basictypes.h"
+#include "pagespeed/core/cancellation.h"
+#include "pagespeed/core/resource_coordinate_finder.h"
 
 namespace pagespeed {
 
 class PagespeedInput;
 class Resource;
+class Result;
+class ResultProvider;
+class RuleResults;
 
 class RuleInput {
  public:
@@ -40,9 +47,69 @@ class RuleInput {
   bool GetCompressedResponseBodySize(const Resource& resource,
                                      int* output) const;
 
+  // Classify the images referenced from the DOM as on or offscreen (see
+  // dom::FindOnAndOffscreenImageResources), and find the rects at which
+  // each of them is displayed.  Any of the out parameters may be NULL; the
+  // others are pointed at data owned by the RuleInput.  Return true on
+  // success, false on error (e.g. if there is no DOM or viewport).  This
+  // method is memoized, so the DOM is traversed at most once no matter how
+  // many rules call it.
+  bool GetOnAndOffscreenImageResources(
+      const std::vector<const Resource*>** onscreen_resources,
+      const std::vector<const Resource*>** offscreen_resources,
+      const dom::ResourceRectMap** resource_to_rect_map) const;
+
+  // The token that the rule currently running should poll, and pass on to
+  // the minifiers, optimizers and visitors it invokes.  A rule that finds
+  // it cancelled should stop and return false from AppendResults; any
+  // results it already added are kept.  May be NULL.
+  const CancellationToken* cancellation_token() const {
+    return cancellation_token_;
+  }
+  bool IsCancelled() const {
+    return pagespeed::IsCancelled(cancellation_token_);
+  }
+
+  // Called by the Engine before running each rule.  Ownership is not
+  // transferred.
+  void set_cancellation_token(const CancellationToken* token) {
+    cancellation_token_ = token;
+  }
+
+  // During incremental analysis (see Engine::ComputeResultsIncrementally),
+  // if resource is unchanged since the previous analysis, add copies of the
+  // results that the running rule produced for it then to provider, and
+  // return true; the rule should then skip the resource.  Otherwise, and
+  // outside of incremental analysis, return false.  Only rules whose
+  // SupportsIncrementalResults() returns true may call this.
+  bool ReusePreviousResults(const Resource& resource,
+                            ResultProvider* provider) const;
+
+  // Called by the Engine before running any rule.  Ownership is not
+  // transferred; NULL (the default) means no resource is unchanged.
+  void set_unchanged_resource_urls(const std::set<std::string>* urls) {
+    unchanged_resource_urls_ = urls;
+  }
+
+  // Called by the Engine before running each rule, with the results of the
+  // rule from the previous analysis, or NULL if they can not be reused.
+  // Ownership is not transferred.
+  void set_previous_rule_results(const RuleResults* rule_results);
+
  private:
+  typedef std::map<std::string, std::vector<const Result*> > UrlToResultsMap;
+
   const PagespeedInput* pagespeed_input_;
+  const CancellationToken* cancellation_token_;
+  const std::set<std::string>* unchanged_resource_urls_;
+  const RuleResults* previous_rule_results_;
+  UrlToResultsMap previous_results_by_url_;
   mutable std::map<const Resource*, int> compressed_response_body_sizes_;
+  mutable bool images_classified_;
+  mutable bool images_classified_successfully_;
+  mutable std::vector<const Resource*> onscreen_image_resources_;
+  mutable std::vector<const Resource*> offscreen_image_resources_;
+  mutable dom::ResourceRectMap image_resource_rects_;
   bool initialized_;
 
   DISALLOW_COPY_AND_ASSIGN(RuleInput);
@@ -66,3 +66,63 @@ TEST_F(RuleInputTest, GetCompressedResponseBodySize) {
   ASSERT_NE(actual_compressed_size, cached_compressed_size);
   ASSERT_EQ(cached_compressed_size, compressed_size);
 }
+
+TEST_F(RuleInputTest, GetOnAndOffscreenImageResources) {
+  SetViewportWidthAndHeight(1024, 768);
+  NewPrimaryResource("http://test.com/");
+  CreateHtmlHeadBodyElements();
+  pagespeed_testing::FakeDomElement* img1 = NULL;
+  NewPngResource("http://test.com/a.png", body(), &img1);
+  img1->SetCoordinates(0, 0);
+  img1->SetActualWidthAndHeight(10, 10);
+  pagespeed_testing::FakeDomElement* img2 = NULL;
+  NewPngResource("http://test.com/b.png", body(), &img2);
+  img2->SetCoordinates(0, 1000);
+  img2->SetActualWidthAndHeight(20, 30);
+  Freeze();
+
+  RuleInput rule_input(*pagespeed_input());
+
+  const pagespeed::ResourceVector* onscreen = NULL;
+  const pagespeed::ResourceVector* offscreen = NULL;
+  const pagespeed::dom::ResourceRectMap* rects = NULL;
+  ASSERT_TRUE(rule_input.GetOnAndOffscreenImageResources(
+      &onscreen, &offscreen, &rects));
+  ASSERT_EQ(1U, onscreen->size());
+  ASSERT_EQ("http://test.com/a.png", (*onscreen)[0]->GetRequestUrl());
+  ASSERT_EQ(1U, offscreen->size());
+  ASSERT_EQ("http://test.com/b.png", (*offscreen)[0]->GetRequestUrl());
+  ASSERT_EQ(2U, rects->size());
+  const std::vector<pagespeed::DomRect>& b_rects =
+      rects->find((*offscreen)[0])->second;
+  ASSERT_EQ(1U, b_rects.size());
+  ASSERT_EQ(0, b_rects[0].x());
+  ASSERT_EQ(1000, b_rects[0].y());
+  ASSERT_EQ(20, b_rects[0].width());
+  ASSERT_EQ(30, b_rects[0].height());
+
+  // Move the offscreen image onscreen. As in the test above, this should
+  // not be possible once the input is frozen, but it lets us verify that
+  // the DOM is not traversed again.
+  img2->SetCoordinates(0, 0);
+  const pagespeed::ResourceVector* cached_onscreen = NULL;
+  const pagespeed::ResourceVector* cached_offscreen = NULL;
+  ASSERT_TRUE(rule_input.GetOnAndOffscreenImageResources(
+      &cached_onscreen, &cached_offscreen, NULL));
+  ASSERT_EQ(onscreen, cached_onscreen);
+  ASSERT_EQ(offscreen, cached_offscreen);
+  ASSERT_EQ(1U, cached_onscreen->size());
+  ASSERT_EQ(1U, cached_offscreen->size());
+}
+
+TEST_F(RuleInputTest, GetOnAndOffscreenImageResourcesNoViewport) {
+  NewPrimaryResource("http://test.com/");
+  CreateHtmlHeadBodyElements();
+  Freeze();
+
+  RuleInput rule_input(*pagespeed_input());
+  const pagespeed::ResourceVector* onscreen = NULL;
+  ASSERT_FALSE(rule_input.GetOnAndOffscreenImageResources(
+      &onscreen, NULL, NULL));
+  ASSERT_TRUE(onscreen == NULL);
+}
@@ -0,0 +1,195 @@
+// Copyright 2013 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pagespeed/core/site_analyzer.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "base/logging.h"
+#include "pagespeed/core/engine.h"
+#include "pagespeed/core/input_fingerprint.h"
+#include "pagespeed/core/pagespeed_input.h"
+
+namespace {
+
+bool ContainsRule(
+    const google::protobuf::RepeatedPtrField<std::string>& rule_names,
+    const std::string& rule_name) {
+  return std::find(rule_names.begin(), rule_names.end(), rule_name) !=
+      rule_names.end();
+}
+
+pagespeed::RuleResults* FindOrAddRuleResults(const std::string& rule_name,
+                                             pagespeed::Results* results) {
+  for (int idx = 0; idx < results->rule_results_size(); ++idx) {
+    if (results->rule_results(idx).rule_name() == rule_name) {
+      return results->mutable_rule_results(idx);
+    }
+  }
+  pagespeed::RuleResults* rule_results = results->add_rule_results();
+  rule_results->set_rule_name(rule_name);
+  return rule_results;
+}
+
+}  // namespace
+
+namespace pagespeed {
+
+SiteAnalyzer::SiteAnalyzer(const Engine* engine)
+    : engine_(engine), num_pages_(0) {
+  DCHECK(engine_);
+}
+
+SiteAnalyzer::~SiteAnalyzer() {}
+
+bool SiteAnalyzer::AnalyzePage(const PagespeedInput& input,
+                               Results* results) {
+  if (!input.is_frozen()) {
+    LOG(DFATAL) << "Attempting to analyze non-frozen input.";
+    return false;
+  }
+
+  InputFingerprint fingerprint;
+  input_fingerprint::ComputeInputFingerprint(input, &fingerprint);
+  const bool success = engine_->ComputeResultsIncrementally(
+      input, pool_, pool_fingerprint_, fingerprint, results);
+
+  AddToPool(*results, fingerprint);
+  AddToStats(*results, fingerprint);
+  ++num_pages_;
+  return success;
+}
+
+void SiteAnalyzer::AddToPool(const Results& results,
+                             const InputFingerprint& fingerprint) {
+  if (!pool_.has_version()) {
+    pool_.mutable_version()->CopyFrom(results.version());
+  }
+
+  std::set<std::string> new_urls;
+  for (int idx = 0; idx < fingerprint.resources_size(); ++idx) {
+    const ResourceFingerprint& resource = fingerprint.resources(idx);
+    if (pool_urls_.insert(resource.url()).second) {
+      new_urls.insert(resource.url());
+      pool_fingerprint_.add_resources()->CopyFrom(resource);
+    }
+  }
+  if (new_urls.empty()) {
+    return;
+  }
+
+  for (int idx = 0; idx < results.rule_results_size(); ++idx) {
+    const RuleResults& rule_results = results.rule_results(idx);
+    const std::string& rule_name = rule_results.rule_name();
+    if (!engine_->RuleSupportsIncrementalResults(rule_name) ||
+        ContainsRule(pool_.error_rules(), rule_name)) {
+      continue;
+    }
+    if (ContainsRule(results.error_rules(), rule_name)) {
+      // The results of the new resources may be incomplete, so the rule
+      // has to analyze every resource from now on.
+      pool_.add_error_rules(rule_name);
+      continue;
+    }
+    RuleResults* pool_rule_results = FindOrAddRuleResults(rule_name, &pool_);
+    for (int result_idx = 0; result_idx < rule_results.results_size();
+         ++result_idx) {
+      const Result& result = rule_results.results(result_idx);
+      if (result.resource_urls_size() == 1 &&
+          new_urls.count(result.resource_urls(0)) > 0) {
+        pool_rule_results->add_results()->CopyFrom(result);
+      }
+    }
+  }
+}
+
+void SiteAnalyzer::AddToStats(const Results& results,
+                              const InputFingerprint& fingerprint) {
+  std::map<std::string, std::string> url_to_digest;
+  for (int idx = 0; idx < fingerprint.resources_size(); ++idx) {
+    const ResourceFingerprint& resource = fingerprint.resources(idx);
+    url_to_digest[resource.url()] = resource.digest();
+    ResourceStats& stats = stats_[resource.digest()];
+    stats.url = resource.url();
+    ++stats.num_pages;
+  }
+
+  for (int idx = 0; idx < results.rule_results_size(); ++idx) {
+    const RuleResults& rule_results = results.rule_results(idx);
+    for (int result_idx = 0; result_idx < rule_results.results_size();
+         ++result_idx) {
+      const Result& result = rule_results.results(result_idx);
+      if (result.resource_urls_size() != 1) {
+        continue;
+      }
+      std::map<std::string, std::string>::const_iterator iter =
+          url_to_digest.find(result.resource_urls(0));
+      if (iter == url_to_digest.end()) {
+        continue;
+      }
+      ResourceStats& stats = stats_[iter->second];
+      stats.response_bytes_saved += result.savings().response_bytes_saved();
+      stats.rule_names.insert(rule_results.rule_name());
+    }
+  }
+}
+
+void SiteAnalyzer::ComputeSiteResults(SiteResults* site_results) const {
+  site_results->Clear();
+  site_results->set_num_pages(num_pages_);
+  site_results->set_num_unique_resources(static_cast<int>(stats_.size()));
+
+  std::vector<const DigestToStatsMap::value_type*> shared;
+  for (DigestToStatsMap::const_iterator iter = stats_.begin(),
+           end = stats_.end();
+       iter != end;
+       ++iter) {
+    if (iter->second.num_pages > 1) {
+      shared.push_back(&*iter);
+    }
+  }
+  std::sort(shared.begin(), shared.end(), HasGreaterSavings);
+
+  for (std::vector<const DigestToStatsMap::value_type*>::const_iterator
+           iter = shared.begin(), end = shared.end();
+       iter != end;
+       ++iter) {
+    const ResourceStats& stats = (*iter)->second;
+    SharedResource* resource = site_results->add_shared_resources();
+    resource->set_url(stats.url);
+    resource->set_digest((*iter)->first);
+    resource->set_num_pages(stats.num_pages);
+    resource->set_response_bytes_saved(stats.response_bytes_saved);
+    for (std::set<std::string>::const_iterator it = stats.rule_names.begin(),
+             end = stats.rule_names.end();
+         it != end;
+         ++it) {
+      resource->add_rule_names(*it);
+    }
+  }
+}
+
+bool SiteAnalyzer::HasGreaterSavings(const DigestToStatsMap::value_type* a,
+                                     const DigestToStatsMap::value_type* b) {
+  if (a->second.response_bytes_saved != b->second.response_bytes_saved) {
+    return a->second.response_bytes_saved > b->second.response_bytes_saved;
+  }
+  if (a->second.url != b->second.url) {
+    return a->second.url < b->second.url;
+  }
+  return a->first < b->first;
+}
+
+}  // namespace pagespeed
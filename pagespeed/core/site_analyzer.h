@@ -0,0 +1,99 @@
+// Copyright 2013 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PAGESPEED_CORE_SITE_ANALYZER_H_
+#define PAGESPEED_CORE_SITE_ANALYZER_H_
+
+#include <map>
+#include <set>
+#include <string>
+
+#include "base/basictypes.h"
+#include "pagespeed/proto/pagespeed_output.pb.h"
+
+namespace pagespeed {
+
+class Engine;
+class PagespeedInput;
+
+// Analyzes the pages of one site, which typically share most of their
+// stylesheets, scripts and images.  A resource is identified by its
+// digest (see input_fingerprint::ComputeResourceDigest), which covers its
+// URL and content.  The rules that support incremental results (see
+// Rule::SupportsIncrementalResults) analyze each resource only on the first
+// page that loads it, and copy those results on later pages; all other
+// rules analyze every page in full.  Once all pages are analyzed,
+// ComputeSiteResults ranks the resources shared between pages by the
+// bytes their optimization would save over the whole site.
+//
+// If several pages load one URL with different content, only the first
+// content is remembered, and the others are analyzed on each page.
+class SiteAnalyzer {
+ public:
+  // Ownership of engine is not transferred; it must outlive the
+  // SiteAnalyzer, and must have been initialized.
+  explicit SiteAnalyzer(const Engine* engine);
+  ~SiteAnalyzer();
+
+  // Computes the results of one page, which are the same as those of
+  // Engine::ComputeResults, and adds the page to the site rollup.  input
+  // must be frozen.
+  // @return true iff the computation was completed without errors.
+  bool AnalyzePage(const PagespeedInput& input, Results* results);
+
+  // Populates site_results from the pages analyzed so far.
+  void ComputeSiteResults(SiteResults* site_results) const;
+
+  int num_pages() const { return num_pages_; }
+
+ private:
+  struct ResourceStats {
+    ResourceStats() : num_pages(0), response_bytes_saved(0) {}
+
+    std::string url;
+    int num_pages;
+    int64 response_bytes_saved;
+    std::set<std::string> rule_names;
+  };
+
+  typedef std::map<std::string, ResourceStats> DigestToStatsMap;
+
+  // Orders resources by decreasing savings, then by URL and digest.
+  static bool HasGreaterSavings(const DigestToStatsMap::value_type* a,
+                                const DigestToStatsMap::value_type* b);
+
+  // Adds the results of the resources that are not yet in the pool to it.
+  void AddToPool(const Results& results, const InputFingerprint& fingerprint);
+
+  // Adds a page to the per-resource statistics.
+  void AddToStats(const Results& results, const InputFingerprint& fingerprint);
+
+  const Engine* const engine_;
+  int num_pages_;
+
+  // The results of the incremental rules for each resource in
+  // pool_fingerprint_, in the form Engine::ComputeResultsIncrementally
+  // expects of a previous analysis.
+  Results pool_;
+  InputFingerprint pool_fingerprint_;
+  std::set<std::string> pool_urls_;
+
+  DigestToStatsMap stats_;
+
+  DISALLOW_COPY_AND_ASSIGN(SiteAnalyzer);
+};
+
+}  // namespace pagespeed
+
+#endif  // PAGESPEED_CORE_SITE_ANALYZER_H_
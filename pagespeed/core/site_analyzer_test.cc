@@ -0,0 +1,255 @@
+// Copyright 2013 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+#include <vector>
+
+#include "base/memory/scoped_ptr.h"
+#include "pagespeed/core/engine.h"
+#include "pagespeed/core/pagespeed_input.h"
+#include "pagespeed/core/resource.h"
+#include "pagespeed/core/result_provider.h"
+#include "pagespeed/core/rule.h"
+#include "pagespeed/core/rule_input.h"
+#include "pagespeed/core/site_analyzer.h"
+#include "pagespeed/l10n/l10n.h"
+#include "pagespeed/proto/pagespeed_output.pb.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+using pagespeed::Engine;
+using pagespeed::InputInformation;
+using pagespeed::PagespeedInput;
+using pagespeed::Resource;
+using pagespeed::Result;
+using pagespeed::ResultProvider;
+using pagespeed::Results;
+using pagespeed::Rule;
+using pagespeed::RuleFormatter;
+using pagespeed::RuleInput;
+using pagespeed::SharedResource;
+using pagespeed::SiteAnalyzer;
+using pagespeed::SiteResults;
+
+namespace {
+
+// A rule that suggests saving half of the body of every resource, and
+// records which resources it analyzed.
+class HalfBodyRule : public Rule {
+ public:
+  HalfBodyRule(const char* name, bool incremental)
+      : Rule(pagespeed::InputCapabilities()),
+        name_(name),
+        incremental_(incremental) {}
+
+  virtual const char* name() const { return name_; }
+
+  virtual pagespeed::UserFacingString header() const {
+    return not_localized("Half body rule");
+  }
+
+  virtual bool AppendResults(const RuleInput& input,
+                             ResultProvider* provider) {
+    const PagespeedInput& pagespeed_input = input.pagespeed_input();
+    for (int idx = 0, num = pagespeed_input.num_resources(); idx < num;
+         ++idx) {
+      const Resource& resource = pagespeed_input.GetResource(idx);
+      if (incremental_ && input.ReusePreviousResults(resource, provider)) {
+        continue;
+      }
+      analyzed_urls_.push_back(resource.GetRequestUrl());
+      const int size = resource.GetResponseBody().size();
+      if (size > 0) {
+        Result* result = provider->NewResult();
+        result->add_resource_urls(resource.GetRequestUrl());
+        result->set_original_response_bytes(size);
+        result->mutable_savings()->set_response_bytes_saved(size / 2);
+      }
+    }
+    return true;
+  }
+
+  virtual void FormatResults(const pagespeed::ResultVector& results,
+                             RuleFormatter* formatter) {}
+
+  virtual double ComputeResultImpact(const InputInformation& input_info,
+                                     const Result& result) {
+    return result.savings().response_bytes_saved();
+  }
+
+  virtual bool SupportsIncrementalResults() const { return incremental_; }
+
+  std::vector<std::string>* analyzed_urls() { return &analyzed_urls_; }
+
+ private:
+  const char* name_;
+  const bool incremental_;
+  std::vector<std::string> analyzed_urls_;
+
+  DISALLOW_COPY_AND_ASSIGN(HalfBodyRule);
+};
+
+class SiteAnalyzerTest : public ::testing::Test {
+ protected:
+  virtual void SetUp() {
+    incremental_rule_ = new HalfBodyRule("incremental", true);
+    full_rule_ = new HalfBodyRule("full", false);
+    std::vector<Rule*> rules;
+    rules.push_back(incremental_rule_);
+    rules.push_back(full_rule_);
+    engine_.reset(new Engine(&rules));
+    engine_->Init();
+    analyzer_.reset(new SiteAnalyzer(engine_.get()));
+  }
+
+  void AddResource(const char* url, const char* body, PagespeedInput* input) {
+    Resource* resource = new Resource;
+    resource->SetRequestUrl(url);
+    resource->SetRequestMethod("GET");
+    resource->SetResponseStatusCode(200);
+    resource->SetResponseBody(body);
+    ASSERT_TRUE(input->AddResource(resource));
+  }
+
+  // Analyzes input as the next page of the site, and checks that the
+  // results match those of an independent analysis.
+  void AnalyzeAndCheck(PagespeedInput* input) {
+    input->Freeze();
+    Results results;
+    ASSERT_TRUE(analyzer_->AnalyzePage(*input, &results));
+
+    // Set aside the URLs the rules analyzed for the site, so that the
+    // independent analysis does not add to them.
+    Results expected;
+    std::vector<std::string> incremental_urls;
+    incremental_urls.swap(*incremental_rule_->analyzed_urls());
+    std::vector<std::string> full_urls;
+    full_urls.swap(*full_rule_->analyzed_urls());
+    ASSERT_TRUE(engine_->ComputeResults(*input, &expected));
+    EXPECT_EQ(expected.SerializeAsString(), results.SerializeAsString());
+    incremental_urls.swap(*incremental_rule_->analyzed_urls());
+    full_urls.swap(*full_rule_->analyzed_urls());
+  }
+
+  // Owned by engine_.
+  HalfBodyRule* incremental_rule_;
+  HalfBodyRule* full_rule_;
+  scoped_ptr<Engine> engine_;
+  scoped_ptr<SiteAnalyzer> analyzer_;
+};
+
+TEST_F(SiteAnalyzerTest, SharedResourcesAreAnalyzedOnce) {
+  PagespeedInput page1;
+  AddResource("http://a.com/", "page1", &page1);
+  AddResource("http://a.com/site.css", "css", &page1);
+  AddResource("http://a.com/site.js", "javascript", &page1);
+  AnalyzeAndCheck(&page1);
+
+  PagespeedInput page2;
+  AddResource("http://a.com/2", "page2", &page2);
+  AddResource("http://a.com/site.css", "css", &page2);
+  AddResource("http://a.com/site.js", "javascript", &page2);
+  AnalyzeAndCheck(&page2);
+
+  PagespeedInput page3;
+  AddResource("http://a.com/3", "page3", &page3);
+  AddResource("http://a.com/site.js", "javascript", &page3);
+  AnalyzeAndCheck(&page3);
+
+  const std::vector<std::string>& incremental_urls =
+      *incremental_rule_->analyzed_urls();
+  ASSERT_EQ(5U, incremental_urls.size());
+  EXPECT_EQ("http://a.com/", incremental_urls[0]);
+  EXPECT_EQ("http://a.com/site.css", incremental_urls[1]);
+  EXPECT_EQ("http://a.com/site.js", incremental_urls[2]);
+  EXPECT_EQ("http://a.com/2", incremental_urls[3]);
+  EXPECT_EQ("http://a.com/3", incremental_urls[4]);
+  EXPECT_EQ(8U, full_rule_->analyzed_urls()->size());
+  EXPECT_EQ(3, analyzer_->num_pages());
+}
+
+TEST_F(SiteAnalyzerTest, ChangedContentIsAnalyzedAgain) {
+  PagespeedInput page1;
+  AddResource("http://a.com/site.css", "css", &page1);
+  AnalyzeAndCheck(&page1);
+
+  PagespeedInput page2;
+  AddResource("http://a.com/site.css", "changed css", &page2);
+  AnalyzeAndCheck(&page2);
+
+  PagespeedInput page3;
+  AddResource("http://a.com/site.css", "css", &page3);
+  AnalyzeAndCheck(&page3);
+
+  const std::vector<std::string>& incremental_urls =
+      *incremental_rule_->analyzed_urls();
+  ASSERT_EQ(2U, incremental_urls.size());
+  EXPECT_EQ("http://a.com/site.css", incremental_urls[0]);
+  EXPECT_EQ("http://a.com/site.css", incremental_urls[1]);
+
+  SiteResults site_results;
+  analyzer_->ComputeSiteResults(&site_results);
+  EXPECT_EQ(3, site_results.num_pages());
+  EXPECT_EQ(2, site_results.num_unique_resources());
+  ASSERT_EQ(1, site_results.shared_resources_size());
+  EXPECT_EQ(2, site_results.shared_resources(0).num_pages());
+}
+
+TEST_F(SiteAnalyzerTest, SiteResultsRankSharedResources) {
+  PagespeedInput page1;
+  AddResource("http://a.com/", "page one", &page1);
+  AddResource("http://a.com/small.css", "css", &page1);
+  AddResource("http://a.com/large.js", "javascript", &page1);
+  AddResource("http://a.com/empty.js", "", &page1);
+  AnalyzeAndCheck(&page1);
+
+  PagespeedInput page2;
+  AddResource("http://a.com/2", "page two", &page2);
+  AddResource("http://a.com/small.css", "css", &page2);
+  AddResource("http://a.com/large.js", "javascript", &page2);
+  AddResource("http://a.com/empty.js", "", &page2);
+  AnalyzeAndCheck(&page2);
+
+  SiteResults site_results;
+  analyzer_->ComputeSiteResults(&site_results);
+  EXPECT_EQ(2, site_results.num_pages());
+  EXPECT_EQ(5, site_results.num_unique_resources());
+  ASSERT_EQ(3, site_results.shared_resources_size());
+
+  const SharedResource& large = site_results.shared_resources(0);
+  EXPECT_EQ("http://a.com/large.js", large.url());
+  EXPECT_EQ(2, large.num_pages());
+  // Each of the two rules saves 5 bytes on each of the two pages.
+  EXPECT_EQ(20, large.response_bytes_saved());
+  ASSERT_EQ(2, large.rule_names_size());
+  EXPECT_EQ("full", large.rule_names(0));
+  EXPECT_EQ("incremental", large.rule_names(1));
+
+  const SharedResource& small = site_results.shared_resources(1);
+  EXPECT_EQ("http://a.com/small.css", small.url());
+  EXPECT_EQ(4, small.response_bytes_saved());
+
+  const SharedResource& empty = site_results.shared_resources(2);
+  EXPECT_EQ("http://a.com/empty.js", empty.url());
+  EXPECT_EQ(0, empty.response_bytes_saved());
+  EXPECT_EQ(0, empty.rule_names_size());
+}
+
+TEST_F(SiteAnalyzerTest, NoPages) {
+  SiteResults site_results;
+  analyzer_->ComputeSiteResults(&site_results);
+  EXPECT_EQ(0, site_results.num_pages());
+  EXPECT_EQ(0, site_results.shared_resources_size());
+}
+
+}  // namespace
@@ -15,6 +15,7 @@
 #include "pagespeed/core/string_util.h"
 
 #include <errno.h>
+#include <string.h>  // for memcpy
 
 #include <algorithm>  // for lexicographical_compare
 #include <functional> // for trim
@@ -110,9 +111,64 @@ bool StringCaseEndsWith(const base::StringPiece& str,
 }
 
 std::string IntToString(int value) {
-  std::ostringstream sstream;
-  sstream << value;
-  return sstream.str();
+  return Int64ToString(value);
+}
+
+std::string Int64ToString(int64 value) {
+  // Enough room for the 19 digits of kint64max, plus a sign.
+  char buf[20];
+  char* const end = buf + arraysize(buf);
+  char* p = end;
+  // Negate in unsigned arithmetic so that kint64min does not overflow.
+  uint64 magnitude = static_cast<uint64>(value);
+  if (value < 0) {
+    magnitude = 0 - magnitude;
+  }
+  do {
+    *--p = static_cast<char>('0' + magnitude % 10);
+    magnitude /= 10;
+  } while (magnitude != 0);
+  if (value < 0) {
+    *--p = '-';
+  }
+  return std::string(p, end - p);
+}
+
+uint64 Hash64(const base::StringPiece& data) {
+  const uint64 kMul = GG_ULONGLONG(0xc6a4a7935bd1e995);
+  const int kShift = 47;
+  const size_t len = data.size();
+  const char* p = data.data();
+  const char* const words_end = p + (len & ~static_cast<size_t>(7));
+
+  uint64 h = GG_ULONGLONG(0x9747b28c1f3d5a7b) ^ (len * kMul);
+  for (; p != words_end; p += 8) {
+    // memcpy instead of a cast, since response bodies need not be aligned.
+    // Compilers turn this into a single load.
+    uint64 k;
+    memcpy(&k, p, sizeof(k));
+    k *= kMul;
+    k ^= k >> kShift;
+    k *= kMul;
+    h ^= k;
+    h *= kMul;
+  }
+  // Mix in the remaining 0-7 bytes.  The byte order differs from the word
+  // loop above on big-endian hosts, which only affects the particular hash
+  // values, not their quality.
+  const size_t remaining = len & 7;
+  if (remaining > 0) {
+    uint64 k = 0;
+    for (size_t i = 0; i < remaining; ++i) {
+      k |= static_cast<uint64>(static_cast<unsigned char>(p[i])) << (8 * i);
+    }
+    h ^= k;
+    h *= kMul;
+  }
+  h ^= h >> kShift;
+  h *= kMul;
+  h ^= h >> kShift;
+  return h;
 }
 
 std::string DoubleToString(double value) {
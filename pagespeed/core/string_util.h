@@ -19,6 +19,7 @@
 #include <string>
 #include <vector>
 
+#include "base/basictypes.h"
 #include "base/string_piece.h"
 #include "pagespeed/core/compiler_specific.h"
 
@@ -63,11 +64,21 @@ bool StringCaseEndsWith(const base::StringPiece& str,
                         const base::StringPiece& suffix);
 
 std::string IntToString(int value);
+// Formats value in base 10 without consulting the global locale or
+// allocating beyond the returned string, so it is safe to call
+// concurrently from any thread.
+std::string Int64ToString(int64 value);
 bool StringToInt(const std::string& input, int* output);
 std::string DoubleToString(double value);
 
 std::string JoinString(const std::vector<std::string>& parts, char s);
 
+// Computes a 64-bit non-cryptographic hash (MurmurHash64A) of the given
+// bytes, reading them a word at a time.  Equal inputs always hash equally;
+// unequal inputs collide with probability on the order of 2^-64, so callers
+// that need exact equality must still compare the inputs when hashes match.
+uint64 Hash64(const base::StringPiece& data);
+
 // Replace placeholders in a format string with their string values.  For a
 // given key "FOO", the placeholder in the format string should be "%(FOO)s".
 // Percent signs can be escaped by doubling them.  For example, if the map is
@@ -87,6 +87,14 @@ TEST(StringUtilTest, IntToString) {
   EXPECT_STREQ("-99999", IntToString(-99999).c_str());
 }
 
+TEST(StringUtilTest, Int64ToString) {
+  EXPECT_EQ("0", Int64ToString(0));
+  EXPECT_EQ("-1", Int64ToString(-1));
+  EXPECT_EQ("4294967296", Int64ToString(GG_LONGLONG(4294967296)));
+  EXPECT_EQ("9223372036854775807", Int64ToString(kint64max));
+  EXPECT_EQ("-9223372036854775808", Int64ToString(kint64min));
+}
+
 TEST(StringUtilTest, StringToInt) {
   static const struct {
     std::string input;
@@ -320,4 +328,29 @@ TEST(StringUtilTest, ContainsOnlyWhitespaceASCII) {
   EXPECT_FALSE(ContainsOnlyWhitespaceASCII("\thello\r \n  "));
 }
 
+TEST(StringUtilTest, Hash64) {
+  EXPECT_EQ(Hash64(""), Hash64(std::string()));
+  EXPECT_EQ(Hash64("hello, world"), Hash64(std::string("hello, world")));
+  EXPECT_NE(Hash64(""), Hash64(std::string(1, '\0')));
+  EXPECT_NE(Hash64(std::string(1, '\0')), Hash64(std::string(2, '\0')));
+
+  // Every tail length, and a change in every byte position, must affect the
+  // hash.
+  const std::string data = "abcdefghijklmnopqrstuvwxyz";
+  for (size_t len = 0; len < data.size(); ++len) {
+    const std::string prefix = data.substr(0, len);
+    EXPECT_NE(Hash64(prefix), Hash64(data.substr(0, len + 1)));
+    for (size_t i = 0; i < len; ++i) {
+      std::string modified = prefix;
+      modified[i] ^= 1;
+      EXPECT_NE(Hash64(prefix), Hash64(modified)) << len << " " << i;
+    }
+  }
+
+  // The hash depends only on the bytes, not on their alignment.
+  const std::string padded = "x" + data;
+  EXPECT_EQ(Hash64(data),
+            Hash64(base::StringPiece(padded.data() + 1, data.size())));
+}
+
 }  // namespace
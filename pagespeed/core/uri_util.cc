@@ -22,6 +22,9 @@
 #include "googleurl/src/gurl.h"
 #include "googleurl/src/url_canon.h"
 #include "pagespeed/core/dom.h"
+#include "pagespeed/core/pagespeed_input.h"
+#include "pagespeed/core/resource.h"
+#include "pagespeed/core/resource_collection.h"
 #include "pagespeed/core/string_util.h"
 #include "third_party/domain_registry_provider/src/domain_registry/domain_registry.h"
 
@@ -87,21 +90,41 @@ GURL GetUriWithoutFragmentInternal(const GURL& url) {
   return url.ReplaceComponents(clear_fragment);
 }
 
-// Code based on Chromium's
-// RegistryControlledDomainService::GetDomainAndRegistryImpl.
-std::string GetDomainAndRegistryImpl(const std::string& host) {
+// Code based on GURL::HostIsIPAddress.
+bool HostIsIPAddress(const std::string& host) {
+  url_canon::RawCanonOutputT<char, 128> ignored_output;
+  url_canon::CanonHostInfo host_info;
+  url_canon::CanonicalizeIPAddress(host.data(),
+                                   url_parse::Component(0, host.length()),
+                                   &ignored_output,
+                                   &host_info);
+  return host_info.IsIPAddress();
+}
+
+// Returns the length of the registry of host, or 0 if host has no
+// registry, or is itself a registry.
+size_t GetRegistryLengthForHost(const std::string& host) {
   DCHECK(!host.empty());
 
   // Skip leading dots.
   const size_t host_check_begin = host.find_first_not_of('.');
   if (host_check_begin == std::string::npos)
-    return std::string();  // Host is only dots.
+    return 0;  // Host is only dots.
   const size_t trimmed_host_len = host.length() - host_check_begin;
 
   // Find the length of the registry for this host.
   const size_t registry_length =
       GetRegistryLengthAllowUnknownRegistries(host.c_str());
-  if (registry_length == 0 || registry_length >= trimmed_host_len)
+  if (registry_length >= trimmed_host_len)
+    return 0;
+  return registry_length;
+}
+
+// Code based on Chromium's
+// RegistryControlledDomainService::GetDomainAndRegistryImpl.
+std::string GetDomainAndRegistryImpl(const std::string& host) {
+  const size_t registry_length = GetRegistryLengthForHost(host);
+  if (registry_length == 0)
     return std::string();  // No registry.
   // The "2" in this next line is 1 for the dot, plus a 1-char minimum preceding
   // subcomponent length.
@@ -241,6 +264,45 @@ std::string GetDomainAndRegistry(const std::string& url) {
       gurl.possibly_invalid_spec().data() + host.begin, host.len));
 }
 
+std::string GetDomainAndRegistryForHost(const std::string& host) {
+  if (host.empty() || HostIsIPAddress(host))
+    return std::string();
+  return GetDomainAndRegistryImpl(host);
+}
+
+std::string GetRegistryForHost(const std::string& host) {
+  if (host.empty() || HostIsIPAddress(host))
+    return std::string();
+  const size_t registry_length = GetRegistryLengthForHost(host);
+  if (registry_length == 0)
+    return std::string();
+  return host.substr(host.length() - registry_length);
+}
+
+std::string GetDomainAndRegistry(const PagespeedInput& input,
+                                 const Resource& resource) {
+  const ResourceCollection& collection = input.GetResourceCollection();
+  const int host_id = collection.GetResourceHostId(resource);
+  if (host_id < 0) {
+    LOG(DFATAL) << "Resource " << resource.GetRequestUrl()
+                << " does not belong to the input.";
+    return GetDomainAndRegistry(resource.GetRequestUrl());
+  }
+  return collection.GetHostDomainAndRegistry(host_id);
+}
+
+std::string GetRegistry(const PagespeedInput& input,
+                        const Resource& resource) {
+  const ResourceCollection& collection = input.GetResourceCollection();
+  const int host_id = collection.GetResourceHostId(resource);
+  if (host_id < 0) {
+    LOG(DFATAL) << "Resource " << resource.GetRequestUrl()
+                << " does not belong to the input.";
+    return GetRegistryForHost(resource.GetHost());
+  }
+  return collection.GetHostRegistry(host_id);
+}
+
 const char kFetchType[] = "fetch";
 const char kEvalType[] = "eval";
 const char kBrowsingContextType[] = "context";
@@ -22,6 +22,8 @@
 namespace pagespeed {
 
 class DomDocument;
+class PagespeedInput;
+class Resource;
 
 namespace uri_util {
 
@@ -86,6 +88,24 @@ bool IsExternalResourceUrl(const std::string& uri);
 //   http://foo.bar/file.html        -> "foo.bar"     (no rule; assume bar)
 std::string GetDomainAndRegistry(const std::string& url);
 
+// Like GetDomainAndRegistry, but takes a host name, e.g. as returned by
+// GetHost, rather than a URL, which saves parsing the URL again.
+std::string GetDomainAndRegistryForHost(const std::string& host);
+
+// Returns the registry of the given host name, e.g. "co.uk" for
+// "a.b.co.uk", or an empty string in the cases where
+// GetDomainAndRegistryForHost would.
+std::string GetRegistryForHost(const std::string& host);
+
+// Like GetDomainAndRegistry(resource.GetRequestUrl()) and the registry of
+// its host, for a resource of the given frozen input.  The answers for
+// each host are computed once, when the input is frozen, so these are
+// much cheaper to call once per resource.
+std::string GetDomainAndRegistry(const PagespeedInput& input,
+                                 const Resource& resource);
+std::string GetRegistry(const PagespeedInput& input,
+                        const Resource& resource);
+
 enum UriType {
   FETCH, EVAL, BROWSING_CONTEXT
 };
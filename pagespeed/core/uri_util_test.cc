@@ -25,8 +25,10 @@ using pagespeed_testing::FakeDomDocument;
 using pagespeed_testing::FakeDomElement;
 using pagespeed::uri_util::GetActionUriFromResourceUrl;
 using pagespeed::uri_util::GetDomainAndRegistry;
+using pagespeed::uri_util::GetDomainAndRegistryForHost;
 using pagespeed::uri_util::GetHost;
 using pagespeed::uri_util::GetPath;
+using pagespeed::uri_util::GetRegistryForHost;
 using pagespeed::uri_util::GetResourceUrlFromActionUri;
 using pagespeed::uri_util::UriType;
 
@@ -202,6 +204,30 @@ TEST(UriUtilTest, GetDomainAndRegistry) {
   EXPECT_EQ("", GetDomainAndRegistry("http:// . "));
 }
 
+TEST(UriUtilTest, GetDomainAndRegistryForHost) {
+  EXPECT_EQ("google.com", GetDomainAndRegistryForHost("www.google.com"));
+  EXPECT_EQ("google.com", GetDomainAndRegistryForHost("..google.com"));
+  EXPECT_EQ("b.co.uk", GetDomainAndRegistryForHost("a.b.co.uk"));
+  EXPECT_EQ("foo.bar", GetDomainAndRegistryForHost("foo.bar"));
+  EXPECT_EQ("", GetDomainAndRegistryForHost(""));
+  EXPECT_EQ("", GetDomainAndRegistryForHost("foo.com.."));
+  EXPECT_EQ("", GetDomainAndRegistryForHost("192.168.0.1"));
+  EXPECT_EQ("", GetDomainAndRegistryForHost("[::1]"));
+  EXPECT_EQ("", GetDomainAndRegistryForHost("bar"));
+  EXPECT_EQ("", GetDomainAndRegistryForHost("co.uk"));
+  EXPECT_EQ("", GetDomainAndRegistryForHost("..."));
+}
+
+TEST(UriUtilTest, GetRegistryForHost) {
+  EXPECT_EQ("com", GetRegistryForHost("www.google.com"));
+  EXPECT_EQ("co.uk", GetRegistryForHost("a.b.co.uk"));
+  EXPECT_EQ("bar", GetRegistryForHost("foo.bar"));
+  EXPECT_EQ("", GetRegistryForHost(""));
+  EXPECT_EQ("", GetRegistryForHost("192.168.0.1"));
+  EXPECT_EQ("", GetRegistryForHost("bar"));
+  EXPECT_EQ("", GetRegistryForHost("co.uk"));
+}
+
 TEST(UriUtil, CreateActionUri) {
   std::string action_uri;
   GetActionUriFromResourceUrl(pagespeed::uri_util::BROWSING_CONTEXT,
@@ -0,0 +1,69 @@
+// Copyright 2013 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <set>
+#include <string>
+
+#include "pagespeed/core/string_util.h"
+#include "pagespeed/css/cssmin.h"
+#include "pagespeed/css/external_resource_finder.h"
+#include "pagespeed/testing/benchmark.h"
+
+namespace {
+
+// About 200KB of unminified CSS, typical of a framework stylesheet.
+std::string MakeCss() {
+  std::string css;
+  for (int i = 0; i < 1000; ++i) {
+    css += pagespeed::string_util::StringPrintf(
+        "/* Styles for button variant %d. */\n"
+        ".btn-%d:hover,\n"
+        ".nav > li.item-%d {\n"
+        "  color: #%06x;\n"
+        "  margin: 0 auto;\n"
+        "  padding: 4px 8px;\n"
+        "  background: url(img/sprite-%d.png) no-repeat -%dpx 0;\n"
+        "  font-family: \"Helvetica Neue\", Arial, sans-serif;\n"
+        "}\n\n", i, i, i, (i * 7919) & 0xffffff, i % 50, i % 300);
+  }
+  return css;
+}
+
+PAGESPEED_BENCHMARK(BM_MinifyCss) {
+  const std::string css = MakeCss();
+  std::string out;
+  state->SetBytesPerIteration(css.size());
+  state->ResetTiming();
+  for (int i = 0; i < state->iterations(); ++i) {
+    out.clear();
+    if (!pagespeed::css::MinifyCss(css, &out)) {
+      state->SetError("MinifyCss failed");
+      return;
+    }
+  }
+}
+
+PAGESPEED_BENCHMARK(BM_FindExternalResourcesInCssBlock) {
+  const std::string css = MakeCss();
+  std::set<std::string> urls;
+  state->SetBytesPerIteration(css.size());
+  state->ResetTiming();
+  for (int i = 0; i < state->iterations(); ++i) {
+    urls.clear();
+    pagespeed::css::FindExternalResourcesInCssBlock(
+        "http://www.example.com/styles/main.css", css, &urls);
+  }
+}
+
+}  // namespace
@@ -19,6 +19,7 @@
 #include "base/basictypes.h"
 #include "base/logging.h"
 #include "base/string_piece.h"
+#include "pagespeed/core/cancellation.h"
 #include "pagespeed/core/string_util.h"
 
 namespace {
@@ -118,7 +119,9 @@ bool IsExtendableOnLeft(int c) {
 template<typename OutputConsumer>
 class Minifier {
  public:
-  Minifier(const base::StringPiece& input, std::string* output);
+  Minifier(const base::StringPiece& input,
+           const pagespeed::CancellationToken* cancel,
+           std::string* output);
   ~Minifier() {}
 
   // Return a pointer to an OutputConsumer instance if minification was
@@ -144,17 +147,21 @@ class Minifier {
   Whitespace whitespace_;  // whitespace since the previous token
   int prev_token_;
   bool error_;
+  // Minification fails once this is cancelled.  May be NULL.
+  const pagespeed::CancellationToken* cancel_;
 };
 
 template<typename OutputConsumer>
 Minifier<OutputConsumer>::Minifier(const base::StringPiece& input,
+                                   const pagespeed::CancellationToken* cancel,
                                    std::string* output)
   : input_(input),
     index_(0),
     output_(output),
     whitespace_(NO_WHITESPACE),
     prev_token_(kStartToken),
-    error_(false) {}
+    error_(false),
+    cancel_(cancel) {}
 
 template<typename OutputConsumer>
 OutputConsumer* Minifier<OutputConsumer>::GetOutput() {
@@ -238,7 +245,12 @@ void Minifier<OutputConsumer>::ConsumeString() {
 
 template<typename OutputConsumer>
 void Minifier<OutputConsumer>::Minify() {
+  pagespeed::CancellationPoller poller(cancel_);
   while (index_ < input_.size() && !error_) {
+    if (poller.IsCancelled()) {
+      error_ = true;
+      break;
+    }
     const char ch = input_[index_];
     // Track whitespace since the previous token.  NO_WHITESPACE means no
     // whitespace; LINEBREAK means there's been at least one linebreak; SPACE
@@ -277,12 +289,24 @@ namespace pagespeed {
 namespace css {
 
 bool MinifyCss(const std::string& input, std::string* out) {
-  Minifier<StringConsumer> minifier(input, out);
-  return (minifier.GetOutput() != NULL);
+  return MinifyCss(input, NULL, out);
 }
 
 bool GetMinifiedCssSize(const std::string& input, int* minified_size) {
-  Minifier<SizeConsumer> minifier(input, NULL);
+  return GetMinifiedCssSize(input, NULL, minified_size);
+}
+
+bool MinifyCss(const std::string& input,
+               const CancellationToken* cancel,
+               std::string* out) {
+  Minifier<StringConsumer> minifier(input, cancel, out);
+  return (minifier.GetOutput() != NULL);
+}
+
+bool GetMinifiedCssSize(const std::string& input,
+                        const CancellationToken* cancel,
+                        int* minified_size) {
+  Minifier<SizeConsumer> minifier(input, cancel, NULL);
   SizeConsumer* output = minifier.GetOutput();
   if (output) {
     *minified_size = output->size();
@@ -21,6 +21,8 @@
 
 namespace pagespeed {
 
+class CancellationToken;
+
 namespace css {
 
 // Minifies CSS by removing comments and whitespaces.
@@ -30,6 +32,15 @@ bool MinifyCss(const std::string& input, std::string* out);
 // output.
 bool GetMinifiedCssSize(const std::string& input, int* minified_size);
 
+// As above, but give up and return false once cancel is cancelled.  cancel
+// may be NULL.
+bool MinifyCss(const std::string& input,
+               const CancellationToken* cancel,
+               std::string* out);
+bool GetMinifiedCssSize(const std::string& input,
+                        const CancellationToken* cancel,
+                        int* minified_size);
+
 }  // namespace css
 
 }  // namespace pagespeed
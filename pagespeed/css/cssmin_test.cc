@@ -14,6 +14,7 @@
 
 #include <string>
 
+#include "pagespeed/core/cancellation.h"
 #include "pagespeed/css/cssmin.h"
 #include "testing/gtest/include/gtest/gtest.h"
 
@@ -139,4 +140,21 @@ TEST_F(CssminTest, DoNotJoinTokensSeparatedByComment1) {
                     ".foo .bar{color:blue;}");
 }
 
+TEST_F(CssminTest, Cancellation) {
+  std::string input;
+  for (int i = 0; i < 1000; ++i) {
+    input.append("body { color : red ; }\n");
+  }
+  pagespeed::CancellationToken token;
+  std::string output;
+  int size = 0;
+  ASSERT_TRUE(pagespeed::css::MinifyCss(input, &token, &output));
+  ASSERT_TRUE(pagespeed::css::GetMinifiedCssSize(input, &token, &size));
+  ASSERT_EQ(static_cast<int>(output.size()), size);
+
+  token.Cancel();
+  ASSERT_FALSE(pagespeed::css::MinifyCss(input, &token, &output));
+  ASSERT_FALSE(pagespeed::css::GetMinifiedCssSize(input, &token, &size));
+}
+
 }  // namespace
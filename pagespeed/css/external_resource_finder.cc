@@ -23,12 +23,11 @@ using pagespeed::css::CssTokenizer;
 
 namespace {
 
-const char* kCssWhitespaceChars = " \t\r\n\f";
 const char* kCommentStart = "/*";
 const char* kCommentEnd = "*/";
 const char* kCssImportDirective = "@import";
 const char* kCssUrlDirective = "url(";
-const char* kFragmentIdentifier = "#";
+const char kFragmentIdentifier = '#';
 const size_t kCommentStartLen = strlen(kCommentStart);
 const size_t kCommentEndLen = strlen(kCommentEnd);
 const size_t kCssUrlDirectiveLen = strlen(kCssUrlDirective);
@@ -47,46 +46,49 @@ inline bool IsIdentChar(unsigned char candidate) {
       candidate == '-' || candidate == '_' || candidate == '.';
 }
 
-}  // namespace
-
-namespace pagespeed {
-
-namespace css {
-
+inline bool IsCssWhitespace(char candidate) {
+  return candidate == ' ' || candidate == '\t' || candidate == '\r' ||
+      candidate == '\n' || candidate == '\f';
+}
 
-void FindExternalResourcesInCssResource(
-    const Resource& resource,
-    std::set<std::string>* external_resource_urls) {
-  if (resource.GetResourceType() != pagespeed::CSS) {
-    LOG(DFATAL) << "Non-CSS resource passed to"
-                << " FindExternalResourcesInCssResource.";
-    return;
+// Trims the same characters as string_util::TrimWhitespaceASCII, without
+// copying.
+void TrimWhitespaceASCII(base::StringPiece* str) {
+  size_t begin = 0;
+  size_t end = str->size();
+  while (begin < end &&
+         pagespeed::string_util::IsAsciiWhitespace((*str)[begin])) {
+    ++begin;
   }
-  FindExternalResourcesInCssBlock(
-      resource.GetRequestUrl(), resource.GetResponseBody(),
-      external_resource_urls);
+  while (end > begin &&
+         pagespeed::string_util::IsAsciiWhitespace((*str)[end - 1])) {
+    --end;
+  }
+  str->set(str->data() + begin, end - begin);
 }
 
-void FindExternalResourcesInCssBlock(
-    const std::string& resource_url, const std::string& css_body,
-    std::set<std::string>* external_resource_urls) {
-  std::string body;
-
-  // Make our search easier by removing comments. We could be more
-  // efficient by attempting to skip over comments as we walk the
-  // string, but this would complicate the logic. It's simpler to
-  // remove comments first, then iterate over the string.
-  RemoveCssComments(css_body, &body);
-  CssTokenizer tokenizer(body);
-  std::string token;
+// Collects the URLs referenced from the given CSS, resolved relative to
+// resource_url.  If imports_only is true, only @import URLs are collected.
+void FindUrlsInCssBlock(const std::string& resource_url,
+                        const base::StringPiece& css_body,
+                        bool imports_only,
+                        std::set<std::string>* urls) {
+  CssTokenizer tokenizer(css_body);
+  base::StringPiece token;
   CssTokenizer::CssTokenType type;
-  std::string url;
-  while (tokenizer.GetNextToken(&token, &type)) {
+  base::StringPiece url;
+  while (true) {
+    tokenizer.SkipToUrlOrImport();
+    if (!tokenizer.GetNextToken(&token, &type)) {
+      break;
+    }
     url.clear();
     if (type == CssTokenizer::URL) {
-      url = token;
+      if (!imports_only) {
+        url = token;
+      }
     } else if (type == CssTokenizer::IDENT &&
-               pagespeed::string_util::LowerCaseEqualsASCII(
+               pagespeed::string_util::StringCaseEqual(
                    token, kCssImportDirective)) {
       // @import can contain either a url, e.g. "url('foo.css')" or a
       // plain string, e.g. "foo.css". Either way, it will be the
@@ -97,19 +99,45 @@ void FindExternalResourcesInCssBlock(
       }
     }
 
-    if (!url.empty() && !pagespeed::string_util::StringCaseStartsWith(url, kFragmentIdentifier)) {
+    if (!url.empty() && url[0] != kFragmentIdentifier) {
       // Resolve the URI relative to its parent stylesheet.
       std::string resolved_url =
-          pagespeed::uri_util::ResolveUri(url, resource_url);
+          pagespeed::uri_util::ResolveUri(url.as_string(), resource_url);
       if (resolved_url.empty()) {
         LOG(INFO) << "Unable to ResolveUri " << url;
       } else {
-        external_resource_urls->insert(resolved_url);
+        urls->insert(resolved_url);
       }
     }
   }
 }
 
+}  // namespace
+
+namespace pagespeed {
+
+namespace css {
+
+
+void FindExternalResourcesInCssResource(
+    const Resource& resource,
+    std::set<std::string>* external_resource_urls) {
+  if (resource.GetResourceType() != pagespeed::CSS) {
+    LOG(DFATAL) << "Non-CSS resource passed to"
+                << " FindExternalResourcesInCssResource.";
+    return;
+  }
+  FindExternalResourcesInCssBlock(
+      resource.GetRequestUrl(), resource.GetResponseBody(),
+      external_resource_urls);
+}
+
+void FindExternalResourcesInCssBlock(
+    const std::string& resource_url, const base::StringPiece& css_body,
+    std::set<std::string>* external_resource_urls) {
+  FindUrlsInCssBlock(resource_url, css_body, false, external_resource_urls);
+}
+
 void FindImportsInCssResource(
     const Resource& resource,
     std::set<std::string>* imported_urls) {
@@ -124,44 +152,9 @@ void FindImportsInCssResource(
 }
 
 void FindImportsInCssBlock(
-    const std::string& resource_url, const std::string& css_body,
+    const std::string& resource_url, const base::StringPiece& css_body,
     std::set<std::string>* imported_urls) {
-  std::string body;
-
-  // Make our search easier by removing comments. We could be more
-  // efficient by attempting to skip over comments as we walk the
-  // string, but this would complicate the logic. It's simpler to
-  // remove comments first, then iterate over the string.
-  RemoveCssComments(css_body, &body);
-  CssTokenizer tokenizer(body);
-  std::string token;
-  CssTokenizer::CssTokenType type;
-  std::string url;
-  while (tokenizer.GetNextToken(&token, &type)) {
-    url.clear();
-    if (type == CssTokenizer::IDENT &&
-               pagespeed::string_util::LowerCaseEqualsASCII(
-                   token, kCssImportDirective)) {
-      // @import can contain either a url, e.g. "url('foo.css')" or a
-      // plain string, e.g. "foo.css". Either way, it will be the
-      // immediate next token.
-      if (tokenizer.GetNextToken(&token, &type) &&
-          (type == CssTokenizer::URL || type == CssTokenizer::STRING)) {
-        url = token;
-      }
-    }
-
-    if (!url.empty() && !pagespeed::string_util::StringCaseStartsWith(url, kFragmentIdentifier)) {
-      // Resolve the URI relative to its parent stylesheet.
-      std::string resolved_url =
-          pagespeed::uri_util::ResolveUri(url, resource_url);
-      if (resolved_url.empty()) {
-        LOG(INFO) << "Unable to ResolveUri " << url;
-      } else {
-        imported_urls->insert(resolved_url);
-      }
-    }
-  }
+  FindUrlsInCssBlock(resource_url, css_body, true, imported_urls);
 }
 
 // The CSS 2.1 Specification section on comments
@@ -200,25 +193,21 @@ void RemoveCssComments(const std::string& in, std::string* out) {
   }
 }
 
-CssTokenizer::CssTokenizer(const std::string& css_body)
+CssTokenizer::CssTokenizer(const base::StringPiece& css_body)
     : css_body_(css_body),
       index_(0) {
 }
 
-bool CssTokenizer::GetNextToken(std::string* out_token,
+bool CssTokenizer::GetNextToken(base::StringPiece* out_token,
                                 CssTokenType* out_type) {
   out_token->clear();
 
+  // skip over leading whitespace and comments
+  index_ = SkipWhitespaceAndComments(index_);
   if (index_ >= css_body_.size()) {
     return false;
   }
 
-  // skip over leading whitespace
-  index_ = css_body_.find_first_not_of(kCssWhitespaceChars, index_);
-  if (index_ == std::string::npos) {
-    return false;
-  }
-
   const size_t prev_index = index_;
 
   // First try to extract a URL, then a CSS identifier, and finally a
@@ -240,23 +229,77 @@ bool CssTokenizer::GetNextToken(std::string* out_token,
     // One of the Take functions didn't find a valid token, but did
     // consume characters. Emit the consumed characters as an invalid
     // token.
-    out_token->assign(css_body_, prev_index, index_ - prev_index);
+    *out_token = css_body_.substr(prev_index, index_ - prev_index);
     *out_type = INVALID;
   } else {
     // We didn't find an ident or a string, so the token is likely a
     // one character separator.
-    out_token->assign(css_body_, index_, 1);
+    *out_token = css_body_.substr(index_, 1);
     ++index_;
     *out_type = SEPARATOR;
   }
   return true;
 }
 
-bool CssTokenizer::TakeString(std::string* out_token) {
+bool CssTokenizer::GetNextToken(std::string* out_token,
+                                CssTokenType* out_type) {
+  base::StringPiece token;
+  const bool result = GetNextToken(&token, out_type);
+  token.CopyToString(out_token);
+  return result;
+}
+
+void CssTokenizer::SkipToUrlOrImport() {
+  // Mirrors the dispatch in GetNextToken, so that the token boundaries
+  // (and thus the tokens that follow) are the same.  Only tokens starting
+  // with 'u' can be URLs, and only tokens starting with '@' can be
+  // @import, so everything else is skipped without trying TakeUrl or
+  // comparing identifiers.
+  base::StringPiece skipped;
+  while (true) {
+    index_ = SkipWhitespaceAndComments(index_);
+    if (index_ >= css_body_.size()) {
+      return;
+    }
+    const char candidate = css_body_[index_];
+    if (candidate == 'u' || candidate == 'U' || candidate == '@') {
+      return;
+    }
+    if (!TakeIdent(&skipped) && !TakeString(&skipped)) {
+      // A one character separator.
+      ++index_;
+    }
+  }
+}
+
+size_t CssTokenizer::SkipWhitespaceAndComments(size_t index) const {
+  const size_t size = css_body_.size();
+  while (index < size) {
+    if (IsCssWhitespace(css_body_[index])) {
+      ++index;
+      continue;
+    }
+    if (css_body_[index] != kCommentStart[0] ||
+        css_body_.substr(index, kCommentStartLen) != kCommentStart) {
+      break;
+    }
+    const size_t comment_end =
+        css_body_.find(kCommentEnd, index + kCommentStartLen);
+    if (comment_end == base::StringPiece::npos) {
+      // Unterminated comment, which runs to the end of the body.
+      return size;
+    }
+    index = comment_end + kCommentEndLen;
+  }
+  return index < size ? index : size;
+}
+
+bool CssTokenizer::TakeString(base::StringPiece* out_token) {
   return TakeString(out_token, &index_);
 }
 
-bool CssTokenizer::TakeString(std::string* out_token, size_t *inout_index) {
+bool CssTokenizer::TakeString(base::StringPiece* out_token,
+                              size_t *inout_index) {
   if (*inout_index >= css_body_.length()) {
     return false;
   }
@@ -265,35 +308,37 @@ bool CssTokenizer::TakeString(std::string* out_token, size_t *inout_index) {
     return false;
   }
 
-  size_t next_token = *inout_index + 1;
-  bool done = false;
-  while (!done && next_token < css_body_.size()) {
-    unsigned char candidate = css_body_[next_token];
-    if (candidate == start_quote) {
-      done = true;
+  const size_t contents_start = *inout_index + 1;
+  size_t next_token = contents_start;
+  // The contents are returned in place unless they contain an escape
+  // sequence, in which case they are copied to unescaped_ from there on.
+  bool has_escapes = false;
+  while (next_token < css_body_.size()) {
+    const char candidate = css_body_[next_token];
+    if (candidate == start_quote ||
+        candidate == '\r' || candidate == '\n' || candidate == '\f') {
       break;
     }
-    switch (candidate) {
-      case '\\':
-        next_token += ConsumeEscape(next_token, out_token);
-        break;
-
-      case '\r':
-      case '\n':
-      case '\f':
-        done = true;
-        break;
-
-      default:
-        out_token->push_back(candidate);
-        break;
-    }
-    if (done) {
-      break;
+    if (candidate == '\\') {
+      if (!has_escapes) {
+        has_escapes = true;
+        unescaped_.assign(css_body_.data() + contents_start,
+                          next_token - contents_start);
+      }
+      next_token += ConsumeEscape(next_token, &unescaped_);
+    } else if (has_escapes) {
+      unescaped_.push_back(candidate);
     }
     ++next_token;
   }
 
+  if (has_escapes) {
+    out_token->set(unescaped_.data(), unescaped_.size());
+  } else {
+    *out_token = css_body_.substr(contents_start,
+                                  next_token - contents_start);
+  }
+
   if (next_token < css_body_.length()) {
     if (css_body_[next_token] == start_quote) {
       ++next_token;
@@ -305,31 +350,29 @@ bool CssTokenizer::TakeString(std::string* out_token, size_t *inout_index) {
   return true;
 }
 
-bool CssTokenizer::TakeUrl(std::string* out_token) {
+bool CssTokenizer::TakeUrl(base::StringPiece* out_token) {
   if (index_ + kCssUrlDirectiveLen >= css_body_.length()) {
     return false;
   }
-  std::string possible_url_directive(
-      css_body_.c_str() + index_, kCssUrlDirectiveLen);
-  if (!pagespeed::string_util::LowerCaseEqualsASCII(
-          possible_url_directive,
+  if (!pagespeed::string_util::StringCaseEqual(
+          css_body_.substr(index_, kCssUrlDirectiveLen),
           kCssUrlDirective)) {
     // Doesn't start with "url(", so it can't be a URL token.
     return false;
   }
 
   // Skip over whitespace.
-  size_t next_token = css_body_.find_first_not_of(
-      kCssWhitespaceChars, index_ + kCssUrlDirectiveLen);
-  if (next_token == std::string::npos) {
+  size_t next_token =
+      SkipWhitespaceAndComments(index_ + kCssUrlDirectiveLen);
+  if (next_token >= css_body_.length()) {
     return false;
   }
 
   // First, try to scan for a quoted string inside the "url(".
   if (TakeString(out_token, &next_token)) {
     // Found a quoted string. Now skip over whitespace after it.
-    next_token = css_body_.find_first_not_of(kCssWhitespaceChars, next_token);
-    if (next_token == std::string::npos) {
+    next_token = SkipWhitespaceAndComments(next_token);
+    if (next_token >= css_body_.length()) {
       // We found a quoted URL but only whitespace after the URL,
       // indicating a premature EOF. CSS parsers don't parse such URLs
       // but we do want to consume the characters, so update index_
@@ -343,7 +386,7 @@ bool CssTokenizer::TakeUrl(std::string* out_token) {
       // case, WebKit will search for a closing parentheses, and
       // ignore all content up to that point. We do the same.
       next_token = css_body_.find(')', next_token);
-      if (next_token != std::string::npos) {
+      if (next_token != base::StringPiece::npos) {
         index_ = next_token + 1;
       } else {
         // There was no closing parentheses, so consume all remaining
@@ -359,18 +402,17 @@ bool CssTokenizer::TakeUrl(std::string* out_token) {
   // If we were unable to find a quoted string, fall back to taking
   // the entire unquoted string inside of the parentheses.
   size_t close_paren = css_body_.find(')', index_ + kCssUrlDirectiveLen);
-  if (close_paren == std::string::npos) {
+  if (close_paren == base::StringPiece::npos) {
     return false;
   }
   size_t url_start = index_ + kCssUrlDirectiveLen;
-  out_token->assign(css_body_, url_start, close_paren - url_start);
-  pagespeed::string_util::TrimWhitespaceASCII(
-      *out_token, pagespeed::string_util::TRIM_ALL, out_token);
+  *out_token = css_body_.substr(url_start, close_paren - url_start);
+  TrimWhitespaceASCII(out_token);
   index_ = close_paren + 1;
   return true;
 }
 
-bool CssTokenizer::TakeIdent(std::string* out_token) {
+bool CssTokenizer::TakeIdent(base::StringPiece* out_token) {
   if (index_ >= css_body_.length()) {
     return false;
   }
@@ -448,7 +490,7 @@ bool CssTokenizer::TakeIdent(std::string* out_token) {
   }
   const bool success = (s == DONE);
   if (success) {
-    out_token->assign(css_body_, index_, next_token - index_);
+    *out_token = css_body_.substr(index_, next_token - index_);
     index_ = next_token;
   }
   return success;
@@ -456,6 +498,10 @@ bool CssTokenizer::TakeIdent(std::string* out_token) {
 
 size_t CssTokenizer::ConsumeEscape(size_t next_token, std::string* out_token) {
   ++next_token;
+  if (next_token >= css_body_.size()) {
+    // Nothing to consume.
+    return 0;
+  }
   const size_t remaining = css_body_.size() - next_token;
   const unsigned char first = css_body_[next_token];
   if (remaining >= 2) {
@@ -465,22 +511,17 @@ size_t CssTokenizer::ConsumeEscape(size_t next_token, std::string* out_token) {
       return 2;
     }
   }
-  if (remaining >= 1) {
-    switch (first) {
-      case '\r':
-      case '\n':
-        // Silently consume these escaped characters, per the CSS 2 spec.
-        return 1;
+  switch (first) {
+    case '\r':
+    case '\n':
+      // Silently consume these escaped characters, per the CSS 2 spec.
+      return 1;
 
-      default:
-        break;
-    }
-    out_token->push_back(first);
-    return 1;
+    default:
+      break;
   }
-
-  // Nothing to consume.
-  return 0;
+  out_token->push_back(first);
+  return 1;
 }
 
 }  // namespace rules
@@ -19,6 +19,7 @@
 #include <string>
 
 #include "base/basictypes.h"
+#include "base/string_piece.h"
 
 namespace pagespeed {
 
@@ -36,7 +37,7 @@ void FindExternalResourcesInCssResource(
 // either be the body of an external CSS resource, or the contents of an inline
 // CSS block in an HTML resource.
 void FindExternalResourcesInCssBlock(
-    const std::string& resource_url, const std::string& css_body,
+    const std::string& resource_url, const base::StringPiece& css_body,
     std::set<std::string>* external_resource_urls);
 
 // Get all imported URLs contained in the body of the given CSS
@@ -49,7 +50,7 @@ void FindImportsInCssResource(
 // either be the body of an external CSS resource, or the contents of an inline
 // CSS block in an HTML resource.
 void FindImportsInCssBlock(
-    const std::string& resource_url, const std::string& css_body,
+    const std::string& resource_url, const base::StringPiece& css_body,
     std::set<std::string>* imported_urls);
 
 // These function is exposed only for unit testing.  It should not be called by
@@ -58,7 +59,9 @@ void RemoveCssComments(const std::string& in, std::string* out);
 
 
 // Simple CSS tokenizer.  Generates a stream of tokens along with the
-// token type.  Exposed in the header only for testing.
+// token type.  Comments are skipped like whitespace.  The tokenizer scans
+// the given buffer in place, so the buffer must outlive the tokenizer.
+// Exposed in the header only for testing.
 class CssTokenizer {
  public:
   enum CssTokenType {
@@ -69,23 +72,42 @@ class CssTokenizer {
     INVALID,
   };
 
-  CssTokenizer(const std::string& css_body);
+  explicit CssTokenizer(const base::StringPiece& css_body);
 
   // Generates the next token in the token stream as well as its
   // type. Returns true if a valid token was generated, false
-  // otherwise (due to i.e. EOF).
+  // otherwise (due to i.e. EOF).  The token points into the CSS body,
+  // or, for strings and URLs containing escape sequences, into a buffer
+  // owned by the tokenizer; either way it is only valid until the next
+  // call.
+  bool GetNextToken(base::StringPiece* out_token, CssTokenType* out_type);
+
+  // As above, but copies the token.
   bool GetNextToken(std::string* out_token, CssTokenType* out_type);
 
+  // Skips ahead to the next token that may be a URL or an @import
+  // directive, without generating the tokens in between.  The tokens that
+  // follow are the same ones GetNextToken would have generated.
+  void SkipToUrlOrImport();
+
  private:
-  bool TakeUrl(std::string* out_token);
-  bool TakeString(std::string* out_token);
-  bool TakeIdent(std::string* out_token);
+  bool TakeUrl(base::StringPiece* out_token);
+  bool TakeString(base::StringPiece* out_token);
+  bool TakeIdent(base::StringPiece* out_token);
   size_t ConsumeEscape(size_t next_token, std::string* out_token);
 
-  bool TakeString(std::string* out_token, size_t *inout_index);
+  bool TakeString(base::StringPiece* out_token, size_t *inout_index);
+
+  // Returns the index of the first character at or after index that is
+  // neither whitespace nor part of a comment, or the length of the body if
+  // there is none.
+  size_t SkipWhitespaceAndComments(size_t index) const;
 
-  const std::string css_body_;
+  const base::StringPiece css_body_;
   size_t index_;
+  // Holds the contents of the last string token that contained escape
+  // sequences, which cannot be returned in place.
+  std::string unescaped_;
 
   DISALLOW_COPY_AND_ASSIGN(CssTokenizer);
 };
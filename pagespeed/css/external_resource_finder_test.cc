@@ -21,7 +21,9 @@
 namespace {
 
 using pagespeed::css::CssTokenizer;
+using pagespeed::css::FindExternalResourcesInCssBlock;
 using pagespeed::css::FindExternalResourcesInCssResource;
+using pagespeed::css::FindImportsInCssBlock;
 using pagespeed::css::RemoveCssComments;
 
 struct CssToken {
@@ -478,11 +480,79 @@ void StressCssTokenizer(const std::string& body) {
   std::string token;
   CssTokenizer::CssTokenType type;
   for (size_t i = 0; i < body.length(); ++i) {
-    CssTokenizer tokenizer(body.substr(0, i));
+    const std::string prefix = body.substr(0, i);
+    CssTokenizer tokenizer(prefix);
     while (tokenizer.GetNextToken(&token, &type)) {}
   }
 }
 
+TEST(CssTokenizerTest, SkipsComments) {
+  CssTokenizer tokenizer("/* a */ b /**/c/* 'd' */ 'e /* f */' /* g");
+  std::string token;
+  CssTokenizer::CssTokenType type;
+  ASSERT_TRUE(tokenizer.GetNextToken(&token, &type));
+  ASSERT_STREQ("b", token.c_str());
+  ASSERT_EQ(CssTokenizer::IDENT, type);
+  ASSERT_TRUE(tokenizer.GetNextToken(&token, &type));
+  ASSERT_STREQ("c", token.c_str());
+  ASSERT_EQ(CssTokenizer::IDENT, type);
+  // Comment delimiters inside a string are part of the string.
+  ASSERT_TRUE(tokenizer.GetNextToken(&token, &type));
+  ASSERT_STREQ("e /* f */", token.c_str());
+  ASSERT_EQ(CssTokenizer::STRING, type);
+  ASSERT_FALSE(tokenizer.GetNextToken(&token, &type));
+}
+
+TEST(CssTokenizerTest, TokensPointIntoBody) {
+  const std::string body = "@import url( 'a.css' ) 'b\\c' d";
+  CssTokenizer tokenizer(body);
+  base::StringPiece token;
+  CssTokenizer::CssTokenType type;
+  ASSERT_TRUE(tokenizer.GetNextToken(&token, &type));
+  ASSERT_EQ(CssTokenizer::IDENT, type);
+  ASSERT_EQ(body.data(), token.data());
+  ASSERT_TRUE(tokenizer.GetNextToken(&token, &type));
+  ASSERT_EQ(CssTokenizer::URL, type);
+  ASSERT_EQ("a.css", token.as_string());
+  ASSERT_EQ(body.data() + body.find("a.css"), token.data());
+  // Strings with escapes are unescaped into a separate buffer.
+  ASSERT_TRUE(tokenizer.GetNextToken(&token, &type));
+  ASSERT_EQ(CssTokenizer::STRING, type);
+  ASSERT_EQ("bc", token.as_string());
+  ASSERT_TRUE(tokenizer.GetNextToken(&token, &type));
+  ASSERT_EQ(CssTokenizer::IDENT, type);
+  ASSERT_EQ(body.data() + body.size() - 1, token.data());
+  ASSERT_FALSE(tokenizer.GetNextToken(&token, &type));
+}
+
+TEST(CssTokenizerTest, SkipToUrlOrImport) {
+  // Neither the string contents nor the identifier ending in "url" may be
+  // mistaken for URL tokens.
+  CssTokenizer tokenizer(
+      "a { b: 'url(x)' } .nourl(y) @media u { c: URL(z) } @import 'i'");
+  base::StringPiece token;
+  CssTokenizer::CssTokenType type;
+  tokenizer.SkipToUrlOrImport();
+  ASSERT_TRUE(tokenizer.GetNextToken(&token, &type));
+  ASSERT_EQ("@media", token.as_string());
+  tokenizer.SkipToUrlOrImport();
+  ASSERT_TRUE(tokenizer.GetNextToken(&token, &type));
+  ASSERT_EQ("u", token.as_string());
+  ASSERT_EQ(CssTokenizer::IDENT, type);
+  tokenizer.SkipToUrlOrImport();
+  ASSERT_TRUE(tokenizer.GetNextToken(&token, &type));
+  ASSERT_EQ("z", token.as_string());
+  ASSERT_EQ(CssTokenizer::URL, type);
+  tokenizer.SkipToUrlOrImport();
+  ASSERT_TRUE(tokenizer.GetNextToken(&token, &type));
+  ASSERT_EQ("@import", token.as_string());
+  ASSERT_TRUE(tokenizer.GetNextToken(&token, &type));
+  ASSERT_EQ("i", token.as_string());
+  ASSERT_EQ(CssTokenizer::STRING, type);
+  tokenizer.SkipToUrlOrImport();
+  ASSERT_FALSE(tokenizer.GetNextToken(&token, &type));
+}
+
 TEST(CssTokenizerTest, Stress) {
   StressCssTokenizer(kNoImportBody);
   StressCssTokenizer(kBasicImportBody);
@@ -569,6 +639,26 @@ TEST_F(ExternalResourceFinderTest, NoImportUnterminatedComment) {
   ASSERT_TRUE(urls.empty());
 }
 
+TEST_F(ExternalResourceFinderTest, CssBlock) {
+  std::set<std::string> urls;
+  FindExternalResourcesInCssBlock(
+      kCssUrl,
+      "@import 'import1.css'; /* url(comment.png) */\n"
+      "div { background: url(/*x*/a.png) }\n"
+      "p { content: 'url(string.png)' }",
+      &urls);
+  ASSERT_EQ(2U, urls.size());
+  // Comment delimiters in an unquoted URL are part of the URL.
+  ASSERT_EQ("http://www.example.com/*x*/a.png", *urls.begin());
+  ASSERT_EQ(kImportUrl1, *urls.rbegin());
+
+  urls.clear();
+  FindImportsInCssBlock(kCssUrl, "a { b: url(c.png) } @import 'import2.css'",
+                        &urls);
+  ASSERT_EQ(1U, urls.size());
+  ASSERT_EQ(kImportUrl2, *urls.begin());
+}
+
 TEST_F(ExternalResourceFinderTest, BadUrlInImport) {
   pagespeed::Resource* r = NewCssResource(kCssUrl);
   r->SetResponseBody(kBadImportUrlBody);
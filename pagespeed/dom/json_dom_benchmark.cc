@@ -0,0 +1,102 @@
+// Copyright 2013 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+
+#include "base/basictypes.h"
+#include "base/json/json_reader.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/values.h"
+#include "pagespeed/core/dom.h"
+#include "pagespeed/core/string_util.h"
+#include "pagespeed/dom/json_dom.h"
+#include "pagespeed/testing/benchmark.h"
+
+namespace {
+
+const int kNumImages = 500;
+
+// Builds a flat document of kNumImages sized IMG elements under a BODY.
+std::string MakeDocumentJson() {
+  std::string json =
+      "{\"documentUrl\":\"http://www.example.com/index.html\","
+      "\"baseUrl\":\"http://www.example.com/\",\"elements\":["
+      "{\"tag\":\"HTML\",\"children\":[1]},{\"tag\":\"BODY\",\"children\":[";
+  for (int i = 0; i < kNumImages; ++i) {
+    if (i > 0) {
+      json += ",";
+    }
+    json += pagespeed::string_util::IntToString(i + 2);
+  }
+  json += "]}";
+  for (int i = 0; i < kNumImages; ++i) {
+    json += pagespeed::string_util::StringPrintf(
+        ",{\"tag\":\"IMG\",\"attrs\":{\"src\":\"images/%d.png\","
+        "\"width\":\"%d\",\"height\":\"%d\"},\"width\":%d,\"height\":%d}",
+        i, 16 + i % 64, 16 + i % 32, 16 + i % 64, 16 + i % 32);
+  }
+  json += "]}";
+  return json;
+}
+
+// Reads the attributes the rules ask of each element.
+class AttributeVisitor : public pagespeed::DomElementVisitor {
+ public:
+  AttributeVisitor() : count_(0) {}
+
+  virtual void Visit(const pagespeed::DomElement& node) {
+    std::string src;
+    int width = 0, height = 0;
+    node.GetAttributeByName("src", &src);
+    node.GetActualWidth(&width);
+    node.GetActualHeight(&height);
+    ++count_;
+  }
+
+  int count() const { return count_; }
+
+ private:
+  int count_;
+
+  DISALLOW_COPY_AND_ASSIGN(AttributeVisitor);
+};
+
+PAGESPEED_BENCHMARK(BM_CreateDocumentAndTraverse) {
+  const std::string json = MakeDocumentJson();
+  scoped_ptr<base::Value> value(base::JSONReader::Read(json));
+  if (value == NULL || !value->IsType(base::Value::TYPE_DICTIONARY)) {
+    state->SetError("Unable to parse document JSON");
+    return;
+  }
+  const base::DictionaryValue* dict =
+      static_cast<const base::DictionaryValue*>(value.get());
+  state->ResetTiming();
+  for (int i = 0; i < state->iterations(); ++i) {
+    // CreateDocument takes ownership of its argument, so give each
+    // iteration its own copy.
+    state->PauseTiming();
+    base::DictionaryValue* copy = dict->DeepCopy();
+    state->ResumeTiming();
+    scoped_ptr<pagespeed::DomDocument> document(
+        pagespeed::dom::CreateDocument(copy));
+    AttributeVisitor visitor;
+    document->Traverse(&visitor);
+    if (visitor.count() != kNumImages + 2) {
+      state->SetError("Unexpected element count");
+      return;
+    }
+  }
+}
+
+}  // namespace
@@ -32,6 +32,7 @@
         'landing_page_redirection_filter.cc',
         'protocol_filter.cc',
         'response_byte_result_filter.cc',
+        'rule_name_result_filter.cc',
         'tracker_filter.cc',
         'url_regex_filter.cc',
       ],
@@ -0,0 +1,85 @@
+// Copyright 2013 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+#include <vector>
+
+#include "base/stl_util.h"  // for STLDeleteContainerPointers
+#include "pagespeed/core/resource.h"
+#include "pagespeed/core/resource_filter.h"
+#include "pagespeed/core/string_util.h"
+#include "pagespeed/filters/ad_filter.h"
+#include "pagespeed/filters/tracker_filter.h"
+#include "pagespeed/filters/url_regex_filter.h"
+#include "pagespeed/testing/benchmark.h"
+
+namespace {
+
+const int kNumResources = 1000;
+
+// A mix of first-party, CDN, ad and tracker URLs.
+const char* const kUrlFormats[] = {
+  "http://www.example.com/static/script-%d.js",
+  "http://cdn%d.example-static.net/images/sprite.png",
+  "http://pagead2.googlesyndication.com/pagead/show_ads.js?id=%d",
+  "http://www.google-analytics.com/__utm.gif?utmn=%d",
+  "http://ad.doubleclick.net/adj/site/page;ord=%d",
+};
+
+void CreateResources(std::vector<pagespeed::Resource*>* resources) {
+  for (int i = 0; i < kNumResources; ++i) {
+    pagespeed::Resource* resource = new pagespeed::Resource;
+    resource->SetRequestUrl(pagespeed::string_util::StringPrintf(
+        kUrlFormats[i % arraysize(kUrlFormats)], i));
+    resources->push_back(resource);
+  }
+}
+
+void RunFilter(const pagespeed::ResourceFilter& filter,
+               pagespeed_testing::BenchmarkState* state) {
+  std::vector<pagespeed::Resource*> resources;
+  CreateResources(&resources);
+  int accepted = 0;
+  state->ResetTiming();
+  for (int i = 0; i < state->iterations(); ++i) {
+    for (std::vector<pagespeed::Resource*>::const_iterator it =
+             resources.begin(); it != resources.end(); ++it) {
+      if (filter.IsAccepted(**it)) {
+        ++accepted;
+      }
+    }
+  }
+  state->PauseTiming();
+  if (accepted == 0) {
+    state->SetError("No resources were accepted");
+  }
+  STLDeleteContainerPointers(resources.begin(), resources.end());
+}
+
+PAGESPEED_BENCHMARK(BM_UrlRegexFilter_IsAccepted) {
+  pagespeed::UrlRegexFilter filter(".*googlesyndication\\.com|.*\\.gif");
+  RunFilter(filter, state);
+}
+
+PAGESPEED_BENCHMARK(BM_AdFilter_IsAccepted) {
+  pagespeed::AdFilter filter;
+  RunFilter(filter, state);
+}
+
+PAGESPEED_BENCHMARK(BM_TrackerFilter_IsAccepted) {
+  pagespeed::TrackerFilter filter;
+  RunFilter(filter, state);
+}
+
+}  // namespace
@@ -0,0 +1,43 @@
+// Copyright 2013 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pagespeed/filters/rule_name_result_filter.h"
+
+#include "pagespeed/proto/pagespeed_output.pb.h"
+
+namespace pagespeed {
+
+RuleNameResultFilter::RuleNameResultFilter(
+    const std::vector<std::string>& rule_names)
+    : rule_names_(rule_names.begin(), rule_names.end()) {
+}
+
+RuleNameResultFilter::~RuleNameResultFilter() {
+}
+
+bool RuleNameResultFilter::IsResultAccepted(const Result&) const {
+  // Results are only ever seen as part of an accepted RuleResults.
+  return true;
+}
+
+bool RuleNameResultFilter::IsRuleResultsAccepted(
+    const RuleResults& results) const {
+  return IsRuleAccepted(results.rule_name());
+}
+
+bool RuleNameResultFilter::IsRuleAccepted(const std::string& rule_name) const {
+  return rule_names_.count(rule_name) > 0;
+}
+
+}  // namespace pagespeed
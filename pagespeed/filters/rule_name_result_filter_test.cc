@@ -0,0 +1,60 @@
+// Copyright 2013 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+#include <vector>
+
+#include "pagespeed/filters/rule_name_result_filter.h"
+#include "pagespeed/proto/pagespeed_output.pb.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace pagespeed {
+
+TEST(RuleNameResultFilterTest, AcceptsNamedRules) {
+  std::vector<std::string> rule_names;
+  rule_names.push_back("MinifyCss");
+  rule_names.push_back("EnableGzipCompression");
+  RuleNameResultFilter filter(rule_names);
+
+  EXPECT_TRUE(filter.IsRuleAccepted("MinifyCss"));
+  EXPECT_TRUE(filter.IsRuleAccepted("EnableGzipCompression"));
+  EXPECT_FALSE(filter.IsRuleAccepted("MinifyJavaScript"));
+  EXPECT_FALSE(filter.IsRuleAccepted(""));
+
+  RuleResults rule_results;
+  rule_results.set_rule_name("MinifyCss");
+  EXPECT_TRUE(filter.IsRuleResultsAccepted(rule_results));
+  rule_results.set_rule_name("MinifyJavaScript");
+  EXPECT_FALSE(filter.IsRuleResultsAccepted(rule_results));
+
+  Result result;
+  EXPECT_TRUE(filter.IsResultAccepted(result));
+}
+
+TEST(RuleNameResultFilterTest, NoRules) {
+  std::vector<std::string> rule_names;
+  RuleNameResultFilter filter(rule_names);
+  EXPECT_FALSE(filter.IsRuleAccepted("MinifyCss"));
+}
+
+TEST(RuleNameResultFilterTest, AndResultFilter) {
+  std::vector<std::string> rule_names;
+  rule_names.push_back("MinifyCss");
+  AndResultFilter filter(new AlwaysAcceptResultFilter(),
+                         new RuleNameResultFilter(rule_names));
+  EXPECT_TRUE(filter.IsRuleAccepted("MinifyCss"));
+  EXPECT_FALSE(filter.IsRuleAccepted("MinifyJavaScript"));
+}
+
+}  // namespace pagespeed
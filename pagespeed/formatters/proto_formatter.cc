@@ -64,7 +64,7 @@ bool MaybeLocalizeString(const Localizer* loc,
 // used for sanity checking in debug builds.
 bool ValidatePlaceholderKeys(
     const base::StringPiece format,
-    const std::vector<const FormatArgument*>& args) {
+    const google::protobuf::RepeatedPtrField<FormatArgument>& args) {
   // Collect placeholder keys appearing in format string:
   std::set<std::string> format_keys;
   for (size_t i = 0; i < format.size(); ++i) {
@@ -99,11 +99,10 @@ bool ValidatePlaceholderKeys(
 
   // Collect placeholder keys of format arguments.
   std::set<std::string> arg_keys;
-  for (std::vector<const FormatArgument*>::const_iterator iter = args.begin();
-       iter != args.end(); ++iter) {
-    const FormatArgument* arg = *iter;
-    const std::string& key = arg->placeholder_key();
-    if (arg->type() != FormatArgument::HYPERLINK) {
+  for (google::protobuf::RepeatedPtrField<FormatArgument>::const_iterator
+           iter = args.begin(); iter != args.end(); ++iter) {
+    const std::string& key = iter->placeholder_key();
+    if (iter->type() != FormatArgument::HYPERLINK) {
       if (arg_keys.count(key) != 0) {
         LOG(ERROR) << "Repeated placeholder key: " << key;
         return false;
@@ -140,25 +139,22 @@ bool ValidatePlaceholderKeys(
   return true;
 }
 
-// Fills in a FormatString proto from a format string and arguments.
-// TODO(aoates): move this functionality into the Argument and FormatterParams
-// classes, to provide l10n for all formatters that want it.
-void FillFormatString(const Localizer* loc,
-                      const UserFacingString& format_str,
-                      const std::vector<const FormatArgument*>& arguments,
-                      FormatString* out) {
+// Localizes format_str into out->format() and fills in the localized value of
+// each of out's arguments, which must already be present.
+void LocalizeFormatString(const Localizer* loc,
+                          const UserFacingString& format_str,
+                          FormatString* out) {
   MaybeLocalizeString(loc, format_str, out->mutable_format());
 
   // In debug builds, do some post-translation sanity checking on the
   // placeholders and the format string.
-  DCHECK(ValidatePlaceholderKeys(out->format(), arguments));
+  DCHECK(ValidatePlaceholderKeys(out->format(), out->args()));
 
-  for (int index = 0, limit = arguments.size(); index < limit; ++index) {
+  for (int index = 0, limit = out->args_size(); index < limit; ++index) {
     bool success = true;
     std::string localized;
 
-    FormatArgument* format_arg = out->add_args();
-    *format_arg = *arguments[index];
+    FormatArgument* format_arg = out->mutable_args(index);
 
     switch (format_arg->type()) {
       case FormatArgument::INT_LITERAL:
@@ -216,6 +212,68 @@ void FillFormatString(const Localizer* loc,
   }
 }
 
+// Fills in a FormatString proto from a format string and arguments.  If
+// unlocalized_strings is non-NULL, the format string is recorded there for
+// later localization rather than being localized with loc.
+// TODO(aoates): move this functionality into the Argument and FormatterParams
+// classes, to provide l10n for all formatters that want it.
+void FillFormatString(const Localizer* loc,
+                      UnlocalizedStringMap* unlocalized_strings,
+                      const UserFacingString& format_str,
+                      const std::vector<const FormatArgument*>& arguments,
+                      FormatString* out) {
+  for (std::vector<const FormatArgument*>::const_iterator iter =
+           arguments.begin(), end = arguments.end(); iter != end; ++iter) {
+    out->add_args()->CopyFrom(**iter);
+  }
+  if (unlocalized_strings != NULL) {
+    out->set_format(format_str);
+    (*unlocalized_strings)[out] = format_str;
+  } else {
+    LocalizeFormatString(loc, format_str, out);
+  }
+}
+
+// Fills in the fields of rule_results that do not need localization.
+void FillRuleResults(const Rule& rule, double impact,
+                     FormattedRuleResults* rule_results) {
+  rule_results->set_rule_name(rule.name());
+  rule_results->set_rule_impact(impact);
+  if (rule.IsExperimental()) {
+    rule_results->set_experimental(true);
+  }
+
+  std::vector<FormattedRuleResults::RuleGroup> groups;
+  rule.AppendRuleGroups(&groups);
+  for (std::vector<FormattedRuleResults::RuleGroup>::const_iterator iter =
+           groups.begin(), end = groups.end(); iter != end; ++iter) {
+    rule_results->add_groups(*iter);
+  }
+}
+
+// Repairs the impact and score values after filtering; see
+// ProtoFormatter::Finalize.
+void RepairFilteredResults(FormattedResults* results) {
+  // Now for a superhack. If a ResultFilter is used, it may produce
+  // rule results with no suggestions, or possibly an overall
+  // formatted results with no suggestions. In those cases we need to
+  // manually repair the impact and score values so the user is not
+  // confused by a non-100 score with no suggestions.
+  bool has_any_results = false;
+  for (int i = 0; i < results->rule_results_size(); ++i) {
+    FormattedRuleResults* rule_results =
+        results->mutable_rule_results(i);
+    if (rule_results->url_blocks_size() == 0) {
+      rule_results->set_rule_impact(0.0);
+    } else {
+      has_any_results = true;
+    }
+  }
+  if (!has_any_results && results->has_score()) {
+    results->set_score(100);
+  }
+}
+
 }  // namespace
 
 ProtoFormatter::ProtoFormatter(const Localizer* localizer,
@@ -232,18 +290,7 @@ ProtoFormatter::~ProtoFormatter() {
 
 RuleFormatter* ProtoFormatter::AddRule(const Rule& rule, double impact) {
   FormattedRuleResults* rule_results = results_->add_rule_results();
-  rule_results->set_rule_name(rule.name());
-  rule_results->set_rule_impact(impact);
-  if (rule.IsExperimental()) {
-    rule_results->set_experimental(true);
-  }
-
-  std::vector<FormattedRuleResults::RuleGroup> groups;
-  rule.AppendRuleGroups(&groups);
-  for (std::vector<FormattedRuleResults::RuleGroup>::const_iterator iter =
-           groups.begin(), end = groups.end(); iter != end; ++iter) {
-    rule_results->add_groups(*iter);
-  }
+  FillRuleResults(rule, impact, rule_results);
 
   if (!MaybeLocalizeString(localizer_,
                            rule.header(),
@@ -263,33 +310,126 @@ void ProtoFormatter::SetOverallScore(int score) {
 }
 
 void ProtoFormatter::Finalize() {
-  // Now for a superhack. If a ResultFilter is used, it may produce
-  // rule results with no suggestions, or possibly an overall
-  // formatted results with no suggestions. In those cases we need to
-  // manually repair the impact and score values so the user is not
-  // confused by a non-100 score with no suggestions.
-  bool has_any_results = false;
+  RepairFilteredResults(results_);
+}
+
+MultiLocaleProtoFormatter::MultiLocaleProtoFormatter()
+    : results_(new FormattedResults), finalized_(false) {
+}
+
+MultiLocaleProtoFormatter::~MultiLocaleProtoFormatter() {
+  STLDeleteContainerPointers(rule_formatters_.begin(),
+                             rule_formatters_.end());
+}
+
+RuleFormatter* MultiLocaleProtoFormatter::AddRule(const Rule& rule,
+                                                  double impact) {
+  DCHECK(!finalized_);
+  FormattedRuleResults* rule_results = results_->add_rule_results();
+  FillRuleResults(rule, impact, rule_results);
+
+  const UserFacingString header = rule.header();
+  rule_results->set_localized_rule_name(header);
+  unlocalized_strings_[rule_results] = header;
+
+  RuleFormatter* rule_formatter =
+      new ProtoRuleFormatter(&unlocalized_strings_, rule_results);
+  rule_formatters_.push_back(rule_formatter);
+  return rule_formatter;
+}
+
+void MultiLocaleProtoFormatter::SetOverallScore(int score) {
+  DCHECK(0 <= score && score <= 100);
+  results_->set_score(score);
+}
+
+void MultiLocaleProtoFormatter::Finalize() {
+  RepairFilteredResults(results_.get());
+  finalized_ = true;
+}
+
+bool MultiLocaleProtoFormatter::Localize(const Localizer* localizer,
+                                         FormattedResults* results) const {
+  if (!finalized_) {
+    LOG(DFATAL) << "Localize called before Finalize.";
+    return false;
+  }
+
+  results->CopyFrom(*results_);
+  results->set_locale(localizer->GetLocale());
   for (int i = 0; i < results_->rule_results_size(); ++i) {
-    FormattedRuleResults* rule_results =
-        results_->mutable_rule_results(i);
-    if (rule_results->url_blocks_size() == 0) {
-      rule_results->set_rule_impact(0.0);
-    } else {
-      has_any_results = true;
+    const FormattedRuleResults& recorded_rule = results_->rule_results(i);
+    FormattedRuleResults* rule_results = results->mutable_rule_results(i);
+
+    UnlocalizedStringMap::const_iterator header =
+        unlocalized_strings_.find(&recorded_rule);
+    if (header == unlocalized_strings_.end()) {
+      LOG(DFATAL) << "No header recorded for " << recorded_rule.rule_name();
+    } else if (!MaybeLocalizeString(
+        localizer, header->second,
+        rule_results->mutable_localized_rule_name())) {
+      LOG(ERROR) << "Unable to LocalizeString " << header->second;
+    }
+
+    if (recorded_rule.has_summary()) {
+      LocalizeFormatStringFrom(localizer, recorded_rule.summary(),
+                               rule_results->mutable_summary());
+    }
+    for (int j = 0; j < recorded_rule.url_blocks_size(); ++j) {
+      const FormattedUrlBlockResults& recorded_block =
+          recorded_rule.url_blocks(j);
+      FormattedUrlBlockResults* url_block = rule_results->mutable_url_blocks(j);
+      if (recorded_block.has_header()) {
+        LocalizeFormatStringFrom(localizer, recorded_block.header(),
+                                 url_block->mutable_header());
+      }
+      for (int k = 0; k < recorded_block.urls_size(); ++k) {
+        const FormattedUrlResult& recorded_url = recorded_block.urls(k);
+        FormattedUrlResult* url_result = url_block->mutable_urls(k);
+        LocalizeFormatStringFrom(localizer, recorded_url.result(),
+                                 url_result->mutable_result());
+        for (int l = 0; l < recorded_url.details_size(); ++l) {
+          LocalizeFormatStringFrom(localizer, recorded_url.details(l),
+                                   url_result->mutable_details(l));
+        }
+      }
     }
   }
-  if (!has_any_results && results_->has_score()) {
-    results_->set_score(100);
+  return true;
+}
+
+void MultiLocaleProtoFormatter::LocalizeFormatStringFrom(
+    const Localizer* localizer,
+    const FormatString& recorded,
+    FormatString* out) const {
+  UnlocalizedStringMap::const_iterator iter =
+      unlocalized_strings_.find(&recorded);
+  if (iter == unlocalized_strings_.end()) {
+    LOG(DFATAL) << "No format string recorded for " << recorded.format();
+    return;
   }
+  LocalizeFormatString(localizer, iter->second, out);
 }
 
 ProtoRuleFormatter::ProtoRuleFormatter(const Localizer* localizer,
                                        FormattedRuleResults* rule_results)
-    : localizer_(localizer), rule_results_(rule_results) {
+    : localizer_(localizer),
+      unlocalized_strings_(NULL),
+      rule_results_(rule_results) {
   DCHECK(localizer_);
   DCHECK(rule_results_);
 }
 
+ProtoRuleFormatter::ProtoRuleFormatter(
+    UnlocalizedStringMap* unlocalized_strings,
+    FormattedRuleResults* rule_results)
+    : localizer_(NULL),
+      unlocalized_strings_(unlocalized_strings),
+      rule_results_(rule_results) {
+  DCHECK(unlocalized_strings_);
+  DCHECK(rule_results_);
+}
+
 ProtoRuleFormatter::~ProtoRuleFormatter() {
   STLDeleteContainerPointers(url_block_formatters_.begin(),
                              url_block_formatters_.end());
@@ -298,7 +438,7 @@ ProtoRuleFormatter::~ProtoRuleFormatter() {
 void ProtoRuleFormatter::SetSummaryLine(
     const UserFacingString& format_str,
     const std::vector<const FormatArgument*>& arguments) {
-  FillFormatString(localizer_, format_str, arguments,
+  FillFormatString(localizer_, unlocalized_strings_, format_str, arguments,
                    rule_results_->mutable_summary());
 }
 
@@ -307,9 +447,11 @@ UrlBlockFormatter* ProtoRuleFormatter::AddUrlBlock(
     const std::vector<const FormatArgument*>& arguments) {
   FormattedUrlBlockResults* url_block_results =
       rule_results_->add_url_blocks();
-  FillFormatString(localizer_, format_str, arguments,
+  FillFormatString(localizer_, unlocalized_strings_, format_str, arguments,
                    url_block_results->mutable_header());
   UrlBlockFormatter* url_block_formatter =
+      unlocalized_strings_ != NULL ?
+      new ProtoUrlBlockFormatter(unlocalized_strings_, url_block_results) :
       new ProtoUrlBlockFormatter(localizer_, url_block_results);
   url_block_formatters_.push_back(url_block_formatter);
   return url_block_formatter;
@@ -318,11 +460,23 @@ UrlBlockFormatter* ProtoRuleFormatter::AddUrlBlock(
 ProtoUrlBlockFormatter::ProtoUrlBlockFormatter(
     const Localizer* localizer,
     FormattedUrlBlockResults* url_block_results)
-    : localizer_(localizer), url_block_results_(url_block_results) {
+    : localizer_(localizer),
+      unlocalized_strings_(NULL),
+      url_block_results_(url_block_results) {
   DCHECK(localizer_);
   DCHECK(url_block_results_);
 }
 
+ProtoUrlBlockFormatter::ProtoUrlBlockFormatter(
+    UnlocalizedStringMap* unlocalized_strings,
+    FormattedUrlBlockResults* url_block_results)
+    : localizer_(NULL),
+      unlocalized_strings_(unlocalized_strings),
+      url_block_results_(url_block_results) {
+  DCHECK(unlocalized_strings_);
+  DCHECK(url_block_results_);
+}
+
 ProtoUrlBlockFormatter::~ProtoUrlBlockFormatter() {
   STLDeleteContainerPointers(url_formatters_.begin(),
                              url_formatters_.end());
@@ -332,9 +486,11 @@ UrlFormatter* ProtoUrlBlockFormatter::AddUrlResult(
     const UserFacingString& format_str,
     const std::vector<const FormatArgument*>& arguments) {
   FormattedUrlResult* url_result = url_block_results_->add_urls();
-  FillFormatString(localizer_, format_str, arguments,
+  FillFormatString(localizer_, unlocalized_strings_, format_str, arguments,
                    url_result->mutable_result());
   UrlFormatter* url_formatter =
+      unlocalized_strings_ != NULL ?
+      new ProtoUrlFormatter(unlocalized_strings_, url_result) :
       new ProtoUrlFormatter(localizer_, url_result);
   url_formatters_.push_back(url_formatter);
   return url_formatter;
@@ -342,15 +498,26 @@ UrlFormatter* ProtoUrlBlockFormatter::AddUrlResult(
 
 ProtoUrlFormatter::ProtoUrlFormatter(const Localizer* localizer,
                                      FormattedUrlResult* url_result)
-    : localizer_(localizer), url_result_(url_result) {
+    : localizer_(localizer),
+      unlocalized_strings_(NULL),
+      url_result_(url_result) {
   DCHECK(localizer_);
   DCHECK(url_result_);
 }
 
+ProtoUrlFormatter::ProtoUrlFormatter(UnlocalizedStringMap* unlocalized_strings,
+                                     FormattedUrlResult* url_result)
+    : localizer_(NULL),
+      unlocalized_strings_(unlocalized_strings),
+      url_result_(url_result) {
+  DCHECK(unlocalized_strings_);
+  DCHECK(url_result_);
+}
+
 void ProtoUrlFormatter::AddDetail(
     const UserFacingString& format_str,
     const std::vector<const FormatArgument*>& arguments) {
-  FillFormatString(localizer_, format_str, arguments,
+  FillFormatString(localizer_, unlocalized_strings_, format_str, arguments,
                    url_result_->add_details());
 }
 
@@ -17,15 +17,24 @@
 #ifndef PAGESPEED_FORMATTERS_PROTO_FORMATTER_H_
 #define PAGESPEED_FORMATTERS_PROTO_FORMATTER_H_
 
+#include <map>
 #include <vector>
 
 #include "base/basictypes.h"
+#include "base/memory/scoped_ptr.h"
 #include "pagespeed/core/formatter.h"
 #include "pagespeed/core/serializer.h"
 
+namespace google {
+namespace protobuf {
+class MessageLite;
+}  // namespace protobuf
+}  // namespace google
+
 namespace pagespeed {
 
 class FormatArgument;
+class FormatString;
 class FormattedResults;
 class FormattedRuleResults;
 class FormattedUrlBlockResults;
@@ -34,6 +43,12 @@ namespace l10n { class Localizer; }
 
 namespace formatters {
 
+// Map from a FormattedRuleResults or FormatString recorded by
+// MultiLocaleProtoFormatter to the not-yet-localized string that belongs in
+// its localized_rule_name or format field.
+typedef std::map<const google::protobuf::MessageLite*, UserFacingString>
+    UnlocalizedStringMap;
+
 /**
  * Formatter that fills in a localized FormattedResults proto.
  */
@@ -56,10 +71,54 @@ class ProtoFormatter : public Formatter {
   DISALLOW_COPY_AND_ASSIGN(ProtoFormatter);
 };
 
+/**
+ * Formatter that records the output of each rule's FormatResults without
+ * localizing it, so that a single Engine::FormatResults pass (including
+ * sorting the results into presentation order) can be localized into any
+ * number of FormattedResults protos.  The recorded results are not modified
+ * after Finalize(), so Localize may then be called from several threads at
+ * once, given thread-safe localizers such as GettextLocalizer::GetShared
+ * returns.
+ */
+class MultiLocaleProtoFormatter : public Formatter {
+ public:
+  MultiLocaleProtoFormatter();
+  ~MultiLocaleProtoFormatter();
+
+  // Formatter interface.
+  virtual RuleFormatter* AddRule(const Rule& rule, double impact);
+  void SetOverallScore(int score);
+  void Finalize();
+
+  // Fills in results with the recorded results, localized using the given
+  // localizer, and sets its locale.  Returns false if called before
+  // Finalize().
+  bool Localize(const pagespeed::l10n::Localizer* localizer,
+                FormattedResults* results) const;
+
+ private:
+  void LocalizeFormatStringFrom(const pagespeed::l10n::Localizer* localizer,
+                                const FormatString& recorded,
+                                FormatString* out) const;
+
+  // The formatted results, with each localizable field holding the native
+  // string, and unlocalized_strings_ giving the string to localize into it.
+  scoped_ptr<FormattedResults> results_;
+  UnlocalizedStringMap unlocalized_strings_;
+  std::vector<RuleFormatter*> rule_formatters_;
+  bool finalized_;
+
+  DISALLOW_COPY_AND_ASSIGN(MultiLocaleProtoFormatter);
+};
+
 class ProtoRuleFormatter : public RuleFormatter {
  public:
   ProtoRuleFormatter(const pagespeed::l10n::Localizer* localizer,
                      FormattedRuleResults* rule_results);
+  // Records format strings into unlocalized_strings instead of localizing
+  // them.
+  ProtoRuleFormatter(UnlocalizedStringMap* unlocalized_strings,
+                     FormattedRuleResults* rule_results);
   ~ProtoRuleFormatter();
 
   // RuleFormatter interface.
@@ -72,6 +131,7 @@ class ProtoRuleFormatter : public RuleFormatter {
 
  private:
   const pagespeed::l10n::Localizer* localizer_;
+  UnlocalizedStringMap* unlocalized_strings_;
   FormattedRuleResults* rule_results_;
   std::vector<UrlBlockFormatter*> url_block_formatters_;
 
@@ -82,6 +142,8 @@ class ProtoUrlBlockFormatter : public UrlBlockFormatter {
  public:
   ProtoUrlBlockFormatter(const pagespeed::l10n::Localizer* localizer,
                          FormattedUrlBlockResults* url_block_results);
+  ProtoUrlBlockFormatter(UnlocalizedStringMap* unlocalized_strings,
+                         FormattedUrlBlockResults* url_block_results);
   ~ProtoUrlBlockFormatter();
 
   // UrlBlockFormatter interface.
@@ -91,6 +153,7 @@ class ProtoUrlBlockFormatter : public UrlBlockFormatter {
 
  private:
   const pagespeed::l10n::Localizer* localizer_;
+  UnlocalizedStringMap* unlocalized_strings_;
   FormattedUrlBlockResults* url_block_results_;
   std::vector<UrlFormatter*> url_formatters_;
 
@@ -101,6 +164,8 @@ class ProtoUrlFormatter : public UrlFormatter {
  public:
   ProtoUrlFormatter(const pagespeed::l10n::Localizer* localizer,
                     FormattedUrlResult* url_result);
+  ProtoUrlFormatter(UnlocalizedStringMap* unlocalized_strings,
+                    FormattedUrlResult* url_result);
 
   // UrlFormatter interface.
   virtual void AddDetail(
@@ -110,6 +175,7 @@ class ProtoUrlFormatter : public UrlFormatter {
 
  private:
   const pagespeed::l10n::Localizer* localizer_;
+  UnlocalizedStringMap* unlocalized_strings_;
   FormattedUrlResult* url_result_;
 
   DISALLOW_COPY_AND_ASSIGN(ProtoUrlFormatter);
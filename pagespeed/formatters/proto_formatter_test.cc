@@ -36,6 +36,7 @@ using pagespeed::RuleFormatter;
 using pagespeed::UrlBlockFormatter;
 using pagespeed::UrlFormatter;
 using pagespeed::UserFacingString;
+using pagespeed::formatters::MultiLocaleProtoFormatter;
 using pagespeed::formatters::ProtoFormatter;
 using pagespeed::l10n::Localizer;
 using pagespeed::l10n::NullLocalizer;
@@ -315,4 +316,82 @@ TEST(ProtoFormatterTest, LocalizerTest) {
   ASSERT_EQ(0, r2.url_blocks_size());
 }
 
+// Makes the same sequence of formatter calls as a rule's FormatResults would,
+// mixing localized and non-localized strings.
+void FormatMixedResults(pagespeed::Formatter* formatter) {
+  DummyTestRule rule1(UserFacingString("rule1", true));
+  DummyTestRule rule2(UserFacingString("rule2", false));
+
+  RuleFormatter* body = formatter->AddRule(rule1, 2.5);
+  UrlBlockFormatter* block = body->AddUrlBlock(
+      UserFacingString("block %(URL)s %(BYTES)s", true),
+      pagespeed::UrlArgument("URL", "http://www.example.com/"),
+      pagespeed::BytesArgument("BYTES", 4096));
+  UrlFormatter* url = block->AddUrlResult(
+      UserFacingString("%(URL)s", false),
+      pagespeed::UrlArgument("URL", "http://www.example.com/a.css"));
+  url->AddDetail(UserFacingString("took %(DUR)s", true),
+                 pagespeed::DurationArgument("DUR", 1500));
+  url->SetAssociatedResultId(7);
+  // The summary line is set after the blocks, as many rules do.
+  body->SetSummaryLine(UserFacingString("%(PERCENT)s of bytes", true),
+                       pagespeed::PercentageArgument("PERCENT", 1, 4));
+
+  formatter->AddRule(rule2, 0);
+  formatter->SetOverallScore(80);
+  formatter->Finalize();
+}
+
+TEST(MultiLocaleProtoFormatterTest, MatchesProtoFormatter) {
+  MultiLocaleProtoFormatter multi_formatter;
+  FormatMixedResults(&multi_formatter);
+
+  TestLocalizer test_localizer;
+  NullLocalizer null_localizer;
+  const Localizer* localizers[] = { &test_localizer, &null_localizer };
+  for (size_t i = 0; i < arraysize(localizers); ++i) {
+    FormattedResults expected;
+    expected.set_locale(localizers[i]->GetLocale());
+    ProtoFormatter formatter(localizers[i], &expected);
+    FormatMixedResults(&formatter);
+    ASSERT_TRUE(expected.IsInitialized());
+
+    FormattedResults actual;
+    ASSERT_TRUE(multi_formatter.Localize(localizers[i], &actual));
+    ASSERT_TRUE(actual.IsInitialized());
+    EXPECT_EQ(expected.SerializeAsString(), actual.SerializeAsString())
+        << localizers[i]->GetLocale();
+  }
+
+  // Spot-check the localized output.
+  FormattedResults results;
+  ASSERT_TRUE(multi_formatter.Localize(&test_localizer, &results));
+  EXPECT_EQ("test", results.locale());
+  EXPECT_EQ(80, results.score());
+  ASSERT_EQ(2, results.rule_results_size());
+  const FormattedRuleResults& r1 = results.rule_results(0);
+  EXPECT_EQ("***rule1***", r1.localized_rule_name());
+  EXPECT_EQ("***%(PERCENT)s of bytes***", r1.summary().format());
+  EXPECT_EQ("****", r1.summary().args(0).localized_value());
+  EXPECT_EQ("***block %(URL)s %(BYTES)s***",
+            r1.url_blocks(0).header().format());
+  EXPECT_EQ("%(URL)s", r1.url_blocks(0).urls(0).result().format());
+  EXPECT_EQ(7, r1.url_blocks(0).urls(0).associated_result_id());
+  EXPECT_EQ("rule2", results.rule_results(1).localized_rule_name());
+  // Filtered-out rules have their impact zeroed, as in ProtoFormatter.
+  EXPECT_EQ(0.0, results.rule_results(1).rule_impact());
+}
+
+TEST(MultiLocaleProtoFormatterTest, LocalizeBeforeFinalize) {
+  MultiLocaleProtoFormatter multi_formatter;
+  NullLocalizer localizer;
+  FormattedResults results;
+#ifdef NDEBUG
+  EXPECT_FALSE(multi_formatter.Localize(&localizer, &results));
+#else
+  EXPECT_DEATH(multi_formatter.Localize(&localizer, &results),
+               "Localize called before Finalize");
+#endif
+}
+
 } // namespace
@@ -0,0 +1,81 @@
+// Copyright 2013 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+
+#include "base/memory/scoped_ptr.h"
+#include "pagespeed/core/pagespeed_input.h"
+#include "pagespeed/core/string_util.h"
+#include "pagespeed/har/http_archive.h"
+#include "pagespeed/testing/benchmark.h"
+
+namespace {
+
+const int kNumEntries = 200;
+
+std::string MakeHarEntry(int i) {
+  return pagespeed::string_util::StringPrintf(
+      "{\"pageref\":\"page_0\","
+      "\"startedDateTime\":\"2009-04-16T12:07:%02d.%03dZ\","
+      "\"request\":{\"method\":\"GET\","
+      "\"url\":\"http://www.example.com/static/script-%d.js\","
+      "\"httpVersion\":\"HTTP/1.1\",\"cookies\":[],"
+      "\"headers\":[{\"name\":\"Accept-Encoding\",\"value\":\"gzip\"},"
+      "{\"name\":\"User-Agent\",\"value\":\"Mozilla/5.0\"}],"
+      "\"headersSize\":-1,\"bodySize\":0},"
+      "\"response\":{\"status\":200,\"statusText\":\"OK\","
+      "\"httpVersion\":\"HTTP/1.1\",\"cookies\":[],"
+      "\"headers\":[{\"name\":\"Content-Type\","
+      "\"value\":\"application/javascript\"},"
+      "{\"name\":\"Cache-Control\",\"value\":\"max-age=3600\"}],"
+      "\"content\":{\"size\":64,\"mimeType\":\"application/javascript\","
+      "\"text\":\"function f%d(a, b) {\\n  return a + b * %d;\\n}\\n\"},"
+      "\"redirectUrl\":\"\",\"headersSize\":-1,\"bodySize\":64},"
+      "\"timings\":{\"connect\":2,\"send\":2,\"wait\":100,\"receive\":10}}",
+      24 + i / 1000, i % 1000, i, i, i);
+}
+
+std::string MakeHar() {
+  std::string har =
+      "{\"log\":{\"version\":\"1.2\","
+      "\"creator\":{\"name\":\"pagespeed_benchmarks\",\"version\":\"1.0\"},"
+      "\"pages\":[{\"startedDateTime\":\"2009-04-16T12:07:23.321Z\","
+      "\"id\":\"page_0\",\"title\":\"Benchmark\","
+      "\"pageTimings\":{\"onLoad\":1500}}],"
+      "\"entries\":[";
+  for (int i = 0; i < kNumEntries; ++i) {
+    if (i > 0) {
+      har += ",";
+    }
+    har += MakeHarEntry(i);
+  }
+  har += "]}}";
+  return har;
+}
+
+PAGESPEED_BENCHMARK(BM_ParseHttpArchive) {
+  const std::string har = MakeHar();
+  state->SetBytesPerIteration(har.size());
+  state->ResetTiming();
+  for (int i = 0; i < state->iterations(); ++i) {
+    scoped_ptr<pagespeed::PagespeedInput> input(
+        pagespeed::ParseHttpArchive(har));
+    if (input == NULL || input->num_resources() != kNumEntries) {
+      state->SetError("ParseHttpArchive failed");
+      return;
+    }
+  }
+}
+
+}  // namespace
@@ -0,0 +1,64 @@
+// Copyright 2013 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+
+#include "pagespeed/core/string_util.h"
+#include "pagespeed/html/html_minifier.h"
+#include "pagespeed/testing/benchmark.h"
+
+namespace {
+
+// About 150KB of unminified markup with inline script and style.
+std::string MakeHtml() {
+  std::string html =
+      "<!DOCTYPE html>\n<html>\n  <head>\n"
+      "    <title>Benchmark page</title>\n"
+      "    <style type=\"text/css\">\n"
+      "      body { margin: 0;  padding: 0; }\n"
+      "      .item   { color: #333333; }\n"
+      "    </style>\n"
+      "    <script type=\"text/javascript\">\n"
+      "      // Count the items on the page.\n"
+      "      var count = 0;\n"
+      "    </script>\n"
+      "  </head>\n  <body>\n";
+  for (int i = 0; i < 1000; ++i) {
+    html += pagespeed::string_util::StringPrintf(
+        "    <!-- Item %d -->\n"
+        "    <div class=\"item\" id=\"item-%d\">\n"
+        "      <a href=\"/items/%d.html\">   Item   number %d   </a>\n"
+        "      <img src=\"/images/%d.png\" width=\"32\" height=\"32\">\n"
+        "    </div>\n", i, i, i, i, i % 50);
+  }
+  html += "  </body>\n</html>\n";
+  return html;
+}
+
+PAGESPEED_BENCHMARK(BM_MinifyHtml) {
+  const std::string html = MakeHtml();
+  pagespeed::html::HtmlMinifier minifier;
+  std::string out;
+  state->SetBytesPerIteration(html.size());
+  state->ResetTiming();
+  for (int i = 0; i < state->iterations(); ++i) {
+    out.clear();
+    if (!minifier.MinifyHtml("http://www.example.com/", html, &out)) {
+      state->SetError("MinifyHtml failed");
+      return;
+    }
+  }
+}
+
+}  // namespace
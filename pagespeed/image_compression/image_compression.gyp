@@ -110,6 +110,7 @@
       'dependencies': [
         'pagespeed_jpeg_reader',
         '<(DEPTH)/base/base.gyp:base',
+        '<(pagespeed_root)/pagespeed/core/core.gyp:pagespeed_cancellation',
         '<(DEPTH)/third_party/libjpeg_turbo/libjpeg_turbo.gyp:libjpeg_turbo',
       ],
       'sources': [
@@ -151,6 +152,7 @@
       'dependencies': [
         'pagespeed_scanline_utils',
         '<(DEPTH)/base/base.gyp:base',
+        '<(pagespeed_root)/pagespeed/core/core.gyp:pagespeed_cancellation',
         '<(DEPTH)/third_party/giflib/giflib.gyp:dgiflib',
         '<(DEPTH)/third_party/libpng/libpng.gyp:libpng',
         '<(DEPTH)/third_party/optipng/optipng.gyp:opngreduc',
@@ -0,0 +1,131 @@
+// Copyright 2013 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+
+#include "pagespeed/image_compression/gif_reader.h"
+#include "pagespeed/image_compression/image_converter.h"
+#include "pagespeed/image_compression/jpeg_optimizer.h"
+#include "pagespeed/image_compression/png_optimizer.h"
+#include "pagespeed/image_compression/webp_optimizer.h"
+#include "pagespeed/testing/benchmark.h"
+#include "pagespeed/testing/pagespeed_test.h"
+
+namespace {
+
+using pagespeed::image_compression::GifReader;
+using pagespeed::image_compression::ImageConverter;
+using pagespeed::image_compression::JpegCompressionOptions;
+using pagespeed::image_compression::PngOptimizer;
+using pagespeed::image_compression::PngReader;
+using pagespeed::image_compression::PngReaderInterface;
+using pagespeed::image_compression::WebpConfiguration;
+
+const char kJpegFile[] = IMAGE_TEST_DIR_PATH "jpeg/sjpeg4.jpg";
+const char kPngFile[] = IMAGE_TEST_DIR_PATH "png/this_is_a_test.png";
+const char kGifFile[] = IMAGE_TEST_DIR_PATH "gif/interlaced.gif";
+
+// Reads a test image, marking the benchmark as failed if it is missing.
+bool ReadImage(const char* path,
+               pagespeed_testing::BenchmarkState* state,
+               std::string* out) {
+  if (!pagespeed_testing::ReadFileToString(path, out)) {
+    state->SetError(std::string("Unable to read ") + path +
+                    "; check --srcroot");
+    return false;
+  }
+  state->SetBytesPerIteration(out->size());
+  return true;
+}
+
+PAGESPEED_BENCHMARK(BM_OptimizeJpeg) {
+  std::string in, out;
+  if (!ReadImage(kJpegFile, state, &in)) {
+    return;
+  }
+  state->ResetTiming();
+  for (int i = 0; i < state->iterations(); ++i) {
+    out.clear();
+    if (!pagespeed::image_compression::OptimizeJpeg(in, &out)) {
+      state->SetError("OptimizeJpeg failed");
+      return;
+    }
+  }
+}
+
+void OptimizePng(const char* path,
+                 const PngReaderInterface& reader,
+                 pagespeed_testing::BenchmarkState* state) {
+  std::string in, out;
+  if (!ReadImage(path, state, &in)) {
+    return;
+  }
+  state->ResetTiming();
+  for (int i = 0; i < state->iterations(); ++i) {
+    out.clear();
+    if (!PngOptimizer::OptimizePng(reader, in, &out)) {
+      state->SetError("OptimizePng failed");
+      return;
+    }
+  }
+}
+
+PAGESPEED_BENCHMARK(BM_OptimizePng_PngReader) {
+  PngReader reader;
+  OptimizePng(kPngFile, reader, state);
+}
+
+PAGESPEED_BENCHMARK(BM_OptimizePng_GifReader) {
+  GifReader reader;
+  OptimizePng(kGifFile, reader, state);
+}
+
+PAGESPEED_BENCHMARK(BM_ConvertPngToJpeg) {
+  std::string in, out;
+  if (!ReadImage(kPngFile, state, &in)) {
+    return;
+  }
+  PngReader reader;
+  JpegCompressionOptions options;
+  options.lossy = true;
+  state->ResetTiming();
+  for (int i = 0; i < state->iterations(); ++i) {
+    out.clear();
+    if (!ImageConverter::ConvertPngToJpeg(reader, in, options, &out)) {
+      state->SetError("ConvertPngToJpeg failed");
+      return;
+    }
+  }
+}
+
+PAGESPEED_BENCHMARK(BM_ConvertPngToWebp) {
+  std::string in, out;
+  if (!ReadImage(kPngFile, state, &in)) {
+    return;
+  }
+  PngReader reader;
+  WebpConfiguration config;
+  bool is_opaque = false;
+  state->ResetTiming();
+  for (int i = 0; i < state->iterations(); ++i) {
+    out.clear();
+    if (!ImageConverter::ConvertPngToWebp(reader, in, config, &out,
+                                          &is_opaque)) {
+      state->SetError("ConvertPngToWebp failed");
+      return;
+    }
+  }
+}
+
+}  // namespace
@@ -36,6 +36,7 @@ extern "C" {
 #endif
 }
 
+#include "pagespeed/core/cancellation.h"
 #include "pagespeed/image_compression/jpeg_reader.h"
 
 using pagespeed::image_compression::ColorSampling;
@@ -122,6 +123,24 @@ void ErrorExit(j_common_ptr jpeg_state_struct) {
     longjmp(*env, 1);
 }
 
+// A jpeg_progress_mgr that aborts the (de)compression once a
+// CancellationToken is cancelled.  libjpeg calls the progress monitor
+// periodically during each pass, so even a huge image stops promptly.
+struct CancellationProgressManager {
+  jpeg_progress_mgr pub;  // public fields; must be first
+  const pagespeed::CancellationToken* cancel;
+};
+
+void CheckCancellation(j_common_ptr jpeg_state_struct) {
+  const CancellationProgressManager* progress =
+      reinterpret_cast<const CancellationProgressManager*>(
+          jpeg_state_struct->progress);
+  if (pagespeed::IsCancelled(progress->cancel)) {
+    // Take the same longjmp path as any other libjpeg error.
+    (*jpeg_state_struct->err->error_exit)(jpeg_state_struct);
+  }
+}
+
 // OutputMessageFromReader is called by libjpeg code on an error when reading.
 // Without this function, a default function would print to standard error.
 void OutputMessage(j_common_ptr jpeg_decompress) {
@@ -220,7 +239,8 @@ void SetJpegCompressAfterStartCompress(const JpegCompressionOptions& options,
 
 class JpegOptimizer {
  public:
-  JpegOptimizer();
+  // cancel may be NULL.
+  explicit JpegOptimizer(const pagespeed::CancellationToken* cancel);
   ~JpegOptimizer();
 
   // Take the given input file and compress it, either losslessly or lossily,
@@ -251,12 +271,16 @@ class JpegOptimizer {
   // Structures for jpeg compression.
   jpeg_compress_struct jpeg_compress_;
   jpeg_error_mgr compress_error_;
+  CancellationProgressManager progress_;
 
   DISALLOW_COPY_AND_ASSIGN(JpegOptimizer);
 };
 
-JpegOptimizer::JpegOptimizer() {
+JpegOptimizer::JpegOptimizer(const pagespeed::CancellationToken* cancel) {
   InitJpegCompress(&jpeg_compress_, &compress_error_);
+  memset(&progress_, 0, sizeof(progress_));
+  progress_.pub.progress_monitor = &CheckCancellation;
+  progress_.cancel = cancel;
 }
 
 JpegOptimizer::~JpegOptimizer() {
@@ -384,6 +408,11 @@ bool JpegOptimizer::DoCreateOptimizedJpeg(
   jpeg_decompress->client_data = static_cast<void *>(&env);
   jpeg_compress_.client_data = static_cast<void *>(&env);
 
+  if (progress_.cancel != NULL) {
+    jpeg_decompress->progress = &progress_.pub;
+    jpeg_compress_.progress = &progress_.pub;
+  }
+
   reader_.PrepareForRead(original.data(), original.size());
 
   if (options.retain_color_profile) {
@@ -420,6 +449,9 @@ bool JpegOptimizer::CreateOptimizedJpeg(const std::string &original,
 
   jpeg_decompress->client_data = NULL;
   jpeg_compress_.client_data = NULL;
+  // Only monitor progress while CreateOptimizedJpeg() is running.
+  jpeg_decompress->progress = NULL;
+  jpeg_compress_.progress = NULL;
 
   if (!result) {
     // Clean up the state of jpeglib structures.  It is okay to abort even if
@@ -520,7 +552,13 @@ void JpegScanlineWriter::AbortWrite() {
 
 bool OptimizeJpeg(const std::string &original,
                   std::string *compressed) {
-  JpegOptimizer optimizer;
+  return OptimizeJpeg(original, NULL, compressed);
+}
+
+bool OptimizeJpeg(const std::string &original,
+                  const CancellationToken *cancel,
+                  std::string *compressed) {
+  JpegOptimizer optimizer(cancel);
   JpegCompressionOptions options;
   return optimizer.CreateOptimizedJpeg(original, compressed, options);
 }
@@ -528,7 +566,7 @@ bool OptimizeJpeg(const std::string &original,
 bool OptimizeJpegWithOptions(const std::string &original,
                              std::string *compressed,
                              const JpegCompressionOptions &options) {
-  JpegOptimizer optimizer;
+  JpegOptimizer optimizer(NULL);
   return optimizer.CreateOptimizedJpeg(original, compressed, options);
 }
 
@@ -29,6 +29,8 @@
 
 namespace pagespeed {
 
+class CancellationToken;
+
 namespace image_compression {
 
 enum ColorSampling {
@@ -82,6 +84,12 @@ struct JpegCompressionOptions {
 bool OptimizeJpeg(const std::string &original,
                   std::string *compressed);
 
+// As above, but give up and return false once cancel is cancelled.  cancel
+// may be NULL.
+bool OptimizeJpeg(const std::string &original,
+                  const CancellationToken *cancel,
+                  std::string *compressed);
+
 // Performs JPEG optimizations with the provided options.
 bool OptimizeJpegWithOptions(const std::string &original,
                              std::string *compressed,
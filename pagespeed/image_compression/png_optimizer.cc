@@ -23,6 +23,7 @@
 
 #include "base/logging.h"
 #include "base/memory/scoped_ptr.h"
+#include "pagespeed/core/cancellation.h"
 #include "pagespeed/image_compression/scanline_utils.h"
 
 #ifdef __native_client__
@@ -273,10 +274,11 @@ PngReaderInterface::PngReaderInterface() {
 PngReaderInterface::~PngReaderInterface() {
 }
 
-PngOptimizer::PngOptimizer()
+PngOptimizer::PngOptimizer(const CancellationToken* cancel)
     : read_(ScopedPngStruct::READ),
       write_(ScopedPngStruct::WRITE),
-      best_compression_(false) {
+      best_compression_(false),
+      cancel_(cancel) {
 }
 
 PngOptimizer::~PngOptimizer() {
@@ -309,7 +311,8 @@ bool PngOptimizer::CreateOptimizedPng(const PngReaderInterface& reader,
     return false;
   }
 
-  if (!opng_validate_image(read_.png_ptr(), read_.info_ptr())) {
+  if (!opng_validate_image(read_.png_ptr(), read_.info_ptr()) ||
+      IsCancelled(cancel_)) {
     return false;
   }
 
@@ -321,6 +324,9 @@ bool PngOptimizer::CreateOptimizedPng(const PngReaderInterface& reader,
   // Perform all possible lossless image reductions
   // (e.g. RGB->palette, etc).
   opng_reduce_image(write_.png_ptr(), write_.info_ptr(), OPNG_REDUCE_ALL);
+  if (IsCancelled(cancel_)) {
+    return false;
+  }
 
   if (best_compression_) {
     return CreateBestOptimizedPngForParams(kPngCompressionParams, kParamCount,
@@ -336,6 +342,9 @@ bool PngOptimizer::CreateBestOptimizedPngForParams(
     std::string* out) {
   bool success = false;
   for (size_t idx = 0; idx < param_list_size; ++idx) {
+    if (IsCancelled(cancel_)) {
+      return false;
+    }
     ScopedPngStruct write(ScopedPngStruct::WRITE);
     std::string temp_output;
     // libpng doesn't allow for reuse of the write structs, so we must copy on
@@ -371,14 +380,28 @@ bool PngOptimizer::CreateOptimizedPngWithParams(ScopedPngStruct* write,
 bool PngOptimizer::OptimizePng(const PngReaderInterface& reader,
                                const std::string& in,
                                std::string* out) {
-  PngOptimizer o;
+  return OptimizePng(reader, in, NULL, out);
+}
+
+bool PngOptimizer::OptimizePngBestCompression(const PngReaderInterface& reader,
+                                              const std::string& in,
+                                              std::string* out) {
+  return OptimizePngBestCompression(reader, in, NULL, out);
+}
+
+bool PngOptimizer::OptimizePng(const PngReaderInterface& reader,
+                               const std::string& in,
+                               const CancellationToken* cancel,
+                               std::string* out) {
+  PngOptimizer o(cancel);
   return o.CreateOptimizedPng(reader, in, out);
 }
 
 bool PngOptimizer::OptimizePngBestCompression(const PngReaderInterface& reader,
                                               const std::string& in,
+                                              const CancellationToken* cancel,
                                               std::string* out) {
-  PngOptimizer o;
+  PngOptimizer o(cancel);
   o.EnableBestCompression();
   return o.CreateOptimizedPng(reader, in, out);
 }
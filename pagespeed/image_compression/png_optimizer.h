@@ -38,6 +38,8 @@ extern "C" {
 
 namespace pagespeed {
 
+class CancellationToken;
+
 namespace image_compression {
 
 class PngInput;
@@ -208,8 +210,20 @@ class PngOptimizer {
                                          const std::string& in,
                                          std::string* out);
 
+  // As above, but give up and return false once cancel is cancelled.
+  // Cancellation is checked between the decoding, reduction and encoding
+  // passes, so the pass in progress runs to completion.  cancel may be NULL.
+  static bool OptimizePng(const PngReaderInterface& reader,
+                          const std::string& in,
+                          const CancellationToken* cancel,
+                          std::string* out);
+  static bool OptimizePngBestCompression(const PngReaderInterface& reader,
+                                         const std::string& in,
+                                         const CancellationToken* cancel,
+                                         std::string* out);
+
  private:
-  PngOptimizer();
+  explicit PngOptimizer(const CancellationToken* cancel);
   ~PngOptimizer();
 
   // Take the given input and losslessly compress it by removing
@@ -237,6 +251,7 @@ class PngOptimizer {
   ScopedPngStruct read_;
   ScopedPngStruct write_;
   bool best_compression_;
+  const CancellationToken* cancel_;
 
   DISALLOW_COPY_AND_ASSIGN(PngOptimizer);
 };
@@ -33,6 +33,7 @@
       ],
       'dependencies': [
         '<(DEPTH)/base/base.gyp:base',
+        '<(pagespeed_root)/pagespeed/core/core.gyp:pagespeed_cancellation',
         'pagespeed_javascript_gperf',
       ],
       'direct_dependent_settings': {
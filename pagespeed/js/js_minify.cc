@@ -19,6 +19,7 @@
 
 #include "base/logging.h"
 #include "base/string_piece.h"
+#include "pagespeed/core/cancellation.h"
 
 using pagespeed::JsKeywords;
 
@@ -170,6 +171,12 @@ class Minifier {
   // and before calling GetOutput().
   void EnableStringCollapse() { collapse_string_ = true; }
 
+  // Give up, as if the input were invalid, once cancel is cancelled.  Should
+  // call before calling GetOutput().
+  void set_cancellation_token(const pagespeed::CancellationToken* cancel) {
+    cancel_ = cancel;
+  }
+
  private:
   int Peek();
   void ChangeToken(int next_token);
@@ -194,6 +201,7 @@ class Minifier {
   int prev_token_;
   bool error_;
   bool collapse_string_;
+  const pagespeed::CancellationToken* cancel_;
 };
 
 template<typename OutputConsumer>
@@ -205,7 +213,8 @@ Minifier<OutputConsumer>::Minifier(const base::StringPiece& input,
     whitespace_(NO_WHITESPACE),
     prev_token_(kStartToken),
     error_(false),
-    collapse_string_(false) {}
+    collapse_string_(false),
+    cancel_(NULL) {}
 
 // Return the next character after index_, or kEOF if there aren't any more.
 template<typename OutputConsumer>
@@ -380,7 +389,12 @@ void Minifier<OutputConsumer>::ConsumeString() {
 
 template<typename OutputConsumer>
 void Minifier<OutputConsumer>::Minify() {
+  pagespeed::CancellationPoller poller(cancel_);
   while (index_ < input_.size() && !error_) {
+    if (poller.IsCancelled()) {
+      error_ = true;
+      break;
+    }
     const char ch = input_[index_];
     // Track whitespace since the previous token.  NO_WHITESPACE means no
     // whitespace; LINEBREAK means there's been at least one linebreak; SPACE
@@ -508,12 +522,26 @@ namespace pagespeed {
 namespace js {
 
 bool MinifyJs(const base::StringPiece& input, std::string* out) {
+  return MinifyJs(input, NULL, out);
+}
+
+bool MinifyJs(const base::StringPiece& input,
+              const CancellationToken* cancel,
+              std::string* out) {
   Minifier<StringConsumer> minifier(input, out);
+  minifier.set_cancellation_token(cancel);
   return (minifier.GetOutput() != NULL);
 }
 
 bool GetMinifiedJsSize(const base::StringPiece& input, int* minimized_size) {
+  return GetMinifiedJsSize(input, NULL, minimized_size);
+}
+
+bool GetMinifiedJsSize(const base::StringPiece& input,
+                       const CancellationToken* cancel,
+                       int* minimized_size) {
   Minifier<SizeConsumer> minifier(input, NULL);
+  minifier.set_cancellation_token(cancel);
   SizeConsumer* output = minifier.GetOutput();
   if (output) {
     *minimized_size = output->size_;
@@ -532,8 +560,15 @@ bool MinifyJsAndCollapseStrings(const base::StringPiece& input,
 
 bool GetMinifiedStringCollapsedJsSize(const base::StringPiece& input,
                                       int* minimized_size) {
+  return GetMinifiedStringCollapsedJsSize(input, NULL, minimized_size);
+}
+
+bool GetMinifiedStringCollapsedJsSize(const base::StringPiece& input,
+                                      const CancellationToken* cancel,
+                                      int* minimized_size) {
   Minifier<SizeConsumer> minifier(input, NULL);
   minifier.EnableStringCollapse();
+  minifier.set_cancellation_token(cancel);
   SizeConsumer* output = minifier.GetOutput();
   if (output) {
     *minimized_size = output->size_;
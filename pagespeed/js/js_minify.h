@@ -21,6 +21,8 @@
 
 namespace pagespeed {
 
+class CancellationToken;
+
 namespace js {
 
 // Return true if minification was successful, false otherwise.
@@ -39,6 +41,18 @@ bool MinifyJsAndCollapseStrings(const base::StringPiece& input,
 bool GetMinifiedStringCollapsedJsSize(const base::StringPiece& input,
                                       int* minimized_size);
 
+// As above, but give up and return false once cancel is cancelled.  cancel
+// may be NULL.
+bool MinifyJs(const base::StringPiece& input,
+              const CancellationToken* cancel,
+              std::string* out);
+bool GetMinifiedJsSize(const base::StringPiece& input,
+                       const CancellationToken* cancel,
+                       int* minimized_size);
+bool GetMinifiedStringCollapsedJsSize(const base::StringPiece& input,
+                                      const CancellationToken* cancel,
+                                      int* minimized_size);
+
 }  // namespace js
 
 }  // namespace pagespeed
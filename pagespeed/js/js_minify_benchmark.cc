@@ -0,0 +1,70 @@
+// Copyright 2013 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+
+#include "pagespeed/core/string_util.h"
+#include "pagespeed/js/js_minify.h"
+#include "pagespeed/testing/benchmark.h"
+
+namespace {
+
+// About 200KB of unminified script, typical of a large library.
+std::string MakeJs() {
+  std::string js;
+  for (int i = 0; i < 1000; ++i) {
+    js += pagespeed::string_util::StringPrintf(
+        "/**\n"
+        " * Computes something interesting (%d).\n"
+        " */\n"
+        "function compute_%d(first_argument, second_argument) {\n"
+        "  // Combine the two arguments.\n"
+        "  var result = first_argument + second_argument * %d;\n"
+        "  if (result > 100 && typeof result === 'number') {\n"
+        "    return \"large: \" + result / 2;\n"
+        "  }\n"
+        "  return result;\n"
+        "}\n\n", i, i, i);
+  }
+  return js;
+}
+
+PAGESPEED_BENCHMARK(BM_MinifyJs) {
+  const std::string js = MakeJs();
+  std::string out;
+  state->SetBytesPerIteration(js.size());
+  state->ResetTiming();
+  for (int i = 0; i < state->iterations(); ++i) {
+    out.clear();
+    if (!pagespeed::js::MinifyJs(js, &out)) {
+      state->SetError("MinifyJs failed");
+      return;
+    }
+  }
+}
+
+PAGESPEED_BENCHMARK(BM_GetMinifiedJsSize) {
+  const std::string js = MakeJs();
+  int size = 0;
+  state->SetBytesPerIteration(js.size());
+  state->ResetTiming();
+  for (int i = 0; i < state->iterations(); ++i) {
+    if (!pagespeed::js::GetMinifiedJsSize(js, &size)) {
+      state->SetError("GetMinifiedJsSize failed");
+      return;
+    }
+  }
+}
+
+}  // namespace
@@ -15,6 +15,7 @@
 #include <string>
 
 #include "base/string_piece.h"
+#include "pagespeed/core/cancellation.h"
 #include "pagespeed/js/js_minify.h"
 #include "testing/gtest/include/gtest/gtest.h"
 
@@ -397,4 +398,23 @@ TEST_F(JsMinifyTest, CollapsingStringTest) {
     ASSERT_EQ(static_cast<int>(strlen(kCollapsedTestString)), size);
 }
 
+TEST_F(JsMinifyTest, Cancellation) {
+  std::string input;
+  for (int i = 0; i < 1000; ++i) {
+    input.append("var x = 1 ;\n");
+  }
+  pagespeed::CancellationToken token;
+  std::string output;
+  int size = 0;
+  ASSERT_TRUE(pagespeed::js::MinifyJs(input, &token, &output));
+  ASSERT_TRUE(pagespeed::js::GetMinifiedJsSize(input, &token, &size));
+  ASSERT_EQ(static_cast<int>(output.size()), size);
+
+  token.Cancel();
+  ASSERT_FALSE(pagespeed::js::MinifyJs(input, &token, &output));
+  ASSERT_FALSE(pagespeed::js::GetMinifiedJsSize(input, &token, &size));
+  ASSERT_FALSE(pagespeed::js::GetMinifiedStringCollapsedJsSize(
+      input, &token, &size));
+}
+
 }  // namespace
@@ -15,9 +15,8 @@
 
 #include "pagespeed/l10n/gettext_localizer.h"
 
-#include <iomanip>
 #include <map>
-#include <sstream>
+#include <vector>
 
 #include "base/logging.h"
 #include "pagespeed/core/string_util.h"
@@ -35,6 +34,57 @@ namespace {
 const int kBytesPerKiB = 1 << 10;
 const int kBytesPerMiB = 1 << 20;
 
+typedef std::map<std::string, const GettextLocalizer*,
+                 pagespeed::string_util::CaseInsensitiveStringComparator>
+    SharedLocalizerMap;
+
+// Map from registered locale name to its shared localizer.  Written only by
+// InitSharedLocalizers and ShutDownSharedLocalizers, which run while the
+// process is single-threaded, so readers need no locking.
+SharedLocalizerMap* g_shared_localizers = NULL;
+
+// Finds the string table that best matches the given locale, storing the name
+// it was registered under (as spelled in the locale argument) in
+// *matched_locale.  Returns NULL if no registered locale matches.
+const char** FindStringTable(const std::string& locale,
+                             std::string* matched_locale) {
+  // Parse the locale string.
+  std::string language, country, encoding;
+  ParseLocaleString(locale, &language, &country, &encoding);
+
+  // Check that encoding is empty or UTF-8.
+  if (!encoding.empty() &&
+      !pagespeed::string_util::StringCaseEqual(encoding, "utf-8")) {
+    LOG(ERROR) << "could not provide encoding '" << encoding
+               << "' for locale '" << locale << "'";
+    return NULL;
+  }
+
+  const char** locale_table = NULL;
+
+  // Check <language>_<country> first.
+  if (!country.empty()) {
+    *matched_locale = language + "_" + country;
+    locale_table = RegisterLocale::GetStringTable(*matched_locale);
+
+    if (!locale_table) {
+      LOG(INFO) << "could not find string table for locale '"
+                << *matched_locale << "', trying '" << language << "'";
+    }
+  }
+
+  if (!locale_table) {
+    *matched_locale = language;
+    locale_table = RegisterLocale::GetStringTable(*matched_locale);
+  }
+
+  if (!locale_table) {
+    LOG(ERROR) << "could not find string table matching locale '"
+               << locale << "'";
+  }
+  return locale_table;
+}
+
 }  // namespace
 
 void ParseLocaleString(const std::string& locale, std::string* language_out,
@@ -73,44 +123,63 @@ void ParseLocaleString(const std::string& locale, std::string* language_out,
 }
 
 GettextLocalizer* GettextLocalizer::Create(const std::string& locale) {
-  // Parse the locale string.
-  std::string language, country, encoding;
-  ParseLocaleString(locale, &language, &country, &encoding);
+  std::string requested_locale;
+  const char** locale_table = FindStringTable(locale, &requested_locale);
+  if (!locale_table) {
+    return NULL;
+  }
+  return new GettextLocalizer(requested_locale, locale_table);
+}
 
-  // Check that encoding is empty or UTF-8.
-  if (!encoding.empty() &&
-      !pagespeed::string_util::StringCaseEqual(encoding, "utf-8")) {
-    LOG(ERROR) << "could not provide encoding '" << encoding
-               << "' for locale '" << locale << "'";
+const GettextLocalizer* GettextLocalizer::GetShared(const std::string& locale) {
+  if (!g_shared_localizers) {
+    LOG(DFATAL) << "shared localizers not initialized (call pagespeed::Init())";
     return NULL;
   }
 
   std::string requested_locale;
-  const char** locale_table = NULL;
+  if (!FindStringTable(locale, &requested_locale)) {
+    return NULL;
+  }
 
-  // Check <language>_<country> first.
-  if (!country.empty()) {
-    requested_locale = language + "_" + country;
-    locale_table = RegisterLocale::GetStringTable(requested_locale);
+  SharedLocalizerMap::const_iterator it =
+      g_shared_localizers->find(requested_locale);
+  if (it == g_shared_localizers->end()) {
+    LOG(DFATAL) << "no shared localizer for registered locale '"
+                << requested_locale << "'";
+    return NULL;
+  }
+  return it->second;
+}
 
-    if (!locale_table) {
-      LOG(INFO) << "could not find string table for locale '"
-                << requested_locale << "', trying '" << language << "'";
-    }
+void GettextLocalizer::InitSharedLocalizers() {
+  if (g_shared_localizers) {
+    LOG(DFATAL) << "InitSharedLocalizers called multiple times.";
+    return;
   }
 
-  if (!locale_table) {
-    requested_locale = language;
-    locale_table = RegisterLocale::GetStringTable(requested_locale);
+  g_shared_localizers = new SharedLocalizerMap();
+  std::vector<std::string> locales;
+  RegisterLocale::GetAllLocales(&locales);
+  for (std::vector<std::string>::const_iterator it = locales.begin();
+       it != locales.end(); ++it) {
+    const char** locale_table = RegisterLocale::GetStringTable(*it);
+    if (locale_table) {
+      (*g_shared_localizers)[*it] = new GettextLocalizer(*it, locale_table);
+    }
   }
+}
 
-  if (!locale_table) {
-    LOG(ERROR) << "could not find string table matching locale '"
-               << locale << "'";
-    return NULL;
-  } else {
-    return new GettextLocalizer(requested_locale, locale_table);
+void GettextLocalizer::ShutDownSharedLocalizers() {
+  if (!g_shared_localizers) {
+    return;
+  }
+  for (SharedLocalizerMap::const_iterator it = g_shared_localizers->begin();
+       it != g_shared_localizers->end(); ++it) {
+    delete it->second;
   }
+  delete g_shared_localizers;
+  g_shared_localizers = NULL;
 }
 
 GettextLocalizer::GettextLocalizer(const std::string& locale,
@@ -129,18 +198,15 @@ bool GettextLocalizer::LocalizeString(const std::string& val,
     return false;
   }
 
-  const std::map<std::string, size_t>* master_string_map =
-      RegisterLocale::GetMasterStringMap();
-  if (!master_string_map) {
+  if (!RegisterLocale::HasMasterStringTable()) {
     LOG(DFATAL) << "no master string table found";
     return false;
   }
-  std::map<std::string, size_t>::const_iterator itr =
-      master_string_map->find(val);
 
   // If the string isn't found in the table, then it was never extracted for
   // localization.
-  if (itr == master_string_map->end()) {
+  size_t idx = 0;
+  if (!RegisterLocale::GetMasterStringIndex(val, &idx)) {
     LOG(INFO) << "no entry in translation table for string '"
               << val << "'";
     *out = val;
@@ -149,7 +215,6 @@ bool GettextLocalizer::LocalizeString(const std::string& val,
 
   // If the translated string is empty, on the other hand, then it was extracted
   // for localization, but the localization hasn't happened yet.
-  size_t idx = itr->second;
   if (locale_string_table_[idx][0] == '\0') {
     LOG(WARNING) << "no translation available for string '"
                  << val << "'";
@@ -167,9 +232,7 @@ bool GettextLocalizer::LocalizeInt(int64 val, std::string* out) const {
     return false;
   }
 
-  ClearOstream();
-  ostream_ << val;
-  *out = ostream_.str();
+  *out = pagespeed::string_util::Int64ToString(val);
   return true;
 }
 
@@ -194,33 +257,29 @@ bool GettextLocalizer::LocalizeBytes(int64 bytes, std::string* out) const {
   const char* placeholder_key;
   std::string value;
 
-  ClearOstream();
   if (bytes < kBytesPerKiB) {
     // TRANSLATOR: An amount of bytes with abbreviated unit.  The "NUM_BYTES"
     // placeholder is replaced with the number of bytes (e.g. "93",
     // representing 93 bytes).
     format = _("%(NUM_BYTES)sB");
     placeholder_key = "NUM_BYTES";
-    ostream_ << bytes;
-    value = ostream_.str();
+    value = pagespeed::string_util::Int64ToString(bytes);
   } else if (bytes < kBytesPerMiB) {
     // TRANSLATOR: An amount of kilobytes with abbreviated unit.  The
     // "NUM_KILOBYTES" placeholder is replaced with the number of kilobytes
     // (e.g. "32.5", representing 32.5 kilobytes).
     format = _("%(NUM_KILOBYTES)sKiB");
     placeholder_key = "NUM_KILOBYTES";
-    ostream_ << std::fixed << std::setprecision(1)
-             << bytes / static_cast<double>(kBytesPerKiB);
-    value = ostream_.str();
+    value = pagespeed::string_util::StringPrintf(
+        "%.1f", bytes / static_cast<double>(kBytesPerKiB));
   } else {
     // TRANSLATOR: An amount of megabytes with abbreviated unit.  The
     // "NUM_MEGABYTES" placeholder is replaced with the number of megabytes
     // (e.g. "32.5", representing 32.5 megabytes).
     format = _("%(NUM_MEGABYTES)sMiB");
     placeholder_key = "NUM_MEGABYTES";
-    ostream_ << std::fixed << std::setprecision(1)
-             << bytes / static_cast<double>(kBytesPerMiB);
-    value = ostream_.str();
+    value = pagespeed::string_util::StringPrintf(
+        "%.1f", bytes / static_cast<double>(kBytesPerMiB));
   }
 
   std::string localized_format;
@@ -260,17 +319,11 @@ bool GettextLocalizer::LocalizePercentage(int64 p, std::string* out) const {
     return false;
   }
 
-  ClearOstream();
-  ostream_ << p << "%";
-  *out = ostream_.str();
+  *out = pagespeed::string_util::Int64ToString(p);
+  out->push_back('%');
   return false;
 }
 
-void GettextLocalizer::ClearOstream() const {
-  ostream_.clear();
-  ostream_.str("");
-}
-
 }  // namespace l10n
 
 }  // namespace pagespeed
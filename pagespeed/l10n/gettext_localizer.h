@@ -16,11 +16,9 @@
 #ifndef PAGESPEED_L10N_GETTEXT_LOCALIZER_H_
 #define PAGESPEED_L10N_GETTEXT_LOCALIZER_H_
 
-#include <locale>
-#include <map>
-#include <sstream>
+#include <string>
 
-#include "base/memory/scoped_ptr.h"
+#include "base/basictypes.h"
 #include "pagespeed/l10n/localizer.h"
 
 namespace pagespeed {
@@ -34,8 +32,8 @@ void ParseLocaleString(const std::string& locale, std::string* language_out,
 
 /**
  * A localizer that looks up translations of strings in copies of gettext .po
- * files compiled into the binary.  Uses std::locale for localizing numbers,
- * etc.
+ * files compiled into the binary.  Instances are immutable once constructed,
+ * so a single GettextLocalizer may be used from many threads at once.
  */
 class GettextLocalizer : public Localizer {
  public:
@@ -49,6 +47,22 @@ class GettextLocalizer : public Localizer {
   // available, or "en" if not.  Locale matching is case-insensitive.
   static GettextLocalizer* Create(const std::string& locale);
 
+  // Returns the process-wide shared GettextLocalizer that best matches the
+  // given locale (using the same matching rules as Create), or NULL if no
+  // locale matches.  The returned object is owned by the registry and may be
+  // used concurrently from any thread.  The registry is built by
+  // InitSharedLocalizers.
+  static const GettextLocalizer* GetShared(const std::string& locale);
+
+  // Builds one shared GettextLocalizer per registered locale.  Must be called
+  // after RegisterLocale::Freeze and before any threads are created
+  // (i.e. in pagespeed::Init()).
+  static void InitSharedLocalizers();
+
+  // Deletes the shared localizers.  Must only be called once no other thread
+  // can be using them (i.e. in pagespeed::ShutDown()).
+  static void ShutDownSharedLocalizers();
+
   virtual const char* GetLocale() const;
   virtual bool LocalizeString(const std::string& val, std::string* out) const;
   virtual bool LocalizeInt(int64 val, std::string* out) const;
@@ -64,12 +78,7 @@ class GettextLocalizer : public Localizer {
   const std::string locale_;
 
   // Pointer to the string table for the chosen locale
-  const char** locale_string_table_;
-
-  // It's >2x faster to reuse the same std::ostringstream object rather than
-  // construct a new one for each call that needs it.
-  void ClearOstream() const;
-  mutable std::ostringstream ostream_;
+  const char** const locale_string_table_;
 
   DISALLOW_COPY_AND_ASSIGN(GettextLocalizer);
 };
@@ -95,6 +95,25 @@ TEST_F(GettextLocalizerTest, StringTest) {
   ASSERT_EQ("test string", out);
 }
 
+TEST_F(GettextLocalizerTest, MasterStringIndexTest) {
+  const char** master_table = RegisterLocale::GetStringTable("en_US");
+  ASSERT_TRUE(master_table != NULL);
+  ASSERT_TRUE(RegisterLocale::HasMasterStringTable());
+
+  // Every master string must map back to its own index (or, for
+  // duplicates, to the index of an identical string).
+  for (size_t i = 0; master_table[i] != NULL; ++i) {
+    size_t index = 0;
+    ASSERT_TRUE(RegisterLocale::GetMasterStringIndex(master_table[i], &index))
+        << master_table[i];
+    ASSERT_STREQ(master_table[i], master_table[index]);
+  }
+
+  size_t index = 0;
+  ASSERT_FALSE(RegisterLocale::GetMasterStringIndex("test string", &index));
+  ASSERT_FALSE(RegisterLocale::GetMasterStringIndex("", &index));
+}
+
 TEST_F(GettextLocalizerTest, OtherTest) {
   scoped_ptr<GettextLocalizer> loc(GettextLocalizer::Create("test"));
   ASSERT_TRUE(loc.get() != NULL);
@@ -119,6 +138,33 @@ TEST_F(GettextLocalizerTest, OtherTest) {
   ASSERT_EQ("6 seconds", out);
 }
 
+TEST_F(GettextLocalizerTest, SharedLocalizerTest) {
+  const GettextLocalizer* loc = GettextLocalizer::GetShared("test");
+  ASSERT_TRUE(loc != NULL);
+  ASSERT_STREQ("test", loc->GetLocale());
+
+  // Every spelling that resolves to the same locale shares one instance.
+  ASSERT_EQ(loc, GettextLocalizer::GetShared("TEST"));
+  ASSERT_EQ(loc, GettextLocalizer::GetShared("test_unknown.utf-8"));
+  ASSERT_NE(loc, GettextLocalizer::GetShared("test_empty"));
+
+  ASSERT_TRUE(NULL == GettextLocalizer::GetShared("test2_bad"));
+  ASSERT_TRUE(NULL == GettextLocalizer::GetShared("test.utf-32"));
+
+  std::string out;
+  ASSERT_TRUE(loc->LocalizeString(std::string("Avoid CSS @import"), &out));
+  ASSERT_EQ("@IMPORT css aVOID", out);
+
+  ASSERT_TRUE(loc->LocalizeBytes(5430, &out));
+  ASSERT_EQ("5.3kIb", out);
+
+  ASSERT_TRUE(loc->LocalizeInt(kint64min, &out));
+  ASSERT_EQ("-9223372036854775808", out);
+
+  ASSERT_FALSE(loc->LocalizePercentage(-5, &out));
+  ASSERT_EQ("-5%", out);
+}
+
 // Tests that utf8-encoding translations make it through the entire pipeline
 TEST_F(GettextLocalizerTest, EncodingTest) {
   scoped_ptr<GettextLocalizer> loc(GettextLocalizer::Create("test_encoding"));
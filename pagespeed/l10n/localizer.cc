@@ -15,9 +15,8 @@
 
 #include "pagespeed/l10n/localizer.h"
 
-#include <sstream>
-
 #include "base/logging.h"
+#include "pagespeed/core/string_util.h"
 #include "pagespeed/formatters/formatter_util.h"
 
 namespace {
@@ -52,9 +51,7 @@ bool BasicLocalizer::LocalizeInt(int64 val, std::string* out) const {
     LOG(DFATAL) << "out == NULL";
     return false;
   }
-  std::ostringstream ss;
-  ss << val;
-  *out = ss.str();
+  *out = pagespeed::string_util::Int64ToString(val);
   return true;
 }
 
@@ -100,9 +97,8 @@ bool BasicLocalizer::LocalizePercentage(int64 p, std::string* out) const {
     LOG(DFATAL) << "out == NULL";
     return false;
   }
-  std::ostringstream ss;
-  ss << p << "%";
-  *out = ss.str();
+  *out = pagespeed::string_util::Int64ToString(p);
+  out->push_back('%');
   return true;
 }
 
@@ -126,9 +122,7 @@ bool NullLocalizer::LocalizeInt(int64 val, std::string* out) const {
     LOG(DFATAL) << "out == NULL";
     return false;
   }
-  std::ostringstream ss;
-  ss << val;
-  *out = ss.str();
+  *out = pagespeed::string_util::Int64ToString(val);
   return true;
 }
 
@@ -147,9 +141,7 @@ bool NullLocalizer::LocalizeBytes(int64 bytes, std::string* out) const {
     LOG(DFATAL) << "out == NULL";
     return false;
   }
-  std::ostringstream ss;
-  ss << bytes;
-  *out = ss.str();
+  *out = pagespeed::string_util::Int64ToString(bytes);
   return true;
 }
 
@@ -158,9 +150,7 @@ bool NullLocalizer::LocalizeTimeDuration(int64 ms, std::string* out) const {
     LOG(DFATAL) << "out == NULL";
     return false;
   }
-  std::ostringstream ss;
-  ss << ms;
-  *out = ss.str();
+  *out = pagespeed::string_util::Int64ToString(ms);
   return true;
 }
 
@@ -170,9 +160,7 @@ bool NullLocalizer::LocalizeDistance(
     LOG(DFATAL) << "out == NULL";
     return false;
   }
-  std::ostringstream ss;
-  ss << micrometers;
-  *out = ss.str();
+  *out = pagespeed::string_util::Int64ToString(micrometers);
   return true;
 }
 
@@ -181,9 +169,7 @@ bool NullLocalizer::LocalizePercentage(int64 p, std::string* out) const {
     LOG(DFATAL) << "out == NULL";
     return false;
   }
-  std::ostringstream ss;
-  ss << p;
-  *out = ss.str();
+  *out = pagespeed::string_util::Int64ToString(p);
   return true;
 }
 
@@ -34,6 +34,9 @@ namespace l10n {
  * The Localizer should attempt to localize the value, and return true if
  * successful, putting the localized value in *out.  The Localizer should put a
  * reasonable value in *out even if localization fails.
+ *
+ * Implementations must not mutate any state from the const Localize* methods,
+ * so that a single instance can be shared by concurrent formatting threads.
  */
 class Localizer {
  public:
@@ -15,6 +15,8 @@
 
 #include "pagespeed/l10n/register_locale.h"
 
+#include <string.h>
+
 #include <algorithm>
 
 #include "base/logging.h"
@@ -29,6 +31,10 @@ namespace {
 // identity transformation).
 const char* kNativeLocale = "en_US";
 
+// 32-bit FNV-1a parameters.
+const uint32 kFnvOffsetBasis = 2166136261U;
+const uint32 kFnvPrime = 16777619U;
+
 }  // namespace
 
 using std::map;
@@ -38,7 +44,9 @@ using pagespeed::string_util::CaseInsensitiveStringComparator;
 
 bool RegisterLocale::frozen_ = false;
 RegisterLocale::StringTableMap* RegisterLocale::string_table_map_ = NULL;
-std::map<std::string, size_t>* RegisterLocale::master_string_map_ = NULL;
+const char** RegisterLocale::master_string_table_ = NULL;
+std::vector<RegisterLocale::MasterStringSlot>*
+    RegisterLocale::master_string_index_ = NULL;
 
 RegisterLocale::RegisterLocale(const char* locale, const char** string_table) {
   CHECK(string_table);
@@ -52,13 +60,10 @@ RegisterLocale::RegisterLocale(const char* locale, const char** string_table) {
   if (!locale) {
     string_table_map_->insert(make_pair(string(kNativeLocale), string_table));
 
-    // Build map from master string -> table index
-    CHECK(!master_string_map_); // we can only register one master string table
-    master_string_map_ = new std::map<std::string, size_t>();
-
-    for (size_t i = 0; string_table[i] != NULL; ++i) {
-      master_string_map_->insert(std::make_pair(string_table[i], i));
-    }
+    // Build index from master string -> table index
+    CHECK(!master_string_table_); // we can only register one master table
+    master_string_table_ = string_table;
+    BuildMasterStringIndex();
   } else {
     string_table_map_->insert(make_pair(string(locale), string_table));
   }
@@ -70,10 +75,11 @@ RegisterLocale::~RegisterLocale() {
     string_table_map_ = NULL;
   }
 
-  if (master_string_map_) {
-    delete master_string_map_;
-    master_string_map_ = NULL;
+  if (master_string_index_) {
+    delete master_string_index_;
+    master_string_index_ = NULL;
   }
+  master_string_table_ = NULL;
 }
 
 void RegisterLocale::Freeze() {
@@ -84,7 +90,7 @@ void RegisterLocale::Freeze() {
 
   // If any locales were registered, we must have a master string table.
   if (string_table_map_)
-    CHECK(master_string_map_);
+    CHECK(master_string_table_);
 
   frozen_ = true;
 }
@@ -107,6 +113,76 @@ const char** RegisterLocale::GetStringTable(const std::string& locale) {
   return itr->second;
 }
 
+uint32 RegisterLocale::HashString(const char* str, size_t length) {
+  uint32 hash = kFnvOffsetBasis;
+  for (size_t i = 0; i < length; ++i) {
+    hash ^= static_cast<unsigned char>(str[i]);
+    hash *= kFnvPrime;
+  }
+  return hash;
+}
+
+void RegisterLocale::BuildMasterStringIndex() {
+  size_t num_strings = 0;
+  while (master_string_table_[num_strings] != NULL) {
+    ++num_strings;
+  }
+
+  // Keep the load factor at or below 1/2, so that probe sequences are short.
+  size_t num_slots = 1;
+  while (num_slots < 2 * num_strings) {
+    num_slots <<= 1;
+  }
+  const MasterStringSlot empty_slot = { 0, 0 };
+  master_string_index_ =
+      new std::vector<MasterStringSlot>(num_slots, empty_slot);
+
+  const size_t mask = num_slots - 1;
+  for (size_t i = 0; i < num_strings; ++i) {
+    const char* str = master_string_table_[i];
+    const uint32 hash = HashString(str, strlen(str));
+    size_t slot = hash & mask;
+    bool duplicate = false;
+    while ((*master_string_index_)[slot].index_plus_one != 0) {
+      const MasterStringSlot& existing = (*master_string_index_)[slot];
+      if (existing.hash == hash &&
+          strcmp(master_string_table_[existing.index_plus_one - 1],
+                 str) == 0) {
+        // Like the first translation in a .po file, the first occurrence
+        // of a string wins.
+        duplicate = true;
+        break;
+      }
+      slot = (slot + 1) & mask;
+    }
+    if (!duplicate) {
+      (*master_string_index_)[slot].hash = hash;
+      (*master_string_index_)[slot].index_plus_one = static_cast<uint32>(i + 1);
+    }
+  }
+}
+
+bool RegisterLocale::GetMasterStringIndex(const std::string& str,
+                                          size_t* out_index) {
+  if (!master_string_index_ || master_string_index_->empty()) {
+    return false;
+  }
+
+  const uint32 hash = HashString(str.data(), str.size());
+  const size_t mask = master_string_index_->size() - 1;
+  for (size_t slot = hash & mask; ; slot = (slot + 1) & mask) {
+    const MasterStringSlot& candidate = (*master_string_index_)[slot];
+    if (candidate.index_plus_one == 0) {
+      return false;
+    }
+    if (candidate.hash == hash &&
+        str.compare(master_string_table_[candidate.index_plus_one - 1]) == 0) {
+      *out_index = candidate.index_plus_one - 1;
+      return true;
+    }
+  }
+}
+
 void RegisterLocale::GetAllLocales(std::vector<std::string>* out) {
   if (!frozen_) {
     LOG(DFATAL) << "RegisterLocale not frozen (call pagespeed::Init())";
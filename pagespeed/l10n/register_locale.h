@@ -20,6 +20,7 @@
 #include <string>
 #include <vector>
 
+#include "base/basictypes.h"
 #include "pagespeed/core/string_util.h"
 
 namespace pagespeed {
@@ -55,13 +56,29 @@ class RegisterLocale {
   // Fills the given vector with all available locales.
   static void GetAllLocales(std::vector<std::string>* out);
 
-  // Returns the master string map (mapping from canonical/native string to
-  // table index)
-  static const std::map<std::string, size_t>* GetMasterStringMap() {
-    return master_string_map_;
-  }
+  // Looks up the given canonical/native string in the master string table.
+  // If found, returns true and sets *out_index to its index, which is the
+  // index of its translation in every locale's string table.  The lookup
+  // costs one hash of the string plus, in the common case, one string
+  // comparison.
+  static bool GetMasterStringIndex(const std::string& str, size_t* out_index);
+
+  // Returns true if a master string table has been registered.
+  static bool HasMasterStringTable() { return master_string_table_ != NULL; }
 
  private:
+  // Slot of the open-addressing hash index over the master string table.
+  struct MasterStringSlot {
+    uint32 hash;
+    // Index into the master string table, plus one; zero marks an empty slot.
+    uint32 index_plus_one;
+  };
+
+  static uint32 HashString(const char* str, size_t length);
+
+  // Builds master_string_index_ from master_string_table_.
+  static void BuildMasterStringIndex();
+
   // flag that indicates any future writing to the string table maps is an error
   static bool frozen_;
 
@@ -73,9 +90,14 @@ class RegisterLocale {
   // RegisterLocale destructor called at process shutdown.
   static StringTableMap* string_table_map_;
 
-  // map from string constant to table index, generated from the "master" string
-  // table.  Instantiated when RegisterLocale(NULL, ...) is called.
-  static std::map<std::string, size_t>* master_string_map_;
+  // The "master" (native locale) string table, registered with
+  // RegisterLocale(NULL, ...).
+  static const char** master_string_table_;
+
+  // Hash index from string constant to master table index, with a power of
+  // two number of slots.  Instantiated when RegisterLocale(NULL, ...) is
+  // called.
+  static std::vector<MasterStringSlot>* master_string_index_;
 };
 
 } // namespace l10n
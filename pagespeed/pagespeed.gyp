@@ -27,7 +27,6 @@
         '<(pagespeed_root)/pagespeed/core/core.gyp:pagespeed_core',
         '<(pagespeed_root)/pagespeed/css/css.gyp:pagespeed_cssmin',
         '<(pagespeed_root)/pagespeed/css/css.gyp:pagespeed_css_external_resource_finder',
-        '<(pagespeed_root)/pagespeed/dom/dom.gyp:pagespeed_resource_coordinate_finder',
         '<(pagespeed_root)/pagespeed/html/html.gyp:pagespeed_html',
         '<(pagespeed_root)/pagespeed/html/html.gyp:pagespeed_external_resource_filter',
         '<(pagespeed_root)/pagespeed/image_compression/image_compression.gyp:pagespeed_jpeg_optimizer',
@@ -127,32 +126,40 @@
       ],
       'sources': [
         'browsing_context/browsing_context_factory_test.cc',
+        'core/blob_store_test.cc',
         'core/browsing_context_test.cc',
+        'core/cancellation_test.cc',
         'core/dom_test.cc',
         'core/engine_test.cc',
         'core/file_util_test.cc',
         'core/formatter_test.cc',
         'core/input_capabilities_test.cc',
+        'core/input_fingerprint_test.cc',
         'core/instrumentation_data_test.cc',
         'core/pagespeed_input_test.cc',
+        'core/profile_timer_test.cc',
+        'core/parallel_for_test.cc',
         'core/resource_test.cc',
         'core/resource_collection_test.cc',
+        'core/resource_coordinate_finder_test.cc',
         'core/resource_evaluation_test.cc',
         'core/resource_fetch_test.cc',
         'core/resource_filter_test.cc',
+        'core/resource_url_index_test.cc',
         'core/resource_util_test.cc',
         'core/rule_input_test.cc',
+        'core/site_analyzer_test.cc',
         'core/string_tokenizer_test.cc',
         'core/string_util_test.cc',
         'core/uri_util_test.cc',
         'css/cssmin_test.cc',
         'css/external_resource_finder_test.cc',
         'dom/json_dom_test.cc',
-        'dom/resource_coordinate_finder_test.cc',
         'filters/ad_filter_test.cc',
         'filters/landing_page_redirection_filter_test.cc',
         'filters/protocol_filter_test.cc',
         'filters/response_byte_result_filter_test.cc',
+        'filters/rule_name_result_filter_test.cc',
         'filters/tracker_filter_test.cc',
         'filters/url_regex_filter_test.cc',
         'formatters/formatter_util_test.cc',
@@ -167,6 +174,7 @@
         'proto/formatted_results_to_json_converter_test.cc',
         'proto/formatted_results_to_text_converter_test.cc',
         'proto/pagespeed_output_util_test.cc',
+        'proto/proto_input_stream_test.cc',
         'proto/results_to_json_converter_test.cc',
         'rules/avoid_bad_requests_test.cc',
         'rules/avoid_charset_in_meta_tag_test.cc',
@@ -210,6 +218,7 @@
         'rules/use_an_application_cache_test.cc',
         'testing/fake_dom_test.cc',
         'testing/instrumentation_data_builder_test.cc',
+        'testing/synthetic_page_test.cc',
         'timeline/json_importer_test.cc',
         'util/regex_test.cc',
       ],
@@ -251,5 +260,73 @@
         'IMAGE_TEST_DIR_PATH="pagespeed/image_compression/testdata/"',
       ],
     },
+    {
+      'target_name': 'pagespeed_benchmarks',
+      'type': 'executable',
+      'dependencies': [
+        'pagespeed_library',
+        '<(pagespeed_root)/pagespeed/css/css.gyp:pagespeed_cssmin',
+        '<(pagespeed_root)/pagespeed/css/css.gyp:pagespeed_css_external_resource_finder',
+        '<(pagespeed_root)/pagespeed/dom/dom.gyp:pagespeed_json_dom',
+        '<(pagespeed_root)/pagespeed/filters/filters.gyp:pagespeed_filters',
+        '<(pagespeed_root)/pagespeed/formatters/formatters.gyp:pagespeed_formatters',
+        '<(pagespeed_root)/pagespeed/har/har.gyp:pagespeed_har',
+        '<(pagespeed_root)/pagespeed/html/html.gyp:pagespeed_html',
+        '<(pagespeed_root)/pagespeed/image_compression/image_compression.gyp:pagespeed_image_converter',
+        '<(pagespeed_root)/pagespeed/image_compression/image_compression.gyp:pagespeed_read_image',
+        '<(pagespeed_root)/pagespeed/js/js.gyp:pagespeed_jsminify',
+        '<(pagespeed_root)/pagespeed/l10n/l10n.gyp:pagespeed_l10n',
+        '<(pagespeed_root)/pagespeed/proto/proto_gen.gyp:pagespeed_input_pb',
+        '<(pagespeed_root)/pagespeed/proto/proto_gen.gyp:pagespeed_output_pb',
+        '<(pagespeed_root)/pagespeed/testing/testing.gyp:pagespeed_benchmark_main',
+        '<(pagespeed_root)/pagespeed/testing/testing.gyp:pagespeed_testing',
+        '<(pagespeed_root)/pagespeed/timeline/timeline.gyp:pagespeed_timeline',
+        '<(DEPTH)/base/base.gyp:base',
+        '<(DEPTH)/third_party/libjpeg_turbo/libjpeg_turbo.gyp:libjpeg_turbo',
+        '<(DEPTH)/third_party/libpng/libpng.gyp:libpng',
+      ],
+      'include_dirs': [
+        '<(pagespeed_root)',
+      ],
+      'sources': [
+        'core/core_benchmark.cc',
+        'css/css_benchmark.cc',
+        'dom/json_dom_benchmark.cc',
+        'filters/filters_benchmark.cc',
+        'har/http_archive_benchmark.cc',
+        'html/html_minifier_benchmark.cc',
+        'image_compression/image_compression_benchmark.cc',
+        'js/js_minify_benchmark.cc',
+        'rules/rules_benchmark.cc',
+        'timeline/json_importer_benchmark.cc',
+      ],
+      'defines': [
+        'IMAGE_TEST_DIR_PATH="pagespeed/image_compression/testdata/"',
+        'RULES_TEST_DIR_PATH="pagespeed/rules/testdata/"',
+      ],
+    },
+    {
+      'target_name': 'pagespeed_load',
+      'type': 'executable',
+      'dependencies': [
+        'pagespeed_library',
+        '<(pagespeed_root)/pagespeed/core/init.gyp:pagespeed_init',
+        '<(pagespeed_root)/pagespeed/formatters/formatters.gyp:pagespeed_formatters',
+        '<(pagespeed_root)/pagespeed/l10n/l10n.gyp:pagespeed_l10n',
+        '<(pagespeed_root)/pagespeed/proto/proto_gen.gyp:pagespeed_input_pb',
+        '<(pagespeed_root)/pagespeed/proto/proto_gen.gyp:pagespeed_output_pb',
+        '<(pagespeed_root)/pagespeed/proto/proto.gyp:pagespeed_proto',
+        '<(pagespeed_root)/pagespeed/testing/testing.gyp:pagespeed_testing',
+        '<(DEPTH)/base/base.gyp:base',
+        '<(DEPTH)/third_party/gflags/gflags.gyp:gflags',
+        '<(DEPTH)/<(protobuf_gyp_path):protobuf_lite',
+      ],
+      'include_dirs': [
+        '<(pagespeed_root)',
+      ],
+      'sources': [
+        'testing/pagespeed_load_main.cc',
+      ],
+    },
   ],
 }
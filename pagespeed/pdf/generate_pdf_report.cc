@@ -14,13 +14,24 @@
 
 #include "pagespeed/pdf/generate_pdf_report.h"
 
+#include <errno.h>
+
+#include <algorithm>
 #include <string>
+#include <vector>
 
 #include "base/basictypes.h"
 #include "base/logging.h"
+#include "build/build_config.h"
 #include "pagespeed/proto/pagespeed_proto_formatter.pb.h"
 #include "third_party/libharu/include/hpdf.h"
 
+#if defined(OS_WIN)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
 namespace pagespeed {
 
 namespace {
@@ -33,6 +44,31 @@ const double kRight = kLeft + kWidth, kTop = kBottom + kHeight;
 // Paragraph text constants:
 const double kTextFontSize = 10.0;
 const double kLineSpacing = 12.0;
+// How much of a PDF is copied out of libharu's stream at a time when writing
+// to a file descriptor.
+const HPDF_UINT32 kStreamChunkSize = 64 << 10;
+
+// Write size bytes of data to fd, retrying after partial writes.
+bool WriteToFileDescriptor(int fd, const char* data, size_t size) {
+  while (size > 0) {
+#if defined(OS_WIN)
+    const int written = _write(fd, data, static_cast<unsigned int>(size));
+#else
+    const ssize_t written = write(fd, data, size);
+#endif
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    data += written;
+    size -= written;
+  }
+  return true;
+}
+
+}  // namespace
 
 class PdfGenerator {
  public:
@@ -42,10 +78,18 @@ class PdfGenerator {
   // Return true if an error has occurred so far.
   bool error() { return error_; }
 
-  // Generate a PDF from the results and store it internally.
+  // Generate a PDF from the results and store it internally, replacing
+  // any PDF generated before.
   void GeneratePdf(const FormattedResults& results);
   // Save the previously generated PDF to a file.
   void SaveToFile(const std::string& path);
+  // Save the previously generated PDF to *out.
+  void SaveToString(std::string* out);
+  // Write the previously generated PDF to a file descriptor.
+  void SaveToFileDescriptor(int fd);
+  // Release the memory held by the previously generated PDF.  The document
+  // object itself is kept for the next call to GeneratePdf.
+  void FreeDocument();
 
  private:
   static void ErrorHandler(HPDF_STATUS error, HPDF_STATUS detail,
@@ -71,6 +115,13 @@ class PdfGenerator {
   // end of the current page, create a new page and set baseline to the top of
   // that page.
   void AdvanceBaseline(double amount, double* baseline);
+  // Save the previously generated PDF to libharu's in-memory stream, from
+  // which it is then read with ReadStream.  Return the size of the PDF, or 0
+  // on error.
+  HPDF_UINT32 SaveToMemoryStream();
+  // Read up to size bytes of the saved PDF into buffer, and return the number
+  // of bytes read.
+  HPDF_UINT32 ReadStream(char* buffer, HPDF_UINT32 size);
 
   HPDF_Doc pdf_;
   HPDF_Page page_;  // the current page (initialized by NewPage())
@@ -81,9 +132,8 @@ class PdfGenerator {
 };
 
 PdfGenerator::PdfGenerator()
-    : error_(false) {
+    : page_(NULL), font_(NULL), error_(false) {
   pdf_ = HPDF_New(ErrorHandler, this);
-  font_ = HPDF_GetFont(pdf_, "Helvetica", "StandardEncoding");
 }
 
 PdfGenerator::~PdfGenerator() {
@@ -93,6 +143,11 @@ PdfGenerator::~PdfGenerator() {
 }
 
 void PdfGenerator::GeneratePdf(const FormattedResults& results) {
+  // Start a new document in the existing document object, which keeps the
+  // encoders loaded for earlier documents.
+  error_ = false;
+  HPDF_NewDoc(pdf_);
+  font_ = HPDF_GetFont(pdf_, "Helvetica", "StandardEncoding");
   HPDF_SetCompressionMode(pdf_, HPDF_COMP_ALL);
   for (int index = 0; index < results.rule_results_size(); ++index) {
     const FormattedRuleResults& rule_results = results.rule_results(index);
@@ -106,9 +161,81 @@ void PdfGenerator::SaveToFile(const std::string& path) {
   HPDF_SaveToFile(pdf_, path.c_str());
 }
 
+void PdfGenerator::SaveToString(std::string* out) {
+  out->clear();
+  const HPDF_UINT32 size = SaveToMemoryStream();
+  if (size == 0) {
+    return;
+  }
+  out->resize(size);
+  HPDF_UINT32 offset = 0;
+  while (offset < size) {
+    const HPDF_UINT32 read = ReadStream(&(*out)[offset], size - offset);
+    if (read == 0) {
+      break;
+    }
+    offset += read;
+  }
+  if (offset < size) {
+    LOG(ERROR) << "PDF stream ended after " << offset << " of " << size
+               << " bytes.";
+    error_ = true;
+    out->clear();
+  }
+}
+
+void PdfGenerator::SaveToFileDescriptor(int fd) {
+  HPDF_UINT32 remaining = SaveToMemoryStream();
+  std::vector<char> buffer(std::min(remaining, kStreamChunkSize));
+  while (remaining > 0) {
+    const HPDF_UINT32 read = ReadStream(
+        &buffer[0], std::min(remaining, kStreamChunkSize));
+    if (read == 0) {
+      LOG(ERROR) << "PDF stream ended early.";
+      error_ = true;
+      return;
+    }
+    if (!WriteToFileDescriptor(fd, &buffer[0], read)) {
+      LOG(ERROR) << "Failed to write PDF to file descriptor " << fd
+                 << ", errno=" << errno;
+      error_ = true;
+      return;
+    }
+    remaining -= read;
+  }
+}
+
+void PdfGenerator::FreeDocument() {
+  HPDF_FreeDoc(pdf_);
+  page_ = NULL;
+  font_ = NULL;
+}
+
+HPDF_UINT32 PdfGenerator::SaveToMemoryStream() {
+  if (HPDF_SaveToStream(pdf_) != HPDF_OK) {
+    return 0;
+  }
+  return HPDF_GetStreamSize(pdf_);
+}
+
+HPDF_UINT32 PdfGenerator::ReadStream(char* buffer, HPDF_UINT32 size) {
+  HPDF_UINT32 read = size;
+  // HPDF_STREAM_EOF just means that the end of the PDF was reached.
+  const HPDF_STATUS status = HPDF_ReadFromStream(
+      pdf_, reinterpret_cast<HPDF_BYTE*>(buffer), &read);
+  if (status != HPDF_OK && status != HPDF_STREAM_EOF) {
+    return 0;
+  }
+  return read;
+}
+
 void PdfGenerator::ErrorHandler(HPDF_STATUS error_no, HPDF_STATUS detail_no,
                                 void* generator) {
   CHECK(generator != NULL);
+  if (error_no == HPDF_STREAM_EOF) {
+    // Reaching the end of the in-memory stream is expected; see ReadStream.
+    return;
+  }
   static_cast<PdfGenerator*>(generator)->error_ = true;
   LOG(ERROR) << "Error in PdfGenerator.  error_no=" << error_no
              << " detail_no=" << detail_no;
@@ -310,14 +437,50 @@ void PdfGenerator::AdvanceBaseline(double amount, double* baseline) {
   }
 }
 
-}  // namespace
+PdfReportGenerator::PdfReportGenerator() : generator_(new PdfGenerator) {}
+
+PdfReportGenerator::~PdfReportGenerator() {}
+
+bool PdfReportGenerator::GenerateToFile(const FormattedResults& results,
+                                        const std::string& path) {
+  generator_->GeneratePdf(results);
+  generator_->SaveToFile(path);
+  generator_->FreeDocument();
+  return !generator_->error();
+}
+
+bool PdfReportGenerator::GenerateToString(const FormattedResults& results,
+                                          std::string* out) {
+  generator_->GeneratePdf(results);
+  generator_->SaveToString(out);
+  generator_->FreeDocument();
+  return !generator_->error();
+}
+
+bool PdfReportGenerator::GenerateToFileDescriptor(
+    const FormattedResults& results, int fd) {
+  generator_->GeneratePdf(results);
+  generator_->SaveToFileDescriptor(fd);
+  generator_->FreeDocument();
+  return !generator_->error();
+}
 
 bool GeneratePdfReportToFile(const FormattedResults& results,
                              const std::string& path) {
-  PdfGenerator generator;
-  generator.GeneratePdf(results);
-  generator.SaveToFile(path);
-  return !generator.error();
+  PdfReportGenerator generator;
+  return generator.GenerateToFile(results, path);
+}
+
+bool GeneratePdfReportToString(const FormattedResults& results,
+                               std::string* out) {
+  PdfReportGenerator generator;
+  return generator.GenerateToString(results, out);
+}
+
+bool GeneratePdfReportToFileDescriptor(const FormattedResults& results,
+                                       int fd) {
+  PdfReportGenerator generator;
+  return generator.GenerateToFileDescriptor(results, fd);
 }
 
 }  // namespace pagespeed
@@ -17,18 +17,54 @@
 
 #include <string>
 
+#include "base/basictypes.h"
+#include "base/memory/scoped_ptr.h"
+
 namespace pagespeed {
 
 class FormattedResults;
+class PdfGenerator;
+
+// Generates PDFs summarizing the results of Page Speed runs.  The generator
+// keeps its libharu document object, along with the encoders it has loaded,
+// from one report to the next, so a process that generates many reports
+// should reuse one generator rather than call the functions below.  A
+// generator must only be used by one thread at a time.
+class PdfReportGenerator {
+ public:
+  PdfReportGenerator();
+  ~PdfReportGenerator();
+
+  // Generate a PDF and save it to a file.
+  bool GenerateToFile(const FormattedResults& results,
+                      const std::string& path);
+
+  // Generate a PDF and store it in *out, replacing its contents.
+  bool GenerateToString(const FormattedResults& results, std::string* out);
+
+  // Generate a PDF and write it to the open file descriptor fd, such as
+  // that of stdout or of a socket.  The descriptor is not closed.
+  bool GenerateToFileDescriptor(const FormattedResults& results, int fd);
+
+ private:
+  scoped_ptr<PdfGenerator> generator_;
+
+  DISALLOW_COPY_AND_ASSIGN(PdfReportGenerator);
+};
 
 // Generate a PDF summarizing the results of a Page Speed run, and save the PDF
 // to a file.
 bool GeneratePdfReportToFile(const FormattedResults& results,
                              const std::string& path);
 
-// TODO(mdsteele): We'll probably also be wanting a function that generates a
-// PDF and writes it to memory.  Just a question of what the API should be.
-// (e.g. Does it take an ostream?  An empty std::string?  Something else?)
+// Like GeneratePdfReportToFile, but store the PDF in *out.
+bool GeneratePdfReportToString(const FormattedResults& results,
+                               std::string* out);
+
+// Like GeneratePdfReportToFile, but write the PDF to the open file
+// descriptor fd.
+bool GeneratePdfReportToFileDescriptor(const FormattedResults& results,
+                                       int fd);
 
 }  // namespace pagespeed
 
@@ -14,11 +14,15 @@
 
 #include "pagespeed/proto/formatted_results_to_json_converter.h"
 
+#include <map>
+#include <string>
+
 #include "base/json/json_writer.h"
 #include "base/logging.h"
 #include "base/values.h"
 #include "base/memory/scoped_ptr.h"
 #include "pagespeed/core/string_util.h"
+#include "pagespeed/proto/json_stream_writer.h"
 #include "pagespeed/proto/pagespeed_proto_formatter.pb.h"
 
 namespace {
@@ -52,6 +56,200 @@ COMPILE_ASSERT(
         pagespeed::FormatArgument_ArgumentType_ArgumentType_ARRAYSIZE),
     compile_assert_incomplete_argument_type_to_name_map);
 
+using pagespeed::FormatArgument;
+using pagespeed::proto::FormattedResultsToJsonConverter;
+using pagespeed::proto::JsonStreamWriter;
+
+// Returns the format string with each placeholder replaced by
+// "{{PLACEHOLDER}}", as it appears in the JSON output.
+std::string GetJsonFormat(const pagespeed::FormatString& format_string) {
+  if (format_string.args_size() == 0) {
+    return format_string.format();
+  }
+  std::map<std::string, std::string> subst;
+  for (int i = 0, len = format_string.args_size(); i < len; ++i) {
+    const FormatArgument& arg = format_string.args(i);
+    if (arg.type() == FormatArgument::HYPERLINK) {
+      subst["BEGIN_" + arg.placeholder_key()] =
+          "{{BEGIN_" + arg.placeholder_key() + "}}";
+      subst["END_" + arg.placeholder_key()] =
+          "{{END_" + arg.placeholder_key() + "}}";
+    } else {
+      subst[arg.placeholder_key()] = "{{" + arg.placeholder_key() + "}}";
+    }
+  }
+  return pagespeed::string_util::ReplaceStringPlaceholders(
+      format_string.format(), subst);
+}
+
+// The Write* functions below emit object members in sorted key order, to
+// match the output of JSONWriter for the equivalent DictionaryValue.
+
+void WriteRect(const pagespeed::Rect& rect, JsonStreamWriter* writer) {
+  writer->BeginObject();
+  writer->Key("height");
+  writer->WriteInteger(rect.height());
+  writer->Key("left");
+  writer->WriteInteger(rect.left());
+  writer->Key("top");
+  writer->WriteInteger(rect.top());
+  writer->Key("width");
+  writer->WriteInteger(rect.width());
+  writer->EndObject();
+}
+
+bool WriteFormatArgument(const FormatArgument& format_arg,
+                         JsonStreamWriter* writer) {
+  if (!format_arg.has_type() || !format_arg.has_placeholder_key() ||
+      !format_arg.has_localized_value()) {
+    LOG(ERROR) << "FormatArgument instance not fully initialized.";
+    return false;
+  }
+  writer->BeginObject();
+  if (format_arg.has_int_value()) {
+    writer->Key("int_value");
+    writer->WriteInteger(static_cast<int>(format_arg.int_value()));
+  }
+  writer->Key("localized_value");
+  writer->WriteString(format_arg.localized_value());
+  writer->Key("placeholder_key");
+  writer->WriteString(format_arg.placeholder_key());
+  if (format_arg.rect_size() > 0) {
+    writer->Key("rects");
+    writer->BeginList();
+    for (int i = 0; i < format_arg.rect_size(); ++i) {
+      WriteRect(format_arg.rect(i), writer);
+    }
+    writer->EndList();
+  }
+  if (format_arg.secondary_rect_size() > 0) {
+    writer->Key("secondary_rects");
+    writer->BeginList();
+    for (int i = 0; i < format_arg.secondary_rect_size(); ++i) {
+      WriteRect(format_arg.secondary_rect(i), writer);
+    }
+    writer->EndList();
+  }
+  if (format_arg.has_string_value()) {
+    writer->Key("string_value");
+    writer->WriteString(format_arg.string_value());
+  }
+  writer->Key("type");
+  writer->WriteString(
+      FormattedResultsToJsonConverter::ConvertFormatArgumentType(
+          format_arg.type()));
+  writer->EndObject();
+  return true;
+}
+
+bool WriteFormatString(const pagespeed::FormatString& format_string,
+                       JsonStreamWriter* writer) {
+  writer->BeginObject();
+  if (format_string.args_size() > 0) {
+    writer->Key("args");
+    writer->BeginList();
+    for (int i = 0, len = format_string.args_size(); i < len; ++i) {
+      if (!WriteFormatArgument(format_string.args(i), writer)) {
+        return false;
+      }
+    }
+    writer->EndList();
+  }
+  writer->Key("format");
+  writer->WriteString(GetJsonFormat(format_string));
+  writer->EndObject();
+  return true;
+}
+
+bool WriteFormattedUrlResult(const pagespeed::FormattedUrlResult& url_result,
+                             JsonStreamWriter* writer) {
+  writer->BeginObject();
+  if (url_result.has_associated_result_id()) {
+    writer->Key("associated_result_id");
+    writer->WriteInteger(url_result.associated_result_id());
+  }
+  if (url_result.details_size() > 0) {
+    writer->Key("details");
+    writer->BeginList();
+    for (int i = 0, len = url_result.details_size(); i < len; ++i) {
+      if (!WriteFormatString(url_result.details(i), writer)) {
+        return false;
+      }
+    }
+    writer->EndList();
+  }
+  writer->Key("result");
+  if (!WriteFormatString(url_result.result(), writer)) {
+    return false;
+  }
+  writer->EndObject();
+  return true;
+}
+
+bool WriteFormattedUrlBlockResults(
+    const pagespeed::FormattedUrlBlockResults& url_block_results,
+    JsonStreamWriter* writer) {
+  writer->BeginObject();
+  if (url_block_results.has_associated_result_id()) {
+    writer->Key("associated_result_id");
+    writer->WriteInteger(url_block_results.associated_result_id());
+  }
+  if (url_block_results.has_header()) {
+    writer->Key("header");
+    if (!WriteFormatString(url_block_results.header(), writer)) {
+      return false;
+    }
+  }
+  if (url_block_results.urls_size() > 0) {
+    writer->Key("urls");
+    writer->BeginList();
+    for (int i = 0, len = url_block_results.urls_size(); i < len; ++i) {
+      if (!WriteFormattedUrlResult(url_block_results.urls(i), writer)) {
+        return false;
+      }
+    }
+    writer->EndList();
+  }
+  writer->EndObject();
+  return true;
+}
+
+bool WriteFormattedRuleResults(
+    const pagespeed::FormattedRuleResults& rule_results,
+    JsonStreamWriter* writer) {
+  writer->BeginObject();
+  if (rule_results.has_experimental()) {
+    writer->Key("experimental");
+    writer->WriteBoolean(rule_results.experimental());
+  }
+  writer->Key("localized_rule_name");
+  writer->WriteString(rule_results.localized_rule_name());
+  if (rule_results.has_rule_impact()) {
+    writer->Key("rule_impact");
+    writer->WriteDouble(rule_results.rule_impact());
+  }
+  writer->Key("rule_name");
+  writer->WriteString(rule_results.rule_name());
+  if (rule_results.has_summary()) {
+    writer->Key("summary_line");
+    if (!WriteFormatString(rule_results.summary(), writer)) {
+      return false;
+    }
+  }
+  if (rule_results.url_blocks_size() > 0) {
+    writer->Key("url_blocks");
+    writer->BeginList();
+    for (int i = 0, len = rule_results.url_blocks_size(); i < len; ++i) {
+      if (!WriteFormattedUrlBlockResults(rule_results.url_blocks(i), writer)) {
+        return false;
+      }
+    }
+    writer->EndList();
+  }
+  writer->EndObject();
+  return true;
+}
+
 }  // namespace
 
 namespace pagespeed {
@@ -60,11 +258,47 @@ namespace proto {
 
 bool FormattedResultsToJsonConverter::Convert(
     const pagespeed::FormattedResults& results, std::string* out) {
-  scoped_ptr<Value> root(ConvertFormattedResults(results));
-  if (root == NULL) {
+  std::string json;
+  {
+    JsonStreamWriter writer(&json);
+    if (!WriteFormattedResults(results, &writer)) {
+      return false;
+    }
+  }
+  out->swap(json);
+  return true;
+}
+
+bool FormattedResultsToJsonConverter::Convert(
+    const pagespeed::FormattedResults& results, std::ostream* out) {
+  JsonStreamWriter writer(out);
+  return WriteFormattedResults(results, &writer) && writer.Flush();
+}
+
+bool FormattedResultsToJsonConverter::WriteFormattedResults(
+    const pagespeed::FormattedResults& results, JsonStreamWriter* writer) {
+  if (!results.IsInitialized()) {
+    LOG(ERROR) << "FormattedResults instance not fully initialized.";
     return false;
   }
-  base::JSONWriter::Write(root.get(), out);
+  writer->BeginObject();
+  writer->Key("locale");
+  writer->WriteString(results.locale());
+  if (results.rule_results_size() > 0) {
+    writer->Key("rule_results");
+    writer->BeginList();
+    for (int i = 0, len = results.rule_results_size(); i < len; ++i) {
+      if (!WriteFormattedRuleResults(results.rule_results(i), writer)) {
+        return false;
+      }
+    }
+    writer->EndList();
+  }
+  if (results.has_score()) {
+    writer->Key("score");
+    writer->WriteInteger(results.score());
+  }
+  writer->EndObject();
   return true;
 }
 
@@ -175,25 +409,12 @@ Value* FormattedResultsToJsonConverter::ConvertFormatString(
   base::DictionaryValue* root = new base::DictionaryValue();
   if (format_string.args_size() > 0) {
     base::ListValue* args = new base::ListValue();
-    std::map<std::string, std::string> subst;
     for (int i = 0, len = format_string.args_size(); i < len; ++i) {
-      const FormatArgument& arg = format_string.args(i);
-      args->Append(ConvertFormatArgument(arg));
-      if (arg.type() == FormatArgument::HYPERLINK) {
-        subst["BEGIN_" + arg.placeholder_key()] =
-            "{{BEGIN_" + arg.placeholder_key() + "}}";
-        subst["END_" + arg.placeholder_key()] =
-            "{{END_" + arg.placeholder_key() + "}}";
-      } else {
-        subst[arg.placeholder_key()] = "{{" + arg.placeholder_key() + "}}";
-      }
+      args->Append(ConvertFormatArgument(format_string.args(i)));
     }
     root->Set("args", args);
-    root->SetString("format", string_util::ReplaceStringPlaceholders(
-        format_string.format(), subst));
-  } else {
-    root->SetString("format", format_string.format());
   }
+  root->SetString("format", GetJsonFormat(format_string));
 
   return root;
 }
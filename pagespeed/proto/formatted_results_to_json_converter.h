@@ -15,6 +15,7 @@
 #ifndef PAGESPEED_PROTO_FORMATTED_RESULTS_TO_JSON_CONVERTER_H_
 #define PAGESPEED_PROTO_FORMATTED_RESULTS_TO_JSON_CONVERTER_H_
 
+#include <ostream>
 #include <string>
 
 #include "base/basictypes.h"
@@ -34,6 +35,8 @@ class FormattedUrlBlockResults;
 
 namespace proto {
 
+class JsonStreamWriter;
+
 /**
  * Converts a Results protobuf to JSON.
  */
@@ -44,6 +47,20 @@ class FormattedResultsToJsonConverter {
   static bool Convert(const pagespeed::FormattedResults& results,
                       std::string* out);
 
+  // Writes a FormattedResults protocol buffer as JSON to the given
+  // stream. Will return false on failure, in which case partial output may
+  // have been written.
+  static bool Convert(const pagespeed::FormattedResults& results,
+                      std::ostream* out);
+
+  // Writes a FormattedResults protocol buffer as JSON directly to writer,
+  // walking the protocol buffer rather than building a base::Value
+  // tree. The output is identical to that of
+  // JSONWriter::Write(ConvertFormattedResults(results)). Will return false
+  // on failure.
+  static bool WriteFormattedResults(const pagespeed::FormattedResults& results,
+                                    JsonStreamWriter* writer);
+
   // Converts the various protocol buffers in a FormattedResults
   // structure into a base::Value* object, whsich can be converted to
   // JSON with a JSONWriter. Ownership of the returned base::Value* is
@@ -14,6 +14,8 @@
 
 #include "pagespeed/proto/formatted_results_to_json_converter.h"
 
+#include <sstream>
+
 #include "base/json/json_writer.h"
 #include "base/memory/scoped_ptr.h"
 #include "base/values.h"
@@ -198,6 +200,9 @@ TEST(FormattedResultsToJsonConverterTest, Full) {
   scoped_ptr<Value> value(
       FormattedResultsToJsonConverter::ConvertFormattedResults(results));
   ASSERT_NE(static_cast<Value*>(NULL), value);
+  std::string tree_json;
+  base::JSONWriter::Write(value.get(), &tree_json);
+  ASSERT_EQ(tree_json, json);
 }
 
 TEST(FormattedResultsToJsonConverterTest, Hyperlink) {
@@ -254,6 +259,9 @@ TEST(FormattedResultsToJsonConverterTest, Hyperlink) {
   scoped_ptr<Value> value(
       FormattedResultsToJsonConverter::ConvertFormattedResults(results));
   ASSERT_NE(static_cast<Value*>(NULL), value);
+  std::string tree_json;
+  base::JSONWriter::Write(value.get(), &tree_json);
+  ASSERT_EQ(tree_json, json);
 }
 
 TEST(FormattedResultsToJsonConverterTest, SnapshotRect) {
@@ -343,6 +351,43 @@ TEST(FormattedResultsToJsonConverterTest, SnapshotRect) {
   scoped_ptr<Value> value(
       FormattedResultsToJsonConverter::ConvertFormattedResults(results));
   ASSERT_NE(static_cast<Value*>(NULL), value);
+  std::string tree_json;
+  base::JSONWriter::Write(value.get(), &tree_json);
+  ASSERT_EQ(tree_json, json);
+}
+
+// Strings that JSONWriter escapes must come out of the streaming writer
+// identically.
+TEST(FormattedResultsToJsonConverterTest, EscapedStrings) {
+  FormattedResults results;
+  results.set_locale("test");
+  FormattedRuleResults* rule_results = results.add_rule_results();
+  rule_results->set_localized_rule_name(
+      "Quote \" backslash \\ <tag> & 'apos' \t\x01 "
+      "caf\xc3\xa9 \xf0\x9f\x98\x80");
+  rule_results->set_rule_name("RuleName");
+  rule_results->set_rule_impact(0.25);
+  FormattedUrlResult* url = rule_results->add_url_blocks()->add_urls();
+  url->mutable_result()->set_format("%(URL)s");
+  FormatArgument* arg = url->mutable_result()->add_args();
+  arg->set_type(FormatArgument::URL);
+  arg->set_placeholder_key("URL");
+  arg->set_string_value("http://www.example.com/?a=1&b=<2>");
+  arg->set_localized_value("http://www.example.com/?a=1&b=<2>");
+
+  std::string json;
+  ASSERT_TRUE(FormattedResultsToJsonConverter::Convert(results, &json));
+
+  scoped_ptr<Value> value(
+      FormattedResultsToJsonConverter::ConvertFormattedResults(results));
+  ASSERT_NE(static_cast<Value*>(NULL), value);
+  std::string tree_json;
+  base::JSONWriter::Write(value.get(), &tree_json);
+  ASSERT_EQ(tree_json, json);
+
+  std::ostringstream stream;
+  ASSERT_TRUE(FormattedResultsToJsonConverter::Convert(results, &stream));
+  ASSERT_EQ(tree_json, stream.str());
 }
 
 TEST(FormattedResultsToJsonConverterTest, ConvertFormatArgumentType) {
@@ -0,0 +1,154 @@
+// Copyright 2013 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pagespeed/proto/json_stream_writer.h"
+
+#include "base/json/json_writer.h"
+#include "base/logging.h"
+#include "base/string_number_conversions.h"
+#include "base/values.h"
+
+namespace {
+
+// Returns true if base::JSONWriter would write each character of value
+// unchanged, so that value can be copied into the output between quotes.
+// Anything else (quotes, backslashes, control characters, non-ASCII, and the
+// HTML-sensitive characters JSONWriter escapes) takes the slow path.
+bool IsPassThroughString(const std::string& value) {
+  for (std::string::const_iterator it = value.begin(); it != value.end();
+       ++it) {
+    const unsigned char c = static_cast<unsigned char>(*it);
+    if (c < 0x20 || c > 0x7e || c == '"' || c == '\\' || c == '<' ||
+        c == '>' || c == '&' || c == '\'') {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+namespace pagespeed {
+
+namespace proto {
+
+JsonStreamWriter::JsonStreamWriter(std::string* out)
+    : out_(out), stream_(NULL), need_comma_(false) {
+  DCHECK(out_);
+}
+
+JsonStreamWriter::JsonStreamWriter(std::ostream* out)
+    : out_(&buffer_), stream_(out), need_comma_(false) {
+  DCHECK(stream_);
+  buffer_.reserve(kFlushThreshold);
+}
+
+JsonStreamWriter::~JsonStreamWriter() {
+  Flush();
+}
+
+void JsonStreamWriter::BeginObject() {
+  BeginValue();
+  out_->push_back('{');
+  need_comma_ = false;
+}
+
+void JsonStreamWriter::EndObject() {
+  out_->push_back('}');
+  EndValue();
+}
+
+void JsonStreamWriter::BeginList() {
+  BeginValue();
+  out_->push_back('[');
+  need_comma_ = false;
+}
+
+void JsonStreamWriter::EndList() {
+  out_->push_back(']');
+  EndValue();
+}
+
+void JsonStreamWriter::Key(const char* key) {
+  BeginValue();
+  out_->push_back('"');
+  out_->append(key);
+  out_->append("\":");
+  need_comma_ = false;
+}
+
+void JsonStreamWriter::WriteString(const std::string& value) {
+  BeginValue();
+  if (IsPassThroughString(value)) {
+    out_->push_back('"');
+    out_->append(value);
+    out_->push_back('"');
+  } else {
+    base::StringValue string_value(value);
+    base::JSONWriter::Write(&string_value, &scratch_);
+    out_->append(scratch_);
+  }
+  EndValue();
+}
+
+void JsonStreamWriter::WriteInteger(int value) {
+  BeginValue();
+  out_->append(base::IntToString(value));
+  EndValue();
+}
+
+void JsonStreamWriter::WriteDouble(double value) {
+  BeginValue();
+  // JSONWriter's double formatting has several special cases (a ".0" suffix
+  // for integral values, a leading zero for values in (-1, 1)), so defer to
+  // it rather than duplicating them.
+  base::FundamentalValue double_value(value);
+  base::JSONWriter::Write(&double_value, &scratch_);
+  out_->append(scratch_);
+  EndValue();
+}
+
+void JsonStreamWriter::WriteBoolean(bool value) {
+  BeginValue();
+  out_->append(value ? "true" : "false");
+  EndValue();
+}
+
+bool JsonStreamWriter::Flush() {
+  if (stream_ == NULL) {
+    return true;
+  }
+  if (!buffer_.empty()) {
+    stream_->write(buffer_.data(), buffer_.size());
+    buffer_.clear();
+  }
+  return stream_->good();
+}
+
+void JsonStreamWriter::BeginValue() {
+  if (need_comma_) {
+    out_->push_back(',');
+  }
+}
+
+void JsonStreamWriter::EndValue() {
+  need_comma_ = true;
+  if (stream_ != NULL && buffer_.size() >= kFlushThreshold) {
+    Flush();
+  }
+}
+
+}  // namespace proto
+
+}  // namespace pagespeed
@@ -0,0 +1,81 @@
+// Copyright 2013 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PAGESPEED_PROTO_JSON_STREAM_WRITER_H_
+#define PAGESPEED_PROTO_JSON_STREAM_WRITER_H_
+
+#include <ostream>
+#include <string>
+
+#include "base/basictypes.h"
+
+namespace pagespeed {
+
+namespace proto {
+
+/**
+ * Writes JSON incrementally, without building a base::Value tree first.  The
+ * output is byte-for-byte what base::JSONWriter::Write produces for the
+ * equivalent tree, provided that the members of each object are written in
+ * sorted key order (DictionaryValue stores its members sorted by key).
+ */
+class JsonStreamWriter {
+ public:
+  // Appends the JSON to *out.
+  explicit JsonStreamWriter(std::string* out);
+  // Writes the JSON to *out, buffering up to kFlushThreshold bytes at a time.
+  explicit JsonStreamWriter(std::ostream* out);
+  ~JsonStreamWriter();
+
+  void BeginObject();
+  void EndObject();
+  void BeginList();
+  void EndList();
+
+  // Writes the key of the next object member.  key is written unescaped, so
+  // it must not contain characters that JSON requires to be escaped.
+  void Key(const char* key);
+
+  void WriteString(const std::string& value);
+  void WriteInteger(int value);
+  void WriteDouble(double value);
+  void WriteBoolean(bool value);
+
+  // Writes any buffered output to the underlying stream.  Returns false if
+  // the stream is in a failed state.
+  bool Flush();
+
+ private:
+  static const size_t kFlushThreshold = 64 << 10;
+
+  // Writes a separating comma if a value was already written in the current
+  // container.
+  void BeginValue();
+  void EndValue();
+
+  std::string* out_;
+  std::ostream* stream_;
+  std::string buffer_;
+  // Reused to format scalars through base::JSONWriter.
+  std::string scratch_;
+  bool need_comma_;
+
+  DISALLOW_COPY_AND_ASSIGN(JsonStreamWriter);
+};
+
+}  // namespace proto
+
+}  // namespace pagespeed
+
+#endif  // PAGESPEED_PROTO_JSON_STREAM_WRITER_H_
@@ -28,6 +28,7 @@
       ],
       'sources': [
         'pagespeed_output_util.cc',
+        'proto_input_stream.cc',
         'proto_resource_utils.cc',
       ],
       'include_dirs': [
@@ -139,6 +139,7 @@
         '<(pagespeed_root)/pagespeed/proto/proto_gen.gyp:pagespeed_output_pb',
       ],
       'sources': [
+        'json_stream_writer.cc',
         'results_to_json_converter.cc',
       ],
       'include_dirs': [
@@ -157,6 +158,7 @@
       'target_name': 'pagespeed_proto_formatted_results_converter',
       'type': '<(library)',
       'dependencies': [
+        'pagespeed_proto_results_converter',
         '<(DEPTH)/base/base.gyp:base',
         '<(pagespeed_root)/pagespeed/proto/proto_gen.gyp:pagespeed_output_pb',
       ],
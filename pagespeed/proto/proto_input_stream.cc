@@ -0,0 +1,140 @@
+// Copyright 2013 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pagespeed/proto/proto_input_stream.h"
+
+#include "base/logging.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/io/zero_copy_stream.h"
+#include "google/protobuf/message_lite.h"
+#include "pagespeed/proto/pagespeed_input.pb.h"
+
+namespace {
+
+// Resources can be larger than CodedInputStream's default limit of 64MB.
+// This is the largest size it can safely parse.
+const int kMaxMessageBytes = 512 << 20;
+
+}  // namespace
+
+namespace pagespeed {
+
+namespace proto {
+
+ProtoInputStreamWriter::ProtoInputStreamWriter(
+    google::protobuf::io::ZeroCopyOutputStream* out)
+    : out_(out), wrote_header_(false) {
+}
+
+bool ProtoInputStreamWriter::WriteHeader(
+    const ProtoInputStreamHeader& header) {
+  if (wrote_header_) {
+    LOG(DFATAL) << "Header already written.";
+    return false;
+  }
+  wrote_header_ = true;
+  return WriteMessage(header);
+}
+
+bool ProtoInputStreamWriter::WriteResource(const ProtoResource& resource) {
+  if (!wrote_header_) {
+    LOG(DFATAL) << "Header not written.";
+    return false;
+  }
+  return WriteMessage(resource);
+}
+
+bool ProtoInputStreamWriter::WriteMessage(
+    const google::protobuf::MessageLite& message) {
+  // The CodedOutputStream gives back the part of out_'s buffer that it did
+  // not use when it is destroyed, so one can be made for each message.
+  google::protobuf::io::CodedOutputStream coded_out(out_);
+  const int size = message.ByteSize();
+  coded_out.WriteVarint32(size);
+  message.SerializeWithCachedSizes(&coded_out);
+  return !coded_out.HadError();
+}
+
+ProtoInputStreamReader::ProtoInputStreamReader(
+    google::protobuf::io::ZeroCopyInputStream* in)
+    : in_(in), read_header_(false), error_(false) {
+}
+
+bool ProtoInputStreamReader::ReadHeader(ProtoInputStreamHeader* header) {
+  if (read_header_) {
+    LOG(DFATAL) << "Header already read.";
+    return false;
+  }
+  read_header_ = true;
+  if (!ReadMessage(header)) {
+    // Even an empty stream has a header.
+    LOG(WARNING) << "Failed to read header.";
+    error_ = true;
+    return false;
+  }
+  return true;
+}
+
+bool ProtoInputStreamReader::ReadResource(ProtoResource* resource) {
+  if (!read_header_) {
+    LOG(DFATAL) << "Header not read.";
+    error_ = true;
+    return false;
+  }
+  return ReadMessage(resource);
+}
+
+bool ProtoInputStreamReader::ReadMessage(
+    google::protobuf::MessageLite* message) {
+  if (error_) {
+    return false;
+  }
+
+  // Check for the end of the stream, which is only allowed between
+  // messages.
+  const void* data = NULL;
+  int size = 0;
+  do {
+    if (!in_->Next(&data, &size)) {
+      return false;
+    }
+  } while (size == 0);
+  in_->BackUp(size);
+
+  // CodedInputStream's byte limit applies to its whole lifetime, so make
+  // one for each message rather than sharing one across the stream.
+  google::protobuf::io::CodedInputStream coded_in(in_);
+  coded_in.SetTotalBytesLimit(kMaxMessageBytes, -1);
+  uint32 length = 0;
+  if (!coded_in.ReadVarint32(&length)) {
+    LOG(WARNING) << "Failed to read message length.";
+    error_ = true;
+    return false;
+  }
+  const google::protobuf::io::CodedInputStream::Limit limit =
+      coded_in.PushLimit(length);
+  if (!message->ParseFromCodedStream(&coded_in) ||
+      !coded_in.ConsumedEntireMessage() ||
+      coded_in.BytesUntilLimit() != 0) {
+    LOG(WARNING) << "Failed to parse message.";
+    error_ = true;
+    return false;
+  }
+  coded_in.PopLimit(limit);
+  return true;
+}
+
+}  // namespace proto
+
+}  // namespace pagespeed
@@ -0,0 +1,92 @@
+// Copyright 2013 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PAGESPEED_PROTO_PROTO_INPUT_STREAM_H_
+#define PAGESPEED_PROTO_PROTO_INPUT_STREAM_H_
+
+#include "base/basictypes.h"
+
+namespace google {
+namespace protobuf {
+class MessageLite;
+namespace io {
+class ZeroCopyInputStream;
+class ZeroCopyOutputStream;
+}  // namespace io
+}  // namespace protobuf
+}  // namespace google
+
+namespace pagespeed {
+
+class ProtoInputStreamHeader;
+class ProtoResource;
+
+namespace proto {
+
+// Writes the streaming form of ProtoInput (see ProtoInputStreamHeader in
+// pagespeed_input.proto): WriteHeader once, then WriteResource for each
+// resource.
+class ProtoInputStreamWriter {
+ public:
+  // Ownership of out is not transferred.
+  explicit ProtoInputStreamWriter(
+      google::protobuf::io::ZeroCopyOutputStream* out);
+
+  // Return true on success, false on error.
+  bool WriteHeader(const ProtoInputStreamHeader& header);
+  bool WriteResource(const ProtoResource& resource);
+
+ private:
+  bool WriteMessage(const google::protobuf::MessageLite& message);
+
+  google::protobuf::io::ZeroCopyOutputStream* const out_;
+  bool wrote_header_;
+
+  DISALLOW_COPY_AND_ASSIGN(ProtoInputStreamWriter);
+};
+
+// Reads the streaming form of ProtoInput: ReadHeader once, then
+// ReadResource until it returns false.  Only one resource needs to be in
+// memory at a time.
+class ProtoInputStreamReader {
+ public:
+  // Ownership of in is not transferred.
+  explicit ProtoInputStreamReader(
+      google::protobuf::io::ZeroCopyInputStream* in);
+
+  // Return true on success, false on error.
+  bool ReadHeader(ProtoInputStreamHeader* header);
+
+  // Read the next resource into *resource.  Return false at the end of the
+  // stream, or on error; error() tells the two apart.
+  bool ReadResource(ProtoResource* resource);
+
+  bool error() const { return error_; }
+
+ private:
+  // Return false, without setting error_, at the end of the stream.
+  bool ReadMessage(google::protobuf::MessageLite* message);
+
+  google::protobuf::io::ZeroCopyInputStream* const in_;
+  bool read_header_;
+  bool error_;
+
+  DISALLOW_COPY_AND_ASSIGN(ProtoInputStreamReader);
+};
+
+}  // namespace proto
+
+}  // namespace pagespeed
+
+#endif  // PAGESPEED_PROTO_PROTO_INPUT_STREAM_H_
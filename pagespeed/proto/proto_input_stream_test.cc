@@ -0,0 +1,158 @@
+// Copyright 2013 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
+#include "pagespeed/core/pagespeed_input.h"
+#include "pagespeed/core/resource.h"
+#include "pagespeed/proto/pagespeed_input.pb.h"
+#include "pagespeed/proto/proto_input_stream.h"
+#include "pagespeed/proto/proto_resource_utils.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace {
+
+using google::protobuf::io::ArrayInputStream;
+using google::protobuf::io::StringOutputStream;
+using pagespeed::PagespeedInput;
+using pagespeed::ProtoInputStreamHeader;
+using pagespeed::ProtoResource;
+using pagespeed::Resource;
+using pagespeed::proto::PopulatePagespeedInputFromStream;
+using pagespeed::proto::PopulateProtoInputStream;
+using pagespeed::proto::ProtoInputStreamReader;
+using pagespeed::proto::ProtoInputStreamWriter;
+
+const char* kUrl1 = "http://www.example.com/";
+const char* kUrl2 = "http://www.example.com/a.css";
+
+// Writes a stream with the given identifier and resource URLs, with
+// bodies of body_size bytes.
+std::string WriteStream(const std::string& identifier,
+                        const char* const* urls,
+                        int num_urls,
+                        int body_size) {
+  std::string out;
+  {
+    StringOutputStream out_stream(&out);
+    ProtoInputStreamWriter writer(&out_stream);
+    ProtoInputStreamHeader header;
+    header.set_identifier(identifier);
+    EXPECT_TRUE(writer.WriteHeader(header));
+    for (int i = 0; i < num_urls; ++i) {
+      ProtoResource resource;
+      resource.set_request_url(urls[i]);
+      resource.set_request_method("GET");
+      resource.set_response_status_code(200);
+      resource.set_response_body(std::string(body_size, 'a' + i));
+      EXPECT_TRUE(writer.WriteResource(resource));
+    }
+  }
+  return out;
+}
+
+TEST(ProtoInputStreamTest, RoundTrip) {
+  const char* urls[] = { kUrl1, kUrl2 };
+  // A body larger than the stream's blocks, so that messages span blocks.
+  const std::string data = WriteStream(kUrl1, urls, 2, 10000);
+
+  ArrayInputStream in_stream(data.data(), data.size(), 1000);
+  ProtoInputStreamReader reader(&in_stream);
+  ProtoInputStreamHeader header;
+  ASSERT_TRUE(reader.ReadHeader(&header));
+  EXPECT_EQ(kUrl1, header.identifier());
+
+  ProtoResource resource;
+  ASSERT_TRUE(reader.ReadResource(&resource));
+  EXPECT_EQ(kUrl1, resource.request_url());
+  EXPECT_EQ(std::string(10000, 'a'), resource.response_body());
+  ASSERT_TRUE(reader.ReadResource(&resource));
+  EXPECT_EQ(kUrl2, resource.request_url());
+  EXPECT_EQ(std::string(10000, 'b'), resource.response_body());
+  EXPECT_FALSE(reader.ReadResource(&resource));
+  EXPECT_FALSE(reader.error());
+}
+
+TEST(ProtoInputStreamTest, HeaderOnly) {
+  const std::string data = WriteStream("", NULL, 0, 0);
+  ArrayInputStream in_stream(data.data(), data.size());
+  ProtoInputStreamReader reader(&in_stream);
+  ProtoInputStreamHeader header;
+  ASSERT_TRUE(reader.ReadHeader(&header));
+  EXPECT_FALSE(header.has_identifier());
+  ProtoResource resource;
+  EXPECT_FALSE(reader.ReadResource(&resource));
+  EXPECT_FALSE(reader.error());
+}
+
+TEST(ProtoInputStreamTest, Empty) {
+  ArrayInputStream in_stream("", 0);
+  ProtoInputStreamReader reader(&in_stream);
+  ProtoInputStreamHeader header;
+  EXPECT_FALSE(reader.ReadHeader(&header));
+  EXPECT_TRUE(reader.error());
+}
+
+TEST(ProtoInputStreamTest, Truncated) {
+  const char* urls[] = { kUrl1, kUrl2 };
+  const std::string data = WriteStream(kUrl1, urls, 2, 100);
+
+  ArrayInputStream in_stream(data.data(), data.size() - 1);
+  ProtoInputStreamReader reader(&in_stream);
+  ProtoInputStreamHeader header;
+  ASSERT_TRUE(reader.ReadHeader(&header));
+  ProtoResource resource;
+  ASSERT_TRUE(reader.ReadResource(&resource));
+  EXPECT_FALSE(reader.ReadResource(&resource));
+  EXPECT_TRUE(reader.error());
+}
+
+TEST(ProtoInputStreamTest, PagespeedInputRoundTrip) {
+  PagespeedInput input;
+  Resource* resource1 = new Resource;
+  resource1->SetRequestUrl(kUrl1);
+  resource1->SetRequestMethod("GET");
+  resource1->SetResponseStatusCode(200);
+  resource1->AddResponseHeader("Content-Type", "text/html");
+  resource1->SetResponseBody("<html></html>");
+  ASSERT_TRUE(input.AddResource(resource1));
+  Resource* resource2 = new Resource;
+  resource2->SetRequestUrl(kUrl2);
+  resource2->SetRequestMethod("GET");
+  resource2->SetResponseStatusCode(200);
+  resource2->SetResponseBody("body { color: red }");
+  ASSERT_TRUE(input.AddResource(resource2));
+  ASSERT_TRUE(input.SetPrimaryResourceUrl(kUrl1));
+
+  std::string data;
+  {
+    StringOutputStream out_stream(&data);
+    ASSERT_TRUE(PopulateProtoInputStream(input, &out_stream));
+  }
+
+  ArrayInputStream in_stream(data.data(), data.size());
+  PagespeedInput output;
+  ASSERT_TRUE(PopulatePagespeedInputFromStream(&in_stream, &output));
+  ASSERT_EQ(2, output.num_resources());
+  EXPECT_EQ(kUrl1, output.primary_resource_url());
+  EXPECT_EQ(kUrl1, output.GetResource(0).GetRequestUrl());
+  EXPECT_EQ("text/html",
+            output.GetResource(0).GetResponseHeader("Content-Type"));
+  EXPECT_EQ("<html></html>", output.GetResource(0).GetResponseBody());
+  EXPECT_EQ(kUrl2, output.GetResource(1).GetRequestUrl());
+  EXPECT_EQ("body { color: red }", output.GetResource(1).GetResponseBody());
+}
+
+}  // namespace
@@ -22,6 +22,7 @@
 #include "pagespeed/core/resource.h"
 #include "pagespeed/proto/pagespeed_input.pb.h"
 #include "pagespeed/proto/pagespeed_output.pb.h"
+#include "pagespeed/proto/proto_input_stream.h"
 
 namespace pagespeed {
 
@@ -71,6 +72,35 @@ void PopulatePagespeedInput(const ProtoInput& proto_input,
   }
 }
 
+void PopulateResourceSwappingBody(ProtoResource* input, Resource* output) {
+  std::string response_body;
+  response_body.swap(*input->mutable_response_body());
+  input->clear_response_body();
+  PopulateResource(*input, output);
+  output->SwapResponseBody(&response_body);
+}
+
+bool PopulatePagespeedInputFromStream(
+    google::protobuf::io::ZeroCopyInputStream* in,
+    PagespeedInput* pagespeed_input) {
+  ProtoInputStreamReader reader(in);
+  ProtoInputStreamHeader header;
+  if (!reader.ReadHeader(&header)) {
+    return false;
+  }
+  ProtoResource proto_resource;
+  while (reader.ReadResource(&proto_resource)) {
+    Resource* resource = new Resource;
+    PopulateResourceSwappingBody(&proto_resource, resource);
+    pagespeed_input->AddResource(resource);
+  }
+  // The primary resource must have been added before it can be set.
+  if (!header.identifier().empty()) {
+    pagespeed_input->SetPrimaryResourceUrl(header.identifier());
+  }
+  return !reader.error();
+}
+
 void PopulateProtoResource(const Resource& input, ProtoResource* output) {
   output->set_request_url(input.GetRequestUrl());
   output->set_request_method(input.GetRequestMethod());
@@ -107,6 +137,27 @@ void PopulateProtoInput(const PagespeedInput& input, ProtoInput* proto_input) {
   }
 }
 
+bool PopulateProtoInputStream(const PagespeedInput& input,
+                              google::protobuf::io::ZeroCopyOutputStream* out) {
+  ProtoInputStreamWriter writer(out);
+  ProtoInputStreamHeader header;
+  if (!input.primary_resource_url().empty()) {
+    header.set_identifier(input.primary_resource_url());
+  }
+  if (!writer.WriteHeader(header)) {
+    return false;
+  }
+  ProtoResource proto_resource;
+  for (int idx = 0; idx < input.num_resources(); ++idx) {
+    proto_resource.Clear();
+    PopulateProtoResource(input.GetResource(idx), &proto_resource);
+    if (!writer.WriteResource(proto_resource)) {
+      return false;
+    }
+  }
+  return true;
+}
+
 }  // namespace proto
 
 }  // namespace pagespeed
@@ -15,6 +15,15 @@
 #ifndef PAGESPEED_APPS_PROTO_RESOURCE_UTILS_H_
 #define PAGESPEED_APPS_PROTO_RESOURCE_UTILS_H_
 
+namespace google {
+namespace protobuf {
+namespace io {
+class ZeroCopyInputStream;
+class ZeroCopyOutputStream;
+}  // namespace io
+}  // namespace protobuf
+}  // namespace google
+
 namespace pagespeed {
 
 class PagespeedInput;
@@ -34,6 +43,18 @@ void PopulateResource(const ProtoResource& input, Resource* output);
 void PopulatePagespeedInput(const ProtoInput& proto_input,
                             PagespeedInput* pagespeed_input);
 
+// Like PopulateResource, but swaps the response body out of input rather
+// than copying it.
+void PopulateResourceSwappingBody(ProtoResource* input, Resource* output);
+
+// Populate a PagespeedInput from the streaming form of ProtoInput (see
+// ProtoInputStreamHeader), one resource at a time.  The primary resource
+// URL is set from the identifier, if any.  Return true on success, false
+// on error; resources read before the error are kept.
+bool PopulatePagespeedInputFromStream(
+    google::protobuf::io::ZeroCopyInputStream* in,
+    PagespeedInput* pagespeed_input);
+
 // Serialization to protocol buffer
 
 // Populate a ProtoResource protocol buffer from a Resource object.
@@ -43,6 +64,12 @@ void PopulateProtoResource(const Resource& input, ProtoResource* output);
 // PagespeedInput object.
 void PopulateProtoInput(const PagespeedInput& input, ProtoInput* proto_input);
 
+// Write the resources of a PagespeedInput in the streaming form of
+// ProtoInput, one resource at a time, with the primary resource URL as the
+// identifier.  Return true on success, false on error.
+bool PopulateProtoInputStream(const PagespeedInput& input,
+                              google::protobuf::io::ZeroCopyOutputStream* out);
+
 }  // namespace proto
 
 }  // namespace pagespeed
@@ -17,8 +17,182 @@
 #include "base/json/json_writer.h"
 #include "base/logging.h"
 #include "base/values.h"
+#include "pagespeed/proto/json_stream_writer.h"
 #include "pagespeed/proto/pagespeed_output.pb.h"
 
+namespace {
+
+using pagespeed::proto::JsonStreamWriter;
+
+// The Write* functions below emit object members in sorted key order, to
+// match the output of JSONWriter for the equivalent DictionaryValue.
+
+void WriteVersion(const pagespeed::Version& version,
+                  JsonStreamWriter* writer) {
+  writer->BeginObject();
+  writer->Key("major");
+  writer->WriteInteger(version.major());
+  writer->Key("minor");
+  writer->WriteInteger(version.minor());
+  writer->Key("official_release");
+  writer->WriteBoolean(version.official_release());
+  writer->EndObject();
+}
+
+void WriteSavings(const pagespeed::Savings& savings,
+                  JsonStreamWriter* writer) {
+  writer->BeginObject();
+  if (savings.has_connections_saved()) {
+    writer->Key("connections_saved");
+    writer->WriteInteger(savings.connections_saved());
+  }
+  if (savings.has_critical_path_length_saved()) {
+    writer->Key("critical_path_length_saved");
+    writer->WriteInteger(savings.critical_path_length_saved());
+  }
+  if (savings.has_dns_requests_saved()) {
+    writer->Key("dns_requests_saved");
+    writer->WriteInteger(savings.dns_requests_saved());
+  }
+  if (savings.has_request_bytes_saved()) {
+    writer->Key("request_bytes_saved");
+    writer->WriteInteger(savings.request_bytes_saved());
+  }
+  if (savings.has_requests_saved()) {
+    writer->Key("requests_saved");
+    writer->WriteInteger(savings.requests_saved());
+  }
+  if (savings.has_response_bytes_saved()) {
+    writer->Key("response_bytes_saved");
+    writer->WriteInteger(savings.response_bytes_saved());
+  }
+  writer->EndObject();
+}
+
+void WriteProfileEntry(const pagespeed::ProfileEntry& entry,
+                       JsonStreamWriter* writer) {
+  writer->BeginObject();
+  if (entry.has_bytes_allocated()) {
+    // JSON numbers are doubles; an int64 may not fit in WriteInteger.
+    writer->Key("bytes_allocated");
+    writer->WriteDouble(static_cast<double>(entry.bytes_allocated()));
+  }
+  if (entry.has_cpu_time_ms()) {
+    writer->Key("cpu_time_ms");
+    writer->WriteDouble(entry.cpu_time_ms());
+  }
+  writer->Key("name");
+  writer->WriteString(entry.name());
+  if (entry.has_num_results()) {
+    writer->Key("num_results");
+    writer->WriteInteger(entry.num_results());
+  }
+  if (entry.has_wall_time_ms()) {
+    writer->Key("wall_time_ms");
+    writer->WriteDouble(entry.wall_time_ms());
+  }
+  writer->EndObject();
+}
+
+void WriteProfileEntries(
+    const char* key,
+    const google::protobuf::RepeatedPtrField<pagespeed::ProfileEntry>& entries,
+    JsonStreamWriter* writer) {
+  if (entries.size() == 0) {
+    return;
+  }
+  writer->Key(key);
+  writer->BeginList();
+  for (int i = 0, len = entries.size(); i < len; ++i) {
+    WriteProfileEntry(entries.Get(i), writer);
+  }
+  writer->EndList();
+}
+
+void WriteProfile(const pagespeed::Profile& profile,
+                  JsonStreamWriter* writer) {
+  writer->BeginObject();
+  WriteProfileEntries("compute_results", profile.compute_results(), writer);
+  WriteProfileEntries("compute_score_and_impact",
+                      profile.compute_score_and_impact(), writer);
+  WriteProfileEntries("format_results", profile.format_results(), writer);
+  WriteProfileEntries("input_phases", profile.input_phases(), writer);
+  writer->EndObject();
+}
+
+base::ListValue* ConvertProfileEntries(
+    const google::protobuf::RepeatedPtrField<pagespeed::ProfileEntry>&
+        entries) {
+  base::ListValue* list = new base::ListValue();
+  for (int i = 0, len = entries.size(); i < len; ++i) {
+    const pagespeed::ProfileEntry& entry = entries.Get(i);
+    base::DictionaryValue* value = new base::DictionaryValue();
+    value->SetString("name", entry.name());
+    if (entry.has_wall_time_ms()) {
+      value->SetDouble("wall_time_ms", entry.wall_time_ms());
+    }
+    if (entry.has_cpu_time_ms()) {
+      value->SetDouble("cpu_time_ms", entry.cpu_time_ms());
+    }
+    if (entry.has_bytes_allocated()) {
+      value->SetDouble("bytes_allocated",
+                       static_cast<double>(entry.bytes_allocated()));
+    }
+    if (entry.has_num_results()) {
+      value->SetInteger("num_results", entry.num_results());
+    }
+    list->Append(value);
+  }
+  return list;
+}
+
+void WriteResult(const pagespeed::Result& result, JsonStreamWriter* writer) {
+  writer->BeginObject();
+  if (result.has_optimized_content_hash()) {
+    writer->Key("optimized_content_hash");
+    writer->WriteString(result.optimized_content_hash());
+  }
+  if (result.has_optimized_content_size()) {
+    writer->Key("optimized_content_size");
+    writer->WriteInteger(result.optimized_content_size());
+  }
+  if (result.resource_urls_size() > 0) {
+    writer->Key("resource_urls");
+    writer->BeginList();
+    for (int i = 0, len = result.resource_urls_size(); i < len; ++i) {
+      writer->WriteString(result.resource_urls(i));
+    }
+    writer->EndList();
+  }
+  if (result.has_savings()) {
+    writer->Key("savings");
+    WriteSavings(result.savings(), writer);
+  }
+  writer->EndObject();
+}
+
+void WriteRuleResults(const pagespeed::RuleResults& rule_results,
+                      JsonStreamWriter* writer) {
+  writer->BeginObject();
+  if (rule_results.results_size() > 0) {
+    writer->Key("results");
+    writer->BeginList();
+    for (int i = 0, len = rule_results.results_size(); i < len; ++i) {
+      WriteResult(rule_results.results(i), writer);
+    }
+    writer->EndList();
+  }
+  if (rule_results.has_rule_impact()) {
+    writer->Key("rule_impact");
+    writer->WriteDouble(rule_results.rule_impact());
+  }
+  writer->Key("rule_name");
+  writer->WriteString(rule_results.rule_name());
+  writer->EndObject();
+}
+
+}  // namespace
+
 namespace pagespeed {
 
 namespace proto {
@@ -26,12 +200,56 @@ namespace proto {
 // static
 bool ResultsToJsonConverter::Convert(
     const pagespeed::Results& results, std::string* out) {
-  base::Value* root = ConvertResults(results);
-  if (root == NULL) {
+  std::string json;
+  {
+    JsonStreamWriter writer(&json);
+    if (!WriteResults(results, &writer)) {
+      return false;
+    }
+  }
+  out->swap(json);
+  return true;
+}
+
+// static
+bool ResultsToJsonConverter::Convert(
+    const pagespeed::Results& results, std::ostream* out) {
+  JsonStreamWriter writer(out);
+  return WriteResults(results, &writer) && writer.Flush();
+}
+
+// static
+bool ResultsToJsonConverter::WriteResults(const pagespeed::Results& results,
+                                          JsonStreamWriter* writer) {
+  // IsInitialized() checks the required fields of every nested message, so
+  // nothing below can fail once this passes.
+  if (!results.IsInitialized()) {
+    LOG(ERROR) << "Results instance not fully initialized.";
     return false;
   }
-  base::JSONWriter::Write(root, out);
-  delete root;
+
+  writer->BeginObject();
+  if (results.has_profile()) {
+    writer->Key("profile");
+    WriteProfile(results.profile(), writer);
+  }
+  if (results.rule_results_size() > 0) {
+    writer->Key("rule_results");
+    writer->BeginList();
+    for (int i = 0, len = results.rule_results_size(); i < len; ++i) {
+      WriteRuleResults(results.rule_results(i), writer);
+    }
+    writer->EndList();
+  }
+  if (results.has_score()) {
+    writer->Key("score");
+    writer->WriteInteger(results.score());
+  }
+  if (results.has_version()) {
+    writer->Key("version");
+    WriteVersion(results.version(), writer);
+  }
+  writer->EndObject();
   return true;
 }
 
@@ -94,6 +312,13 @@ base::Value* ResultsToJsonConverter::ConvertResult(
     }
     root->Set("resource_urls", resource_urls);
   }
+  if (result.has_optimized_content_hash()) {
+    root->SetString("optimized_content_hash", result.optimized_content_hash());
+  }
+  if (result.has_optimized_content_size()) {
+    root->SetInteger("optimized_content_size",
+                     result.optimized_content_size());
+  }
 
   // TODO: implement details serializers. Not supported for now.
   return root;
@@ -120,6 +345,31 @@ base::Value* ResultsToJsonConverter::ConvertRuleResult(
   return root;
 }
 
+base::Value* ResultsToJsonConverter::ConvertProfile(
+    const pagespeed::Profile& profile) {
+  if (!profile.IsInitialized()) {
+    LOG(ERROR) << "Profile instance not fully initialized.";
+    return NULL;
+  }
+  base::DictionaryValue* root = new base::DictionaryValue();
+  if (profile.input_phases_size() > 0) {
+    root->Set("input_phases", ConvertProfileEntries(profile.input_phases()));
+  }
+  if (profile.compute_results_size() > 0) {
+    root->Set("compute_results",
+              ConvertProfileEntries(profile.compute_results()));
+  }
+  if (profile.compute_score_and_impact_size() > 0) {
+    root->Set("compute_score_and_impact",
+              ConvertProfileEntries(profile.compute_score_and_impact()));
+  }
+  if (profile.format_results_size() > 0) {
+    root->Set("format_results",
+              ConvertProfileEntries(profile.format_results()));
+  }
+  return root;
+}
+
 base::Value* ResultsToJsonConverter::ConvertResults(
     const pagespeed::Results& results) {
   if (!results.IsInitialized()) {
@@ -144,6 +394,10 @@ base::Value* ResultsToJsonConverter::ConvertResults(
     root->SetInteger("score", results.score());
   }
 
+  if (results.has_profile()) {
+    root->Set("profile", ConvertProfile(results.profile()));
+  }
+
   return root;
 }
 
@@ -15,6 +15,7 @@
 #ifndef PAGESPEED_PROTO_RESULTS_TO_JSON_CONVERTER_H_
 #define PAGESPEED_PROTO_RESULTS_TO_JSON_CONVERTER_H_
 
+#include <ostream>
 #include <string>
 
 #include "base/basictypes.h"
@@ -25,6 +26,7 @@ class Value;
 
 namespace pagespeed {
 
+class Profile;
 class Result;
 class Results;
 class RuleResults;
@@ -33,6 +35,8 @@ class Version;
 
 namespace proto {
 
+class JsonStreamWriter;
+
 /**
  * Converts a Results protobuf to JSON.
  */
@@ -42,6 +46,18 @@ class ResultsToJsonConverter {
   // false on failure.
   static bool Convert(const pagespeed::Results& results, std::string* out);
 
+  // Writes a Results protocol buffer as JSON to the given stream.  Will
+  // return false on failure, in which case partial output may have been
+  // written.
+  static bool Convert(const pagespeed::Results& results, std::ostream* out);
+
+  // Writes a Results protocol buffer as JSON directly to writer, walking the
+  // protocol buffer rather than building a base::Value tree.  The output is
+  // identical to that of JSONWriter::Write(ConvertResults(results)).  Will
+  // return false on failure.
+  static bool WriteResults(const pagespeed::Results& results,
+                           JsonStreamWriter* writer);
+
   // Converts the various protocol buffers in a Results structure into
   // a base::Value* object, which can be converted to JSON with a
   // JSONWriter. Ownership of the returned base::Value* is transferred
@@ -52,6 +68,7 @@ class ResultsToJsonConverter {
   static base::Value* ConvertResult(const pagespeed::Result& result);
   static base::Value* ConvertSavings(const pagespeed::Savings& savings);
   static base::Value* ConvertVersion(const pagespeed::Version& version);
+  static base::Value* ConvertProfile(const pagespeed::Profile& profile);
 
  private:
   DISALLOW_IMPLICIT_CONSTRUCTORS(ResultsToJsonConverter);
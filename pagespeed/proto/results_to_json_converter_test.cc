@@ -14,6 +14,9 @@
 
 #include "pagespeed/proto/results_to_json_converter.h"
 
+#include <sstream>
+
+#include "base/json/json_writer.h"
 #include "base/values.h"
 #include "pagespeed/proto/pagespeed_output.pb.h"
 #include "testing/gtest/include/gtest/gtest.h"
@@ -21,6 +24,8 @@
 namespace {
 
 using pagespeed::InputInformation;
+using pagespeed::Profile;
+using pagespeed::ProfileEntry;
 using pagespeed::Result;
 using pagespeed::Results;
 using pagespeed::RuleResults;
@@ -51,6 +56,8 @@ const char *kFullJson =
        "\"savings\":{\"critical_path_length_saved\":3,\"requests_saved\":2}"
       "},"
       "{"
+       "\"optimized_content_hash\":\"0123abcd\","
+       "\"optimized_content_size\":10,"
        "\"resource_urls\":[\"http://www.example.com/foo\"],"
        "\"savings\":{\"request_bytes_saved\":1}"
       "}"
@@ -117,6 +124,8 @@ TEST(ResultsToJsonConverterTest, Full) {
   savings = result->mutable_savings();
   savings->set_request_bytes_saved(1);
   result->add_resource_urls("http://www.example.com/foo");
+  result->set_optimized_content_hash("0123abcd");
+  result->set_optimized_content_size(10);
 
   results.set_score(42);
 
@@ -126,6 +135,47 @@ TEST(ResultsToJsonConverterTest, Full) {
 
   Value* value = ResultsToJsonConverter::ConvertResults(results);
   ASSERT_NE(static_cast<Value*>(NULL), value);
+  std::string tree_json;
+  base::JSONWriter::Write(value, &tree_json);
+  ASSERT_EQ(kFullJson, tree_json);
+  delete value;
+
+  std::ostringstream stream;
+  ASSERT_TRUE(ResultsToJsonConverter::Convert(results, &stream));
+  ASSERT_EQ(kFullJson, stream.str());
+}
+
+TEST(ResultsToJsonConverterTest, Profile) {
+  Results results;
+  PopulateBasicFields(&results);
+  Profile* profile = results.mutable_profile();
+  ProfileEntry* entry = profile->add_input_phases();
+  entry->set_name("Freeze");
+  entry->set_wall_time_ms(1.5);
+  entry = profile->add_compute_results();
+  entry->set_name("Foo");
+  entry->set_wall_time_ms(2.0);
+  entry->set_cpu_time_ms(0.5);
+  entry->set_bytes_allocated(1024);
+  entry->set_num_results(3);
+
+  const char* kExpected =
+      "{\"profile\":{"
+      "\"compute_results\":[{\"bytes_allocated\":1024.0,"
+      "\"cpu_time_ms\":0.5,\"name\":\"Foo\",\"num_results\":3,"
+      "\"wall_time_ms\":2.0}],"
+      "\"input_phases\":[{\"name\":\"Freeze\",\"wall_time_ms\":1.5}]},"
+      "\"version\":{\"major\":1,\"minor\":9,\"official_release\":false}}";
+
+  std::string json;
+  ASSERT_TRUE(ResultsToJsonConverter::Convert(results, &json));
+  ASSERT_EQ(kExpected, json);
+
+  Value* value = ResultsToJsonConverter::ConvertResults(results);
+  ASSERT_NE(static_cast<Value*>(NULL), value);
+  std::string tree_json;
+  base::JSONWriter::Write(value, &tree_json);
+  ASSERT_EQ(kExpected, tree_json);
   delete value;
 }
 
@@ -145,9 +145,10 @@ bool AvoidLongRunningScripts::AppendResults(const RuleInput& rule_input,
   CHECK(NULL != timeline);
 
   LongRunningScriptsVisitor visitor(provider);
-  InstrumentationDataVisitor::Traverse(&visitor, *timeline);
+  InstrumentationDataVisitor::Traverse(&visitor, *timeline,
+                                       rule_input.cancellation_token());
 
-  return true;
+  return !rule_input.IsCancelled();
 }
 
 void AvoidLongRunningScripts::FormatResults(const ResultVector& results,
@@ -248,7 +248,7 @@ bool DetermineAllowedFromExtension(const std::string& url) {
   return false;
 }
 
-class PluginElementVisitor : public pagespeed::DomElementVisitor {
+class PluginElementVisitor : public pagespeed::DomTraversalVisitor {
  public:
   PluginElementVisitor(const pagespeed::RuleInput* rule_input,
                const pagespeed::DomDocument* document,
@@ -258,6 +258,9 @@ class PluginElementVisitor : public pagespeed::DomElementVisitor {
   void SetFrameBounds(int x1, int y1, int x2, int y2);
 
   virtual void Visit(const pagespeed::DomElement& node);
+  virtual pagespeed::DomTraversalVisitor* VisitContentDocument(
+      const pagespeed::DomElement& node,
+      const pagespeed::DomDocument& document);
 
  private:
   void AddResult(const pagespeed::DomElement& node,
@@ -342,37 +345,6 @@ void PluginElementVisitor::SetFrameVisible(bool visible) {
 }
 
 void PluginElementVisitor::Visit(const pagespeed::DomElement& node) {
-  std::string tag_name = node.GetTagName();
-
-  // Do a recursive document traversal for iframes.
-  if (tag_name == "IFRAME") {
-    scoped_ptr<pagespeed::DomDocument> child_doc(node.GetContentDocument());
-    if (child_doc.get()) {
-      PluginElementVisitor checker(rule_input_, child_doc.get(), provider_);
-      int x, y, width, height;
-      if (frame_visible_ &&
-          node.GetX(&x) == pagespeed::DomElement::SUCCESS &&
-          node.GetY(&y) == pagespeed::DomElement::SUCCESS &&
-          node.GetActualWidth(&width) == pagespeed::DomElement::SUCCESS &&
-          node.GetActualHeight(&height) == pagespeed::DomElement::SUCCESS) {
-        const int x1 = frame_x1_ + x;
-        const int y1 = frame_y1_ + y;
-        int x2 = x1 + width;
-        int y2 = y1 + height;
-        // If the x2 and y2 coordinates of the frame containing this iframe are
-        // bounded, clip the iframe's x2 and y2 coordinates to match.
-        if (frame_x2_ >= 0 && frame_y2_ >= 0) {
-          x2 = std::min(x2, frame_x2_);
-          y2 = std::min(y2, frame_y2_);
-        }
-        checker.SetFrameBounds(x1, y1, x2, y2);
-      } else {
-        checker.SetFrameVisible(false);
-      }
-      child_doc->Traverse(&checker);
-    }
-  }
-
   // Check if this node contains a plugin, and record it if it does.
   AvoidPluginsDetails_PluginType type = AvoidPluginsDetails_PluginType_UNKNOWN;
   std::string mime;
@@ -382,6 +354,34 @@ void PluginElementVisitor::Visit(const pagespeed::DomElement& node) {
   }
 }
 
+pagespeed::DomTraversalVisitor* PluginElementVisitor::VisitContentDocument(
+    const pagespeed::DomElement& node,
+    const pagespeed::DomDocument& document) {
+  PluginElementVisitor* checker =
+      new PluginElementVisitor(rule_input_, &document, provider_);
+  int x, y, width, height;
+  if (frame_visible_ &&
+      node.GetX(&x) == pagespeed::DomElement::SUCCESS &&
+      node.GetY(&y) == pagespeed::DomElement::SUCCESS &&
+      node.GetActualWidth(&width) == pagespeed::DomElement::SUCCESS &&
+      node.GetActualHeight(&height) == pagespeed::DomElement::SUCCESS) {
+    const int x1 = frame_x1_ + x;
+    const int y1 = frame_y1_ + y;
+    int x2 = x1 + width;
+    int y2 = y1 + height;
+    // If the x2 and y2 coordinates of the frame containing this iframe are
+    // bounded, clip the iframe's x2 and y2 coordinates to match.
+    if (frame_x2_ >= 0 && frame_y2_ >= 0) {
+      x2 = std::min(x2, frame_x2_);
+      y2 = std::min(y2, frame_y2_);
+    }
+    checker->SetFrameBounds(x1, y1, x2, y2);
+  } else {
+    checker->SetFrameVisible(false);
+  }
+  return checker;
+}
+
 void PluginElementVisitor::AddResult(const pagespeed::DomElement& node,
                                      AvoidPluginsDetails_PluginType type,
                                      const std::string& mime,
@@ -834,12 +834,13 @@ UserFacingString AvoidPlugins::header() const {
 
 bool AvoidPlugins::AppendResults(const RuleInput& rule_input,
                                        ResultProvider* provider) {
-  const DomDocument* document = rule_input.pagespeed_input().dom_document();
-  if (document) {
-    PluginElementVisitor visitor(&rule_input, document, provider);
-    document->Traverse(&visitor);
-  }
-  return true;
+  return AppendResultsFromDomVisitor(rule_input, provider);
+}
+
+DomTraversalVisitor* AvoidPlugins::NewDomVisitor(const RuleInput& rule_input,
+                                                 ResultProvider* provider) {
+  return new PluginElementVisitor(
+      &rule_input, rule_input.pagespeed_input().dom_document(), provider);
 }
 
 UrlBlockFormatter* AvoidPlugins::CreateUrlBlockFormatterForType(
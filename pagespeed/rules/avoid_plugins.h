@@ -39,6 +39,8 @@ class AvoidPlugins : public Rule {
   virtual const char* name() const;
   virtual UserFacingString header() const;
   virtual bool AppendResults(const RuleInput& input, ResultProvider* provider);
+  virtual DomTraversalVisitor* NewDomVisitor(const RuleInput& input,
+                                             ResultProvider* provider);
   virtual void FormatResults(const ResultVector& results,
                              RuleFormatter* formatter);
   virtual void AppendRuleGroups(
@@ -69,9 +69,11 @@ class JavaScriptFilter : public net_instaweb::EmptyHtmlFilter {
   typedef std::map<std::string, JavaScriptBlock> UrlToJavaScriptBlockMap;
 
   JavaScriptFilter(net_instaweb::HtmlParse* html_parse,
-                   const pagespeed::PagespeedInput* input)
+                   const pagespeed::PagespeedInput* input,
+                   const pagespeed::CancellationToken* cancel)
     : html_parse_(html_parse),
       pagespeed_input_(input),
+      cancel_(cancel),
       total_size_(0) {}
   virtual ~JavaScriptFilter() {}
 
@@ -102,6 +104,7 @@ class JavaScriptFilter : public net_instaweb::EmptyHtmlFilter {
   UrlToJavaScriptBlockMap pending_javascript_blocks_;
   UrlToJavaScriptBlockMap problem_javascript_blocks_;
   const pagespeed::PagespeedInput* pagespeed_input_;
+  const pagespeed::CancellationToken* cancel_;
   size_t total_size_;
 
   DISALLOW_COPY_AND_ASSIGN(JavaScriptFilter);
@@ -111,7 +114,7 @@ void JavaScriptFilter::AddJavascriptBlock(
     const std::string& url, const std::string& content, bool is_inline) {
   std::string minified;
   int size = 0;
-  bool did_minify = js::GetMinifiedStringCollapsedJsSize(content,
+  bool did_minify = js::GetMinifiedStringCollapsedJsSize(content, cancel_,
                                                          &size);
   if (!did_minify) {
     LOG(INFO) << "Minify JS failed. Original size is used.";
@@ -320,10 +323,14 @@ bool DeferParsingJavaScript::AppendResults(const RuleInput& rule_input,
   net_instaweb::GoogleMessageHandler message_handler;
   message_handler.set_min_message_type(net_instaweb::kError);
   net_instaweb::HtmlParse html_parse(&message_handler);
-  JavaScriptFilter filter(&html_parse, &input);
+  JavaScriptFilter filter(&html_parse, &input,
+                          rule_input.cancellation_token());
   html_parse.AddFilter(&filter);
 
   for (int i = 0, num = input.num_resources(); i < num; ++i) {
+    if (rule_input.IsCancelled()) {
+      return false;
+    }
     const Resource& resource = input.GetResource(i);
     if (input.IsResourceLoadedAfterOnload(resource)) {
       continue;
@@ -337,6 +344,10 @@ bool DeferParsingJavaScript::AppendResults(const RuleInput& rule_input,
     html_parse.ParseText(
         resource.GetResponseBody().data(), resource.GetResponseBody().length());
     html_parse.FinishParse();
+    if (rule_input.IsCancelled()) {
+      // Block sizes may have been computed from unminified content.
+      return false;
+    }
 
     const JavaScriptFilter::UrlToJavaScriptBlockMap& problem_javascript_blocks =
         filter.problem_javascript_blocks();
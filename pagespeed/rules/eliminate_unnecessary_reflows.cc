@@ -288,7 +288,11 @@ bool EliminateUnnecessaryReflows::AppendResults(const RuleInput& rule_input,
   // resource that triggered them.
   URLToInstrumentationStackVectorMap m;
   UnnecessaryReflowDiscoverer visitor(&m);
-  InstrumentationDataVisitor::Traverse(&visitor, *input.instrumentation_data());
+  InstrumentationDataVisitor::Traverse(&visitor, *input.instrumentation_data(),
+                                       rule_input.cancellation_token());
+  if (rule_input.IsCancelled()) {
+    return false;
+  }
 
   for (URLToInstrumentationStackVectorMap::const_iterator
            stack_vector_iter = m.begin(), end = m.end();
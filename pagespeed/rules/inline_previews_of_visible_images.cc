@@ -23,7 +23,6 @@
 #include "pagespeed/core/resource.h"
 #include "pagespeed/core/result_provider.h"
 #include "pagespeed/core/rule_input.h"
-#include "pagespeed/dom/resource_coordinate_finder.h"
 #include "pagespeed/l10n/l10n.h"
 #include "pagespeed/proto/pagespeed_output.pb.h"
 
@@ -35,7 +34,8 @@ InlinePreviewsOfVisibleImages::InlinePreviewsOfVisibleImages()
     : pagespeed::Rule(pagespeed::InputCapabilities(
         pagespeed::InputCapabilities::DOM |
         pagespeed::InputCapabilities::ONLOAD |
-        pagespeed::InputCapabilities::REQUEST_START_TIMES)) {}
+        pagespeed::InputCapabilities::REQUEST_START_TIMES |
+        pagespeed::InputCapabilities::RESPONSE_BODY)) {}
 
 const char* InlinePreviewsOfVisibleImages::name() const {
   return "InlinePreviewsOfVisibleImages";
@@ -53,15 +53,14 @@ UserFacingString InlinePreviewsOfVisibleImages::header() const {
 bool InlinePreviewsOfVisibleImages::AppendResults(const RuleInput& rule_input,
                                                   ResultProvider* provider) {
   const PagespeedInput& input = rule_input.pagespeed_input();
-  std::vector<const pagespeed::Resource*> onscreen_resources;
-  std::vector<const pagespeed::Resource*> offscreen_resources;
-  if (!pagespeed::dom::FindOnAndOffscreenImageResources(
-          input, &onscreen_resources, &offscreen_resources)) {
+  const std::vector<const pagespeed::Resource*>* onscreen_resources = NULL;
+  if (!rule_input.GetOnAndOffscreenImageResources(
+          &onscreen_resources, NULL, NULL)) {
     return false;
   }
 
   for (std::vector<const pagespeed::Resource*>::const_iterator
-           it = onscreen_resources.begin(), end = onscreen_resources.end();
+           it = onscreen_resources->begin(), end = onscreen_resources->end();
        it != end; ++it) {
     const pagespeed::Resource& candidate = **it;
     if (candidate.GetResourceType() != pagespeed::IMAGE) {
@@ -90,7 +90,7 @@ bool InlineSmallResources::AppendResults(const RuleInput& rule_input,
     }
 
     std::string resource_domain =
-        uri_util::GetDomainAndRegistry(resource.GetRequestUrl());
+        uri_util::GetDomainAndRegistry(input, resource);
     if (resource_domain.empty()) {
       LOG(INFO) << "Got empty domain for " << resource.GetRequestUrl();
       continue;
@@ -102,7 +102,7 @@ bool InlineSmallResources::AppendResults(const RuleInput& rule_input,
          it != end;
          ++it) {
       const Resource* external_resource = input.GetResourceWithUrlOrNull(*it);
-      if (IsInlineCandidate(external_resource, resource_domain)) {
+      if (IsInlineCandidate(input, external_resource, resource_domain)) {
         inline_candidates[resource.GetRequestUrl()].insert(external_resource);
         num_referring_documents[external_resource]++;
       }
@@ -162,7 +162,8 @@ bool InlineSmallResources::AppendResults(const RuleInput& rule_input,
 }
 
 // Is this resource a candidate for inlining into the HTML document?
-bool InlineSmallResources::IsInlineCandidate(const Resource* resource,
+bool InlineSmallResources::IsInlineCandidate(const PagespeedInput& input,
+                                             const Resource* resource,
                                              const std::string& html_domain) {
   if (resource == NULL) {
     return false;
@@ -181,7 +182,7 @@ bool InlineSmallResources::IsInlineCandidate(const Resource* resource,
   }
 
   std::string resource_domain =
-      uri_util::GetDomainAndRegistry(resource->GetRequestUrl());
+      uri_util::GetDomainAndRegistry(input, *resource);
   if (resource_domain.empty()) {
     LOG(INFO) << "Got empty domain for "
               << resource->GetRequestUrl();
@@ -21,6 +21,8 @@
 
 namespace pagespeed {
 
+class PagespeedInput;
+
 namespace rules {
 
 /**
@@ -44,7 +46,8 @@ class InlineSmallResources : public Rule {
       const InputInformation& input_info) const = 0;
 
  private:
-  bool IsInlineCandidate(const Resource* resource,
+  bool IsInlineCandidate(const PagespeedInput& input,
+                         const Resource* resource,
                          const std::string& html_domain);
 
   const ResourceType resource_type_;
@@ -85,7 +85,7 @@ int64 GetExpectedFreshnessLifetimeForResource(
   const std::string primary_resource_domain =
       pagespeed::uri_util::GetDomainAndRegistry(input.primary_resource_url());
   const std::string resource_domain =
-      pagespeed::uri_util::GetDomainAndRegistry(resource.GetRequestUrl());
+      pagespeed::uri_util::GetDomainAndRegistry(input, resource);
   if (primary_resource_domain == resource_domain) {
     return kMinAgeForSameDomainContent;
   } else {
@@ -23,7 +23,6 @@
 #include "pagespeed/core/resource.h"
 #include "pagespeed/core/result_provider.h"
 #include "pagespeed/core/rule_input.h"
-#include "pagespeed/dom/resource_coordinate_finder.h"
 #include "pagespeed/l10n/l10n.h"
 #include "pagespeed/proto/pagespeed_output.pb.h"
 
@@ -53,16 +52,16 @@ UserFacingString LoadVisibleImagesFirst::header() const {
 bool LoadVisibleImagesFirst::AppendResults(const RuleInput& rule_input,
                                            ResultProvider* provider) {
   const PagespeedInput& input = rule_input.pagespeed_input();
-  std::vector<const pagespeed::Resource*> onscreen_resources;
-  std::vector<const pagespeed::Resource*> offscreen_resources;
-  if (!pagespeed::dom::FindOnAndOffscreenImageResources(
-          input, &onscreen_resources, &offscreen_resources)) {
+  const std::vector<const pagespeed::Resource*>* onscreen_resources = NULL;
+  const std::vector<const pagespeed::Resource*>* offscreen_resources = NULL;
+  if (!rule_input.GetOnAndOffscreenImageResources(
+          &onscreen_resources, &offscreen_resources, NULL)) {
     return false;
   }
 
   const pagespeed::Resource* last_requested_above_the_fold_resource = NULL;
   for (std::vector<const pagespeed::Resource*>::const_iterator
-           it = onscreen_resources.begin(), end = onscreen_resources.end();
+           it = onscreen_resources->begin(), end = onscreen_resources->end();
        it != end; ++it) {
     const pagespeed::Resource& resource = **it;
     if (resource.GetResourceType() != pagespeed::IMAGE) {
@@ -91,7 +90,7 @@ bool LoadVisibleImagesFirst::AppendResults(const RuleInput& rule_input,
   }
 
   for (std::vector<const pagespeed::Resource*>::const_iterator it =
-           offscreen_resources.begin(), end = offscreen_resources.end();
+           offscreen_resources->begin(), end = offscreen_resources->end();
        it != end; ++it) {
     const pagespeed::Resource& candidate = **it;
     if (candidate.GetResourceType() != pagespeed::IMAGE) {
@@ -126,7 +126,8 @@ const MinifierOutput* CssMinifier::Minify(const Resource& resource,
   if (save_optimized_content_ ||
       resource_util::IsCompressedResource(resource)) {
     std::string minified_css;
-    if (!css::MinifyCss(input, &minified_css)) {
+    if (!css::MinifyCss(input, rule_input.cancellation_token(),
+                        &minified_css)) {
       LOG(ERROR) << "MinifyCss failed for resource: "
                  << resource.GetRequestUrl();
       return MinifierOutput::Error();
@@ -138,7 +139,8 @@ const MinifierOutput* CssMinifier::Minify(const Resource& resource,
     }
   } else {
     int minified_css_size = 0;
-    if (!css::GetMinifiedCssSize(input, &minified_css_size)) {
+    if (!css::GetMinifiedCssSize(input, rule_input.cancellation_token(),
+                                 &minified_css_size)) {
       LOG(ERROR) << "GetMinifiedCssSize failed for resource: "
                  << resource.GetRequestUrl();
       return MinifierOutput::Error();
@@ -126,7 +126,8 @@ const MinifierOutput* JsMinifier::Minify(const Resource& resource,
   if (save_optimized_content_ ||
       resource_util::IsCompressedResource(resource)) {
     std::string minified_js;
-    if (!js::MinifyJs(input, &minified_js)) {
+    if (!js::MinifyJs(input, rule_input.cancellation_token(),
+                      &minified_js)) {
       LOG(ERROR) << "MinifyJs failed for resource: "
                  << resource.GetRequestUrl();
       return MinifierOutput::Error();
@@ -139,7 +140,8 @@ const MinifierOutput* JsMinifier::Minify(const Resource& resource,
     }
   } else {
     int minified_js_size = 0;
-    if (!js::GetMinifiedJsSize(input, &minified_js_size)) {
+    if (!js::GetMinifiedJsSize(input, rule_input.cancellation_token(),
+                               &minified_js_size)) {
       LOG(ERROR) << "GetMinifiedJsSize failed for resource: "
                  << resource.GetRequestUrl();
       return MinifierOutput::Error();
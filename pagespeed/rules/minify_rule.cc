@@ -97,65 +97,63 @@ UserFacingString MinifyRule::header() const {
 
 bool MinifyRule::AppendResults(const RuleInput& rule_input,
                                ResultProvider* provider) {
-  bool error = false;
-  const PagespeedInput& input = rule_input.pagespeed_input();
-  for (int idx = 0, num = input.num_resources(); idx < num; ++idx) {
-    const Resource& resource = input.GetResource(idx);
-
-    scoped_ptr<const MinifierOutput> output(
-        minifier_->Minify(resource, rule_input));
-    if (output == NULL) {
-      error = true;
-      continue;
-    } else if (!output->can_be_minified()) {
-      continue;
-    }
+  return AppendResultsForEachResource(rule_input, provider);
+}
 
-    int bytes_saved = 0;
-    int bytes_original = 0;
-    bool is_post_gzip = false;
-    if (resource_util::IsCompressedResource(resource)) {
-      int new_size;
-      if (rule_input.GetCompressedResponseBodySize(resource, &bytes_original) &&
-          output->GetCompressedMinifiedSize(&new_size)) {
-        bytes_saved = bytes_original - new_size;
-        is_post_gzip = true;
-      } else {
-        LOG(ERROR) << "Unable to compare compressed sizes for "
-                   << resource.GetRequestUrl();
-        error = true;
-        continue;
-      }
+bool MinifyRule::AppendResultsForResource(const RuleInput& rule_input,
+                                          const Resource& resource,
+                                          ResultProvider* provider) {
+  scoped_ptr<const MinifierOutput> output(
+      minifier_->Minify(resource, rule_input));
+  if (output == NULL) {
+    return false;
+  } else if (!output->can_be_minified()) {
+    return true;
+  }
+
+  int bytes_saved = 0;
+  int bytes_original = 0;
+  bool is_post_gzip = false;
+  if (resource_util::IsCompressedResource(resource)) {
+    int new_size;
+    if (rule_input.GetCompressedResponseBodySize(resource, &bytes_original) &&
+        output->GetCompressedMinifiedSize(&new_size)) {
+      bytes_saved = bytes_original - new_size;
+      is_post_gzip = true;
     } else {
-      bytes_original = resource.GetResponseBody().size();
-      bytes_saved = bytes_original - output->plain_minified_size();
+      LOG(ERROR) << "Unable to compare compressed sizes for "
+                 << resource.GetRequestUrl();
+      return false;
     }
+  } else {
+    bytes_original = resource.GetResponseBody().size();
+    bytes_saved = bytes_original - output->plain_minified_size();
+  }
 
-    if (bytes_saved <= 0) {
-      continue;
-    }
+  if (bytes_saved <= 0) {
+    return true;
+  }
 
-    Result* result = provider->NewResult();
-    result->set_original_response_bytes(bytes_original);
-    result->add_resource_urls(resource.GetRequestUrl());
+  Result* result = provider->NewResult();
+  result->set_original_response_bytes(bytes_original);
+  result->add_resource_urls(resource.GetRequestUrl());
 
-    Savings* savings = result->mutable_savings();
-    savings->set_response_bytes_saved(bytes_saved);
+  Savings* savings = result->mutable_savings();
+  savings->set_response_bytes_saved(bytes_saved);
 
-    MinificationDetails* min_details =
-      result->mutable_details()->MutableExtension(
-          MinificationDetails::message_set_extension);
-    min_details->set_savings_are_post_gzip(is_post_gzip);
+  MinificationDetails* min_details =
+    result->mutable_details()->MutableExtension(
+        MinificationDetails::message_set_extension);
+  min_details->set_savings_are_post_gzip(is_post_gzip);
 
-    if (output->should_save_minified_content() &&
-        !resource.IsResponseBodyModified()) {
-      result->set_optimized_content(*output->minified_content());
-      result->set_optimized_content_mime_type(
-          output->minified_content_mime_type());
-    }
+  if (output->should_save_minified_content() &&
+      !resource.IsResponseBodyModified()) {
+    result->set_optimized_content(*output->minified_content());
+    result->set_optimized_content_mime_type(
+        output->minified_content_mime_type());
   }
 
-  return !error;
+  return true;
 }
 
 void MinifyRule::FormatResults(const ResultVector& results,
@@ -232,12 +230,22 @@ void MinifyRule::FormatResults(const ResultVector& results,
         UrlArgument("URL", result.resource_urls(0)),
         BytesArgument("SIZE_IN_BYTES", bytes_saved),
         PercentageArgument("PERCENTAGE", bytes_saved, original_size));
-    if (result.has_id() && result.has_optimized_content()) {
+    if (result.has_id() && (result.has_optimized_content() ||
+                            result.has_optimized_content_hash())) {
       url_result->SetAssociatedResultId(result.id());
     }
   }
 }
 
+bool MinifyRule::SupportsIncrementalResults() const {
+  // Minifiers only look at the resource they are given.
+  return true;
+}
+
+bool MinifyRule::AnalyzesResourcesSeparately() const {
+  return true;
+}
+
 }  // namespace rules
 
 }  // namespace pagespeed
@@ -128,6 +128,12 @@ class MinifyRule : public Rule {
   virtual bool AppendResults(const RuleInput& input, ResultProvider* provider);
   virtual void FormatResults(const ResultVector& results,
                              RuleFormatter* formatter);
+  virtual bool SupportsIncrementalResults() const;
+  virtual bool AnalyzesResourcesSeparately() const;
+  virtual bool AppendResultsForResource(const RuleInput& input,
+                                        const Resource& resource,
+                                        ResultProvider* provider);
+
  private:
   scoped_ptr<Minifier> minifier_;
 
@@ -19,7 +19,6 @@
 #include <vector>
 
 #include "base/logging.h"
-#include "googleurl/src/gurl.h"
 #include "pagespeed/core/formatter.h"
 #include "pagespeed/core/pagespeed_input.h"
 #include "pagespeed/core/resource.h"
@@ -40,6 +39,8 @@ typedef std::map<std::string, pagespeed::HostResourceMap> DomainHostResourceMap;
 void PopulateDomainHostResourceMap(
     const pagespeed::PagespeedInput& input,
     DomainHostResourceMap *domain_host_resouce_map) {
+  const pagespeed::ResourceCollection& collection =
+      input.GetResourceCollection();
   for (int i = 0, num = input.num_resources(); i < num; ++i) {
     const pagespeed::Resource& resource = input.GetResource(i);
     // exclude non-http resources
@@ -53,16 +54,16 @@ void PopulateDomainHostResourceMap(
       continue;
     }
 
-    std::string domain =
-        pagespeed::uri_util::GetDomainAndRegistry(resource.GetRequestUrl());
+    const int host_id = collection.GetHostId(i);
+    const std::string& domain = collection.GetHostDomainAndRegistry(host_id);
     if (domain.empty()) {
       LOG(INFO) << "Got empty domain for " << resource.GetRequestUrl();
       continue;
     }
 
     // Add the resource to the map.
-    GURL gurl(resource.GetRequestUrl());
-    (*domain_host_resouce_map)[domain][gurl.host()].insert(&resource);
+    (*domain_host_resouce_map)[domain][collection.GetHostName(host_id)]
+        .insert(&resource);
   }
 }
 
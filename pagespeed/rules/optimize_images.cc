@@ -128,7 +128,8 @@ const MinifierOutput* ImageMinifier::Minify(const Resource& resource,
   std::string compressed;
   std::string output_mime_type;
   if (type == JPEG) {
-    if (!image_compression::OptimizeJpeg(original, &compressed)) {
+    if (!image_compression::OptimizeJpeg(original, input.cancellation_token(),
+                                         &compressed)) {
       DLOG(INFO) << "OptimizeJpeg failed for resource: "
                  << resource.GetRequestUrl();
       return MinifierOutput::Error();
@@ -136,9 +137,8 @@ const MinifierOutput* ImageMinifier::Minify(const Resource& resource,
     output_mime_type = "image/jpeg";
   } else if (type == PNG) {
     image_compression::PngReader reader;
-    if (!image_compression::PngOptimizer::OptimizePng(reader,
-                                                      original,
-                                                      &compressed)) {
+    if (!image_compression::PngOptimizer::OptimizePng(
+            reader, original, input.cancellation_token(), &compressed)) {
       DLOG(INFO) << "OptimizePng(PngReader) failed for resource: "
                  << resource.GetRequestUrl();
       return MinifierOutput::Error();
@@ -146,9 +146,8 @@ const MinifierOutput* ImageMinifier::Minify(const Resource& resource,
     output_mime_type = "image/png";
   } else if (type == GIF) {
     image_compression::GifReader reader;
-    if (!image_compression::PngOptimizer::OptimizePng(reader,
-                                                      original,
-                                                      &compressed)) {
+    if (!image_compression::PngOptimizer::OptimizePng(
+            reader, original, input.cancellation_token(), &compressed)) {
       DLOG(INFO) << "OptimizePng(GifReader) failed for resource: "
                  << resource.GetRequestUrl();
       return MinifierOutput::Error();
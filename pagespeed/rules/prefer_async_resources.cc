@@ -153,24 +153,16 @@ bool IsBlockingScript(
   return is_blocking_script && (offset == stripped_resolved_src.size());
 }
 
-class ScriptVisitor : public pagespeed::DomElementVisitor {
+class ScriptVisitor : public pagespeed::DomTraversalVisitor {
  public:
-  static void CheckDocument(const PagespeedInput* pagespeed_input,
-                            const DomDocument* document,
-                            ResultProvider* provider) {
-    if (document) {
-      ScriptVisitor visitor(pagespeed_input, document, provider);
-      document->Traverse(&visitor);
-      visitor.AddViolations(provider, document->GetDocumentUrl());
-    }
-  }
+  ScriptVisitor(const PagespeedInput* pagespeed_input,
+                const DomDocument* document, ResultProvider* provider)
+      : pagespeed_input_(pagespeed_input),
+        document_(document), provider_(provider) {}
 
   virtual void Visit(const DomElement& node) {
     const std::string tag_name(node.GetTagName());
-    if (tag_name == "IFRAME") {
-      scoped_ptr<pagespeed::DomDocument> child_doc(node.GetContentDocument());
-      CheckDocument(pagespeed_input_, child_doc.get(), provider_);
-    } else if (pagespeed_input_->has_resource_with_url(
+    if (pagespeed_input_->has_resource_with_url(
         document_->GetDocumentUrl())) {
       if (tag_name == "SCRIPT") {
         std::string script_src;
@@ -186,16 +178,20 @@ class ScriptVisitor : public pagespeed::DomElementVisitor {
     }
   }
 
+  virtual DomTraversalVisitor* VisitContentDocument(
+      const DomElement& node, const DomDocument& document) {
+    return new ScriptVisitor(pagespeed_input_, &document, provider_);
+  }
+
+  virtual void Finish() {
+    AddViolations(provider_, document_->GetDocumentUrl());
+  }
+
   void VisitExternalScript(const std::string& script_src);
 
   void AddViolations(ResultProvider* provider, const std::string& document_url);
 
  private:
-  ScriptVisitor(const PagespeedInput* pagespeed_input,
-                const DomDocument* document, ResultProvider* provider)
-      : pagespeed_input_(pagespeed_input),
-        document_(document), provider_(provider) {}
-
   std::vector<std::string> blocking_scripts_;
 
   const PagespeedInput* pagespeed_input_;
@@ -265,9 +261,13 @@ UserFacingString PreferAsyncResources::header() const {
 
 bool PreferAsyncResources::AppendResults(const RuleInput& rule_input,
                                          ResultProvider* provider) {
+  return AppendResultsFromDomVisitor(rule_input, provider);
+}
+
+DomTraversalVisitor* PreferAsyncResources::NewDomVisitor(
+    const RuleInput& rule_input, ResultProvider* provider) {
   const PagespeedInput& input = rule_input.pagespeed_input();
-  ScriptVisitor::CheckDocument(&input, input.dom_document(), provider);
-  return true;
+  return new ScriptVisitor(&input, input.dom_document(), provider);
 }
 
 void PreferAsyncResources::FormatResults(const ResultVector& results,
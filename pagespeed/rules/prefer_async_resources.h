@@ -34,6 +34,8 @@ class PreferAsyncResources : public Rule {
   virtual const char* name() const;
   virtual UserFacingString header() const;
   virtual bool AppendResults(const RuleInput& input, ResultProvider* provider);
+  virtual DomTraversalVisitor* NewDomVisitor(const RuleInput& input,
+                                             ResultProvider* provider);
   virtual void FormatResults(const ResultVector& results,
                              RuleFormatter* formatter);
 
@@ -34,24 +34,17 @@ namespace {
 
 const char* kRuleName = "PutCssInTheDocumentHead";
 
-class StyleVisitor : public pagespeed::DomElementVisitor {
+class StyleVisitor : public pagespeed::DomTraversalVisitor {
  public:
-  static void CheckDocument(const PagespeedInput* pagespeed_input,
-                            const DomDocument* document,
-                            ResultProvider* provider) {
-    if (document) {
-      StyleVisitor visitor(pagespeed_input, document, provider);
-      document->Traverse(&visitor);
-      visitor.Finish();
-    }
-  }
+  StyleVisitor(const PagespeedInput* pagespeed_input,
+               const DomDocument* document, ResultProvider* provider)
+      : is_in_body_yet_(false), num_inline_style_blocks_(0),
+        pagespeed_input_(pagespeed_input), document_(document),
+        provider_(provider) {}
 
   virtual void Visit(const DomElement& node) {
     const std::string tag_name(node.GetTagName());
-    if (tag_name == "IFRAME") {
-      scoped_ptr<pagespeed::DomDocument> child_doc(node.GetContentDocument());
-      CheckDocument(pagespeed_input_, child_doc.get(), provider_);
-    } else if (tag_name == "BODY") {
+    if (tag_name == "BODY") {
       is_in_body_yet_ = true;
     } else if (is_in_body_yet_) {
       if (pagespeed_input_->has_resource_with_url(
@@ -69,14 +62,12 @@ class StyleVisitor : public pagespeed::DomElementVisitor {
     }
   }
 
- private:
-  StyleVisitor(const PagespeedInput* pagespeed_input,
-               const DomDocument* document, ResultProvider* provider)
-      : is_in_body_yet_(false), num_inline_style_blocks_(0),
-        pagespeed_input_(pagespeed_input), document_(document),
-        provider_(provider) {}
+  virtual DomTraversalVisitor* VisitContentDocument(
+      const DomElement& node, const DomDocument& document) {
+    return new StyleVisitor(pagespeed_input_, &document, provider_);
+  }
 
-  void Finish() {
+  virtual void Finish() {
     DCHECK(num_inline_style_blocks_ >= 0);
     if (num_inline_style_blocks_ == 0 && external_styles_.empty()) {
       return;
@@ -99,6 +90,7 @@ class StyleVisitor : public pagespeed::DomElementVisitor {
     }
   }
 
+ private:
   bool is_in_body_yet_;
   int num_inline_style_blocks_;
   std::vector<std::string> external_styles_;
@@ -131,9 +123,13 @@ UserFacingString PutCssInTheDocumentHead::header() const {
 
 bool PutCssInTheDocumentHead::AppendResults(const RuleInput& rule_input,
                                             ResultProvider* provider) {
+  return AppendResultsFromDomVisitor(rule_input, provider);
+}
+
+DomTraversalVisitor* PutCssInTheDocumentHead::NewDomVisitor(
+    const RuleInput& rule_input, ResultProvider* provider) {
   const PagespeedInput& input = rule_input.pagespeed_input();
-  StyleVisitor::CheckDocument(&input, input.dom_document(), provider);
-  return true;
+  return new StyleVisitor(&input, input.dom_document(), provider);
 }
 
 void PutCssInTheDocumentHead::FormatResults(const ResultVector& results,
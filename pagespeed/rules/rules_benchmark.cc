@@ -0,0 +1,284 @@
+// Copyright 2013 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+#include <vector>
+
+#include "base/memory/scoped_ptr.h"
+#include "base/stl_util.h"  // for STLDeleteContainerPointers
+#include "pagespeed/core/engine.h"
+#include "pagespeed/core/pagespeed_input.h"
+#include "pagespeed/core/resource.h"
+#include "pagespeed/core/result_provider.h"
+#include "pagespeed/core/rule.h"
+#include "pagespeed/core/rule_input.h"
+#include "pagespeed/core/string_util.h"
+#include "pagespeed/formatters/proto_formatter.h"
+#include "pagespeed/l10n/gettext_localizer.h"
+#include "pagespeed/l10n/localizer.h"
+#include "pagespeed/l10n/register_locale.h"
+#include "pagespeed/proto/pagespeed_output.pb.h"
+#include "pagespeed/proto/pagespeed_proto_formatter.pb.h"
+#include "pagespeed/rules/rule_provider.h"
+#include "pagespeed/testing/benchmark.h"
+#include "pagespeed/testing/fake_dom.h"
+#include "pagespeed/testing/pagespeed_input_builder.h"
+#include "pagespeed/testing/pagespeed_test.h"
+
+namespace {
+
+using pagespeed::string_util::IntToString;
+using pagespeed::string_util::StringPrintf;
+using pagespeed_testing::BenchmarkState;
+using pagespeed_testing::FakeDomElement;
+
+const int kNumScripts = 20;
+const int kNumStylesheets = 10;
+const int kNumImages = 60;
+const int kNumRedirects = 5;
+
+const char kPngFile[] = IMAGE_TEST_DIR_PATH "png/this_is_a_test.png";
+
+// Builds a fixed, moderately sized page that gives most rules something to
+// report: uncompressed and unminified text resources, uncacheable and
+// cookie-bearing static resources, images that are scaled in the DOM, and a
+// few redirects.
+class RulesBenchmarkCorpus {
+ public:
+  RulesBenchmarkCorpus() {}
+
+  // Returns false if the page could not be frozen.
+  bool Build() {
+    std::string png_body;
+    if (!pagespeed_testing::ReadFileToString(kPngFile, &png_body)) {
+      png_body = "not a png";
+    }
+
+    pagespeed::Resource* primary =
+        builder_.NewPrimaryResource("http://www.example.com/index.html");
+    primary->SetResponseBody(
+        "<html><head><title>Benchmark</title></head><body>"
+        "<p>  Hello,   world.  </p><!-- comment --></body></html>");
+    builder_.CreateHtmlHeadBodyElements();
+
+    for (int i = 0; i < kNumScripts; ++i) {
+      pagespeed::Resource* resource = builder_.NewScriptResource(
+          StringPrintf("http://www.example.com/js/script-%d.js", i),
+          builder_.body());
+      resource->AddResponseHeader("Content-Type", "application/javascript");
+      resource->SetResponseBody(StringPrintf(
+          "// Script %d.\n"
+          "function add%d(first, second) {\n"
+          "  return first + second;  // sum\n"
+          "}\n"
+          "var value%d = add%d(1, 2);\n", i, i, i, i));
+    }
+
+    for (int i = 0; i < kNumStylesheets; ++i) {
+      pagespeed::Resource* resource = builder_.NewCssResource(
+          StringPrintf("http://static%d.example.com/css/style-%d.css",
+                       i % 3, i),
+          builder_.head());
+      resource->AddResponseHeader("Content-Type", "text/css");
+      resource->AddResponseHeader("Cache-Control", "max-age=300");
+      resource->SetResponseBody(StringPrintf(
+          "/* Style %d. */\n"
+          "body {  color : red ;  }\n"
+          ".item-%d { background: url(/images/bg-%d.png); }\n"
+          "@import url(\"/css/import-%d.css\");\n", i, i, i, i));
+    }
+
+    pagespeed_testing::FakeImageAttributesFactory::ResourceSizeMap sizes;
+    for (int i = 0; i < kNumImages; ++i) {
+      FakeDomElement* img = NULL;
+      pagespeed::Resource* resource = builder_.NewPngResource(
+          StringPrintf("http://images.example.com/images/img-%d.png", i),
+          builder_.body(), &img);
+      resource->AddRequestHeader("Cookie", "session=" + IntToString(i));
+      resource->SetResponseBody(png_body);
+      // The natural size is larger than the displayed size, so that
+      // ServeScaledImages and SpecifyImageDimensions have work to do.
+      sizes[resource] = std::make_pair(64, 64);
+      img->AddAttribute("width", "32");
+      img->AddAttribute("height", "32");
+      img->SetActualWidthAndHeight(32, 32);
+    }
+    builder_.AddFakeImageAttributesFactory(sizes);
+
+    for (int i = 0; i < kNumRedirects; ++i) {
+      const std::string source =
+          StringPrintf("http://www.example.com/r/%d", i);
+      const std::string target =
+          StringPrintf("http://www.example.com/r/%d/target.png", i);
+      builder_.NewRedirectedPngResource(source, target, builder_.body())
+          ->SetResponseBody(png_body);
+    }
+
+    builder_.pagespeed_input()->SetOnloadTimeMillis(1000);
+    builder_.pagespeed_input()->SetViewportWidthAndHeight(1024, 768);
+    return builder_.Freeze();
+  }
+
+  const pagespeed::PagespeedInput* input() {
+    return builder_.pagespeed_input();
+  }
+
+ private:
+  pagespeed_testing::PagespeedInputBuilder builder_;
+
+  DISALLOW_COPY_AND_ASSIGN(RulesBenchmarkCorpus);
+};
+
+// Times one rule's AppendResults over the corpus.  The corpus and the
+// RuleInput are built outside the timed region.
+class AppendResultsBenchmark : public pagespeed_testing::Benchmark {
+ public:
+  // Takes ownership of rule.
+  explicit AppendResultsBenchmark(pagespeed::Rule* rule)
+      : Benchmark(std::string("BM_AppendResults/") + rule->name()),
+        rule_(rule) {}
+
+  virtual void Run(BenchmarkState* state) {
+    RulesBenchmarkCorpus corpus;
+    if (!corpus.Build()) {
+      state->SetError("Unable to build the corpus");
+      return;
+    }
+    pagespeed::RuleInput rule_input(*corpus.input());
+    rule_input.Init();
+
+    state->ResetTiming();
+    for (int i = 0; i < state->iterations(); ++i) {
+      pagespeed::RuleResults rule_results;
+      pagespeed::ResultProvider provider(*rule_, &rule_results, 0);
+      if (!rule_->AppendResults(rule_input, &provider)) {
+        state->SetError("AppendResults failed");
+        return;
+      }
+    }
+  }
+
+ private:
+  scoped_ptr<pagespeed::Rule> rule_;
+
+  DISALLOW_COPY_AND_ASSIGN(AppendResultsBenchmark);
+};
+
+class AppendResultsBenchmarkRegisterer {
+ public:
+  AppendResultsBenchmarkRegisterer() {
+    std::vector<pagespeed::Rule*> rules;
+    pagespeed::rule_provider::AppendAllRules(false, &rules);
+    for (std::vector<pagespeed::Rule*>::const_iterator it = rules.begin();
+         it != rules.end(); ++it) {
+      pagespeed_testing::RegisterBenchmark(new AppendResultsBenchmark(*it));
+    }
+  }
+};
+
+AppendResultsBenchmarkRegisterer g_append_results_registerer;
+
+// Computes the corpus results with all rules, and collects the localizers
+// the formatting benchmarks render them into: English plus every registered
+// gettext locale.
+class FormatResultsBenchmarkSetup {
+ public:
+  FormatResultsBenchmarkSetup() {
+    std::vector<pagespeed::Rule*> rules;
+    pagespeed::rule_provider::AppendAllRules(false, &rules);
+    engine_.reset(new pagespeed::Engine(&rules));
+    engine_->Init();
+
+    localizers_.push_back(&basic_localizer_);
+    std::vector<std::string> locales;
+    pagespeed::l10n::RegisterLocale::GetAllLocales(&locales);
+    for (std::vector<std::string>::const_iterator it = locales.begin();
+         it != locales.end(); ++it) {
+      const pagespeed::l10n::Localizer* localizer =
+          pagespeed::l10n::GettextLocalizer::GetShared(*it);
+      if (localizer != NULL) {
+        localizers_.push_back(localizer);
+      }
+    }
+  }
+
+  bool ComputeResults() {
+    RulesBenchmarkCorpus corpus;
+    return corpus.Build() &&
+        engine_->ComputeResults(*corpus.input(), &results_);
+  }
+
+  const pagespeed::Engine& engine() const { return *engine_; }
+  const pagespeed::Results& results() const { return results_; }
+  const std::vector<const pagespeed::l10n::Localizer*>& localizers() const {
+    return localizers_;
+  }
+
+ private:
+  scoped_ptr<pagespeed::Engine> engine_;
+  pagespeed::Results results_;
+  pagespeed::l10n::BasicLocalizer basic_localizer_;
+  std::vector<const pagespeed::l10n::Localizer*> localizers_;
+
+  DISALLOW_COPY_AND_ASSIGN(FormatResultsBenchmarkSetup);
+};
+
+// Renders the results once per locale, with one FormatResults pass each.
+PAGESPEED_BENCHMARK(BM_FormatResults_ProtoFormatterPerLocale) {
+  FormatResultsBenchmarkSetup setup;
+  if (!setup.ComputeResults()) {
+    state->SetError("ComputeResults failed");
+    return;
+  }
+  state->ResetTiming();
+  for (int i = 0; i < state->iterations(); ++i) {
+    for (size_t j = 0; j < setup.localizers().size(); ++j) {
+      pagespeed::FormattedResults formatted_results;
+      formatted_results.set_locale(setup.localizers()[j]->GetLocale());
+      pagespeed::formatters::ProtoFormatter formatter(
+          setup.localizers()[j], &formatted_results);
+      if (!setup.engine().FormatResults(setup.results(), &formatter)) {
+        state->SetError("FormatResults failed");
+        return;
+      }
+    }
+  }
+}
+
+// Renders the same results with a single FormatResults pass, localized once
+// per locale.
+PAGESPEED_BENCHMARK(BM_FormatResults_MultiLocaleProtoFormatter) {
+  FormatResultsBenchmarkSetup setup;
+  if (!setup.ComputeResults()) {
+    state->SetError("ComputeResults failed");
+    return;
+  }
+  state->ResetTiming();
+  for (int i = 0; i < state->iterations(); ++i) {
+    pagespeed::formatters::MultiLocaleProtoFormatter formatter;
+    if (!setup.engine().FormatResults(setup.results(), &formatter)) {
+      state->SetError("FormatResults failed");
+      return;
+    }
+    for (size_t j = 0; j < setup.localizers().size(); ++j) {
+      pagespeed::FormattedResults formatted_results;
+      if (!formatter.Localize(setup.localizers()[j], &formatted_results)) {
+        state->SetError("Localize failed");
+        return;
+      }
+    }
+  }
+}
+
+}  // namespace
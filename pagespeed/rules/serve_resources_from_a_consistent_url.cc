@@ -14,13 +14,14 @@
 
 #include "pagespeed/rules/serve_resources_from_a_consistent_url.h"
 
-#include <map>
+#include <algorithm>
 #include <string>
 #include <vector>
 
 #include "pagespeed/core/formatter.h"
 #include "pagespeed/core/pagespeed_input.h"
 #include "pagespeed/core/resource.h"
+#include "pagespeed/core/resource_collection.h"
 #include "pagespeed/core/resource_util.h"
 #include "pagespeed/core/result_provider.h"
 #include "pagespeed/core/rule_input.h"
@@ -32,22 +33,49 @@ namespace {
 static const char* kCrossDomainXmlSuffix = "/crossdomain.xml";
 static const size_t kCrossDomainXmlSuffixLen = strlen(kCrossDomainXmlSuffix);
 
-struct ResourceBodyLessThan {
-  bool operator()(const std::string* a,
-                  const std::string* b) const {
-    if (a->size() != b->size()) {
+// Orders groups of identical resources by the size of their common body,
+// then by its contents.  Only group representatives are compared, once
+// each, when sorting the results.
+struct ResourceSetBodyLessThan {
+  bool operator()(const pagespeed::ResourceSet* a,
+                  const pagespeed::ResourceSet* b) const {
+    const std::string& a_body = (*a->begin())->GetResponseBody();
+    const std::string& b_body = (*b->begin())->GetResponseBody();
+    if (a_body.size() != b_body.size()) {
       // If the sizes differ, compare based on size. Comparing size is
       // more efficient than comparing actual string contents.
-      return a->size() < b->size();
+      return a_body.size() < b_body.size();
     }
-    return *a < *b;
+    return a_body < b_body;
   }
 };
 
-// Map of ResourceSets, keyed by Resource bodies.
-typedef std::map<const std::string*,
-                 pagespeed::ResourceSet,
-                 ResourceBodyLessThan> ResourcesWithSameBodyMap;
+bool IsCandidateResource(const pagespeed::PagespeedInput& input,
+                         const pagespeed::Resource& resource) {
+  if (resource.GetResourceType() == pagespeed::OTHER ||
+      resource.GetResourceType() == pagespeed::REDIRECT) {
+    // Don't process resource types that we don't explicitly care
+    // about.
+    return false;
+  }
+  if (pagespeed::resource_util::IsLikelyTrackingPixel(input, resource)) {
+    // Skip over tracking pixels.
+    return false;
+  }
+  const std::string& url = resource.GetRequestUrl();
+  if (kCrossDomainXmlSuffixLen <= url.size()) {
+    const size_t offset = url.size() - kCrossDomainXmlSuffixLen;
+    if (url.find(kCrossDomainXmlSuffix, offset) == offset) {
+      // Looks like an Adobe crossdomain.xml resource, which may be
+      // hosted on different domains in order to enable cross-domain
+      // communication in Flash, so skip it. See
+      // http://kb2.adobe.com/cps/142/tn_14213.html for more
+      // information.
+      return false;
+    }
+  }
+  return true;
+}
 
 }  // namespace
 
@@ -75,61 +103,76 @@ UserFacingString ServeResourcesFromAConsistentUrl::header() const {
 bool ServeResourcesFromAConsistentUrl::
 AppendResults(const RuleInput& rule_input, ResultProvider* provider) {
   const PagespeedInput& input = rule_input.pagespeed_input();
-  ResourcesWithSameBodyMap map;
-  for (int idx = 0, num = input.num_resources(); idx < num; ++idx) {
-    const Resource& resource = input.GetResource(idx);
-    if (resource.GetResourceType() == OTHER ||
-        resource.GetResourceType() == REDIRECT) {
-      // Don't process resource types that we don't explicitly care
-      // about.
-      continue;
-    }
-    if (resource.GetResponseBody().empty()) {
-      // Exclude responses with empty bodies.
+  const BodyHashResourceMap* body_hash_map =
+      input.GetResourceCollection().GetBodyHashResourceMap();
+
+  // Resources with empty bodies are not in the body hash map, so they are
+  // excluded here.  Only resources whose bodies hash equally need their
+  // bodies compared, which guards against hash collisions.
+  std::vector<ResourceSet> groups;
+  for (BodyHashResourceMap::const_iterator hash_iter = body_hash_map->begin(),
+           hash_iter_end = body_hash_map->end();
+       hash_iter != hash_iter_end;
+       ++hash_iter) {
+    const ResourceVector& same_hash = hash_iter->second;
+    if (same_hash.size() < 2) {
       continue;
     }
-    if (resource_util::IsLikelyTrackingPixel(input, resource)) {
-      // Skip over tracking pixels.
-      continue;
-    }
-    const std::string& url = resource.GetRequestUrl();
-    if (kCrossDomainXmlSuffixLen <= url.size()) {
-      const size_t offset = url.size() - kCrossDomainXmlSuffixLen;
-      if (url.find(kCrossDomainXmlSuffix, offset) == offset) {
-        // Looks like an Adobe crossdomain.xml resource, which may be
-        // hosted on different domains in order to enable cross-domain
-        // communication in Flash, so skip it. See
-        // http://kb2.adobe.com/cps/142/tn_14213.html for more
-        // information.
+    const size_t first_group = groups.size();
+    for (ResourceVector::const_iterator it = same_hash.begin(),
+             end = same_hash.end();
+         it != end;
+         ++it) {
+      const Resource& resource = **it;
+      if (!IsCandidateResource(input, resource)) {
         continue;
       }
+      size_t group = first_group;
+      for (; group < groups.size(); ++group) {
+        if ((*groups[group].begin())->GetResponseBody() ==
+            resource.GetResponseBody()) {
+          break;
+        }
+      }
+      if (group == groups.size()) {
+        groups.push_back(ResourceSet());
+      }
+      groups[group].insert(&resource);
     }
-    map[&resource.GetResponseBody()].insert(&resource);
   }
 
-  for (ResourcesWithSameBodyMap::const_iterator map_iter = map.begin(),
-           map_iter_end = map.end();
-       map_iter != map_iter_end;
-       ++map_iter) {
-    const ResourceSet &resources = map_iter->second;
-    if (resources.size() > 1) {
-      Result* result = provider->NewResult();
-      const Resource &first_resource = **resources.begin();
-      const int requests_saved = resources.size() - 1;
-      const int response_bytes_saved =
-          (first_resource.GetResponseBody().size() * requests_saved);
-
-      Savings* savings = result->mutable_savings();
-      savings->set_requests_saved(requests_saved);
-      savings->set_response_bytes_saved(response_bytes_saved);
-
-      for (ResourceSet::const_iterator resource_iter = resources.begin(),
-               resource_iter_end = resources.end();
-           resource_iter != resource_iter_end;
-           ++resource_iter) {
-        const Resource &resource = **resource_iter;
-        result->add_resource_urls(resource.GetRequestUrl());
-      }
+  std::vector<const ResourceSet*> duplicates;
+  for (std::vector<ResourceSet>::const_iterator it = groups.begin(),
+           end = groups.end();
+       it != end;
+       ++it) {
+    if (it->size() > 1) {
+      duplicates.push_back(&*it);
+    }
+  }
+  std::sort(duplicates.begin(), duplicates.end(), ResourceSetBodyLessThan());
+
+  for (std::vector<const ResourceSet*>::const_iterator
+           dup_iter = duplicates.begin(), dup_iter_end = duplicates.end();
+       dup_iter != dup_iter_end;
+       ++dup_iter) {
+    const ResourceSet &resources = **dup_iter;
+    Result* result = provider->NewResult();
+    const Resource &first_resource = **resources.begin();
+    const int requests_saved = resources.size() - 1;
+    const int response_bytes_saved =
+        (first_resource.GetResponseBody().size() * requests_saved);
+
+    Savings* savings = result->mutable_savings();
+    savings->set_requests_saved(requests_saved);
+    savings->set_response_bytes_saved(response_bytes_saved);
+
+    for (ResourceSet::const_iterator resource_iter = resources.begin(),
+             resource_iter_end = resources.end();
+         resource_iter != resource_iter_end;
+         ++resource_iter) {
+      const Resource &resource = **resource_iter;
+      result->add_resource_urls(resource.GetRequestUrl());
     }
   }
 
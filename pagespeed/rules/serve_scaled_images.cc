@@ -121,7 +121,7 @@ void ImageData::Update(int actual_width, int actual_height,
 
 typedef std::map<std::string, ImageData*> ImageDataMap;
 
-class ScaledImagesChecker : public pagespeed::DomElementVisitor {
+class ScaledImagesChecker : public pagespeed::DomTraversalVisitor {
  public:
   // Ownership of document and image_data_map are _not_ transfered to the
   // ScaledImagesChecker.
@@ -132,8 +132,11 @@ class ScaledImagesChecker : public pagespeed::DomElementVisitor {
         image_data_map_(image_data_map) {}
 
   virtual void Visit(const pagespeed::DomElement& node);
+  virtual pagespeed::DomTraversalVisitor* VisitContentDocument(
+      const pagespeed::DomElement& node,
+      const pagespeed::DomDocument& document);
 
- private:
+ protected:
   const pagespeed::RuleInput* rule_input_;
   const pagespeed::DomDocument* document_;
   ImageDataMap* image_data_map_;
@@ -178,58 +181,58 @@ void ScaledImagesChecker::Visit(const pagespeed::DomElement& node) {
         }
       }
     }
-  } else if (node.GetTagName() == "IFRAME") {
-    // Do a recursive document traversal.
-    scoped_ptr<pagespeed::DomDocument> child_doc(node.GetContentDocument());
-    if (child_doc.get()) {
-      ScaledImagesChecker checker(rule_input_, child_doc.get(),
-                                  image_data_map_);
-      child_doc->Traverse(&checker);
-    }
   }
 }
 
-}  // namespace
+pagespeed::DomTraversalVisitor* ScaledImagesChecker::VisitContentDocument(
+    const pagespeed::DomElement& node,
+    const pagespeed::DomDocument& document) {
+  return new ScaledImagesChecker(rule_input_, &document, image_data_map_);
+}
 
-namespace pagespeed {
+void AppendScaledImageResults(const pagespeed::RuleInput& rule_input,
+                              bool is_responsive,
+                              const ImageDataMap& image_data_map,
+                              pagespeed::ResultProvider* provider);
 
-namespace rules {
+// The ScaledImagesChecker for the root document. It owns the ImageDataMap
+// shared by the checkers of all documents, and generates the results once
+// the whole DOM has been visited.
+class RootScaledImagesChecker : public ScaledImagesChecker {
+ public:
+  RootScaledImagesChecker(const pagespeed::RuleInput* rule_input,
+                          const pagespeed::DomDocument* document,
+                          pagespeed::ResultProvider* provider)
+      : ScaledImagesChecker(rule_input, document, &root_image_data_map_),
+        provider_(provider) {}
+
+  virtual ~RootScaledImagesChecker() {
+    STLDeleteContainerPairSecondPointers(root_image_data_map_.begin(),
+                                         root_image_data_map_.end());
+  }
 
-ServeScaledImages::ServeScaledImages()
-    : pagespeed::Rule(pagespeed::InputCapabilities(
-        pagespeed::InputCapabilities::DOM |
-        pagespeed::InputCapabilities::RESPONSE_BODY)) {}
+  virtual void Finish() {
+    AppendScaledImageResults(*rule_input_, document_->IsResponsive(),
+                             root_image_data_map_, provider_);
+  }
 
-const char* ServeScaledImages::name() const {
-  return "ServeScaledImages";
-}
+ private:
+  ImageDataMap root_image_data_map_;
+  pagespeed::ResultProvider* provider_;
 
-UserFacingString ServeScaledImages::header() const {
-  // TRANSLATOR: The name of a Page Speed rule that is triggered when users
-  // serve images, then rescale them in HTML or CSS to the final size (it is
-  // more efficient to serve the image with the dimensions it will be shown at).
-  // This is displayed at the top of a list of rules names that Page Speed
-  // generates.
-  return _("Serve scaled images");
-}
+  DISALLOW_COPY_AND_ASSIGN(RootScaledImagesChecker);
+};
 
-bool ServeScaledImages::AppendResults(const RuleInput& rule_input,
-                                      ResultProvider* provider) {
-  // TODO Consider adding the ability to perform the resizing and provide
-  //      the resized image file to the user.
+void AppendScaledImageResults(const pagespeed::RuleInput& rule_input,
+                              bool is_responsive,
+                              const ImageDataMap& image_data_map,
+                              pagespeed::ResultProvider* provider) {
+  using pagespeed::PagespeedInput;
+  using pagespeed::Resource;
+  using pagespeed::Result;
+  using pagespeed::Savings;
 
   const PagespeedInput& input = rule_input.pagespeed_input();
-  const DomDocument* document = input.dom_document();
-  if (!document) {
-    return true;
-  }
-
-  bool ok = true;
-  bool is_responsive = document->IsResponsive();
-  ImageDataMap image_data_map;
-  ScaledImagesChecker visitor(&rule_input, document, &image_data_map);
-  document->Traverse(&visitor);
-
   typedef std::map<const std::string, int> OriginalSizesMap;
   OriginalSizesMap original_sizes_map;
   for (int idx = 0, num = input.num_resources(); idx < num; ++idx) {
@@ -283,11 +286,43 @@ bool ServeScaledImages::AppendResults(const RuleInput& rule_input,
     image_details->set_actual_height(image_data->client_height());
     image_details->set_actual_width(image_data->client_width());
   }
+}
+
+}  // namespace
+
+namespace pagespeed {
+
+namespace rules {
 
-  STLDeleteContainerPairSecondPointers(image_data_map.begin(),
-                                       image_data_map.end());
+ServeScaledImages::ServeScaledImages()
+    : pagespeed::Rule(pagespeed::InputCapabilities(
+        pagespeed::InputCapabilities::DOM |
+        pagespeed::InputCapabilities::RESPONSE_BODY)) {}
+
+const char* ServeScaledImages::name() const {
+  return "ServeScaledImages";
+}
+
+UserFacingString ServeScaledImages::header() const {
+  // TRANSLATOR: The name of a Page Speed rule that is triggered when users
+  // serve images, then rescale them in HTML or CSS to the final size (it is
+  // more efficient to serve the image with the dimensions it will be shown at).
+  // This is displayed at the top of a list of rules names that Page Speed
+  // generates.
+  return _("Serve scaled images");
+}
+
+bool ServeScaledImages::AppendResults(const RuleInput& rule_input,
+                                      ResultProvider* provider) {
+  // TODO Consider adding the ability to perform the resizing and provide
+  //      the resized image file to the user.
+  return AppendResultsFromDomVisitor(rule_input, provider);
+}
 
-  return ok;
+DomTraversalVisitor* ServeScaledImages::NewDomVisitor(
+    const RuleInput& rule_input, ResultProvider* provider) {
+  return new RootScaledImagesChecker(
+      &rule_input, rule_input.pagespeed_input().dom_document(), provider);
 }
 
 void ServeScaledImages::FormatResults(const ResultVector& results,
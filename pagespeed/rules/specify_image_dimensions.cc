@@ -34,7 +34,7 @@ namespace {
 
 const char* kRuleName = "SpecifyImageDimensions";
 
-class ImageDimensionsChecker : public pagespeed::DomElementVisitor {
+class ImageDimensionsChecker : public pagespeed::DomTraversalVisitor {
  public:
   ImageDimensionsChecker(const pagespeed::RuleInput* rule_input,
                          const pagespeed::DomDocument* document,
@@ -42,6 +42,9 @@ class ImageDimensionsChecker : public pagespeed::DomElementVisitor {
       : rule_input_(rule_input), document_(document), provider_(provider) {}
 
   virtual void Visit(const pagespeed::DomElement& node);
+  virtual pagespeed::DomTraversalVisitor* VisitContentDocument(
+      const pagespeed::DomElement& node,
+      const pagespeed::DomDocument& document);
 
  private:
   const pagespeed::RuleInput* rule_input_;
@@ -105,17 +108,15 @@ void ImageDimensionsChecker::Visit(const pagespeed::DomElement& node) {
         }
       }
     }
-  } else if (node.GetTagName() == "IFRAME") {
-    // Do a recursive document traversal.
-    scoped_ptr<pagespeed::DomDocument> child_doc(node.GetContentDocument());
-    if (child_doc.get()) {
-      ImageDimensionsChecker checker(rule_input_, child_doc.get(),
-                                     provider_);
-      child_doc->Traverse(&checker);
-    }
   }
 }
 
+pagespeed::DomTraversalVisitor* ImageDimensionsChecker::VisitContentDocument(
+    const pagespeed::DomElement& node,
+    const pagespeed::DomDocument& document) {
+  return new ImageDimensionsChecker(rule_input_, &document, provider_);
+}
+
 // sorts results by their URLs.
 struct ResultUrlLessThan {
   bool operator() (const pagespeed::Result& lhs,
@@ -149,12 +150,13 @@ UserFacingString SpecifyImageDimensions::header() const {
 
 bool SpecifyImageDimensions::AppendResults(const RuleInput& rule_input,
                                            ResultProvider* provider) {
-  const DomDocument* document = rule_input.pagespeed_input().dom_document();
-  if (document) {
-    ImageDimensionsChecker visitor(&rule_input, document, provider);
-    document->Traverse(&visitor);
-  }
-  return true;
+  return AppendResultsFromDomVisitor(rule_input, provider);
+}
+
+DomTraversalVisitor* SpecifyImageDimensions::NewDomVisitor(
+    const RuleInput& rule_input, ResultProvider* provider) {
+  return new ImageDimensionsChecker(
+      &rule_input, rule_input.pagespeed_input().dom_document(), provider);
 }
 
 void SpecifyImageDimensions::FormatResults(const ResultVector& results,
@@ -33,6 +33,8 @@ class SpecifyImageDimensions : public Rule {
   virtual const char* name() const;
   virtual UserFacingString header() const;
   virtual bool AppendResults(const RuleInput& input, ResultProvider* provider);
+  virtual DomTraversalVisitor* NewDomVisitor(const RuleInput& input,
+                                             ResultProvider* provider);
   virtual void FormatResults(const ResultVector& results,
                              RuleFormatter* formatter);
 
@@ -115,7 +115,7 @@ bool SpriteImages::AppendResults(const RuleInput& rule_input,
     }
 
     std::string domain =
-        uri_util::GetDomainAndRegistry(resource.GetRequestUrl());
+        uri_util::GetDomainAndRegistry(input, resource);
     if (domain.empty()) {
       LOG(INFO) << "Got empty domain for " << resource.GetRequestUrl();
       continue;
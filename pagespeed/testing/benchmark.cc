@@ -0,0 +1,245 @@
+// Copyright 2013 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pagespeed/testing/benchmark.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "base/logging.h"
+#include "pagespeed/core/allocation_counter.h"
+#include "pagespeed/core/string_util.h"
+
+namespace {
+
+// Never run a benchmark more often than this, however fast it is.
+const int kMaxIterations = 1000000000;
+
+class FunctionBenchmark : public pagespeed_testing::Benchmark {
+ public:
+  FunctionBenchmark(const char* name,
+                    pagespeed_testing::BenchmarkFunction function)
+      : Benchmark(name), function_(function) {}
+
+  virtual void Run(pagespeed_testing::BenchmarkState* state) {
+    function_(state);
+  }
+
+ private:
+  pagespeed_testing::BenchmarkFunction function_;
+
+  DISALLOW_COPY_AND_ASSIGN(FunctionBenchmark);
+};
+
+std::vector<pagespeed_testing::Benchmark*>* g_benchmarks = NULL;
+
+struct BenchmarkNameLessThan {
+  bool operator()(const pagespeed_testing::Benchmark* a,
+                  const pagespeed_testing::Benchmark* b) const {
+    return a->name() < b->name();
+  }
+};
+
+// Runs the benchmark with increasing iteration counts until a run takes at
+// least min_time_ms.  Returns the state of the final run, which the caller
+// owns.
+pagespeed_testing::BenchmarkState* RunBenchmark(
+    pagespeed_testing::Benchmark* benchmark, int min_time_ms) {
+  const int64 min_time_us = static_cast<int64>(min_time_ms) * 1000;
+  int iterations = 1;
+  while (true) {
+    pagespeed_testing::BenchmarkState* state =
+        new pagespeed_testing::BenchmarkState(iterations);
+    benchmark->Run(state);
+    state->Finish();
+    const int64 elapsed_us = state->elapsed_microseconds();
+    if (!state->error().empty() || elapsed_us >= min_time_us ||
+        iterations >= kMaxIterations) {
+      return state;
+    }
+    delete state;
+
+    // Predict the iterations needed from this run, overshooting a little
+    // so that the next run is likely to be the last, but never growing by
+    // more than 10x at once since short runs are noisy.
+    int64 next = static_cast<int64>(iterations) * 10;
+    if (elapsed_us > 0) {
+      next = std::min(next, static_cast<int64>(iterations) * min_time_us *
+                      14 / 10 / elapsed_us);
+    }
+    next = std::max(next, static_cast<int64>(iterations) + 1);
+    iterations = static_cast<int>(std::min<int64>(next, kMaxIterations));
+  }
+}
+
+void WriteTextHeader(std::ostream* out) {
+  *out << pagespeed::string_util::StringPrintf(
+      "%-48s %12s %14s %10s %12s\n",
+      "Benchmark", "Iterations", "ns/op", "MB/s", "allocs/op");
+}
+
+void WriteTextResult(const std::string& name,
+                     const pagespeed_testing::BenchmarkState& state,
+                     std::ostream* out) {
+  if (!state.error().empty()) {
+    *out << pagespeed::string_util::StringPrintf(
+        "%-48s ERROR: %s\n", name.c_str(), state.error().c_str());
+    return;
+  }
+  const double iterations = state.iterations();
+  const double elapsed_us = state.elapsed_microseconds();
+  std::string throughput = "-";
+  if (state.bytes_per_iteration() > 0 && elapsed_us > 0) {
+    throughput = pagespeed::string_util::StringPrintf(
+        "%.2f", state.bytes_per_iteration() * iterations / elapsed_us);
+  }
+  *out << pagespeed::string_util::StringPrintf(
+      "%-48s %12d %14.1f %10s %12.1f\n",
+      name.c_str(), state.iterations(), elapsed_us * 1000.0 / iterations,
+      throughput.c_str(), state.allocations() / iterations);
+}
+
+void WriteCsvHeader(std::ostream* out) {
+  *out << "name,iterations,ns_per_op,mb_per_s,allocs_per_op,error\n";
+}
+
+void WriteCsvResult(const std::string& name,
+                    const pagespeed_testing::BenchmarkState& state,
+                    std::ostream* out) {
+  // Benchmark names are identifiers, so they need no quoting.  Errors are
+  // free text, so commas and quotes in them are replaced.
+  if (!state.error().empty()) {
+    std::string error = state.error();
+    std::replace(error.begin(), error.end(), ',', ';');
+    std::replace(error.begin(), error.end(), '"', '\'');
+    *out << name << "," << state.iterations() << ",,,," << error << "\n";
+    return;
+  }
+  const double iterations = state.iterations();
+  const double elapsed_us = state.elapsed_microseconds();
+  double throughput = 0.0;
+  if (state.bytes_per_iteration() > 0 && elapsed_us > 0) {
+    throughput = state.bytes_per_iteration() * iterations / elapsed_us;
+  }
+  *out << pagespeed::string_util::StringPrintf(
+      "%s,%d,%.1f,%.3f,%.2f,\n",
+      name.c_str(), state.iterations(), elapsed_us * 1000.0 / iterations,
+      throughput, state.allocations() / iterations);
+}
+
+}  // namespace
+
+namespace pagespeed_testing {
+
+BenchmarkState::BenchmarkState(int iterations)
+    : iterations_(iterations),
+      running_(false),
+      start_allocations_(0),
+      allocations_(0),
+      bytes_per_iteration_(0) {
+  ResumeTiming();
+}
+
+void BenchmarkState::ResetTiming() {
+  elapsed_ = base::TimeDelta();
+  allocations_ = 0;
+  running_ = false;
+  ResumeTiming();
+}
+
+void BenchmarkState::PauseTiming() {
+  if (!running_) {
+    LOG(DFATAL) << "PauseTiming called while paused.";
+    return;
+  }
+  elapsed_ += base::TimeTicks::HighResNow() - start_time_;
+  allocations_ += static_cast<size_t>(pagespeed::GetAllocationCount() -
+                                     start_allocations_);
+  running_ = false;
+}
+
+void BenchmarkState::ResumeTiming() {
+  if (running_) {
+    LOG(DFATAL) << "ResumeTiming called while running.";
+    return;
+  }
+  running_ = true;
+  start_allocations_ = pagespeed::GetAllocationCount();
+  start_time_ = base::TimeTicks::HighResNow();
+}
+
+void BenchmarkState::Finish() {
+  if (running_) {
+    PauseTiming();
+  }
+}
+
+void RegisterBenchmark(Benchmark* benchmark) {
+  if (g_benchmarks == NULL) {
+    g_benchmarks = new std::vector<Benchmark*>;
+  }
+  g_benchmarks->push_back(benchmark);
+}
+
+BenchmarkRegisterer::BenchmarkRegisterer(const char* name,
+                                         BenchmarkFunction function) {
+  RegisterBenchmark(new FunctionBenchmark(name, function));
+}
+
+bool RunBenchmarks(const std::string& filter,
+                   const std::string& format,
+                   int min_time_ms,
+                   std::ostream* out) {
+  const bool csv = (format == "csv");
+  if (!csv && format != "text") {
+    LOG(ERROR) << "Unknown benchmark output format " << format;
+    return false;
+  }
+  if (g_benchmarks == NULL) {
+    return true;
+  }
+  pagespeed::EnableAllocationCounting();
+
+  std::vector<Benchmark*> benchmarks(*g_benchmarks);
+  std::sort(benchmarks.begin(), benchmarks.end(), BenchmarkNameLessThan());
+  if (csv) {
+    WriteCsvHeader(out);
+  } else {
+    WriteTextHeader(out);
+  }
+  bool success = true;
+  for (std::vector<Benchmark*>::const_iterator it = benchmarks.begin(),
+           end = benchmarks.end();
+       it != end;
+       ++it) {
+    Benchmark* benchmark = *it;
+    if (benchmark->name().find(filter) == std::string::npos) {
+      continue;
+    }
+    BenchmarkState* state = RunBenchmark(benchmark, min_time_ms);
+    if (!state->error().empty()) {
+      success = false;
+    }
+    if (csv) {
+      WriteCsvResult(benchmark->name(), *state, out);
+    } else {
+      WriteTextResult(benchmark->name(), *state, out);
+    }
+    out->flush();
+    delete state;
+  }
+  return success;
+}
+
+}  // namespace pagespeed_testing
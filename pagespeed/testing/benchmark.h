@@ -0,0 +1,135 @@
+// Copyright 2013 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PAGESPEED_TESTING_BENCHMARK_H_
+#define PAGESPEED_TESTING_BENCHMARK_H_
+
+#include <ostream>
+#include <string>
+
+#include "base/basictypes.h"
+#include "base/time.h"
+
+namespace pagespeed_testing {
+
+/**
+ * Passed to each benchmark run.  A benchmark runs its operation
+ * iterations() times; everything it does is timed unless excluded with
+ * ResetTiming or PauseTiming/ResumeTiming.
+ */
+class BenchmarkState {
+ public:
+  explicit BenchmarkState(int iterations);
+
+  int iterations() const { return iterations_; }
+
+  // Discards the time and allocations measured so far.  Call this once
+  // setup is done, just before the timed loop.
+  void ResetTiming();
+
+  // Excludes the work between the two calls from the measurement.
+  void PauseTiming();
+  void ResumeTiming();
+
+  // The number of input bytes processed by each iteration, used to report
+  // throughput.
+  void SetBytesPerIteration(int64 bytes) { bytes_per_iteration_ = bytes; }
+
+  // Marks the benchmark as failed.  The benchmark should return promptly
+  // after calling this; no measurements are reported for it.
+  void SetError(const std::string& error) { error_ = error; }
+
+  // Called by the runner once the benchmark returns.
+  void Finish();
+
+  int64 elapsed_microseconds() const { return elapsed_.InMicroseconds(); }
+  int64 allocations() const { return allocations_; }
+  int64 bytes_per_iteration() const { return bytes_per_iteration_; }
+  const std::string& error() const { return error_; }
+
+ private:
+  const int iterations_;
+  bool running_;
+  base::TimeTicks start_time_;
+  base::TimeDelta elapsed_;
+  size_t start_allocations_;
+  int64 allocations_;
+  int64 bytes_per_iteration_;
+  std::string error_;
+
+  DISALLOW_COPY_AND_ASSIGN(BenchmarkState);
+};
+
+/**
+ * A named, repeatable measurement.  Most benchmarks are plain functions
+ * declared with PAGESPEED_BENCHMARK; subclass this directly to register
+ * families of benchmarks at startup.
+ */
+class Benchmark {
+ public:
+  explicit Benchmark(const std::string& name) : name_(name) {}
+  virtual ~Benchmark() {}
+
+  const std::string& name() const { return name_; }
+
+  // Runs the operation under test state->iterations() times.
+  virtual void Run(BenchmarkState* state) = 0;
+
+ private:
+  const std::string name_;
+
+  DISALLOW_COPY_AND_ASSIGN(Benchmark);
+};
+
+typedef void (*BenchmarkFunction)(BenchmarkState* state);
+
+// Registers a benchmark to be run by RunBenchmarks.  Ownership is
+// transferred.  Normally called from static initializers.
+void RegisterBenchmark(Benchmark* benchmark);
+
+class BenchmarkRegisterer {
+ public:
+  BenchmarkRegisterer(const char* name, BenchmarkFunction function);
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(BenchmarkRegisterer);
+};
+
+// Runs each registered benchmark whose name contains filter, with enough
+// iterations to take at least min_time_ms, and writes one line per
+// benchmark to out.  format is "text" for a human-readable table or "csv"
+// for machine-readable output.  Returns false if any benchmark failed.
+bool RunBenchmarks(const std::string& filter,
+                   const std::string& format,
+                   int min_time_ms,
+                   std::ostream* out);
+
+}  // namespace pagespeed_testing
+
+// Defines a benchmark function and registers it under its own name:
+//
+//   PAGESPEED_BENCHMARK(BM_MinifyJs) {
+//     ... setup ...
+//     state->ResetTiming();
+//     for (int i = 0; i < state->iterations(); ++i) {
+//       ... operation under test ...
+//     }
+//   }
+#define PAGESPEED_BENCHMARK(name)                                       \
+  static void name(::pagespeed_testing::BenchmarkState* state);         \
+  static ::pagespeed_testing::BenchmarkRegisterer name##_registerer(    \
+      #name, name);                                                     \
+  static void name(::pagespeed_testing::BenchmarkState* state)
+
+#endif  // PAGESPEED_TESTING_BENCHMARK_H_
@@ -0,0 +1,64 @@
+// Copyright 2013 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <iostream>
+
+#include "base/at_exit.h"
+#include "google/protobuf/stubs/common.h"
+#include "pagespeed/core/pagespeed_init.h"
+#include "pagespeed/testing/benchmark.h"
+#include "third_party/gflags/src/google/gflags.h"
+
+DEFINE_string(benchmark_filter, "",
+              "Only run benchmarks whose names contain this string.");
+DEFINE_string(benchmark_format, "text",
+              "Output format: 'text' for a table, 'csv' for "
+              "machine-readable output.");
+DEFINE_int32(benchmark_min_time_ms, 500,
+             "Run each benchmark for at least this many milliseconds.");
+
+namespace {
+
+// Helper class that will run our exit functions in its destructor.  See
+// pagespeed_test_main.cc.
+class ScopedShutDown {
+ public:
+  ~ScopedShutDown() {
+    pagespeed::ShutDown();
+    ::google::protobuf::ShutdownProtobufLibrary();
+    ::google::ShutDownCommandLineFlags();
+  }
+};
+
+ScopedShutDown g_shutdown;
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  // Some of our code uses Singleton<>s, which require an
+  // AtExitManager to schedule their destruction.
+  base::AtExitManager at_exit_manager;
+
+  if (!pagespeed::Init()) {
+    std::cerr << "Failed to initialize PageSpeed. Aborting." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  ::google::SetUsageMessage("Runner for Page Speed benchmarks.");
+  ::google::ParseCommandLineFlags(&argc, &argv, true);
+  const bool success = pagespeed_testing::RunBenchmarks(
+      FLAGS_benchmark_filter, FLAGS_benchmark_format,
+      FLAGS_benchmark_min_time_ms, &std::cout);
+  return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
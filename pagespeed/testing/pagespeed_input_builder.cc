@@ -0,0 +1,209 @@
+// Copyright 2013 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pagespeed/testing/pagespeed_input_builder.h"
+
+#include "base/logging.h"
+#include "base/stl_util.h"
+#include "pagespeed/core/browsing_context.h"
+#include "pagespeed/core/resource.h"
+
+namespace pagespeed_testing {
+
+pagespeed::ImageAttributes* FakeImageAttributesFactory::NewImageAttributes(
+    const pagespeed::Resource* resource) const {
+  ResourceSizeMap::const_iterator c_it = resource_size_map_.find(resource);
+  if (c_it == resource_size_map_.end()) {
+    return NULL;
+  } else {
+    return new pagespeed::ConcreteImageAttributes(c_it->second.first,
+                                                  c_it->second.second);
+  }
+}
+
+PagespeedInputBuilder::PagespeedInputBuilder()
+    : pagespeed_input_(new pagespeed::PagespeedInput()),
+      primary_resource_(NULL),
+      document_(NULL),
+      html_(NULL),
+      head_(NULL),
+      body_(NULL) {
+}
+
+PagespeedInputBuilder::~PagespeedInputBuilder() {
+  STLDeleteContainerPointers(instrumentation_data_.begin(),
+                             instrumentation_data_.end());
+}
+
+bool PagespeedInputBuilder::Freeze() {
+  if (!pagespeed_input_->AcquireInstrumentationData(&instrumentation_data_)) {
+    return false;
+  }
+  return pagespeed_input_->Freeze();
+}
+
+pagespeed::PagespeedInput* PagespeedInputBuilder::ReleasePagespeedInput() {
+  primary_resource_ = NULL;
+  document_ = NULL;
+  html_ = NULL;
+  head_ = NULL;
+  body_ = NULL;
+  return pagespeed_input_.release();
+}
+
+pagespeed::Resource* PagespeedInputBuilder::NewResource(const std::string& url,
+                                                        int status_code) {
+  pagespeed::Resource* resource = new pagespeed::Resource();
+  resource->SetRequestUrl(url);
+  resource->SetRequestMethod("GET");
+  resource->SetResponseStatusCode(status_code);
+  if (!pagespeed_input_->AddResource(resource))
+    return NULL; // resource deleted in AddResource
+  return resource;
+}
+
+pagespeed::Resource* PagespeedInputBuilder::NewPrimaryResource(
+    const std::string& url) {
+  DCHECK(document_ == NULL);
+  pagespeed::Resource* resource = New200Resource(url);
+  resource->SetResourceType(pagespeed::HTML);
+  document_ = FakeDomDocument::NewRoot(url);
+  pagespeed_input_->AcquireDomDocument(document_);
+  pagespeed_input_->SetPrimaryResourceUrl(url);
+  primary_resource_ = resource;
+  return resource;
+}
+
+pagespeed::Resource* PagespeedInputBuilder::NewDocumentResource(
+    const std::string& url, FakeDomElement* iframe, FakeDomDocument** out) {
+  pagespeed::Resource* resource = New200Resource(url);
+  resource->SetResourceType(pagespeed::HTML);
+  if (iframe != NULL) {
+    FakeDomDocument* document = FakeDomDocument::New(iframe, url);
+    if (out != NULL) {
+      *out = document;
+    }
+  }
+  return resource;
+}
+
+pagespeed::Resource* PagespeedInputBuilder::New200Resource(
+    const std::string& source) {
+  return NewResource(source, 200);
+}
+
+pagespeed::Resource* PagespeedInputBuilder::New302Resource(
+    const std::string& source, const std::string& destination) {
+  pagespeed::Resource* resource = NewResource(source, 302);
+  resource->AddResponseHeader("Location", destination);
+  return resource;
+}
+
+pagespeed::Resource* PagespeedInputBuilder::NewPngResource(
+    const std::string& url, FakeDomElement* parent, FakeDomElement** out) {
+  pagespeed::Resource* resource = New200Resource(url);
+  resource->AddResponseHeader("Content-Type", "image/png");
+  if (parent != NULL) {
+    FakeDomElement* element = FakeDomElement::NewImg(parent, url);
+    if (out != NULL) {
+      *out = element;
+    }
+  }
+  return resource;
+}
+
+pagespeed::Resource* PagespeedInputBuilder::NewRedirectedPngResource(
+    const std::string& url1,
+    const std::string& url2,
+    FakeDomElement* parent,
+    FakeDomElement** out) {
+  New302Resource(url1, url2);
+  pagespeed::Resource* resource = New200Resource(url2);
+  resource->AddResponseHeader("Content-Type", "image/png");
+  if (parent != NULL) {
+    FakeDomElement* element = FakeDomElement::NewImg(parent, url1);
+    if (out != NULL) {
+      *out = element;
+    }
+  }
+  return resource;
+}
+
+pagespeed::Resource* PagespeedInputBuilder::NewScriptResource(
+    const std::string& url, FakeDomElement* parent, FakeDomElement** out) {
+  pagespeed::Resource* resource = New200Resource(url);
+  resource->SetResourceType(pagespeed::JS);
+  if (parent != NULL) {
+    FakeDomElement* element = FakeDomElement::NewScript(parent, url);
+    if (out != NULL) {
+      *out = element;
+    }
+  }
+  return resource;
+}
+
+pagespeed::Resource* PagespeedInputBuilder::NewCssResource(
+    const std::string& url, FakeDomElement* parent, FakeDomElement** out) {
+  pagespeed::Resource* resource = New200Resource(url);
+  resource->SetResourceType(pagespeed::CSS);
+  if (parent != NULL) {
+    FakeDomElement* element = FakeDomElement::NewLinkStylesheet(parent, url);
+    if (out != NULL) {
+      *out = element;
+    }
+  }
+  return resource;
+}
+
+bool PagespeedInputBuilder::SetTopLevelBrowsingContext(
+    pagespeed::TopLevelBrowsingContext* context) {
+  return pagespeed_input_->AcquireTopLevelBrowsingContext(context);
+}
+
+pagespeed::TopLevelBrowsingContext*
+PagespeedInputBuilder::NewTopLevelBrowsingContext(
+    const pagespeed::Resource* document_resource) {
+  scoped_ptr<pagespeed::TopLevelBrowsingContext> context(
+      new pagespeed::TopLevelBrowsingContext(
+          document_resource, &pagespeed_input_->GetResourceCollection()));
+  if (!SetTopLevelBrowsingContext(context.get())) {
+    return NULL;
+  }
+  return context.release();
+}
+
+void PagespeedInputBuilder::CreateHtmlHeadBodyElements() {
+  DCHECK(document_ != NULL);
+  DCHECK(html_ == NULL && head_ == NULL && body_ == NULL);
+  html_ = FakeDomElement::NewRoot(document_, "html");
+  head_ = FakeDomElement::New(html_, "head");
+  body_ = FakeDomElement::New(html_, "body");
+}
+
+bool PagespeedInputBuilder::AddResource(pagespeed::Resource* resource) {
+  return pagespeed_input_->AddResource(resource);
+}
+
+bool PagespeedInputBuilder::AddFakeImageAttributesFactory(
+    const FakeImageAttributesFactory::ResourceSizeMap& map) {
+  return pagespeed_input_->AcquireImageAttributesFactory(
+      new FakeImageAttributesFactory(map));
+}
+
+void PagespeedInputBuilder::AddInstrumentationData(
+    const pagespeed::InstrumentationData* data) {
+  instrumentation_data_.push_back(data);
+}
+
+}  // namespace pagespeed_testing
@@ -0,0 +1,176 @@
+// Copyright 2013 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PAGESPEED_TESTING_PAGESPEED_INPUT_BUILDER_H_
+#define PAGESPEED_TESTING_PAGESPEED_INPUT_BUILDER_H_
+
+#include <map>
+#include <string>
+#include <utility>
+
+#include "base/basictypes.h"
+#include "base/memory/scoped_ptr.h"
+#include "pagespeed/core/image_attributes.h"
+#include "pagespeed/core/pagespeed_input.h"
+#include "pagespeed/testing/fake_dom.h"
+
+namespace pagespeed {
+class Resource;
+class TopLevelBrowsingContext;
+}  // namespace pagespeed
+
+namespace pagespeed_testing {
+
+class FakeImageAttributesFactory
+    : public pagespeed::ImageAttributesFactory {
+ public:
+  typedef std::map<const pagespeed::Resource*, std::pair<int,int> >
+      ResourceSizeMap;
+  explicit FakeImageAttributesFactory(const ResourceSizeMap& resource_size_map)
+      : resource_size_map_(resource_size_map) {
+  }
+  virtual pagespeed::ImageAttributes* NewImageAttributes(
+      const pagespeed::Resource* resource) const;
+ private:
+  ResourceSizeMap resource_size_map_;
+};
+
+// Builds a PagespeedInput, along with a fake DOM for its primary resource,
+// one resource at a time.  Unlike PagespeedTest, which wraps it, the builder
+// does not depend on gtest, so it can also be used to build pages outside of
+// a running test (e.g. in benchmarks and load generators).  The caller must
+// have an AtExitManager in scope.
+class PagespeedInputBuilder {
+ public:
+  PagespeedInputBuilder();
+  ~PagespeedInputBuilder();
+
+  // Construct a new HTTP GET Resource with the specified URL and
+  // status code, and add that resource to our PagespeedInput.
+  // Return NULL if the resource was unable to be created or added to
+  // the PagespeedInput.
+  pagespeed::Resource* NewResource(const std::string& url, int status_code);
+
+  // Construct the primary resource, an HTTP GET HTML resource with a
+  // 200 status code, and an associated FakeDomDocument, which is
+  // stored as the DOM document of the PagespeedInput. Must only be
+  // called once per builder.
+  pagespeed::Resource* NewPrimaryResource(const std::string& url);
+
+  // Construct an HTTP GET HTML resource with a 200 status code. An
+  // associated FakeDomDocument will be created for this resource,
+  // parented under the specified iframe and returned via the
+  // out_document parameter, if specified.
+  pagespeed::Resource* NewDocumentResource(const std::string& url,
+                                           FakeDomElement* iframe = NULL,
+                                           FakeDomDocument** out = NULL);
+
+  // Construct a new HTTP GET Resource with the specified URL and
+  // a 200 status code, and add that resource to our PagespeedInput.
+  pagespeed::Resource* New200Resource(const std::string& url);
+
+  // Construct a new HTTP GET redirect (302) Resource with the
+  // specified source and destination URLs, and add that resource
+  // to our PagespeedInput.
+  pagespeed::Resource* New302Resource(const std::string& source,
+                                      const std::string& destination);
+
+  // Construct a new HTTP GET image (PNG) resource, and add that
+  // resource to our PagespeedInput. Also create an associated DOM
+  // node, parented under the specified parent, and returned via the
+  // out parameter, if specified.
+  pagespeed::Resource* NewPngResource(const std::string& url,
+                                      FakeDomElement* parent = NULL,
+                                      FakeDomElement** out = NULL);
+
+  // Creates a redirect from url1 to url2 and a PNG at url2, and an IMG
+  // element with src=url1. Returns the PNG resource.
+  pagespeed::Resource* NewRedirectedPngResource(const std::string& url1,
+                                                const std::string& url2,
+                                                FakeDomElement* parent = NULL,
+                                                FakeDomElement** out = NULL);
+
+  // Construct a new HTTP GET script resource, and add that
+  // resource to our PagespeedInput. Also create an associated DOM
+  // node, parented under the specified parent, and returned via the
+  // out parameter, if specified.
+  pagespeed::Resource* NewScriptResource(const std::string& url,
+                                         FakeDomElement* parent = NULL,
+                                         FakeDomElement** out = NULL);
+
+  // Construct a new HTTP GET CSS resource, and add that
+  // resource to our PagespeedInput. Also create an associated DOM
+  // node, parented under the specified parent, and returned via the
+  // out parameter, if specified.
+  pagespeed::Resource* NewCssResource(const std::string& url,
+                                      FakeDomElement* parent = NULL,
+                                      FakeDomElement** out = NULL);
+
+  // Set the top-level browsing context.
+  bool SetTopLevelBrowsingContext(pagespeed::TopLevelBrowsingContext* context);
+
+  // Create a new TopLevelBrowsingContext with the specified document,
+  // and transfer its ownership to the PagespeedInput.
+  pagespeed::TopLevelBrowsingContext* NewTopLevelBrowsingContext(
+      const pagespeed::Resource* document_resource);
+
+  // Construct default html, head, and body DOM elements under the
+  // document. NewPrimaryResource() must be called prior to calling
+  // this method.
+  void CreateHtmlHeadBodyElements();
+
+  // Adds an ImageAttributesFactory to the PagespeedInput that can
+  // returns ImageAttributes according to the ResourceSizeMap.
+  bool AddFakeImageAttributesFactory(
+      const FakeImageAttributesFactory::ResourceSizeMap& map);
+
+  // Adds a root InstrumentationData for the PagespeedInput. Ownership
+  // is transferred to this object until Freeze().
+  void AddInstrumentationData(const pagespeed::InstrumentationData* data);
+
+  // Add a resource that was not constructed using New*Resource.
+  bool AddResource(pagespeed::Resource* resource);
+
+  // Hands the InstrumentationData to the PagespeedInput and freezes
+  // it. Returns false if either step fails.
+  bool Freeze();
+
+  // Transfers ownership of the PagespeedInput to the caller. The
+  // builder must not be used afterwards.
+  pagespeed::PagespeedInput* ReleasePagespeedInput();
+
+  pagespeed::PagespeedInput* pagespeed_input() {
+    return pagespeed_input_.get();
+  }
+  pagespeed::Resource* primary_resource() const { return primary_resource_; }
+  FakeDomDocument* document() { return document_; }
+  FakeDomElement* html() { return html_; }
+  FakeDomElement* head() { return head_; }
+  FakeDomElement* body() { return body_; }
+
+ private:
+  pagespeed::InstrumentationDataVector instrumentation_data_;
+  scoped_ptr<pagespeed::PagespeedInput> pagespeed_input_;
+  pagespeed::Resource* primary_resource_;
+  FakeDomDocument* document_;
+  FakeDomElement* html_;
+  FakeDomElement* head_;
+  FakeDomElement* body_;
+
+  DISALLOW_COPY_AND_ASSIGN(PagespeedInputBuilder);
+};
+
+}  // namespace pagespeed_testing
+
+#endif  // PAGESPEED_TESTING_PAGESPEED_INPUT_BUILDER_H_
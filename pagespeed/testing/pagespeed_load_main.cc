@@ -0,0 +1,296 @@
+// Copyright 2013 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Load generator that analyzes synthetic pages at a target concurrency and
+// reports latency percentiles, throughput and peak memory use.
+
+#include <stdio.h>
+
+#if !defined(_WIN32)
+#include <sys/resource.h>
+#endif
+
+#include <algorithm>
+#include <fstream>
+#include <vector>
+
+#include "base/at_exit.h"
+#include "base/logging.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/stl_util.h"
+#include "base/time.h"
+#include "google/protobuf/stubs/common.h"
+#include "pagespeed/core/engine.h"
+#include "pagespeed/core/pagespeed_init.h"
+#include "pagespeed/core/pagespeed_input.h"
+#include "pagespeed/core/parallel_for.h"
+#include "pagespeed/core/rule.h"
+#include "pagespeed/formatters/proto_formatter.h"
+#include "pagespeed/l10n/localizer.h"
+#include "pagespeed/proto/pagespeed_input.pb.h"
+#include "pagespeed/proto/pagespeed_output.pb.h"
+#include "pagespeed/proto/pagespeed_proto_formatter.pb.h"
+#include "pagespeed/proto/proto_resource_utils.h"
+#include "pagespeed/rules/rule_provider.h"
+#include "pagespeed/testing/pagespeed_test.h"
+#include "pagespeed/testing/synthetic_page.h"
+#include "third_party/gflags/src/google/gflags.h"
+
+DEFINE_int32(concurrency, 4, "Number of pages analyzed at once.");
+DEFINE_int32(pages_per_worker, 20,
+             "Number of analyses each concurrent worker runs.");
+DEFINE_int32(scripts, 20, "Scripts per page.");
+DEFINE_int32(stylesheets, 10, "Stylesheets per page.");
+DEFINE_int32(images, 50, "Images per page.");
+DEFINE_int32(text_body_bytes, 4096,
+             "Approximate size of each HTML, script and stylesheet body.");
+DEFINE_string(image_file, "",
+              "Image to use as the body of every image resource. Defaults "
+              "to a 1x1 PNG.");
+DEFINE_int32(redirect_chains, 2, "Redirect chains per page.");
+DEFINE_int32(redirect_chain_length, 3, "Redirects in each chain.");
+DEFINE_int32(dom_elements, 500,
+             "DIV elements per page, besides those referencing resources.");
+DEFINE_int32(dom_depth, 10, "Maximum nesting depth of the DIV elements.");
+DEFINE_int32(timeline_records, 100, "Top-level timeline records per page.");
+DEFINE_int32(hosts, 4, "Hosts the subresources are spread over.");
+DEFINE_string(write_proto_input, "",
+              "If set, also write the first synthetic page to this path as "
+              "a serialized ProtoInput, for use with pagespeed_bin "
+              "--input_format=proto.");
+DEFINE_int32(rule_budget_ms, 0,
+             "If positive, the wall time each rule may spend on a page "
+             "before it is stopped and reported as an error.");
+DEFINE_int32(analysis_budget_ms, 0,
+             "If positive, the wall time ComputeResults may spend on a "
+             "page before the remaining rules are skipped.");
+
+namespace {
+
+// Helper class that will run our exit functions in its destructor.  See
+// pagespeed_test_main.cc.
+class ScopedShutDown {
+ public:
+  ~ScopedShutDown() {
+    pagespeed::ShutDown();
+    ::google::protobuf::ShutdownProtobufLibrary();
+    ::google::ShutDownCommandLineFlags();
+  }
+};
+
+ScopedShutDown g_shutdown;
+
+// Returns the peak resident set size of the process in bytes, or -1 if it
+// is not available on this platform.
+int64 GetPeakRssBytes() {
+#if defined(_WIN32)
+  return -1;
+#else
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) {
+    return -1;
+  }
+#if defined(__APPLE__)
+  return usage.ru_maxrss;
+#else
+  return static_cast<int64>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
+
+// Everything one worker needs to analyze its page.  Workers share nothing
+// but the (immutable) localizer, since rules are not required to be
+// thread-safe.
+struct Worker {
+  Worker() : failed(false) {}
+  ~Worker() {}
+
+  scoped_ptr<pagespeed::PagespeedInput> input;
+  scoped_ptr<pagespeed::Engine> engine;
+  std::vector<double> latencies_ms;
+  bool failed;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(Worker);
+};
+
+class LoadTask : public pagespeed::ParallelForTask {
+ public:
+  LoadTask(const std::vector<Worker*>& workers,
+           const pagespeed::l10n::Localizer* localizer,
+           int pages_per_worker)
+      : workers_(workers),
+        localizer_(localizer),
+        pages_per_worker_(pages_per_worker) {}
+
+  virtual void Run(int begin, int end) {
+    for (int i = begin; i < end; ++i) {
+      RunWorker(workers_[i]);
+    }
+  }
+
+ private:
+  void RunWorker(Worker* worker) {
+    for (int i = 0; i < pages_per_worker_; ++i) {
+      const base::TimeTicks start = base::TimeTicks::HighResNow();
+      pagespeed::Results results;
+      pagespeed::FormattedResults formatted_results;
+      formatted_results.set_locale(localizer_->GetLocale());
+      pagespeed::formatters::ProtoFormatter formatter(localizer_,
+                                                      &formatted_results);
+      if (!worker->engine->ComputeResults(*worker->input, &results) ||
+          !worker->engine->FormatResults(results, &formatter)) {
+        worker->failed = true;
+      }
+      worker->latencies_ms.push_back(
+          (base::TimeTicks::HighResNow() - start).InMillisecondsF());
+    }
+  }
+
+  const std::vector<Worker*>& workers_;
+  const pagespeed::l10n::Localizer* const localizer_;
+  const int pages_per_worker_;
+
+  DISALLOW_COPY_AND_ASSIGN(LoadTask);
+};
+
+// Returns the value below which the given fraction of the sorted samples
+// fall (nearest-rank).
+double Percentile(const std::vector<double>& sorted, double fraction) {
+  if (sorted.empty()) {
+    return 0.0;
+  }
+  size_t rank = static_cast<size_t>(fraction * sorted.size() + 0.5);
+  rank = std::max<size_t>(rank, 1);
+  return sorted[std::min(rank, sorted.size()) - 1];
+}
+
+bool WriteProtoInput(const pagespeed::PagespeedInput& input,
+                     const std::string& path) {
+  pagespeed::ProtoInput proto_input;
+  pagespeed::proto::PopulateProtoInput(input, &proto_input);
+  std::ofstream out(path.c_str(), std::ios::out | std::ios::binary);
+  if (!out) {
+    return false;
+  }
+  const std::string serialized = proto_input.SerializeAsString();
+  out.write(serialized.data(), serialized.size());
+  return out.good();
+}
+
+bool RunLoad() {
+  pagespeed_testing::SyntheticPageOptions options;
+  options.num_scripts = FLAGS_scripts;
+  options.num_stylesheets = FLAGS_stylesheets;
+  options.num_images = FLAGS_images;
+  options.text_body_bytes = FLAGS_text_body_bytes;
+  options.num_redirect_chains = FLAGS_redirect_chains;
+  options.redirect_chain_length = FLAGS_redirect_chain_length;
+  options.num_dom_elements = FLAGS_dom_elements;
+  options.dom_depth = FLAGS_dom_depth;
+  options.num_timeline_records = FLAGS_timeline_records;
+  options.num_hosts = FLAGS_hosts;
+  if (!FLAGS_image_file.empty() &&
+      !pagespeed_testing::ReadFileToString(FLAGS_image_file,
+                                           &options.image_body)) {
+    fprintf(stderr, "Unable to read %s.\n", FLAGS_image_file.c_str());
+    return false;
+  }
+
+  // Pages are built up front, on this thread, one per worker.
+  pagespeed_testing::SyntheticPageGenerator generator(options);
+  const int concurrency = std::max(FLAGS_concurrency, 1);
+  std::vector<Worker*> workers;
+  STLElementDeleter<std::vector<Worker*> > worker_deleter(&workers);
+  for (int i = 0; i < concurrency; ++i) {
+    Worker* worker = new Worker;
+    workers.push_back(worker);
+    worker->input.reset(generator.NewPage(i));
+    if (worker->input == NULL) {
+      fprintf(stderr, "Unable to build synthetic page %d.\n", i);
+      return false;
+    }
+
+    std::vector<pagespeed::Rule*> rules;
+    pagespeed::rule_provider::AppendPageSpeedRules(false, &rules);
+    // Ownership of rules is transferred to the Engine instance.
+    worker->engine.reset(new pagespeed::Engine(&rules));
+    worker->engine->Init();
+    worker->engine->set_rule_time_budget(
+        base::TimeDelta::FromMilliseconds(FLAGS_rule_budget_ms));
+    worker->engine->set_analysis_time_budget(
+        base::TimeDelta::FromMilliseconds(FLAGS_analysis_budget_ms));
+    worker->latencies_ms.reserve(FLAGS_pages_per_worker);
+  }
+
+  if (!FLAGS_write_proto_input.empty() &&
+      !WriteProtoInput(*workers[0]->input, FLAGS_write_proto_input)) {
+    fprintf(stderr, "Unable to write %s.\n", FLAGS_write_proto_input.c_str());
+    return false;
+  }
+
+  pagespeed::l10n::BasicLocalizer localizer;
+  LoadTask task(workers, &localizer, FLAGS_pages_per_worker);
+  const base::TimeTicks start = base::TimeTicks::HighResNow();
+  pagespeed::ParallelFor(&task, concurrency, concurrency);
+  const double elapsed_seconds =
+      (base::TimeTicks::HighResNow() - start).InSecondsF();
+
+  std::vector<double> latencies_ms;
+  bool failed = false;
+  for (std::vector<Worker*>::const_iterator it = workers.begin();
+       it != workers.end(); ++it) {
+    latencies_ms.insert(latencies_ms.end(),
+                        (*it)->latencies_ms.begin(),
+                        (*it)->latencies_ms.end());
+    failed = failed || (*it)->failed;
+  }
+  std::sort(latencies_ms.begin(), latencies_ms.end());
+
+  const int64 peak_rss = GetPeakRssBytes();
+  printf("resources/page: %d\n", generator.GetResourcesPerPage());
+  printf("concurrency:    %d\n", concurrency);
+  printf("pages:          %d\n", static_cast<int>(latencies_ms.size()));
+  printf("latency p50:    %.2f ms\n", Percentile(latencies_ms, 0.50));
+  printf("latency p95:    %.2f ms\n", Percentile(latencies_ms, 0.95));
+  printf("latency p99:    %.2f ms\n", Percentile(latencies_ms, 0.99));
+  printf("pages/sec:      %.2f\n", elapsed_seconds > 0 ?
+         latencies_ms.size() / elapsed_seconds : 0.0);
+  if (peak_rss >= 0) {
+    printf("peak RSS:       %.1f MB\n", peak_rss / (1024.0 * 1024.0));
+  }
+  if (failed) {
+    fprintf(stderr, "Some analyses reported errors.\n");
+  }
+  return !failed;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  // Some of our code uses Singleton<>s, which require an
+  // AtExitManager to schedule their destruction.
+  base::AtExitManager at_exit_manager;
+
+  if (!pagespeed::Init()) {
+    fprintf(stderr, "Failed to initialize PageSpeed. Aborting.\n");
+    return EXIT_FAILURE;
+  }
+
+  ::google::SetUsageMessage(
+      "Analyzes synthetic pages concurrently and reports latency "
+      "percentiles, throughput and peak memory use.");
+  ::google::ParseCommandLineFlags(&argc, &argv, true);
+  return RunLoad() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
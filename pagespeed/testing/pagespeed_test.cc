@@ -17,9 +17,7 @@
 #include <fstream>
 #include <string>
 
-#include "base/stl_util.h"
 #include "pagespeed/core/pagespeed_init.h"
-#include "pagespeed/core/browsing_context.h"
 #include "pagespeed/formatters/proto_formatter.h"
 #include "pagespeed/l10n/localizer.h"
 #include "pagespeed/proto/pagespeed_proto_formatter.pb.h"
@@ -53,42 +51,17 @@ std::string GetPathRelativeToSrcRoot(const char* relpath) {
 
 namespace pagespeed_testing {
 
-pagespeed::ImageAttributes* FakeImageAttributesFactory::NewImageAttributes(
-    const pagespeed::Resource* resource) const {
-  ResourceSizeMap::const_iterator c_it = resource_size_map_.find(resource);
-  if (c_it == resource_size_map_.end()) {
-    return NULL;
-  } else {
-    return new pagespeed::ConcreteImageAttributes(c_it->second.first,
-                                                  c_it->second.second);
-  }
-}
-
-
 PagespeedTest::PagespeedTest() {}
-PagespeedTest::~PagespeedTest() {
-  STLDeleteContainerPointers(instrumentation_data_.begin(),
-                             instrumentation_data_.end());
-}
+PagespeedTest::~PagespeedTest() {}
 
 void PagespeedTest::SetUp() {
-  pagespeed_input_.reset(new pagespeed::PagespeedInput());
-  primary_resource_ = NULL;
-  document_ = NULL;
-  html_ = NULL;
-  head_ = NULL;
-  body_ = NULL;
+  builder_.reset(new PagespeedInputBuilder());
   DoSetUp();
 }
 
 void PagespeedTest::TearDown() {
   DoTearDown();
-  primary_resource_ = NULL;
-  document_ = NULL;
-  html_ = NULL;
-  head_ = NULL;
-  body_ = NULL;
-  pagespeed_input_.reset();
+  builder_.reset();
 }
 
 void PagespeedTest::DoSetUp() {}
@@ -99,70 +72,38 @@ void PagespeedTest::Freeze() {
 }
 
 void PagespeedTest::Freeze(bool expected_result) {
-  ASSERT_TRUE(
-      pagespeed_input_->AcquireInstrumentationData(&instrumentation_data_));
-  ASSERT_EQ(expected_result, pagespeed_input_->Freeze());
+  ASSERT_EQ(expected_result, builder_->Freeze());
 }
 
 pagespeed::Resource* PagespeedTest::NewResource(const std::string& url,
                                                 int status_code) {
-  pagespeed::Resource* resource = new pagespeed::Resource();
-  resource->SetRequestUrl(url);
-  resource->SetRequestMethod("GET");
-  resource->SetResponseStatusCode(status_code);
-  if (!pagespeed_input_->AddResource(resource))
-    return NULL; // resource deleted in AddResource
-  return resource;
+  return builder_->NewResource(url, status_code);
 }
 
 pagespeed::Resource* PagespeedTest::NewPrimaryResource(const std::string& url) {
-  pagespeed::Resource* resource = New200Resource(url);
-  resource->SetResourceType(pagespeed::HTML);
-  AssertNull(document_);
-  document_ = FakeDomDocument::NewRoot(url);
-  pagespeed_input_->AcquireDomDocument(document_);
-  pagespeed_input_->SetPrimaryResourceUrl(url);
-  primary_resource_ = resource;
-  return resource;
+  AssertNull(document());
+  return builder_->NewPrimaryResource(url);
 }
 
 pagespeed::Resource* PagespeedTest::NewDocumentResource(const std::string& url,
                                                         FakeDomElement* iframe,
                                                         FakeDomDocument** out) {
-  pagespeed::Resource* resource = New200Resource(url);
-  resource->SetResourceType(pagespeed::HTML);
-  if (iframe != NULL) {
-    FakeDomDocument* document = FakeDomDocument::New(iframe, url);
-    if (out != NULL) {
-      *out = document;
-    }
-  }
-  return resource;
+  return builder_->NewDocumentResource(url, iframe, out);
 }
 
 pagespeed::Resource* PagespeedTest::New200Resource(const std::string& source) {
-  return NewResource(source, 200);
+  return builder_->New200Resource(source);
 }
 
 pagespeed::Resource* PagespeedTest::New302Resource(
     const std::string& source, const std::string& destination) {
-  pagespeed::Resource* resource = NewResource(source, 302);
-  resource->AddResponseHeader("Location", destination);
-  return resource;
+  return builder_->New302Resource(source, destination);
 }
 
 pagespeed::Resource* PagespeedTest::NewPngResource(const std::string& url,
                                                    FakeDomElement* parent,
                                                    FakeDomElement** out) {
-  pagespeed::Resource* resource = New200Resource(url);
-  resource->AddResponseHeader("Content-Type", "image/png");
-  if (parent != NULL) {
-    FakeDomElement* element = FakeDomElement::NewImg(parent, url);
-    if (out != NULL) {
-      *out = element;
-    }
-  }
-  return resource;
+  return builder_->NewPngResource(url, parent, out);
 }
 
 pagespeed::Resource* PagespeedTest::NewRedirectedPngResource(
@@ -170,85 +111,51 @@ pagespeed::Resource* PagespeedTest::NewRedirectedPngResource(
     const std::string& url2,
     FakeDomElement* parent,
     FakeDomElement** out) {
-  New302Resource(url1, url2);
-  pagespeed::Resource* resource = New200Resource(url2);
-  resource->AddResponseHeader("Content-Type", "image/png");
-  if (parent != NULL) {
-    FakeDomElement* element = FakeDomElement::NewImg(parent, url1);
-    if (out != NULL) {
-      *out = element;
-    }
-  }
-  return resource;
+  return builder_->NewRedirectedPngResource(url1, url2, parent, out);
 }
 
 pagespeed::Resource* PagespeedTest::NewScriptResource(const std::string& url,
                                                       FakeDomElement* parent,
                                                       FakeDomElement** out) {
-  pagespeed::Resource* resource = New200Resource(url);
-  resource->SetResourceType(pagespeed::JS);
-  if (parent != NULL) {
-    FakeDomElement* element = FakeDomElement::NewScript(parent, url);
-    if (out != NULL) {
-      *out = element;
-    }
-  }
-  return resource;
+  return builder_->NewScriptResource(url, parent, out);
 }
 
 pagespeed::Resource* PagespeedTest::NewCssResource(const std::string& url,
                                                    FakeDomElement* parent,
                                                    FakeDomElement** out) {
-  pagespeed::Resource* resource = New200Resource(url);
-  resource->SetResourceType(pagespeed::CSS);
-  if (parent != NULL) {
-    FakeDomElement* element = FakeDomElement::NewLinkStylesheet(parent, url);
-    if (out != NULL) {
-      *out = element;
-    }
-  }
-  return resource;
+  return builder_->NewCssResource(url, parent, out);
 }
 
 bool PagespeedTest::SetTopLevelBrowsingContext(
     pagespeed::TopLevelBrowsingContext* context) {
-  return pagespeed_input_->AcquireTopLevelBrowsingContext(context);
+  return builder_->SetTopLevelBrowsingContext(context);
 }
 
 pagespeed::TopLevelBrowsingContext* PagespeedTest::NewTopLevelBrowsingContext(
     const pagespeed::Resource* document_resource) {
-  scoped_ptr<pagespeed::TopLevelBrowsingContext> context(
-      new pagespeed::TopLevelBrowsingContext(
-          document_resource, &pagespeed_input_->GetResourceCollection()));
-  if (!SetTopLevelBrowsingContext(context.get())) {
-    return NULL;
-  }
-  return context.release();
+  return builder_->NewTopLevelBrowsingContext(document_resource);
 }
 
 void PagespeedTest::CreateHtmlHeadBodyElements() {
   AssertNotNull(document());
-  AssertNull(html_);
-  AssertNull(head_);
-  AssertNull(body_);
-  html_ = FakeDomElement::NewRoot(document(), "html");
-  head_ = FakeDomElement::New(html(), "head");
-  body_ = FakeDomElement::New(html(), "body");
+  AssertNull(html());
+  AssertNull(head());
+  AssertNull(body());
+  builder_->CreateHtmlHeadBodyElements();
 }
 
 bool PagespeedTest::AddResource(pagespeed::Resource* resource) {
-  return pagespeed_input_->AddResource(resource);
+  return builder_->AddResource(resource);
 }
 
 bool PagespeedTest::AddFakeImageAttributesFactory(
     const FakeImageAttributesFactory::ResourceSizeMap& map) {
-  return pagespeed_input_->AcquireImageAttributesFactory(
-      new FakeImageAttributesFactory(map));
+  return builder_->AddFakeImageAttributesFactory(map);
 }
 
 void PagespeedTest::AddInstrumentationData(
     const pagespeed::InstrumentationData* data) {
-  instrumentation_data_.push_back(data);
+  builder_->AddInstrumentationData(data);
 }
 
 void DoFormatResultsAsProto(pagespeed::Rule* rule,
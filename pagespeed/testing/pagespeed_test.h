@@ -15,13 +15,11 @@
 #ifndef PAGESPEED_TESTING_PAGESPEED_TEST_H_
 #define PAGESPEED_TESTING_PAGESPEED_TEST_H_
 
-#include <map>
 #include <string>
 #include <vector>
 
 #include "base/at_exit.h"
 #include "base/memory/scoped_ptr.h"
-#include "pagespeed/core/image_attributes.h"
 #include "pagespeed/core/pagespeed_input.h"
 #include "pagespeed/core/resource.h"
 #include "pagespeed/core/result_provider.h"
@@ -30,6 +28,7 @@
 #include "pagespeed/proto/pagespeed_output.pb.h"
 #include "pagespeed/proto/pagespeed_proto_formatter.pb.h"
 #include "pagespeed/testing/fake_dom.h"
+#include "pagespeed/testing/pagespeed_input_builder.h"
 #include "testing/gtest/include/gtest/gtest.h"
 
 namespace pagespeed {
@@ -52,21 +51,6 @@ void AssertTrue(bool condition);
 // the proper location of the root of the source tree.
 bool ReadFileToString(const std::string& filename, std::string *dest);
 
-class FakeImageAttributesFactory
-    : public pagespeed::ImageAttributesFactory {
- public:
-  typedef std::map<const pagespeed::Resource*, std::pair<int,int> >
-      ResourceSizeMap;
-  explicit FakeImageAttributesFactory(const ResourceSizeMap& resource_size_map)
-      : resource_size_map_(resource_size_map) {
-  }
-  virtual pagespeed::ImageAttributes* NewImageAttributes(
-      const pagespeed::Resource* resource) const;
- private:
-  ResourceSizeMap resource_size_map_;
-};
-
-
 // Helper method that returns the output from a TextFormatter for
 // the given Rule and Results.
 std::string DoFormatResultsAsText(pagespeed::Rule* rule,
@@ -195,26 +179,29 @@ class PagespeedTest : public ::testing::Test {
   void AddInstrumentationData(const pagespeed::InstrumentationData* data);
 
   bool SetOnloadTimeMillis(int onload_millis) {
-    return pagespeed_input_->SetOnloadTimeMillis(onload_millis);
+    return builder_->pagespeed_input()->SetOnloadTimeMillis(onload_millis);
   }
 
   bool SetViewportWidthAndHeight(int width, int height) {
-    return pagespeed_input_->SetViewportWidthAndHeight(width, height);
+    return builder_->pagespeed_input()->SetViewportWidthAndHeight(width,
+                                                                  height);
   }
 
   void SetInitialResourceIsCanonical(bool initial_resource_is_canonical) {
-    pagespeed_input_->SetInitialResourceIsCanonical(
+    builder_->pagespeed_input()->SetInitialResourceIsCanonical(
         initial_resource_is_canonical);
   }
 
   const pagespeed::PagespeedInput* pagespeed_input() {
-    return pagespeed_input_.get();
+    return builder_->pagespeed_input();
+  }
+  pagespeed::Resource* primary_resource() const {
+    return builder_->primary_resource();
   }
-  pagespeed::Resource* primary_resource() const { return primary_resource_; }
-  FakeDomDocument* document() { return document_; }
-  FakeDomElement* html() { return html_; }
-  FakeDomElement* head() { return head_; }
-  FakeDomElement* body() { return body_; }
+  FakeDomDocument* document() { return builder_->document(); }
+  FakeDomElement* html() { return builder_->html(); }
+  FakeDomElement* head() { return builder_->head(); }
+  FakeDomElement* body() { return builder_->body(); }
 
   // Add a resource. Do not call this method for resources constructed
   // using New*Resource, as those resources have already been added to
@@ -225,13 +212,7 @@ class PagespeedTest : public ::testing::Test {
 
  private:
   base::AtExitManager at_exit_manager_;
-  pagespeed::InstrumentationDataVector instrumentation_data_;
-  scoped_ptr<pagespeed::PagespeedInput> pagespeed_input_;
-  pagespeed::Resource* primary_resource_;
-  FakeDomDocument* document_;
-  FakeDomElement* html_;
-  FakeDomElement* head_;
-  FakeDomElement* body_;
+  scoped_ptr<PagespeedInputBuilder> builder_;
 };
 
 // A base testing class for use when writing rule tests.
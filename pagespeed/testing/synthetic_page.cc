@@ -0,0 +1,239 @@
+// Copyright 2013 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pagespeed/testing/synthetic_page.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "pagespeed/core/pagespeed_input.h"
+#include "pagespeed/core/resource.h"
+#include "pagespeed/core/string_util.h"
+#include "pagespeed/testing/fake_dom.h"
+#include "pagespeed/testing/instrumentation_data_builder.h"
+#include "pagespeed/testing/pagespeed_input_builder.h"
+
+using pagespeed::string_util::StringPrintf;
+
+namespace {
+
+// A valid 1x1 RGB PNG.
+const char kTinyPng[] =
+    "\x89\x50\x4e\x47\x0d\x0a\x1a\x0a\x00\x00\x00\x0d\x49\x48\x44\x52"
+    "\x00\x00\x00\x01\x00\x00\x00\x01\x08\x02\x00\x00\x00\x90\x77\x53"
+    "\xde\x00\x00\x00\x0c\x49\x44\x41\x54\x78\x9c\x63\xf8\xcf\xc0\x00"
+    "\x00\x03\x01\x01\x00\xc9\xfe\x92\xef\x00\x00\x00\x00\x49\x45\x4e"
+    "\x44\xae\x42\x60\x82";
+
+// Displayed and natural sizes of each image.
+const int kImageDisplaySize = 50;
+const int kImageNaturalSize = 100;
+
+// Returns a deterministic pseudo-random token for the given seed and line,
+// which keeps gzip from finding repeats across lines.
+std::string MakeNoiseToken(int seed, int line) {
+  unsigned int state = static_cast<unsigned int>(seed) * 2654435761U +
+      static_cast<unsigned int>(line) * 40503U + 1U;
+  std::string token;
+  for (int i = 0; i < 4; ++i) {
+    state = state * 1103515245U + 12345U;
+    token += StringPrintf("%04x", (state >> 16) & 0xffff);
+  }
+  return token;
+}
+
+// Unminified text bodies, served without a Content-Encoding, so that the
+// minification and compression rules have savings to report.  Bodies that
+// are not highly_compressible carry a unique token on every line, which
+// shrinks (but does not remove) the savings from gzip.
+std::string MakeScriptBody(int id, int min_bytes, bool highly_compressible) {
+  std::string body;
+  for (int i = 0; static_cast<int>(body.size()) < min_bytes; ++i) {
+    const std::string noise =
+        highly_compressible ? "" : " " + MakeNoiseToken(id, i);
+    body += StringPrintf(
+        "// Adds its arguments.%s\n"
+        "function add_%d_%d(first, second) {\n"
+        "  return first + second;\n"
+        "}\n", noise.c_str(), id, i);
+  }
+  return body;
+}
+
+std::string MakeStylesheetBody(int id, int min_bytes,
+                               bool highly_compressible) {
+  std::string body;
+  for (int i = 0; static_cast<int>(body.size()) < min_bytes; ++i) {
+    const std::string noise =
+        highly_compressible ? "" : " " + MakeNoiseToken(id, i);
+    body += StringPrintf(
+        "/* Rule %d.%s */\n"
+        ".item-%d-%d {  color : red ;  margin : 0px ;  }\n",
+        i, noise.c_str(), id, i);
+  }
+  return body;
+}
+
+std::string MakeHtmlBody(int min_bytes) {
+  std::string body = "<html><head><title>Synthetic page</title></head><body>";
+  while (static_cast<int>(body.size()) < min_bytes) {
+    body += "<div>   Some   text.   </div>  <!-- comment -->\n";
+  }
+  body += "</body></html>";
+  return body;
+}
+
+void SetCachingHeaders(int index, pagespeed::Resource* resource) {
+  if (index % 2 == 0) {
+    resource->AddResponseHeader("Cache-Control", "max-age=31536000");
+  }
+}
+
+bool IsHighlyCompressible(int index) {
+  return index % 3 != 0;
+}
+
+}  // namespace
+
+namespace pagespeed_testing {
+
+SyntheticPageOptions::SyntheticPageOptions()
+    : num_scripts(20),
+      num_stylesheets(10),
+      num_images(50),
+      text_body_bytes(4096),
+      image_body(kTinyPng, sizeof(kTinyPng) - 1),
+      num_redirect_chains(2),
+      redirect_chain_length(3),
+      num_dom_elements(500),
+      dom_depth(10),
+      num_timeline_records(100),
+      num_hosts(4) {
+}
+
+SyntheticPageGenerator::SyntheticPageGenerator(
+    const SyntheticPageOptions& options)
+    : options_(options) {
+}
+
+SyntheticPageGenerator::~SyntheticPageGenerator() {}
+
+int SyntheticPageGenerator::GetResourcesPerPage() const {
+  return 1 + options_.num_scripts + options_.num_stylesheets +
+      options_.num_images +
+      options_.num_redirect_chains * (options_.redirect_chain_length + 1);
+}
+
+pagespeed::PagespeedInput* SyntheticPageGenerator::NewPage(
+    int page_id) const {
+  PagespeedInputBuilder builder;
+  const int num_hosts = std::max(options_.num_hosts, 1);
+
+  pagespeed::Resource* primary = builder.NewPrimaryResource(
+      StringPrintf("http://www.example.com/page-%d/index.html", page_id));
+  primary->AddResponseHeader("Content-Type", "text/html");
+  primary->SetResponseBody(MakeHtmlBody(options_.text_body_bytes));
+  builder.CreateHtmlHeadBodyElements();
+
+  for (int i = 0; i < options_.num_scripts; ++i) {
+    pagespeed::Resource* resource = builder.NewScriptResource(
+        StringPrintf("http://static%d.example.com/p%d/script-%d.js",
+                     i % num_hosts, page_id, i),
+        i % 2 == 0 ? builder.head() : builder.body());
+    resource->AddResponseHeader("Content-Type", "application/javascript");
+    SetCachingHeaders(i, resource);
+    resource->SetResponseBody(MakeScriptBody(i, options_.text_body_bytes,
+                                             IsHighlyCompressible(i)));
+  }
+
+  for (int i = 0; i < options_.num_stylesheets; ++i) {
+    pagespeed::Resource* resource = builder.NewCssResource(
+        StringPrintf("http://static%d.example.com/p%d/style-%d.css",
+                     i % num_hosts, page_id, i),
+        i % 4 == 0 ? builder.body() : builder.head());
+    resource->AddResponseHeader("Content-Type", "text/css");
+    SetCachingHeaders(i, resource);
+    resource->SetResponseBody(MakeStylesheetBody(i, options_.text_body_bytes,
+                                                 IsHighlyCompressible(i)));
+  }
+
+  FakeImageAttributesFactory::ResourceSizeMap image_sizes;
+  for (int i = 0; i < options_.num_images; ++i) {
+    FakeDomElement* img = NULL;
+    pagespeed::Resource* resource = builder.NewPngResource(
+        StringPrintf("http://images%d.example.com/p%d/image-%d.png",
+                     i % num_hosts, page_id, i),
+        builder.body(), &img);
+    SetCachingHeaders(i, resource);
+    resource->SetResponseBody(options_.image_body);
+    image_sizes[resource] = std::make_pair(kImageNaturalSize,
+                                           kImageNaturalSize);
+    img->SetActualWidthAndHeight(kImageDisplaySize, kImageDisplaySize);
+    if (i % 2 == 0) {
+      img->AddAttribute("width", StringPrintf("%d", kImageDisplaySize));
+      img->AddAttribute("height", StringPrintf("%d", kImageDisplaySize));
+    }
+  }
+  builder.AddFakeImageAttributesFactory(image_sizes);
+
+  for (int i = 0; i < options_.num_redirect_chains; ++i) {
+    const std::string script_url = StringPrintf(
+        "http://www.example.com/p%d/redirected-%d.js", page_id, i);
+    std::string url = options_.redirect_chain_length > 0 ?
+        StringPrintf("http://www.example.com/p%d/redirect-%d", page_id, i) :
+        script_url;
+    FakeDomElement::NewScript(builder.body(), url);
+    for (int hop = 0; hop < options_.redirect_chain_length; ++hop) {
+      const std::string target = hop + 1 < options_.redirect_chain_length ?
+          StringPrintf("http://www.example.com/p%d/redirect-%d/%d",
+                       page_id, i, hop) :
+          script_url;
+      builder.New302Resource(url, target);
+      url = target;
+    }
+    pagespeed::Resource* resource = builder.NewScriptResource(script_url);
+    resource->AddResponseHeader("Content-Type", "application/javascript");
+    resource->SetResponseBody(MakeScriptBody(i, options_.text_body_bytes,
+                                             true));
+  }
+
+  // Nest the DIVs in chains of dom_depth elements under the body.
+  FakeDomElement* parent = builder.body();
+  for (int i = 0; i < options_.num_dom_elements; ++i) {
+    if (options_.dom_depth <= 0 || i % options_.dom_depth == 0) {
+      parent = builder.body();
+    }
+    parent = FakeDomElement::New(parent, "DIV");
+  }
+
+  for (int i = 0; i < options_.num_timeline_records; ++i) {
+    const std::string url = options_.num_scripts > 0 ?
+        StringPrintf("http://static%d.example.com/p%d/script-%d.js",
+                     (i % options_.num_scripts) % num_hosts, page_id,
+                     i % options_.num_scripts) :
+        primary->GetRequestUrl();
+    InstrumentationDataBuilder record;
+    builder.AddInstrumentationData(
+        record.EvaluateScript(url.c_str(), 1).Layout().Pause(1).Get());
+  }
+
+  builder.pagespeed_input()->SetOnloadTimeMillis(2000);
+  builder.pagespeed_input()->SetViewportWidthAndHeight(1024, 768);
+  if (!builder.Freeze()) {
+    return NULL;
+  }
+  return builder.ReleasePagespeedInput();
+}
+
+}  // namespace pagespeed_testing
@@ -0,0 +1,86 @@
+// Copyright 2013 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PAGESPEED_TESTING_SYNTHETIC_PAGE_H_
+#define PAGESPEED_TESTING_SYNTHETIC_PAGE_H_
+
+#include <string>
+
+#include "base/basictypes.h"
+
+namespace pagespeed {
+class PagespeedInput;
+}  // namespace pagespeed
+
+namespace pagespeed_testing {
+
+// Describes the shape of the pages built by SyntheticPageGenerator.
+struct SyntheticPageOptions {
+  SyntheticPageOptions();
+
+  int num_scripts;
+  int num_stylesheets;
+  int num_images;
+  // Approximate size of each script and stylesheet body.
+  int text_body_bytes;
+  // Body of each image resource.  Defaults to a valid 1x1 PNG.
+  std::string image_body;
+  // Number of chains of 302 redirects, each redirect_chain_length hops long
+  // and ending in a script.
+  int num_redirect_chains;
+  int redirect_chain_length;
+  // Number of DIV elements added to the body, nested at most dom_depth
+  // deep, in addition to the elements that reference resources.
+  int num_dom_elements;
+  int dom_depth;
+  // Number of top-level timeline records (each a script evaluation with a
+  // nested layout).
+  int num_timeline_records;
+  // Number of hosts the subresources are spread over.
+  int num_hosts;
+};
+
+/**
+ * Builds frozen PagespeedInputs of a configurable size and resource mix, for
+ * load testing and benchmarking.  Pages are built with a
+ * PagespeedInputBuilder and are deterministic: the same options and page id
+ * always yield the same page.  Roughly half of the subresources lack caching
+ * headers, text resources are unminified and served uncompressed (every
+ * third with a less compressible body), and each image is displayed smaller
+ * than its natural size, so that most rules have results to report.
+ *
+ * The caller must have an AtExitManager in scope.
+ */
+class SyntheticPageGenerator {
+ public:
+  explicit SyntheticPageGenerator(const SyntheticPageOptions& options);
+  ~SyntheticPageGenerator();
+
+  // Builds and freezes a new page whose URLs are distinguished by page_id.
+  // Returns NULL if the page could not be frozen.  Caller owns the returned
+  // object.
+  pagespeed::PagespeedInput* NewPage(int page_id) const;
+
+  // The number of resources in each page built with these options.
+  int GetResourcesPerPage() const;
+
+ private:
+  const SyntheticPageOptions options_;
+
+  DISALLOW_COPY_AND_ASSIGN(SyntheticPageGenerator);
+};
+
+}  // namespace pagespeed_testing
+
+#endif  // PAGESPEED_TESTING_SYNTHETIC_PAGE_H_
@@ -0,0 +1,77 @@
+// Copyright 2013 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "base/at_exit.h"
+#include "base/memory/scoped_ptr.h"
+#include "pagespeed/core/pagespeed_input.h"
+#include "pagespeed/core/resource.h"
+#include "pagespeed/testing/synthetic_page.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+using pagespeed_testing::SyntheticPageGenerator;
+using pagespeed_testing::SyntheticPageOptions;
+
+namespace {
+
+class SyntheticPageGeneratorTest : public ::testing::Test {
+ private:
+  base::AtExitManager at_exit_manager_;
+};
+
+TEST_F(SyntheticPageGeneratorTest, DefaultPage) {
+  SyntheticPageOptions options;
+  SyntheticPageGenerator generator(options);
+  scoped_ptr<pagespeed::PagespeedInput> input(generator.NewPage(7));
+  ASSERT_TRUE(input != NULL);
+  EXPECT_TRUE(input->is_frozen());
+  EXPECT_EQ(generator.GetResourcesPerPage(), input->num_resources());
+  EXPECT_EQ(static_cast<size_t>(options.num_timeline_records),
+            input->instrumentation_data()->size());
+
+  const pagespeed::Resource* script = input->GetResourceWithUrlOrNull(
+      "http://static1.example.com/p7/script-1.js");
+  ASSERT_TRUE(script != NULL);
+  EXPECT_LE(options.text_body_bytes,
+            static_cast<int>(script->GetResponseBody().size()));
+  EXPECT_EQ(pagespeed::JS, script->GetResourceType());
+  // Bodies are plain text, so they must not claim a Content-Encoding.
+  EXPECT_EQ("", script->GetResponseHeader("Content-Encoding"));
+
+  const pagespeed::Resource* redirect = input->GetResourceWithUrlOrNull(
+      "http://www.example.com/p7/redirect-0");
+  ASSERT_TRUE(redirect != NULL);
+  EXPECT_EQ(302, redirect->GetResponseStatusCode());
+}
+
+TEST_F(SyntheticPageGeneratorTest, CustomShape) {
+  SyntheticPageOptions options;
+  options.num_scripts = 0;
+  options.num_stylesheets = 3;
+  options.num_images = 1000;
+  options.num_redirect_chains = 1;
+  options.redirect_chain_length = 5;
+  options.num_timeline_records = 0;
+  SyntheticPageGenerator generator(options);
+  EXPECT_EQ(1 + 3 + 1000 + 6, generator.GetResourcesPerPage());
+
+  // Pages can be built one after another from the same generator.
+  for (int i = 0; i < 2; ++i) {
+    scoped_ptr<pagespeed::PagespeedInput> input(generator.NewPage(i));
+    ASSERT_TRUE(input != NULL);
+    EXPECT_EQ(generator.GetResourcesPerPage(), input->num_resources());
+    EXPECT_TRUE(input->instrumentation_data()->empty());
+  }
+}
+
+}  // namespace
@@ -41,7 +41,9 @@
         'fake_dom.cc',
         'formatted_results_test_converter.cc',
         'instrumentation_data_builder.cc',
+        'pagespeed_input_builder.cc',
         'pagespeed_test.cc',
+        'synthetic_page.cc',
       ],
       'include_dirs': [
         '<(pagespeed_root)',
@@ -73,5 +75,30 @@
         '<(pagespeed_root)',
       ],
     },
+    {
+      'target_name': 'pagespeed_benchmark_main',
+      'type': '<(library)',
+      'dependencies': [
+        '<(DEPTH)/base/base.gyp:base',
+        '<(DEPTH)/third_party/gflags/gflags.gyp:gflags',
+        '<(DEPTH)/<(protobuf_gyp_path):protobuf_lite',
+        '<(pagespeed_root)/pagespeed/core/core.gyp:pagespeed_allocation_counter',
+        '<(pagespeed_root)/pagespeed/core/core.gyp:pagespeed_core',
+        '<(pagespeed_root)/pagespeed/core/init.gyp:pagespeed_init',
+      ],
+      'sources': [
+        'benchmark.cc',
+        'pagespeed_benchmark_main.cc',
+      ],
+      'include_dirs': [
+        '<(DEPTH)',
+        '<(pagespeed_root)',
+      ],
+      'direct_dependent_settings': {
+        'include_dirs': [
+          '<(pagespeed_root)',
+        ],
+      },
+    },
   ],
 }
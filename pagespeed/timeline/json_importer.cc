@@ -14,6 +14,7 @@
 
 #include "pagespeed/timeline/json_importer.h"
 
+#include <set>
 #include <string>
 #include <vector>
 
@@ -28,12 +29,112 @@ using pagespeed::InstrumentationData;
 
 namespace {
 
+typedef std::set<InstrumentationData::RecordType> RecordTypeSet;
+
+// Size of the chunks in which CreateTimelineProtoFromJsonStream reads.
+const size_t kReadBufferSize = 64 << 10;
+
+bool IsJsonWhitespace(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+// Sets *type to the record type named by type_string.  Returns false if
+// the type is unknown.
+bool ParseRecordType(const std::string& type_string,
+                     InstrumentationData::RecordType* type) {
+  if (type_string == "EventDispatch") {
+    *type = InstrumentationData::EVENT_DISPATCH;
+  } else if (type_string == "Layout") {
+    *type = InstrumentationData::LAYOUT;
+  } else if (type_string == "RecalculateStyles") {
+    *type = InstrumentationData::RECALCULATE_STYLES;
+  } else if (type_string == "Paint") {
+    *type = InstrumentationData::PAINT;
+  } else if (type_string == "ParseHTML") {
+    *type = InstrumentationData::PARSE_HTML;
+  } else if (type_string == "TimerInstall") {
+    *type = InstrumentationData::TIMER_INSTALL;
+  } else if (type_string == "TimerRemove") {
+    *type = InstrumentationData::TIMER_REMOVE;
+  } else if (type_string == "TimerFire") {
+    *type = InstrumentationData::TIMER_FIRE;
+  } else if (type_string == "XHRReadyStateChange") {
+    *type = InstrumentationData::XHR_READY_STATE_CHANGE;
+  } else if (type_string == "XHRLoad") {
+    *type = InstrumentationData::XHR_LOAD;
+  } else if (type_string == "EvaluateScript") {
+    *type = InstrumentationData::EVALUATE_SCRIPT;
+  } else if (type_string == "MarkTimeline") {
+    *type = InstrumentationData::MARK_TIMELINE;
+  } else if (type_string == "ResourceSendRequest") {
+    *type = InstrumentationData::RESOURCE_SEND_REQUEST;
+  } else if (type_string == "ResourceReceiveResponse") {
+    *type = InstrumentationData::RESOURCE_RECEIVE_RESPONSE;
+  } else if (type_string == "ResourceReceivedData") {
+    *type = InstrumentationData::RESOURCE_RECEIVED_DATA;
+  } else if (type_string == "ResourceFinish") {
+    *type = InstrumentationData::RESOURCE_FINISH;
+  } else if (type_string == "FunctionCall") {
+    *type = InstrumentationData::FUNCTION_CALL;
+  } else if (type_string == "GCEvent") {
+    *type = InstrumentationData::GC_EVENT;
+  } else if (type_string == "MarkDOMContent") {
+    *type = InstrumentationData::MARK_DOM_CONTENT;
+  } else if (type_string == "MarkLoad") {
+    *type = InstrumentationData::MARK_LOAD;
+  } else if (type_string == "ScheduleResourceRequest") {
+    *type = InstrumentationData::SCHEDULE_RESOURCE_REQUEST;
+  } else if (type_string == "TimeStamp") {
+    *type = InstrumentationData::TIME_STAMP;
+  } else if (type_string == "RegisterAnimationFrameCallback") {
+    *type = InstrumentationData::REGISTER_ANIMATION_FRAME_CALLBACK;
+  } else if (type_string == "CancelAnimationFrameCallback") {
+    *type = InstrumentationData::CANCEL_ANIMATION_FRAME_CALLBACK;
+  } else if (type_string == "FireAnimationFrameEvent") {
+    *type = InstrumentationData::FIRE_ANIMATION_FRAME_EVENT;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+// Returns true if the record described by json, or any of its
+// descendants, has one of the given types.
+bool ContainsRecordOfType(const base::DictionaryValue& json,
+                          const RecordTypeSet& types) {
+  std::string type_string;
+  InstrumentationData::RecordType type;
+  if (json.GetString("type", &type_string) &&
+      ParseRecordType(type_string, &type) &&
+      types.count(type) > 0) {
+    return true;
+  }
+  const base::ListValue* children;
+  if (json.GetList("children", &children)) {
+    for (base::ListValue::const_iterator iter = children->begin(),
+             end = children->end(); iter != end; ++iter) {
+      const Value* item = *iter;
+      if (item != NULL && item->IsType(base::Value::TYPE_DICTIONARY) &&
+          ContainsRecordOfType(
+              *static_cast<const base::DictionaryValue*>(item), types)) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
 class ProtoPopulator {
  public:
-  ProtoPopulator() : error_(false) {}
+  // If record_types is non-NULL, top-level records are skipped unless they
+  // or one of their descendants have one of those types.
+  explicit ProtoPopulator(const RecordTypeSet* record_types)
+      : record_types_(record_types), error_(false) {}
 
   void PopulateToplevel(const base::ListValue& json,
                         std::vector<const InstrumentationData*>* proto_out);
+  void PopulateToplevelItem(const Value* item,
+                            std::vector<const InstrumentationData*>* proto_out);
   void PopulateInstrumentationData(const base::DictionaryValue& json,
                                    InstrumentationData* instr);
   void PopulateStackFrame(const base::DictionaryValue& json,
@@ -45,6 +146,7 @@ class ProtoPopulator {
   bool error() { return error_; }
 
  private:
+  const RecordTypeSet* record_types_;
   bool error_;
 
   DISALLOW_COPY_AND_ASSIGN(ProtoPopulator);
@@ -55,19 +157,28 @@ void ProtoPopulator::PopulateToplevel(
     std::vector<const InstrumentationData*>* proto_out) {
   for (base::ListValue::const_iterator iter = json.begin(), end = json.end();
        iter != end; ++iter) {
-    const Value* item = *iter;
-    if (NULL == item || !item->IsType(base::Value::TYPE_DICTIONARY)) {
-      error_ = true;
-      LOG(WARNING) << "Top-level list item must be a dictionary";
-      continue;
-    }
-    scoped_ptr<InstrumentationData> instr(new InstrumentationData);
-    PopulateInstrumentationData(*static_cast<const base::DictionaryValue*>(item),
-                                instr.get());
-    proto_out->push_back(instr.release());
+    PopulateToplevelItem(*iter, proto_out);
   }
 }
 
+void ProtoPopulator::PopulateToplevelItem(
+    const Value* item,
+    std::vector<const InstrumentationData*>* proto_out) {
+  if (NULL == item || !item->IsType(base::Value::TYPE_DICTIONARY)) {
+    error_ = true;
+    LOG(WARNING) << "Top-level list item must be a dictionary";
+    return;
+  }
+  const base::DictionaryValue& json =
+      *static_cast<const base::DictionaryValue*>(item);
+  if (record_types_ != NULL && !ContainsRecordOfType(json, *record_types_)) {
+    return;
+  }
+  scoped_ptr<InstrumentationData> instr(new InstrumentationData);
+  PopulateInstrumentationData(json, instr.get());
+  proto_out->push_back(instr.release());
+}
+
 void ProtoPopulator::PopulateInstrumentationData(
     const base::DictionaryValue& json,
     InstrumentationData* instr) {
@@ -79,62 +190,14 @@ void ProtoPopulator::PopulateInstrumentationData(
       return;
     }
 
-    if (type_string == "EventDispatch") {
-      instr->set_type(InstrumentationData::EVENT_DISPATCH);
-    } else if (type_string == "Layout") {
-      instr->set_type(InstrumentationData::LAYOUT);
-    } else if (type_string == "RecalculateStyles") {
-      instr->set_type(InstrumentationData::RECALCULATE_STYLES);
-    } else if (type_string == "Paint") {
-      instr->set_type(InstrumentationData::PAINT);
-    } else if (type_string == "ParseHTML") {
-      instr->set_type(InstrumentationData::PARSE_HTML);
-    } else if (type_string == "TimerInstall") {
-      instr->set_type(InstrumentationData::TIMER_INSTALL);
-    } else if (type_string == "TimerRemove") {
-      instr->set_type(InstrumentationData::TIMER_REMOVE);
-    } else if (type_string == "TimerFire") {
-      instr->set_type(InstrumentationData::TIMER_FIRE);
-    } else if (type_string == "XHRReadyStateChange") {
-      instr->set_type(InstrumentationData::XHR_READY_STATE_CHANGE);
-    } else if (type_string == "XHRLoad") {
-      instr->set_type(InstrumentationData::XHR_LOAD);
-    } else if (type_string == "EvaluateScript") {
-      instr->set_type(InstrumentationData::EVALUATE_SCRIPT);
-    } else if (type_string == "MarkTimeline") {
-      instr->set_type(InstrumentationData::MARK_TIMELINE);
-    } else if (type_string == "ResourceSendRequest") {
-      instr->set_type(InstrumentationData::RESOURCE_SEND_REQUEST);
-    } else if (type_string == "ResourceReceiveResponse") {
-      instr->set_type(InstrumentationData::RESOURCE_RECEIVE_RESPONSE);
-    } else if (type_string == "ResourceReceivedData") {
-      instr->set_type(InstrumentationData::RESOURCE_RECEIVED_DATA);
-    } else if (type_string == "ResourceFinish") {
-      instr->set_type(InstrumentationData::RESOURCE_FINISH);
-    } else if (type_string == "FunctionCall") {
-      instr->set_type(InstrumentationData::FUNCTION_CALL);
-    } else if (type_string == "GCEvent") {
-      instr->set_type(InstrumentationData::GC_EVENT);
-    } else if (type_string == "MarkDOMContent") {
-      instr->set_type(InstrumentationData::MARK_DOM_CONTENT);
-    } else if (type_string == "MarkLoad") {
-      instr->set_type(InstrumentationData::MARK_LOAD);
-    } else if (type_string == "ScheduleResourceRequest") {
-      instr->set_type(InstrumentationData::SCHEDULE_RESOURCE_REQUEST);
-    } else if (type_string == "TimeStamp") {
-      instr->set_type(InstrumentationData::TIME_STAMP);
-    } else if (type_string == "RegisterAnimationFrameCallback") {
-      instr->set_type(InstrumentationData::REGISTER_ANIMATION_FRAME_CALLBACK);
-    } else if (type_string == "CancelAnimationFrameCallback") {
-      instr->set_type(InstrumentationData::CANCEL_ANIMATION_FRAME_CALLBACK);
-    } else if (type_string == "FireAnimationFrameEvent") {
-      instr->set_type(InstrumentationData::FIRE_ANIMATION_FRAME_EVENT);
-    } else {
+    InstrumentationData::RecordType type;
+    if (!ParseRecordType(type_string, &type)) {
       LOG(DFATAL) << "Unknown record type: " << type_string;
       // Don't treat this as an error since new types may be added as
       // the format evolves.
       return;
     }
+    instr->set_type(type);
   }
 
   DCHECK(instr->has_type());
@@ -373,11 +436,181 @@ bool CreateTimelineProtoFromJsonString(
 bool CreateTimelineProtoFromJsonValue(
     const base::ListValue& json,
     std::vector<const InstrumentationData*>* proto_out) {
-  ProtoPopulator populator;
+  ProtoPopulator populator(NULL);
   populator.PopulateToplevel(json, proto_out);
   return !populator.error();
 }
 
+bool CreateTimelineProtoFromJsonStream(
+    std::istream* json_stream,
+    std::vector<const InstrumentationData*>* proto_out) {
+  JsonTimelineImporter importer(proto_out);
+  std::vector<char> buffer(kReadBufferSize);
+  while (json_stream->good()) {
+    json_stream->read(&buffer[0], buffer.size());
+    if (!importer.Append(&buffer[0], json_stream->gcount())) {
+      return false;
+    }
+  }
+  if (json_stream->bad()) {
+    LOG(WARNING) << "Failed to read JSON stream";
+    return false;
+  }
+  return importer.Finish();
+}
+
+JsonTimelineImporter::JsonTimelineImporter(
+    std::vector<const InstrumentationData*>* proto_out)
+    : proto_out_(proto_out),
+      filter_record_types_(false),
+      state_(BEFORE_LIST),
+      depth_(0),
+      in_string_(false),
+      escaped_(false),
+      error_(false) {
+}
+
+JsonTimelineImporter::~JsonTimelineImporter() {
+}
+
+void JsonTimelineImporter::SetRecordTypes(
+    const std::set<InstrumentationData::RecordType>& record_types) {
+  DCHECK(state_ == BEFORE_LIST);
+  record_types_ = record_types;
+  filter_record_types_ = true;
+}
+
+bool JsonTimelineImporter::Append(const char* data, size_t size) {
+  const char* const end = data + size;
+  for (const char* p = data; p < end; ++p) {
+    switch (state_) {
+      case BEFORE_LIST:
+        if (IsJsonWhitespace(*p)) {
+          break;
+        }
+        if (*p != '[') {
+          Fail("Top-level JSON value must be a list");
+          return false;
+        }
+        state_ = BEFORE_RECORD;
+        break;
+
+      case BEFORE_RECORD:
+        if (IsJsonWhitespace(*p)) {
+          break;
+        }
+        if (*p == ']') {
+          // Either the list is empty, or it has a trailing comma, which
+          // CreateTimelineProtoFromJsonString also allows.
+          state_ = AFTER_LIST;
+          break;
+        }
+        if (*p == ',') {
+          Fail("Missing top-level list item");
+          return false;
+        }
+        state_ = IN_RECORD;
+        depth_ = 0;
+        in_string_ = false;
+        escaped_ = false;
+        // Fall through, to scan this character as part of the record.
+
+      case IN_RECORD: {
+        // Find the end of the record, which is the first comma or
+        // closing bracket outside of any string or nested value, and
+        // copy the record text up to there in one go.
+        const char* record_start = p;
+        bool record_done = false;
+        for (; p < end && !record_done; ++p) {
+          const char c = *p;
+          if (in_string_) {
+            if (escaped_) {
+              escaped_ = false;
+            } else if (c == '\\') {
+              escaped_ = true;
+            } else if (c == '"') {
+              in_string_ = false;
+            }
+          } else if (c == '"') {
+            in_string_ = true;
+          } else if (c == '{' || c == '[') {
+            ++depth_;
+          } else if (c == '}' || c == ']') {
+            if (depth_ > 0) {
+              --depth_;
+            } else if (c == ']') {
+              record_done = true;
+            } else {
+              Fail("Unbalanced '}' in top-level list item");
+              return false;
+            }
+          } else if (c == ',' && depth_ == 0) {
+            record_done = true;
+          }
+        }
+        if (!record_done) {
+          record_.append(record_start, p);
+          return true;
+        }
+        // p is one past the comma or bracket that ended the record.
+        --p;
+        record_.append(record_start, p);
+        ImportRecord();
+        if (state_ == FAILED) {
+          return false;
+        }
+        state_ = (*p == ']') ? AFTER_LIST : BEFORE_RECORD;
+        break;
+      }
+
+      case AFTER_LIST:
+        if (!IsJsonWhitespace(*p)) {
+          Fail("Unexpected text after top-level list");
+          return false;
+        }
+        break;
+
+      case FAILED:
+        return false;
+    }
+  }
+  return state_ != FAILED;
+}
+
+bool JsonTimelineImporter::Finish() {
+  if (state_ == FAILED) {
+    return false;
+  }
+  if (state_ != AFTER_LIST) {
+    Fail("JSON string is truncated");
+    return false;
+  }
+  return !error_;
+}
+
+void JsonTimelineImporter::ImportRecord() {
+  scoped_ptr<const Value> json(base::JSONReader::Read(
+      record_,
+      true));  // allow_trailing_comma
+  // Keep the buffer's capacity for the next record.
+  record_.clear();
+  if (json == NULL) {
+    Fail("JSON string failed to parse");
+    return;
+  }
+  ProtoPopulator populator(filter_record_types_ ? &record_types_ : NULL);
+  populator.PopulateToplevelItem(json.get(), proto_out_);
+  if (populator.error()) {
+    error_ = true;
+  }
+}
+
+void JsonTimelineImporter::Fail(const char* message) {
+  LOG(WARNING) << message;
+  state_ = FAILED;
+  error_ = true;
+}
+
 }  // namespace timeline
 
 }  // namespace pagespeed
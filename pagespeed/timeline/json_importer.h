@@ -15,17 +15,20 @@
 #ifndef PAGESPEED_TIMELINE_JSON_IMPORTER_H_
 #define PAGESPEED_TIMELINE_JSON_IMPORTER_H_
 
+#include <istream>
+#include <set>
 #include <string>
 #include <vector>
 
+#include "base/basictypes.h"
+#include "pagespeed/proto/timeline.pb.h"
+
 namespace base {
 class ListValue;
 }  // namespace base
 
 namespace pagespeed {
 
-class InstrumentationData;
-
 namespace timeline {
 
 // Return false if there were any errors, true otherwise.
@@ -38,6 +41,66 @@ bool CreateTimelineProtoFromJsonValue(
     const base::ListValue& json,
     std::vector<const InstrumentationData*>* proto_out);
 
+// Like CreateTimelineProtoFromJsonString, but reads the JSON from a stream
+// with a JsonTimelineImporter, so the whole text is never held in memory.
+bool CreateTimelineProtoFromJsonStream(
+    std::istream* json_stream,
+    std::vector<const InstrumentationData*>* proto_out);
+
+// Imports a timeline (a JSON list of records) incrementally, as its text
+// arrives, parsing one top-level record at a time.  Memory use is bounded
+// by the text and value tree of the largest top-level record, rather than
+// by those of the whole timeline.
+class JsonTimelineImporter {
+ public:
+  // Records are appended to proto_out, which takes ownership of them.
+  explicit JsonTimelineImporter(
+      std::vector<const InstrumentationData*>* proto_out);
+  ~JsonTimelineImporter();
+
+  // Only import the top-level records that have one of the given types
+  // themselves or in one of their descendants.  Must be called before the
+  // first call to Append.  By default, all records are imported.
+  void SetRecordTypes(
+      const std::set<InstrumentationData::RecordType>& record_types);
+
+  // Import the next size bytes of the timeline.  Returns false if the text
+  // so far is not the start of a JSON list; records already imported are
+  // kept, but no more will be.
+  bool Append(const char* data, size_t size);
+
+  // Call after the last Append.  Returns false if there were any errors,
+  // true otherwise.
+  bool Finish();
+
+ private:
+  enum State {
+    BEFORE_LIST,
+    BEFORE_RECORD,
+    IN_RECORD,
+    AFTER_LIST,
+    FAILED
+  };
+
+  // Parse and import the text of the top-level record in record_.
+  void ImportRecord();
+  void Fail(const char* message);
+
+  std::vector<const InstrumentationData*>* const proto_out_;
+  std::set<InstrumentationData::RecordType> record_types_;
+  bool filter_record_types_;
+  State state_;
+  // The text of the top-level record being read, and the nesting depth
+  // and string state at its end.
+  std::string record_;
+  int depth_;
+  bool in_string_;
+  bool escaped_;
+  bool error_;
+
+  DISALLOW_COPY_AND_ASSIGN(JsonTimelineImporter);
+};
+
 }  // namespace timeline
 
 }  // namespace pagespeed
@@ -0,0 +1,53 @@
+// Copyright 2013 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+#include <vector>
+
+#include "base/stl_util.h"  // for STLDeleteContainerPointers
+#include "pagespeed/proto/timeline.pb.h"
+#include "pagespeed/testing/benchmark.h"
+#include "pagespeed/testing/pagespeed_test.h"
+#include "pagespeed/timeline/json_importer.h"
+
+namespace {
+
+// The RULES_TEST_DIR_PATH macro is set by the gyp target that builds this
+// file.
+const char kTimelineFile[] = RULES_TEST_DIR_PATH "load5_no_loader.json";
+
+PAGESPEED_BENCHMARK(BM_CreateTimelineProtoFromJsonString) {
+  std::string json;
+  if (!pagespeed_testing::ReadFileToString(kTimelineFile, &json)) {
+    state->SetError(std::string("Unable to read ") + kTimelineFile +
+                    "; check --srcroot");
+    return;
+  }
+  state->SetBytesPerIteration(json.size());
+  std::vector<const pagespeed::InstrumentationData*> records;
+  state->ResetTiming();
+  for (int i = 0; i < state->iterations(); ++i) {
+    if (!pagespeed::timeline::CreateTimelineProtoFromJsonString(
+            json, &records)) {
+      state->SetError("CreateTimelineProtoFromJsonString failed");
+    }
+    STLDeleteContainerPointers(records.begin(), records.end());
+    records.clear();
+    if (!state->error().empty()) {
+      return;
+    }
+  }
+}
+
+}  // namespace
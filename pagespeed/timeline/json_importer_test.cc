@@ -12,9 +12,13 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
+#include <set>
+#include <sstream>
 #include <string>
 #include <vector>
 
+#include "base/basictypes.h"
 #include "base/memory/scoped_ptr.h"
 #include "base/stl_util.h"
 #include "pagespeed/proto/timeline.pb.h"
@@ -25,7 +29,9 @@ using pagespeed::InstrumentationData;
 
 namespace {
 
+using pagespeed::timeline::CreateTimelineProtoFromJsonStream;
 using pagespeed::timeline::CreateTimelineProtoFromJsonString;
+using pagespeed::timeline::JsonTimelineImporter;
 
 const std::string kTimelineJson =
     "[{"
@@ -128,4 +134,98 @@ TEST(TimelineTest, Basic) {
   ASSERT_EQ(2, record2b.stack_trace_size());
 }
 
+TEST(TimelineTest, ImporterMatchesString) {
+  std::vector<const InstrumentationData*> expected;
+  STLElementDeleter<std::vector<const InstrumentationData*> > expected_deleter(
+      &expected);
+  ASSERT_TRUE(CreateTimelineProtoFromJsonString(kTimelineJson, &expected));
+
+  // Records must come out the same however the text is split up.
+  const size_t kChunkSizes[] = { 1, 7, 64, kTimelineJson.size() };
+  for (size_t i = 0; i < arraysize(kChunkSizes); ++i) {
+    const size_t chunk_size = kChunkSizes[i];
+    std::vector<const InstrumentationData*> records;
+    STLElementDeleter<std::vector<const InstrumentationData*> > deleter(
+        &records);
+    JsonTimelineImporter importer(&records);
+    for (size_t offset = 0; offset < kTimelineJson.size();
+         offset += chunk_size) {
+      ASSERT_TRUE(importer.Append(
+          kTimelineJson.data() + offset,
+          std::min(chunk_size, kTimelineJson.size() - offset)));
+    }
+    ASSERT_TRUE(importer.Finish());
+    ASSERT_EQ(expected.size(), records.size()) << chunk_size;
+    for (size_t j = 0; j < records.size(); ++j) {
+      EXPECT_EQ(expected[j]->SerializeAsString(),
+                records[j]->SerializeAsString()) << chunk_size;
+    }
+  }
+}
+
+TEST(TimelineTest, ImporterStream) {
+  std::istringstream stream(kTimelineJson);
+  std::vector<const InstrumentationData*> records;
+  STLElementDeleter<std::vector<const InstrumentationData*> > deleter(&records);
+  ASSERT_TRUE(CreateTimelineProtoFromJsonStream(&stream, &records));
+  ASSERT_EQ(3u, records.size());
+  EXPECT_EQ(InstrumentationData::EVALUATE_SCRIPT, records[2]->type());
+}
+
+TEST(TimelineTest, ImporterRecordTypes) {
+  std::set<InstrumentationData::RecordType> record_types;
+  record_types.insert(InstrumentationData::LAYOUT);
+  std::vector<const InstrumentationData*> records;
+  STLElementDeleter<std::vector<const InstrumentationData*> > deleter(&records);
+  JsonTimelineImporter importer(&records);
+  importer.SetRecordTypes(record_types);
+  ASSERT_TRUE(importer.Append(kTimelineJson.data(), kTimelineJson.size()));
+  ASSERT_TRUE(importer.Finish());
+
+  // Only the EvaluateScript record has a Layout record in its tree; it is
+  // kept whole, children included.
+  ASSERT_EQ(1u, records.size());
+  EXPECT_EQ(InstrumentationData::EVALUATE_SCRIPT, records[0]->type());
+  ASSERT_EQ(2, records[0]->children_size());
+  EXPECT_EQ(InstrumentationData::LAYOUT, records[0]->children(1).type());
+}
+
+TEST(TimelineTest, ImporterMalformed) {
+  const char* kMalformed[] = {
+    "{}",
+    "[{\"type\":\"Layout\"}",
+    "[,{\"type\":\"Layout\"}]",
+    "[{\"type\":\"Layout\"}}]",
+    "[{\"type\":\"Layout\"}]]",
+    "[{\"type\":}]",
+  };
+  for (size_t i = 0; i < arraysize(kMalformed); ++i) {
+    const std::string json(kMalformed[i]);
+    std::vector<const InstrumentationData*> records;
+    STLElementDeleter<std::vector<const InstrumentationData*> > deleter(
+        &records);
+    JsonTimelineImporter importer(&records);
+    EXPECT_FALSE(importer.Append(json.data(), json.size()) &&
+                 importer.Finish()) << json;
+  }
+}
+
+TEST(TimelineTest, ImporterEmptyAndTrailingComma) {
+  const char* kValid[] = {
+    " [ ] ",
+    "[{\"type\":\"Layout\"},]",
+    "[{\"type\":\"MarkTimeline\",\"data\":{\"message\":\"],\\\"\"}}]",
+  };
+  for (size_t i = 0; i < arraysize(kValid); ++i) {
+    const std::string json(kValid[i]);
+    std::vector<const InstrumentationData*> records;
+    STLElementDeleter<std::vector<const InstrumentationData*> > deleter(
+        &records);
+    JsonTimelineImporter importer(&records);
+    ASSERT_TRUE(importer.Append(json.data(), json.size())) << json;
+    ASSERT_TRUE(importer.Finish()) << json;
+    ASSERT_EQ(i == 0 ? 0u : 1u, records.size()) << json;
+  }
+}
+
 }  // namespace